@@ -20,6 +20,10 @@
 #include "VS/Graphics/VS_Screen.h"
 #include "VS/Graphics/VS_Sprite.h"
 #include "VS/Graphics/VS_DynamicBatchManager.h"
+#include "VS/Files/VS_StreamingQueue.h"
+#include "VS/Memory/VS_FrameArena.h"
+#include "VS/Utils/VS_Cache.h"
+#include "VS/Utils/VS_Profile.h"
 #include "VS/Utils/VS_System.h"
 
 //REGISTER_GAME("Empty", coreGame)
@@ -183,30 +187,63 @@ coreGame::DeinitGameSystems()
 void
 coreGame::Go()
 {
+	vsProfiler::FrameMarker();
 	m_framesRendered++;
+	vsFrameArena::Instance()->NextFrame();
+	vsStreamingQueue::Instance()->Update();
 
-	for ( int i = 0; i < m_systemCount; i++ )
-		if ( m_system[i]->IsActive() )
-			m_system[i]->Update( m_timeStep );
+	{
+		PROFILE("SystemUpdate");
+		for ( int i = 0; i < m_systemCount; i++ )
+			if ( m_system[i]->IsActive() )
+				m_system[i]->Update( m_timeStep );
+	}
 
 	if ( vsScreen::Instance()->Resized() )
 	{
 		HandleResize();
 	}
 
-	Update( m_timeStep );
+	{
+		PROFILE("GameUpdate");
+		Update( m_timeStep );
 
-	if ( m_currentMode )
-		m_currentMode->Update( m_timeStep );
+		if ( m_currentMode )
+			m_currentMode->Update( m_timeStep );
 
-	vsScreen::Instance()->Update( m_timeStep );
+		vsScreen::Instance()->Update( m_timeStep );
+	}
 
-	for ( int i = 0; i < m_systemCount; i++ )
-		if ( m_system[i]->IsActive() )
-			m_system[i]->PostUpdate( m_timeStep );
+	{
+		PROFILE("SystemPostUpdate");
+		for ( int i = 0; i < m_systemCount; i++ )
+			if ( m_system[i]->IsActive() )
+				m_system[i]->PostUpdate( m_timeStep );
+	}
 
-	DrawFrame();
+#ifdef USE_BOX2D_PHYSICS
+	// In overlapped mode, the next physics step runs while we draw this
+	// frame from the transforms our entities already have.
+	vsCollisionSystem *collision = static_cast<vsCollisionSystem*>( s_system[ GameSystem_Collision ] );
+	bool stepPhysics = collision && collision->IsActive();
+	if ( stepPhysics )
+		collision->BeginStep();
+#endif
+
+	{
+		PROFILE("DrawFrame");
+		DrawFrame();
+	}
+
+#ifdef USE_BOX2D_PHYSICS
+	if ( stepPhysics )
+		collision->FinishStep();
+#endif
 	vsDynamicBatchManager::Instance()->FrameRendered();
+
+	// now that the frame's been drawn, let the resource caches free a
+	// little of whatever isn't being used any more.
+	vsCacheBase::UpdateAll();
 }
 
 void
@@ -224,12 +224,14 @@ vsFile::vsFile( const vsString &filename, vsFile::Mode mode ):
 {
 	// vsAssert( !DirectoryExists(filename), vsFormatString("Attempted to open directory '%s' as a plain file", filename.c_str()) );
 
-	if ( (mode == MODE_Read || mode == MODE_ReadCompressed) &&
-			vsFileCache::IsFileInCache( filename ) )
+	vsStore *cached = NULL;
+	if ( mode == MODE_Read || mode == MODE_ReadCompressed )
+		cached = vsFileCache::CopyFileContents( filename );
+
+	if ( cached )
 	{
 		PROFILE_CACHED(filename);
-		vsStore *c = vsFileCache::GetFileContents( filename );
-		m_store = new vsStore(*c);
+		m_store = cached;
 		m_mode = MODE_Read;
 		m_length = m_store->BufferLength();
 	}
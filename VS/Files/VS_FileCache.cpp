@@ -10,32 +10,42 @@
 #include "VS_FileCache.h"
 #include "VS_HashTable.h"
 #include "VS_Store.h"
+#include "VS/Threads/VS_Spinlock.h"
 
 static vsHashTable<vsStore> *s_cache = NULL;
+static vsSpinlock s_cacheLock;	// files may be read from background threads
 
 void
 vsFileCache::Startup()
 {
+	s_cacheLock.Lock();
 	s_cache = new vsHashTable<vsStore>(128);
+	s_cacheLock.Unlock();
 }
 
 void
 vsFileCache::Shutdown()
 {
+	s_cacheLock.Lock();
 	vsDelete( s_cache );
+	s_cacheLock.Unlock();
 }
 
 void
 vsFileCache::Purge()
 {
-	Shutdown();
-	Startup();
+	// Keep the table itself, so that other threads never see it missing.
+	s_cacheLock.Lock();
+	s_cache->Clear();
+	s_cacheLock.Unlock();
 }
 
 bool
 vsFileCache::IsFileInCache(const vsString& filename)
 {
+	s_cacheLock.Lock();
 	vsStore *s = s_cache->FindItem(filename);
+	s_cacheLock.Unlock();
 
 	return NULL != s;
 }
@@ -47,9 +57,23 @@ vsFileCache::GetFileContents(const vsString& filename)
 	return s;
 }
 
+vsStore*
+vsFileCache::CopyFileContents(const vsString& filename)
+{
+	vsStore *result = NULL;
+	s_cacheLock.Lock();
+	vsStore *s = s_cache->FindItem(filename);
+	if ( s )
+		result = new vsStore(*s);
+	s_cacheLock.Unlock();
+	return result;
+}
+
 void
 vsFileCache::SetFileContents(const vsString& filename, const vsStore &store)
 {
+	s_cacheLock.Lock();
 	s_cache->AddItemWithKey(store, filename);
+	s_cacheLock.Unlock();
 }
 
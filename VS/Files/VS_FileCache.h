@@ -12,6 +12,8 @@
 
 class vsStore;
 
+// vsFileCache may be used from any thread.
+
 class vsFileCache
 {
 public:
@@ -21,7 +23,8 @@ public:
 	static void Purge();
 
 	static bool IsFileInCache(const vsString& filename);
-	static vsStore* GetFileContents(const vsString& filename);
+	static vsStore* GetFileContents(const vsString& filename);	// main thread only;  the result may move if another thread adds a file
+	static vsStore* CopyFileContents(const vsString& filename);	// returns a new copy of the cached contents, or NULL
 	static void SetFileContents(const vsString& filename, const vsStore &store);
 };
 
@@ -15,7 +15,6 @@
 #include "VS/Memory/VS_Serialiser.h"
 
 vsRecord::vsRecord():
-	m_token(0),
 	m_childList(0)
 {
 	m_childList.Clear();
@@ -27,7 +26,6 @@ vsRecord::vsRecord():
 }
 
 vsRecord::vsRecord( const char* fromString ):
-	m_token(0),
 	m_childList(0)
 {
 	m_childList.Clear();
@@ -40,7 +38,6 @@ vsRecord::vsRecord( const char* fromString ):
 }
 
 vsRecord::vsRecord( const vsString& fromString ):
-	m_token(0),
 	m_childList(0)
 {
 	m_childList.Clear();
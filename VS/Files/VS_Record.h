@@ -11,6 +11,7 @@
 #define FS_RECORD_H
 
 #include "VS/Utils/VS_Array.h"
+#include "VS/Utils/VS_InlineArray.h"
 #include "VS/Utils/VS_StringTable.h"
 #include "VS/Utils/VS_ArrayStore.h"
 #include "VS/Math/VS_Quaternion.h"
@@ -27,7 +28,7 @@ class vsRecord
 {
 	vsToken		m_label;
 
-	vsArray<vsToken>	m_token;
+	vsInlineArray<vsToken,4>	m_token;	// almost all records have four or fewer tokens
 
 	vsArray<vsRecord*>	m_childList;
 	vsRecord *	m_lastChild;
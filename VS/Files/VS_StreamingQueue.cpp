@@ -0,0 +1,458 @@
+/*
+ *  VS_StreamingQueue.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_StreamingQueue.h"
+
+#include "VS_File.h"
+#include "VS/Memory/VS_Store.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Threads/VS_Task.h"
+#include "VS/Utils/VS_Profile.h"
+
+#include <SDL2/SDL.h>
+
+class vsStreamReader : public vsTask
+{
+	vsStreamingQueue *	m_queue;
+protected:
+	virtual int Run();
+public:
+	vsStreamReader( vsStreamingQueue *queue ):
+		vsTask("StreamReader"),
+		m_queue(queue)
+	{
+	}
+};
+
+static double SecondsBetween( uint64_t start, uint64_t end )
+{
+	return (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+vsStreamingQueue::vsStreamingQueue( int maxConcurrentReads ):
+	m_files(NULL),
+	m_completedHead(NULL),
+	m_completedTail(NULL),
+	m_nextHandle(1),
+	m_nextSequence(0),
+	m_work( new vsSemaphore(0) ),
+	m_readerCount( vsMax(1, maxConcurrentReads) )
+{
+	m_reader = new vsStreamReader*[m_readerCount];
+	for ( int i = 0; i < m_readerCount; i++ )
+	{
+		m_reader[i] = new vsStreamReader(this);
+		m_reader[i]->Start();
+	}
+}
+
+vsStreamingQueue::~vsStreamingQueue()
+{
+	m_work->Release();
+	for ( int i = 0; i < m_readerCount; i++ )
+	{
+		m_reader[i]->Join();
+		vsDelete( m_reader[i] );
+	}
+	vsDeleteArray( m_reader );
+	vsDelete( m_work );
+
+	// Nobody's reading any more, but there may still be decodes running.
+	vsJobSystem::Instance()->Wait( &m_finishing );
+
+	LogStats();
+	while ( m_files )
+	{
+		File *file = m_files;
+		Unlink( file );
+		DeleteFile( file );
+	}
+}
+
+vsStreamHandle
+vsStreamingQueue::Request( const vsString &filename, int priority, vsStreamDecodeFunction decode, vsStreamCompleteFunction complete, void *data )
+{
+	Listener *listener = new Listener;
+	listener->priority = priority;
+	listener->decode = decode;
+	listener->complete = complete;
+	listener->data = data;
+	listener->requestTime = SDL_GetPerformanceCounter();
+	listener->cancelled = false;
+	listener->decoding = false;
+	listener->decodingThread = 0;
+	listener->next = NULL;
+
+	bool newFile = false;
+
+	m_lock.Lock();
+	listener->handle = m_nextHandle++;
+	if ( m_nextHandle == 0 )
+		m_nextHandle = 1;
+	m_stats.requests++;
+
+	// If this file hasn't been read yet, share its read.
+	File *file = m_files;
+	while ( file )
+	{
+		if ( file->state <= State_Reading && file->filename == filename )
+			break;
+		file = file->next;
+	}
+
+	if ( file )
+	{
+		m_stats.deduplicated++;
+		if ( priority > file->priority )
+			file->priority = priority;
+
+		Listener **tail = &file->listeners;
+		while ( *tail )
+			tail = &(*tail)->next;
+		*tail = listener;
+	}
+	else
+	{
+		file = new File;
+		file->filename = filename;
+		file->state = State_Pending;
+		file->priority = priority;
+		file->sequence = m_nextSequence++;
+		file->listeners = listener;
+		file->contents = NULL;
+		file->success = false;
+		file->nextCompleted = NULL;
+		file->prev = NULL;
+		file->next = m_files;
+		if ( m_files )
+			m_files->prev = file;
+		m_files = file;
+		newFile = true;
+	}
+	listener->file = file;
+	vsStreamHandle handle = listener->handle;
+	m_lock.Unlock();
+
+	if ( newFile )
+		m_work->Post();
+	return handle;
+}
+
+vsStreamingQueue::Listener *
+vsStreamingQueue::FindListener( vsStreamHandle handle )
+{
+	for ( File *file = m_files; file; file = file->next )
+		for ( Listener *l = file->listeners; l; l = l->next )
+			if ( l->handle == handle )
+				return l;
+	return NULL;
+}
+
+bool
+vsStreamingQueue::Cancel( vsStreamHandle handle )
+{
+	m_lock.Lock();
+	Listener *listener = FindListener( handle );
+	if ( !listener || listener->cancelled )
+	{
+		m_lock.Unlock();
+		return false;
+	}
+
+	// Setting 'cancelled' stops any more decodes from starting.  If one has
+	// already started, wait for it, since the caller is about to destroy
+	// whatever it's decoding into;  unless we're being called from inside
+	// that decode, which would wait forever.
+	listener->cancelled = true;
+	m_stats.cancelled++;
+	while ( listener->decoding && listener->decodingThread != SDL_ThreadID() )
+	{
+		m_lock.Unlock();
+		SDL_Delay(0);
+		m_lock.Lock();
+	}
+
+	// If nobody wants this file any more and we haven't started reading it,
+	// don't bother.
+	File *file = listener->file;
+	if ( file->state == State_Pending )
+	{
+		bool wanted = false;
+		for ( Listener *l = file->listeners; l; l = l->next )
+			wanted |= !l->cancelled;
+		if ( !wanted )
+		{
+			Unlink( file );
+			DeleteFile( file );
+		}
+	}
+	m_lock.Unlock();
+	return true;
+}
+
+void
+vsStreamingQueue::SetPriority( vsStreamHandle handle, int priority )
+{
+	m_lock.Lock();
+	Listener *listener = FindListener( handle );
+	if ( listener )
+	{
+		listener->priority = priority;
+
+		File *file = listener->file;
+		file->priority = priority;
+		for ( Listener *l = file->listeners; l; l = l->next )
+			if ( !l->cancelled && l->priority > file->priority )
+				file->priority = l->priority;
+	}
+	m_lock.Unlock();
+}
+
+bool
+vsStreamingQueue::IsPending( vsStreamHandle handle )
+{
+	m_lock.Lock();
+	Listener *listener = FindListener( handle );
+	bool result = ( listener && !listener->cancelled );
+	m_lock.Unlock();
+	return result;
+}
+
+vsStreamingQueue::File *
+vsStreamingQueue::PopHighestPriority()
+{
+	File *best = NULL;
+	for ( File *file = m_files; file; file = file->next )
+	{
+		if ( file->state != State_Pending )
+			continue;
+		if ( !best ||
+				file->priority > best->priority ||
+				(file->priority == best->priority && (int32_t)(file->sequence - best->sequence) < 0) )
+			best = file;
+	}
+	if ( best )
+		best->state = State_Reading;
+	return best;
+}
+
+void
+vsStreamingQueue::Unlink( File *file )
+{
+	if ( file->prev )
+		file->prev->next = file->next;
+	else
+		m_files = file->next;
+	if ( file->next )
+		file->next->prev = file->prev;
+	file->prev = file->next = NULL;
+}
+
+void
+vsStreamingQueue::DeleteFile( File *file )
+{
+	while ( file->listeners )
+	{
+		Listener *l = file->listeners;
+		file->listeners = l->next;
+		vsDelete( l );
+	}
+	vsDelete( file->contents );
+	vsDelete( file );
+}
+
+void
+vsStreamingQueue::Read( File *file )
+{
+	PROFILE("StreamRead");
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	// Nobody else touches the file's contents while it's being read.
+	if ( vsFile::Exists( file->filename ) )
+	{
+		vsFile f( file->filename );
+		file->contents = new vsStore( f.GetLength() );
+		f.Store( file->contents );
+		file->success = true;
+	}
+	else
+		vsLog("Streaming: couldn't find file '%s'", file->filename.c_str());
+
+	uint64_t end = SDL_GetPerformanceCounter();
+
+	m_lock.Lock();
+	m_stats.bytesRead += file->contents ? file->contents->Length() : 0;
+	m_stats.readSeconds += SecondsBetween( start, end );
+
+	// From here on, no more requests can join this file, so it's safe to
+	// walk our listeners without the lock;  Cancel() only flags them.
+	file->state = State_Decoding;
+	m_lock.Unlock();
+
+	vsJobSystem *js = vsJobSystem::Instance();
+	if ( file->success )
+	{
+		for ( Listener *l = file->listeners; l; l = l->next )
+			if ( l->decode )
+				js->Run( &DecodeJob, l, &file->decodes );
+	}
+	js->Run( &FinishJob, file, &m_finishing, &file->decodes );
+}
+
+void
+vsStreamingQueue::DecodeJob( void *data )
+{
+	Listener *listener = reinterpret_cast<Listener*>(data);
+	Instance()->Decode( listener );
+}
+
+void
+vsStreamingQueue::Decode( Listener *listener )
+{
+	m_lock.Lock();
+	bool cancelled = listener->cancelled;
+	listener->decoding = !cancelled;
+	listener->decodingThread = SDL_ThreadID();
+	m_lock.Unlock();
+
+	if ( cancelled )
+		return;
+
+	vsStore *contents = listener->file->contents;
+	listener->decode( contents->GetReadHead(), contents->BytesLeftForReading(), listener->data );
+
+	m_lock.Lock();
+	listener->decoding = false;
+	m_lock.Unlock();
+}
+
+void
+vsStreamingQueue::FinishJob( void *data )
+{
+	File *file = reinterpret_cast<File*>(data);
+	Instance()->Finish( file );
+}
+
+void
+vsStreamingQueue::Finish( File *file )
+{
+	m_lock.Lock();
+	file->state = State_Done;
+	file->nextCompleted = NULL;
+	if ( m_completedTail )
+		m_completedTail->nextCompleted = file;
+	else
+		m_completedHead = file;
+	m_completedTail = file;
+	m_lock.Unlock();
+}
+
+void
+vsStreamingQueue::Update()
+{
+	m_lock.Lock();
+	File *file = m_completedHead;
+	m_completedHead = m_completedTail = NULL;
+	m_lock.Unlock();
+
+	uint64_t now = SDL_GetPerformanceCounter();
+	while ( file )
+	{
+		File *next = file->nextCompleted;
+		const char *bytes = file->contents ? file->contents->GetReadHead() : NULL;
+		size_t length = file->contents ? file->contents->BytesLeftForReading() : 0;
+
+		// Complete functions may make or cancel other requests, so don't hold
+		// the lock while calling them.  This file can't go away meanwhile;
+		// only we delete completed files.
+		for ( Listener *l = file->listeners; l; l = l->next )
+		{
+			// Other threads may be cancelling;  claim the listener first, so
+			// it can't be cancelled any more.
+			m_lock.Lock();
+			bool cancelled = l->cancelled;
+			l->cancelled = true;
+			m_lock.Unlock();
+			if ( cancelled )
+				continue;
+			if ( l->complete )
+				l->complete( file->filename, bytes, length, file->success, l->data );
+
+			double latency = SecondsBetween( l->requestTime, now );
+			m_lock.Lock();
+			m_stats.completed++;
+			if ( !file->success )
+				m_stats.failed++;
+			m_stats.totalLatency += latency;
+			m_stats.maxLatency = vsMax( m_stats.maxLatency, latency );
+			m_lock.Unlock();
+		}
+
+		m_lock.Lock();
+		Unlink( file );
+		m_lock.Unlock();
+		DeleteFile( file );
+		file = next;
+	}
+}
+
+vsStreamingQueue::Stats
+vsStreamingQueue::GetStats()
+{
+	m_lock.Lock();
+	Stats result = m_stats;
+	for ( File *file = m_files; file; file = file->next )
+	{
+		switch ( file->state )
+		{
+			case State_Pending: result.pending++; break;
+			case State_Reading: result.reading++; break;
+			default: result.decoding++; break;
+		}
+	}
+	m_lock.Unlock();
+	return result;
+}
+
+void
+vsStreamingQueue::ResetCounters()
+{
+	m_lock.Lock();
+	m_stats = Stats();
+	m_lock.Unlock();
+}
+
+void
+vsStreamingQueue::LogStats()
+{
+	Stats s = GetStats();
+	vsLog("Streaming queue: %d pending, %d reading, %d decoding", s.pending, s.reading, s.decoding);
+	vsLog("  %d requests (%d deduplicated, %d cancelled), %d completed (%d failed)",
+			s.requests, s.deduplicated, s.cancelled, s.completed, s.failed);
+	vsLog("  %0.2fMB read at %0.2fMB/s per reader;  latency %0.1fms average, %0.1fms worst",
+			s.bytesRead / (1024.0 * 1024.0), s.GetThroughput() / (1024.0 * 1024.0),
+			s.GetAverageLatency() * 1000.0, s.maxLatency * 1000.0);
+}
+
+int
+vsStreamReader::Run()
+{
+	vsProfiler::SetThreadName("StreamReader");
+	while ( m_queue->m_work->Wait() )
+	{
+		m_queue->m_lock.Lock();
+		vsStreamingQueue::File *file = m_queue->PopHighestPriority();
+		m_queue->m_lock.Unlock();
+
+		// Cancelled requests leave extra posts on the semaphore;  that's fine.
+		if ( file )
+			m_queue->Read( file );
+	}
+	return 0;
+}
@@ -0,0 +1,185 @@
+/*
+ *  VS_StreamingQueue.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_STREAMINGQUEUE_H
+#define VS_STREAMINGQUEUE_H
+
+#include "VS/Utils/VS_Singleton.h"
+#include "VS/Threads/VS_JobSystem.h"
+#include "VS/Threads/VS_Spinlock.h"
+
+class vsSemaphore;
+class vsStore;
+class vsStreamReader;
+
+// vsStreamingQueue reads files in the background, so that games can prefetch
+// the next area (or load anything else) without stalling the frame.
+//
+// Each request names a file and a priority;  the highest priority waiting
+// file is always the next one to be read, so (for example) assets near the
+// camera can be given higher priorities than distant ones, and have their
+// priorities raised later with SetPriority() as the camera moves.  Only a
+// fixed number of files are read at once, by dedicated reader threads.
+//
+// Once a file has been read, each request's optional 'decode' function is
+// called with its contents on a job system worker, to do whatever expensive
+// parsing can be done away from the main thread.  Then each request's
+// 'complete' function is called on the main thread, from Update(), which
+// coreGame calls at the start of every frame.
+//
+// Several requests for the same file, made before it's been read, share one
+// read.  A cancelled request never has any more of its functions called
+// (and if its decode function was running, Cancel() waits for it to finish
+// first), so it's safe to destroy the request's data right after cancelling;
+// except when cancelling from the decode function itself, as described at
+// Cancel().
+//
+// File contents are only valid for the duration of the decode and complete
+// calls, and are shared between requests, so must not be modified.
+
+typedef uint32_t vsStreamHandle;	// 0 is never a valid handle
+
+// called on a worker thread
+typedef void (*vsStreamDecodeFunction)( const char *bytes, size_t length, void *data );
+// called on the main thread.  If the file couldn't be read, 'success' is false and 'bytes' is NULL.
+typedef void (*vsStreamCompleteFunction)( const vsString &filename, const char *bytes, size_t length, bool success, void *data );
+
+class vsStreamingQueue : public vsSingleton<vsStreamingQueue>
+{
+public:
+
+	struct Stats
+	{
+		int		pending;		// files waiting to be read
+		int		reading;		// files being read right now
+		int		decoding;		// files which have been read, but whose requests haven't completed yet
+
+		size_t	requests;
+		size_t	deduplicated;	// requests which shared another request's read
+		size_t	cancelled;
+		size_t	completed;		// requests whose complete function was called
+		size_t	failed;			// of which, for files which couldn't be read
+
+		size_t	bytesRead;
+		double	readSeconds;	// total time spent reading, summed across readers
+		double	totalLatency;	// seconds from request to completion, summed across completed requests
+		double	maxLatency;
+
+		Stats(): pending(0), reading(0), decoding(0), requests(0), deduplicated(0), cancelled(0), completed(0), failed(0), bytesRead(0), readSeconds(0.0), totalLatency(0.0), maxLatency(0.0) {}
+
+		double	GetThroughput() const { return readSeconds > 0.0 ? bytesRead / readSeconds : 0.0; }	// bytes per second, per reader
+		double	GetAverageLatency() const { return completed ? totalLatency / completed : 0.0; }
+	};
+
+private:
+
+	struct File;
+
+	struct Listener
+	{
+		vsStreamHandle				handle;
+		int							priority;
+		vsStreamDecodeFunction		decode;
+		vsStreamCompleteFunction	complete;
+		void *						data;
+		uint64_t					requestTime;
+		File *						file;
+		bool						cancelled;
+		bool						decoding;
+		unsigned long				decodingThread;	// SDL_threadID running 'decode', while 'decoding'
+		Listener *					next;
+	};
+
+	enum State
+	{
+		State_Pending,
+		State_Reading,
+		State_Decoding,
+		State_Done
+	};
+
+	struct File
+	{
+		vsString		filename;
+		State			state;
+		int				priority;		// the highest priority of any of our requests
+		uint32_t		sequence;		// for first-come first-served among equal priorities
+		Listener *		listeners;		// one per request for this file
+		vsStore *		contents;
+		bool			success;
+		vsJobCounter	decodes;
+		File *			prev;
+		File *			next;
+		File *			nextCompleted;
+	};
+
+	vsSpinlock			m_lock;			// protects everything below
+	File *				m_files;		// every file we know about, in any state
+	File *				m_completedHead;	// files which are ready for Update(), in order
+	File *				m_completedTail;
+	vsStreamHandle		m_nextHandle;
+	uint32_t			m_nextSequence;
+	Stats				m_stats;
+
+	vsSemaphore *		m_work;
+	vsStreamReader **	m_reader;
+	int					m_readerCount;
+	vsJobCounter		m_finishing;	// files whose decodes we're waiting for
+
+	Listener *	FindListener( vsStreamHandle handle );
+	File *		PopHighestPriority();
+	void		Unlink( File *file );
+	void		DeleteFile( File *file );
+	void		Read( File *file );
+	void		Decode( Listener *listener );
+	void		Finish( File *file );
+
+	static void	DecodeJob( void *data );
+	static void	FinishJob( void *data );
+
+	friend class vsStreamReader;
+
+public:
+
+	vsStreamingQueue( int maxConcurrentReads = 2 );
+	~vsStreamingQueue();
+
+	// Request(), Cancel(), SetPriority(), IsPending(), GetStats(),
+	// ResetCounters() and LogStats() all take the queue's lock, so may be
+	// called from any thread, decode functions included.  Update() must
+	// only be called from the main thread, since that's where complete
+	// functions run.
+
+	// Either function may be NULL.  Returns a handle for use with Cancel()
+	// and SetPriority().  Higher priorities are read first.
+	vsStreamHandle	Request( const vsString &filename, int priority, vsStreamDecodeFunction decode, vsStreamCompleteFunction complete, void *data );
+
+	// Returns false if the request had already completed (or never existed).
+	//
+	// Normally waits for the request's decode function, if it's running.  If
+	// it's called from that decode function itself (or from anything else
+	// running on that job worker while it decodes), waiting would never end,
+	// so it doesn't wait;  then the caller mustn't destroy what the decode
+	// is writing into until the decode function returns.
+	bool			Cancel( vsStreamHandle handle );
+
+	// Only affects requests whose files haven't started being read yet.
+	void			SetPriority( vsStreamHandle handle, int priority );
+
+	bool			IsPending( vsStreamHandle handle );
+
+	// Calls the complete functions for everything which has finished.
+	void			Update();
+
+	Stats			GetStats();
+	void			ResetCounters();
+	void			LogStats();
+};
+
+#endif // VS_STREAMINGQUEUE_H
@@ -233,6 +233,13 @@ vsToken::vsToken(const vsToken& other):
 	}
 }
 
+vsToken::vsToken(vsToken&& other):
+	m_type(Type_None),
+	m_string(NULL)
+{
+	*this = std::move(other);
+}
+
 vsToken::~vsToken()
 {
 	SetInteger(0); // cleanup any string data we had lying around
@@ -597,3 +604,32 @@ vsToken::operator=( const vsToken& other )
 	return *this;
 }
 
+vsToken&
+vsToken::operator=( vsToken&& other )
+{
+	if ( this == &other )
+		return *this;
+
+	// take over the other token's string, if it has one, rather than copying it.
+	SetType( Type_None );
+	m_type = other.m_type;
+	switch ( other.m_type )
+	{
+		case Type_Label:
+		case Type_String:
+			m_string = other.m_string;
+			other.m_string = NULL;
+			other.m_type = Type_None;
+			break;
+		case Type_Float:
+			m_float = other.m_float;
+			break;
+		case Type_Integer:
+			m_int = other.m_int;
+			break;
+		default:
+			break;
+	}
+	return *this;
+}
+
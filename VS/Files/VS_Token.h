@@ -46,6 +46,7 @@ public:
 	vsToken();
 	vsToken(Type t);
 	vsToken(const vsToken& other);
+	vsToken(vsToken&& other);
 	~vsToken();
 
 	bool		ExtractFrom( vsString &string );
@@ -70,6 +71,7 @@ public:
 	bool		IsNumeric() { return IsType( Type_Float ) || IsType( Type_Integer ); }
 
 	vsToken& operator=( const vsToken& other );
+	vsToken& operator=( vsToken&& other );
 	bool operator==( const vsToken& other );
 	bool operator!=( const vsToken& other ) { return ! ((*this) == other); }
 
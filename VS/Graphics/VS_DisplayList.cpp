@@ -16,6 +16,7 @@
 #include "VS_Light.h"
 #include "VS_MaterialInternal.h"
 #include "VS_RenderBuffer.h"
+#include "VS_RenderThread.h"
 #include "VS_Screen.h"
 #include "VS_Shader.h"
 #include "VS_System.h"
@@ -26,6 +27,8 @@
 #include "SDL2/SDL_opengl.h"
 #endif
 
+uint32_t vsDisplayList::s_fifoNumber = 1;
+
 static vsString g_opCodeName[vsDisplayList::OpCode_MAX] =
 {
 	"SetColor",
@@ -105,7 +108,9 @@ static vsString g_opCodeName[vsDisplayList::OpCode_MAX] =
 
 	"SetShaderValues",
 
-	"Debug"
+	"Debug",
+
+	"CallList"
 };
 
 const vsString&
@@ -453,7 +458,12 @@ vsDisplayList::vsDisplayList():
 	m_instanceParent(NULL),
 	m_instanceCount(0),
 	m_materialCount(0),
-	m_colorSet(false)
+	m_colorSet(false),
+	m_recordedFrame(0),
+	m_calledFifo(0),
+	m_dynamic(false),
+	m_frameLocal(false),
+	m_static(false)
 {
 	Clear();
 }
@@ -462,7 +472,12 @@ vsDisplayList::vsDisplayList( size_t memSize ):
 	m_instanceParent(NULL),
 	m_instanceCount(0),
 	m_materialCount(0),
-	m_colorSet(false)
+	m_colorSet(false),
+	m_recordedFrame(0),
+	m_calledFifo(0),
+	m_dynamic(false),
+	m_frameLocal(false),
+	m_static(false)
 {
 	if ( memSize )
 	{
@@ -476,9 +491,25 @@ vsDisplayList::vsDisplayList( size_t memSize ):
 	Clear();
 }
 
+vsDisplayList::vsDisplayList( char *buffer, size_t memSize ):
+	m_fifo( new vsStore(buffer, (int)memSize) ),
+	m_instanceParent(NULL),
+	m_instanceCount(0),
+	m_materialCount(0),
+	m_colorSet(false),
+	m_recordedFrame(0),
+	m_calledFifo(0),
+	m_dynamic(false),
+	m_frameLocal(false),
+	m_static(false)
+{
+	Clear();
+}
+
 vsDisplayList::~vsDisplayList()
 {
 	vsAssert( m_instanceCount == 0, "Deleted a display list while something was still referencing it!" );
+	WaitUntilUnused();
 
 	for ( int i = 0; i < m_materialCount; i++ )
 	{
@@ -524,6 +555,7 @@ vsDisplayList::Clear()
 {
 	if ( m_fifo )
 	{
+		WaitUntilUnused();
 		m_fifo->Clear();
 	}
 	m_colorSet = false;
@@ -535,6 +567,26 @@ vsDisplayList::Rewind()
 	m_fifo->Rewind();
 }
 
+void
+vsDisplayList::WaitUntilUnused()
+{
+	// Without a render thread there's no frame in flight to wait for, but
+	// the FIFO which called us is still being recorded, and would draw
+	// whatever we hold when it's rendered.
+	vsAssert( m_calledFifo != s_fifoNumber || m_frameLocal,
+			"Display list cleared or destroyed after being called by a FIFO which hasn't been rendered yet" );
+
+	if ( m_recordedFrame == 0 || m_frameLocal )
+		return;
+
+	if ( !vsRenderThread::IsFrameComplete( m_recordedFrame ) )
+	{
+		vsRenderThread::Sync();
+		m_dynamic = true;
+	}
+	m_recordedFrame = 0;
+}
+
 void
 vsDisplayList::SetColor( const vsColor &color )
 {
@@ -611,6 +663,32 @@ vsDisplayList::Append( const vsDisplayList &list )
 	}
 }
 
+void
+vsDisplayList::CallList( const vsDisplayList &list )
+{
+	if ( list.m_instanceParent )
+	{
+		CallList( *list.m_instanceParent );
+		return;
+	}
+
+	if ( list.m_dynamic )
+	{
+		Append( list );
+		return;
+	}
+
+	uint32_t length = (uint32_t)list.m_fifo->Length();
+	if ( length == 0 )
+		return;
+
+	list.m_recordedFrame = vsRenderThread::GetRecordingFrame();
+	list.m_calledFifo = s_fifoNumber;
+	m_fifo->WriteUint8( OpCode_CallList );
+	m_fifo->WriteUint32( length );
+	m_fifo->WriteVoidStar( list.m_fifo->GetBuffer() );
+}
+
 void
 vsDisplayList::DrawLine( const vsVector3D &from, const vsVector3D &to )
 {
@@ -665,6 +743,7 @@ void
 vsDisplayList::SetMatrices4x4Buffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_SetMatrices4x4Buffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( (char*)buffer );
 }
 
@@ -680,6 +759,7 @@ void
 vsDisplayList::SetColorsBuffer( const vsRenderBuffer *b )
 {
 	m_fifo->WriteUint8( OpCode_SetColorsBuffer );
+	b->MarkRecorded();
 	m_fifo->WriteVoidStar( (char*)b );
 }
 
@@ -768,6 +848,7 @@ vsDisplayList::VertexBuffer( vsRenderBuffer *buffer )
 			buffer->GetContentType() == vsRenderBuffer::ContentType_P,
 			"Known render buffer types should use ::BindBuffer");
 	m_fifo->WriteUint8( OpCode_VertexBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( buffer );
 }
 
@@ -788,6 +869,7 @@ vsDisplayList::NormalBuffer( vsRenderBuffer *buffer )
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom,
 			"Non-custom render buffer types should use ::BindBuffer");
 	m_fifo->WriteUint8( OpCode_NormalBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( buffer );
 }
 
@@ -797,6 +879,7 @@ vsDisplayList::TexelBuffer( vsRenderBuffer *buffer )
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom,
 			"Non-custom render buffer types should use ::BindBuffer");
 	m_fifo->WriteUint8( OpCode_TexelBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( buffer );
 }
 
@@ -806,6 +889,7 @@ vsDisplayList::ColorBuffer( vsRenderBuffer *buffer )
 	vsAssert(buffer->GetContentType() == vsRenderBuffer::ContentType_Custom,
 			"Non-custom render buffer types should use ::BindBuffer");
 	m_fifo->WriteUint8( OpCode_ColorBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( buffer );
 }
 
@@ -813,6 +897,7 @@ void
 vsDisplayList::BindBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_BindBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( buffer );
 }
 
@@ -820,6 +905,7 @@ void
 vsDisplayList::UnbindBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_UnbindBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar( buffer );
 }
 
@@ -935,6 +1021,7 @@ void
 vsDisplayList::TriangleStripBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_TriangleStripBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar(buffer);
 }
 
@@ -942,6 +1029,7 @@ void
 vsDisplayList::TriangleListBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_TriangleListBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar(buffer);
 }
 
@@ -949,6 +1037,7 @@ void
 vsDisplayList::TriangleFanBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_TriangleFanBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar(buffer);
 }
 
@@ -956,6 +1045,7 @@ void
 vsDisplayList::LineListBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_LineListBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar(buffer);
 }
 
@@ -963,6 +1053,7 @@ void
 vsDisplayList::LineStripBuffer( vsRenderBuffer *buffer )
 {
 	m_fifo->WriteUint8( OpCode_LineStripBuffer );
+	buffer->MarkRecorded();
 	m_fifo->WriteVoidStar(buffer);
 }
 
@@ -991,6 +1082,7 @@ vsDisplayList::TriangleFanArray( int *idArray, int vertexCount )
 void
 vsDisplayList::SetMaterial( vsMaterial *material )
 {
+	material->MarkRecorded();
 	m_fifo->WriteUint8( OpCode_SetMaterial );
 	m_fifo->WriteVoidStar( material );
 }
@@ -1293,6 +1385,10 @@ vsDisplayList::PopOp()
 			case OpCode_Debug:
 				 m_currentOp.data.string = m_fifo->ReadString();
 				break;
+			case OpCode_CallList:
+				m_currentOp.data.i = m_fifo->ReadUint32();
+				m_currentOp.data.SetPointer( (char *)m_fifo->ReadVoidStar() );
+				break;
 			case OpCode_EnableScissor:
 				m_fifo->ReadBox2D( &m_currentOp.data.box2D );
 				break;
@@ -1321,6 +1417,142 @@ vsDisplayList::PopOp()
 	return NULL;
 }
 
+const vsDisplayList::OpView *
+vsDisplayList::PopOpView()
+{
+	if ( m_fifo->AtEnd() )
+		return NULL;
+
+	const char *start = m_fifo->GetReadHead();
+	m_fifo->AdvanceReadHead( m_currentView.Read( start ) - start );
+
+	return &m_currentView;
+}
+
+const char *
+vsDisplayList::OpView::Read( const char *cursor )
+{
+	m_type = (OpCode)(uint8_t)cursor[0];
+	m_payload = cursor + 1;
+	return m_payload + GetPayloadSize();
+}
+
+// Must match the layouts written by the functions which record each op, and
+// read by PopOp().
+size_t
+vsDisplayList::OpView::GetPayloadSize() const
+{
+	switch( m_type )
+	{
+		case OpCode_SetColor:
+			return 4 * sizeof(float);
+		case OpCode_SetColors:
+		case OpCode_SetMatrices4x4:
+		case OpCode_CallList:
+			return sizeof(uint32_t) + sizeof(void*);
+		case OpCode_PushTranslation:
+			return 3 * sizeof(float);
+		case OpCode_PushTransform:
+		case OpCode_SetCameraTransform:
+			return 5 * sizeof(float);
+		case OpCode_PushMatrix4x4:
+		case OpCode_SetMatrix4x4:
+		case OpCode_SetWorldToViewMatrix4x4:
+		case OpCode_SetProjectionMatrix4x4:
+			return sizeof(vsMatrix4x4);
+		case OpCode_Set3DProjection:
+			return 3 * sizeof(float);
+		case OpCode_VertexArray:
+		case OpCode_NormalArray:
+			return sizeof(uint32_t) + sizeof(s_vector3d) * GetCount();
+		case OpCode_TexelArray:
+			return sizeof(uint32_t) + sizeof(s_vector) * GetCount();
+		case OpCode_ColorArray:
+			return sizeof(uint32_t) + sizeof(s_color) * GetCount();
+		case OpCode_LineListArray:
+		case OpCode_LineStripArray:
+		case OpCode_TriangleListArray:
+		case OpCode_TriangleStripArray:
+		case OpCode_TriangleFanArray:
+		case OpCode_PointsArray:
+			return sizeof(uint32_t) + sizeof(uint16_t) * GetCount();
+		case OpCode_SetColorsBuffer:
+		case OpCode_SetMatrices4x4Buffer:
+		case OpCode_SetShaderValues:
+		case OpCode_VertexBuffer:
+		case OpCode_NormalBuffer:
+		case OpCode_TexelBuffer:
+		case OpCode_ColorBuffer:
+		case OpCode_BindBuffer:
+		case OpCode_UnbindBuffer:
+		case OpCode_LineListBuffer:
+		case OpCode_LineStripBuffer:
+		case OpCode_TriangleStripBuffer:
+		case OpCode_TriangleListBuffer:
+		case OpCode_TriangleFanBuffer:
+		case OpCode_SetMaterial:
+		case OpCode_SetRenderTarget:
+		case OpCode_ResolveRenderTarget:
+			return sizeof(void*);
+		case OpCode_BlitRenderTarget:
+			return 2 * sizeof(void*);
+		case OpCode_Light:
+			return sizeof(uint8_t) + 6 * sizeof(float) + 12 * sizeof(float);
+		case OpCode_Fog:
+			// color, 'linear' flag, then either start and end or density
+			return 4 * sizeof(float) + sizeof(uint8_t) + (m_payload[4 * sizeof(float)] ? 2 : 1) * sizeof(float);
+		case OpCode_EnableScissor:
+		case OpCode_SetViewport:
+			return 4 * sizeof(float);
+		case OpCode_Debug:
+			return sizeof(int16_t) + (uint16_t)(((uint8_t)m_payload[0] << 8) | (uint8_t)m_payload[1]);
+		default:
+			return 0;
+	}
+}
+
+uint32_t
+vsDisplayList::OpView::GetCount() const
+{
+	// written in network byte order
+	const uint8_t *b = (const uint8_t *)m_payload;
+	return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+}
+
+vsTransform2D
+vsDisplayList::OpView::GetTransform() const
+{
+	return vsTransform2D( vsVector2D( GetFloat(0), GetFloat(4) ), GetFloat(8), vsVector2D( GetFloat(12), GetFloat(16) ) );
+}
+
+void
+vsDisplayList::OpView::GetLight( vsLight *light ) const
+{
+	light->SetType( (vsLight::Type)(uint8_t)m_payload[0] );
+	light->SetPosition( vsVector3D( GetFloat(1), GetFloat(5), GetFloat(9) ) );
+	light->SetDirection( vsVector3D( GetFloat(13), GetFloat(17), GetFloat(21) ) );
+	light->SetColor( vsColor( GetFloat(25), GetFloat(29), GetFloat(33), GetFloat(37) ) );
+	light->SetAmbientColor( vsColor( GetFloat(41), GetFloat(45), GetFloat(49), GetFloat(53) ) );
+	light->SetSpecularColor( vsColor( GetFloat(57), GetFloat(61), GetFloat(65), GetFloat(69) ) );
+}
+
+void
+vsDisplayList::OpView::GetFog( vsFog *fog ) const
+{
+	vsColor color = GetColor();
+	if ( m_payload[16] )
+		fog->SetLinear( color, GetFloat(17), GetFloat(21) );
+	else
+		fog->SetExponential( color, GetFloat(17) );
+}
+
+vsString
+vsDisplayList::OpView::GetString() const
+{
+	size_t length = GetPayloadSize() - sizeof(int16_t);
+	return vsString( m_payload + sizeof(int16_t), length );
+}
+
 void
 vsDisplayList::AppendOp(vsDisplayList::op * o)
 {
@@ -1460,6 +1692,11 @@ vsDisplayList::AppendOp(vsDisplayList::op * o)
 		case OpCode_Debug:
 			Debug( o->data.GetString() );
 			break;
+		case OpCode_CallList:
+			m_fifo->WriteUint8( OpCode_CallList );
+			m_fifo->WriteUint32( o->data.GetUInt() );
+			m_fifo->WriteVoidStar( o->data.p );
+			break;
 		default:
 			break;
 	}
@@ -1928,6 +2165,7 @@ void
 vsDisplayList::ApplyOffset(const vsVector2D &offset)
 {
 	vsAssert( !m_instanceParent, "Tried to apply an offset to an instanced display list!" );
+	WaitUntilUnused();
 
 	vsTransform2D currentTransform;
 
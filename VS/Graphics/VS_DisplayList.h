@@ -23,6 +23,10 @@
 
 #include "VS/Utils/VS_Array.h"
 
+#include "VS/VS_DisableDebugNew.h"
+#include <string.h>
+#include "VS/VS_EnableDebugNew.h"
+
 class vsRecord;
 class vsStore;
 class vsRenderBuffer;
@@ -117,6 +121,8 @@ public:
 
 		OpCode_Debug,
 
+		OpCode_CallList, // runs another display list's ops in place, then carries on with ours.  See CallList().
+
 		OpCode_MAX
 	};
 
@@ -162,11 +168,64 @@ public:
 		Data	data;
 	};
 
+	// OpView is the renderer's lightweight alternative to 'op', returned by
+	// PopOpView().  Instead of copying an op's arguments out of the FIFO, it
+	// points at them, and decodes only the ones it's asked for.  So it's only
+	// valid until the display list is next changed, cleared, or destroyed.
+	//
+	// Arguments are packed without alignment, so they're returned by value
+	// (or copied into the caller's storage);  array data is returned in place,
+	// just as PopOp() does.
+	class OpView
+	{
+		OpCode			m_type;
+		const char *	m_payload;
+
+		float			GetFloat( size_t offset ) const { float f; memcpy( &f, m_payload + offset, sizeof(f) ); return f; }
+		void *			GetPointerAt( size_t offset ) const { void *p; memcpy( &p, m_payload + offset, sizeof(p) ); return p; }
+		size_t			GetPayloadSize() const;
+
+		friend class vsDisplayList;
+
+	public:
+
+		OpCode			GetType() const { return m_type; }
+
+		// the element count of the array ops, SetColors and SetMatrices4x4, or
+		// the number of bytes CallList runs
+		uint32_t		GetCount() const;
+
+		// the object pointed at by pointer ops (buffers, materials, render
+		// targets, shader values, SetColors and SetMatrices4x4), or the
+		// bytes CallList runs
+		void *			GetPointer() const { return GetPointerAt( (m_type == OpCode_SetColors || m_type == OpCode_SetMatrices4x4 || m_type == OpCode_CallList) ? sizeof(uint32_t) : 0 ); }
+		void *			GetPointer2() const { return GetPointerAt( sizeof(void*) ); }	// BlitRenderTarget's destination
+
+		// the array ops' data, which lives inside the display list
+		char *			GetArray() const { return const_cast<char*>(m_payload) + sizeof(uint32_t); }
+
+		vsColor			GetColor() const { return vsColor( GetFloat(0), GetFloat(4), GetFloat(8), GetFloat(12) ); }
+		vsVector3D		GetVector3D() const { return vsVector3D( GetFloat(0), GetFloat(4), GetFloat(8) ); }
+		vsBox2D			GetBox2D() const { return vsBox2D( vsVector2D( GetFloat(0), GetFloat(4) ), vsVector2D( GetFloat(8), GetFloat(12) ) ); }
+		vsTransform2D	GetTransform() const;
+		void			GetMatrix4x4( vsMatrix4x4 *m ) const { memcpy( m, m_payload, sizeof(vsMatrix4x4) ); }
+		void			GetLight( vsLight *light ) const;
+		void			GetFog( vsFog *fog ) const;
+		float			GetFov() const { return GetFloat(0); }
+		float			GetNearPlane() const { return GetFloat(4); }
+		float			GetFarPlane() const { return GetFloat(8); }
+		vsString		GetString() const;
+
+		// Decodes the op starting at 'cursor', and returns where the next one starts.
+		const char *	Read( const char *cursor );
+	};
+
 private:
 
 	vsStore *	m_fifo;
 
 	op  m_currentOp;
+	OpView	m_currentView;
 
 	vsDisplayList *	m_instanceParent;		// if set, I'm an instance of this other vsDisplayList, and contain no actual data myself
 	int				m_instanceCount;		// The number of instances that have been derived off of me.  If this value isn't zero, assert if someone tries to delete me.
@@ -176,6 +235,14 @@ private:
 
 	bool			m_colorSet;
 
+	mutable uint32_t	m_recordedFrame;	// the last frame which called us;  0 if none since we were last cleared
+	mutable uint32_t	m_calledFifo;		// the last s_fifoNumber which called us;  0 if none
+	mutable bool	m_dynamic;		// cleared while a frame still used us, so CallList() copies us instead
+	bool			m_frameLocal;
+	bool			m_static;
+
+	static uint32_t	s_fifoNumber;	// counts FIFOs which have been handed to the renderer
+
 	vsColor			m_cursorColor;
 	vsColor			m_nextLineColor;
 	vsVector3D		m_cursorPos;
@@ -186,6 +253,8 @@ private:
 	static vsDisplayList *	Load_Obj(const vsString &);
 	void					Write_CVec( const vsString &filename );
 
+	void					WaitUntilUnused();
+
 public:
 
 	// for use by vsFragment.
@@ -196,6 +265,7 @@ public:
 
 			vsDisplayList();		// if no memory size is specified, we size dynamically, in 4kb chunks.
 			vsDisplayList(size_t memSize);
+			vsDisplayList(char *buffer, size_t memSize);	// use an external buffer, which must outlive the vsDisplayList
 	virtual	~vsDisplayList();
 
 	vsStore *		GetFifo() { return m_fifo; }
@@ -314,6 +384,43 @@ public:
 
 	void	Append( const vsDisplayList &list );	// appends the passed display list onto us.
 
+	// Like Append(), but records a reference to 'list' instead of copying
+	// it;  the renderer runs its ops in place, then carries on with ours.
+	//
+	// That means that, unlike Append(), 'list' is read when the frame is
+	// rendered, not now.  Only the ops 'list' holds right now are run, so it
+	// may still be added to;  but it mustn't be cleared, changed, or
+	// destroyed before this frame has been submitted, or the frame will draw
+	// whatever it holds by then.  (vsRenderQueue calls static lists during
+	// its Draw(), so that means not touching fragments' lists between
+	// drawing a scene and the end of the frame)  After the frame has been
+	// submitted, clearing or destroying 'list' waits for the render thread to
+	// finish drawing it, just as vsRenderBuffers do.
+	//
+	// Lists which get cleared while a frame is still drawing them, such as
+	// ones rebuilt every frame, are copied instead from then on, so that
+	// rebuilding them doesn't keep waiting for the render thread.  Clearing
+	// or destroying a list before the FIFO which called it has been handed
+	// to the renderer asserts.
+	//
+	// Bounds and stats don't look inside called lists.
+	void	CallList( const vsDisplayList &list );
+
+	// A frame-local list's contents live in the vsFrameArena, and it's only
+	// called from the frame it was recorded in, so it needn't wait for the
+	// render thread before being destroyed.
+	void	SetFrameLocal( bool frameLocal ) { m_frameLocal = frameLocal; }
+
+	// A static list is built once and then left alone, as vsFragments' lists
+	// are, so vsRenderQueue calls it with CallList() instead of copying it.
+	// Other lists are copied, so they may be rebuilt at any time.
+	void	SetStatic( bool isStatic ) { m_static = isStatic; }
+	bool	IsStatic() const { return m_instanceParent ? m_instanceParent->IsStatic() : m_static; }
+
+	// Called by vsScreen after each FIFO has been rendered or submitted to
+	// the render thread;  lists which it called may be changed after this.
+	static void	FifoSubmitted() { s_fifoNumber++; }
+
 	void	EnableStencil();   // turns on stencil testing, cull future rendering to INSIDE stencil
 	void	DisableStencil();  // turns off stencil testing;  no stencils considered.
 	void	ClearStencil();    // clears our stencil so that everything fails.
@@ -333,6 +440,7 @@ public:
 
 	OpCode	PeekOpType();
 	op *	PopOp();
+	const OpView *	PopOpView();	// like PopOp(), but doesn't copy the op's arguments.  NULL at the end of the list.
 	void	AppendOp(op *);
 
 	static const vsString& GetOpCodeString( OpCode code );
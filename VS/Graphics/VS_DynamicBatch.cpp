@@ -15,6 +15,10 @@ vsDynamicBatch::vsDynamicBatch():
 	m_vbo(vsRenderBuffer::Type_Stream),
 	m_ibo(vsRenderBuffer::Type_Stream)
 {
+	// vsDynamicBatchManager doesn't reuse us until the render thread has
+	// finished drawing the frame we were used in.
+	m_vbo.SetFrameLocal(true);
+	m_ibo.SetFrameLocal(true);
 }
 
 void
@@ -9,6 +9,7 @@
 
 #include "VS_DynamicBatchManager.h"
 #include "VS_DynamicBatch.h"
+#include "VS_RenderThread.h"
 
 vsDynamicBatchManager * vsDynamicBatchManager::s_instance = NULL;
 
@@ -22,7 +23,9 @@ vsDynamicBatchManager::vsDynamicBatchManager():
 
 vsDynamicBatchManager::~vsDynamicBatchManager()
 {
-	ResetBatches();
+	vsRenderThread::Sync();
+	ResetBatches(m_retiredBatches);
+	ResetBatches(m_usedBatches);
 
 	vsAssert(s_instance == this, "vsDynamicBatchManager instance isn't me??");
 }
@@ -39,17 +42,29 @@ vsDynamicBatchManager::GetNewBatch()
 void
 vsDynamicBatchManager::FrameRendered()
 {
-	ResetBatches();
+	// If there's a render thread, the frame we just finished recording is
+	// probably still being drawn, so hang onto its batches for one more
+	// frame.  (The render thread never has more than one frame in flight, so
+	// last frame's batches are definitely finished with by now)
+	ResetBatches(m_retiredBatches);
+	if ( vsRenderThread::IsRunning() )
+	{
+		for (int i = 0; i < m_usedBatches.ItemCount(); i++)
+			m_retiredBatches.AddItem(m_usedBatches[i]);
+		m_usedBatches.Clear();
+	}
+	else
+		ResetBatches(m_usedBatches);
 }
 
 void
-vsDynamicBatchManager::ResetBatches()
+vsDynamicBatchManager::ResetBatches( vsArray<vsDynamicBatch*> &batches )
 {
-	for (int i = 0; i < m_usedBatches.ItemCount(); i++)
+	for (int i = 0; i < batches.ItemCount(); i++)
 	{
-		m_usedBatches[i]->Reset();
-		m_unusedBatches.Return(m_usedBatches[i]);
+		batches[i]->Reset();
+		m_unusedBatches.Return(batches[i]);
 	}
-	m_usedBatches.Clear();
+	batches.Clear();
 }
 
@@ -20,8 +20,9 @@ class vsDynamicBatchManager
 
 	vsPool<vsDynamicBatch> m_unusedBatches;
 	vsArray<vsDynamicBatch*> m_usedBatches;
+	vsArray<vsDynamicBatch*> m_retiredBatches;	// used last frame;  may still be being drawn by the render thread
 
-	void ResetBatches();
+	void ResetBatches( vsArray<vsDynamicBatch*> &batches );
 public:
 	static vsDynamicBatchManager* Instance() { return s_instance; }
 
@@ -9,6 +9,7 @@
 
 #include "VS_Entity.h"
 #include "VS_DisplayList.h"
+#include "VS_RenderQueue.h"
 #include "VS_Scene.h"
 #include "VS_Screen.h"
 #include "VS_System.h"
@@ -19,7 +20,8 @@ vsEntity::vsEntity():
 	m_child(NULL),
 	m_visible(true),
 	m_processing(false),
-	m_extractQueued(false)
+	m_extractQueued(false),
+	m_drawCache(NULL)
 {
 	m_next = m_prev = this;
 	m_clickable = true;
@@ -51,6 +53,8 @@ vsEntity::~vsEntity()
 		delete child;
 		child = next;
 	}
+
+	vsDelete( m_drawCache );
 }
 
 void
@@ -86,12 +90,14 @@ vsEntity::AddChild( vsEntity *sprite )
 		m_child->m_prev = sprite;
 
 	m_child = sprite;
+	InvalidateDrawCache();
 }
 
 void
 vsEntity::RemoveChild( vsEntity *sprite )
 {
 	vsAssert( sprite->m_parent == this, "Entity isn't a child of me?" );
+	InvalidateDrawCache();
 	if ( m_child == sprite )
 	{
 		m_child = m_child->m_next;
@@ -139,17 +145,60 @@ vsEntity::DrawChildren( vsRenderQueue *queue )
 {
 	vsEntity *child = m_child;
 
+	// If we're being recorded into a draw cache, the recording gets replayed
+	// wherever the camera is, so don't leave anything out of it.
+	bool cull = !queue->IsRecordingDrawCache();
+
 	while ( child )
 	{
-		if ( child->OnScreen(g_drawingCameraTransform) )
+		if ( !cull || child->OnScreen(g_drawingCameraTransform) )
 		{
-			child->Draw( queue );
+			child->CachedDraw( queue );
 		}
 
 		child = child->m_next;
 	}
 }
 
+void
+vsEntity::CachedDraw( vsRenderQueue *queue )
+{
+	if ( !m_drawCache )
+	{
+		Draw( queue );
+	}
+	else if ( !queue->ReplayDrawCache( m_drawCache ) )
+	{
+		queue->BeginDrawCache( m_drawCache );
+		Draw( queue );
+		queue->EndDrawCache( m_drawCache );
+	}
+}
+
+void
+vsEntity::SetDrawCaching( bool enable )
+{
+	if ( enable && !m_drawCache )
+	{
+		m_drawCache = new vsDrawCache;
+	}
+	else if ( !enable && m_drawCache )
+	{
+		vsDelete( m_drawCache );
+	}
+	InvalidateDrawCache();
+}
+
+void
+vsEntity::InvalidateDrawCache()
+{
+	for ( vsEntity *e = this; e; e = e->m_parent )
+	{
+		if ( e->m_drawCache )
+			e->m_drawCache->Invalidate();
+	}
+}
+
 void
 vsEntity::Draw( vsRenderQueue *queue )
 {
@@ -11,6 +11,7 @@
 #define VS_ENTITY_H
 
 class vsDisplayList;
+class vsDrawCache;
 class vsLayer;
 class vsRenderQueue;
 class vsScene;
@@ -36,6 +37,8 @@ protected:
 	bool			m_processing;
 	bool			m_extractQueued;
 
+	vsDrawCache *	m_drawCache;	// NULL unless SetDrawCaching(true)
+
 	void			DrawChildren( vsRenderQueue *queue );
 
 	void			DoExtract();
@@ -50,6 +53,36 @@ public:
 
 	virtual bool	OnScreen(const vsTransform2D & /*cameraTrans*/) { return true; }
 
+	// Draws via our draw cache, if we have one.  This is how parents and
+	// scenes draw us;  call it instead of Draw() when drawing an entity
+	// yourself.
+	void			CachedDraw( vsRenderQueue *queue );
+
+	// With draw caching on, what we (and our children) drew last frame is
+	// submitted again, without calling Draw(), until something invalidates
+	// it.  vsEntity, vsSprite and vsModel invalidate themselves when their
+	// own setters change their visibility, transform, material, color,
+	// bounding box, fragments, LOD or children, or those of any of their
+	// children.  Anything else which changes what Draw() would produce must
+	// call InvalidateDrawCache() itself;  that includes:
+	//
+	//  - writing to vsSprite::m_transform directly;
+	//  - showing a fragment with vsFragment::SetVisible(true), since
+	//    fragments don't know who draws them.  (Hiding one is picked up)
+	//  - anything which DynamicDraw() does differently from one frame to the
+	//    next, including destroying a list or material it passed to
+	//    vsRenderQueue::AddBatch().
+	//
+	// Entities which draw old-style display lists (through the render
+	// queue's generic list) or instanced batches can't be cached;  they just
+	// draw normally every frame, and so do any parents recording them.
+	//
+	// Children aren't culled while they're being recorded, so turn this on for
+	// small, static things, rather than for the root of a whole level.
+	void			SetDrawCaching( bool enable );
+	bool			IsDrawCaching() const { return m_drawCache != NULL; }
+	void			InvalidateDrawCache();	// ours, and all our parents'
+
 	void			RegisterOnScene(int scene);
 	void			RegisterOnScene(vsScene *scene);
 #if defined(_DEBUG)
@@ -57,7 +90,7 @@ public:
 #endif // _DEBUG
 	void			Unregister() { Extract(); }
 
-	void			SetVisible(bool visible) { m_visible = visible; }
+	void			SetVisible(bool visible) { m_visible = visible; InvalidateDrawCache(); }
 	bool			GetVisible() { return m_visible; }
 	bool			IsVisible() { return GetVisible(); }
 
@@ -349,6 +349,16 @@ vsFragment::SetMaterial( const vsString &name )
 	m_material = new vsMaterial(name);
 }
 
+void
+vsFragment::SetDisplayList( vsDisplayList *list )
+{
+	m_displayList = list;
+	if ( m_displayList )
+		m_displayList->SetStatic(true);
+	m_vbo = NULL;
+	m_ibo = NULL;
+}
+
 void
 vsFragment::SetSimple( vsRenderBuffer *vbo, vsRenderBuffer *ibo, SimpleType type )
 {
@@ -49,7 +49,8 @@ public:
 	void	SetVisible(bool visible) { m_visible = visible; }
 	void	SetMaterial( vsMaterial *material );
 	void	SetMaterial( const vsString &name );
-	void	SetDisplayList( vsDisplayList *list ) { m_displayList = list; m_vbo = NULL; m_ibo = NULL; }
+	// The list is marked static;  don't change it while it might be drawn.
+	void	SetDisplayList( vsDisplayList *list );
 	void	AddBuffer( vsRenderBuffer *buffer );
 	void	Clear();
 
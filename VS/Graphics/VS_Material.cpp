@@ -11,6 +11,7 @@
 #include "VS_MaterialInternal.h"
 #include "VS_Shader.h"
 
+#include "VS_RenderThread.h"
 #include "VS_Texture.h"
 #include "VS_OpenGL.h"
 
@@ -19,7 +20,8 @@ vsMaterial *vsMaterial::White = NULL;
 vsMaterial::vsMaterial():
 	vsCacheReference<vsMaterialInternal>( new vsMaterialInternal ),
 	m_uniformValue(NULL),
-	m_uniformCount(0)
+	m_uniformCount(0),
+	m_recorded(false)
 {
 	SetupParameters();
 }
@@ -27,7 +29,8 @@ vsMaterial::vsMaterial():
 vsMaterial::vsMaterial( const vsString &name ):
 	vsCacheReference<vsMaterialInternal>(name),
 	m_uniformValue(NULL),
-	m_uniformCount(0)
+	m_uniformCount(0),
+	m_recorded(false)
 {
 	SetupParameters();
 }
@@ -35,7 +38,8 @@ vsMaterial::vsMaterial( const vsString &name ):
 vsMaterial::vsMaterial( vsMaterial *other ):
 	vsCacheReference<vsMaterialInternal>(other->GetResource()->GetName()),
 	m_uniformValue(NULL),
-	m_uniformCount(0)
+	m_uniformCount(0),
+	m_recorded(false)
 {
 	SetupParameters();
 	vsAssert( m_uniformCount == other->m_uniformCount, "Shader has changed??" );
@@ -44,6 +48,8 @@ vsMaterial::vsMaterial( vsMaterial *other ):
 
 vsMaterial::~vsMaterial()
 {
+	if ( m_recorded )
+		vsRenderThread::Sync();
 	vsDeleteArray( m_uniformValue );
 }
 
@@ -47,6 +47,7 @@ class vsMaterial : public vsCacheReference<vsMaterialInternal>
 	};
 	Value		*m_uniformValue;
 	int m_uniformCount;
+	bool m_recorded;	// we've been put into a display list
 
 protected:
 	vsMaterial();
@@ -95,6 +96,10 @@ public:
 
 	bool MatchesForBatching( vsMaterial *other ) const;
 
+	// Called by vsDisplayList;  once we've been recorded, destroying this
+	// material waits for the render thread to finish any frame using it.
+	void MarkRecorded() { m_recorded = true; }
+
 	static vsMaterial *	White;
 };
 
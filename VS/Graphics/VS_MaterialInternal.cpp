@@ -42,6 +42,7 @@ static const vsString s_cullString[CULL_MAX] =
 };
 
 static std::atomic<int>	s_codeMaterialCount( 0 );
+static std::atomic<uint32_t>	s_nextSortId( 0 );
 vsMaterialInternal::vsMaterialInternal():
 	vsResource(vsFormatString("CodeMaterial%02d", s_codeMaterialCount++)),
 	m_textureCount(0),
@@ -72,7 +73,8 @@ vsMaterialInternal::vsMaterialInternal():
 	m_postGeneric(false),
 	m_hasColor(true),
 	m_blend(true),
-	m_flags(0)
+	m_flags(0),
+	m_sortId(s_nextSortId++)
 {
 	for ( int i = 0; i < MAX_TEXTURE_SLOTS; i++ )
 	{
@@ -112,7 +114,8 @@ vsMaterialInternal::vsMaterialInternal( const vsString &name ):
 	m_postGeneric(false),
 	m_hasColor(true),
 	m_blend(true),
-	m_flags(0)
+	m_flags(0),
+	m_sortId(s_nextSortId++)
 {
 	for ( int i = 0; i < MAX_TEXTURE_SLOTS; i++ )
 	{
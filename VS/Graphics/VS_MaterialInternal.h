@@ -107,6 +107,8 @@ public:
 
 	int			m_flags;
 
+	uint32_t	m_sortId;	// unique, in creation order;  render queues use it to group draws by material
+
 	vsMaterialInternal(); // no material name;  we'll create our own name instead.
 	vsMaterialInternal( const vsString & name ); // for loading this material from a file
 	vsMaterialInternal( const vsString & textureName, vsDrawMode mode, const vsColor &c, const vsColor &sc = c_black );
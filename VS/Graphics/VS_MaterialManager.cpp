@@ -46,19 +46,10 @@ vsMaterialManager::ReloadAll()
 	// directly any more.
 	vsShader::ReloadAll();
 
-	for ( int b = 0; b < m_bucketCount; b++ )
+	for ( vsResource *r = NextResource(NULL); r; r = NextResource(r) )
 	{
-		vsCacheEntry< vsMaterialInternal > *bucket = &m_bucket[b];
-		while( bucket )
-		{
-			if ( bucket->m_item )
-			{
-				vsMaterialInternal *m = static_cast<vsMaterialInternal*>(bucket->m_item);
-				m->Reload();
-			}
-
-			bucket = bucket->m_next;
-		}
+		vsMaterialInternal *m = static_cast<vsMaterialInternal*>(r);
+		m->Reload();
 	}
 }
 
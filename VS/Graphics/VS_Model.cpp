@@ -19,6 +19,7 @@
 #include "VS_Record.h"
 #include "VS_Serialiser.h"
 #include "VS_Store.h"
+#include "VS_InlineArray.h"
 
 
 vsModel *
@@ -437,6 +438,7 @@ vsModel::SetDisplayList( vsDisplayList *list )
 	m_displayList = list;
 
 	BuildBoundingBox();
+	InvalidateDrawCache();
 }
 
 void
@@ -445,6 +447,7 @@ vsModel::AddLodFragment( int lodLevel, vsFragment *fragment )
 	vsAssert((int)lodLevel < m_lod.ItemCount(), "Tried to add a fragment to a non-existant lod??");
 	if ( fragment )
 		m_lod[lodLevel]->fragment.AddItem( fragment );
+	InvalidateDrawCache();
 }
 
 void
@@ -452,12 +455,14 @@ vsModel::DestroyFragment( vsFragment *fragment )
 {
 	for ( int i = 0; i < m_lod.ItemCount(); i++ )
 		m_lod[i]->fragment.RemoveItem( fragment );
+	InvalidateDrawCache();
 }
 
 void
 vsModel::ClearFragments()
 {
 	m_lod[0]->fragment.Clear();
+	InvalidateDrawCache();
 }
 
 void
@@ -617,6 +622,7 @@ vsModel::SetLodCount(int count)
 	vsAssert(count > 0, "Zero-LOD vsModels are not supported");
 	m_lod.SetArraySize(count);
 	m_lodLevel = vsMin(m_lodLevel, count-1);
+	InvalidateDrawCache();
 }
 
 int
@@ -631,8 +637,9 @@ vsModel::CollideRay(vsVector3D *result, float *resultT, const vsVector3D &pos, c
 	vsVector3D localPos = m_transform.ApplyInverseTo(pos);
 	vsVector3D localDir = m_transform.GetRotation().Inverse().ApplyTo(dir);
 
-	// now we need to collision test against all our triangles.
-	vsArray<vsDisplayList::Triangle> triangles;
+	// now we need to collision test against all our triangles.  Small
+	// collision meshes fit on the stack;  only big ones need the heap.
+	vsInlineArray<vsDisplayList::Triangle,64> triangles;
 	if ( m_displayList )
 		m_displayList->GetTriangles(triangles);
 	for ( int i = 0; i < GetFragmentCount(); i++ )
@@ -68,31 +68,31 @@ public:
 	void RemoveInstance( vsModelInstance *model );
 	void			UpdateInstance( vsModelInstance *, bool show = true ); // must be called to change the matrix on this instance
 
-	void			SetMaterial( const vsString &name ) { vsDelete( m_material ); m_material = new vsMaterial(name); }
-	void			SetMaterial( vsMaterial *material ) { vsDelete( m_material ); m_material = material; }
+	void			SetMaterial( const vsString &name ) { vsDelete( m_material ); m_material = new vsMaterial(name); InvalidateDrawCache(); }
+	void			SetMaterial( vsMaterial *material ) { vsDelete( m_material ); m_material = material; InvalidateDrawCache(); }
 	vsMaterial *	GetMaterial() { return m_material; }
 
-	virtual void		SetPosition( const vsVector3D &pos ) { m_transform.SetTranslation( pos ); }
+	virtual void		SetPosition( const vsVector3D &pos ) { m_transform.SetTranslation( pos ); InvalidateDrawCache(); }
 	const vsVector3D &	GetPosition() const { return m_transform.GetTranslation(); }
 
-	virtual void			SetOrientation( const vsQuaternion &quat ) { m_transform.SetRotation( quat ); }
+	virtual void			SetOrientation( const vsQuaternion &quat ) { m_transform.SetRotation( quat ); InvalidateDrawCache(); }
 	const vsQuaternion &	GetOrientation() const { return m_transform.GetRotation(); }
 
 	const vsMatrix4x4 &		GetMatrix() const { return m_transform.GetMatrix(); }
 
 	const vsVector3D &		GetScale() const { return m_transform.GetScale(); }
-	void					SetScale( const vsVector3D &s ) { m_transform.SetScale(s); }
-	void					SetScale( float s ) { m_transform.SetScale(s); }
+	void					SetScale( const vsVector3D &s ) { m_transform.SetScale(s); InvalidateDrawCache(); }
+	void					SetScale( float s ) { m_transform.SetScale(s); InvalidateDrawCache(); }
 
 	const vsBox3D &			GetBoundingBox() const { return m_boundingBox; }
-	void					SetBoundingBox(const vsBox3D &box) { m_boundingBox = box; }
+	void					SetBoundingBox(const vsBox3D &box) { m_boundingBox = box; InvalidateDrawCache(); }
 	void					BuildBoundingBox();
 
 	vsDisplayList::Stats	CalculateStats();
 
 	float					GetBoundingRadius() { return m_boundingRadius; }
 
-	void				SetTransform( const vsTransform3D &t ) { m_transform = t; }
+	void				SetTransform( const vsTransform3D &t ) { m_transform = t; InvalidateDrawCache(); }
 	const vsTransform3D&	GetTransform() const { return m_transform; }
 
 	void			SetDisplayList( vsDisplayList *list );
@@ -108,7 +108,7 @@ public:
 	vsFragment *	GetLodFragment(int lodId, int fragmentId) { return m_lod[lodId]->fragment[fragmentId]; }
 	const vsFragment *	GetLodFragment(int lodId, int fragmentId) const { return m_lod[lodId]->fragment[fragmentId]; }
 	void			SetLodCount(int count);
-	void			SetLodLevel(int level) { m_lodLevel = level; }
+	void			SetLodLevel(int level) { if ( level != m_lodLevel ) { m_lodLevel = level; InvalidateDrawCache(); } }
 	int				GetLodLevel() { return m_lodLevel; }
 	void			AddLodFragment( int lodId, vsFragment *fragment );
 
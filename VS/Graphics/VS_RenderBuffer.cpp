@@ -10,6 +10,7 @@
 #include "VS_RenderBuffer.h"
 
 #include "VS_RendererState.h"
+#include "VS_RenderThread.h"
 
 #include "VS_OpenGL.h"
 #include "VS_Profile.h"
@@ -41,7 +42,9 @@ vsRenderBuffer::vsRenderBuffer(vsRenderBuffer::Type type):
     m_contentType(ContentType_Custom),
     m_bufferID(-1),
     m_vbo(false),
-    m_bindType(BindType_Array)
+    m_bindType(BindType_Array),
+	m_recorded(false),
+	m_frameLocal(false)
 {
 	vsAssert( sizeof( uint16_t ) == 2, "I've gotten the size wrong??" );
 
@@ -57,6 +60,7 @@ vsRenderBuffer::vsRenderBuffer(vsRenderBuffer::Type type):
 
 vsRenderBuffer::~vsRenderBuffer()
 {
+	WaitUntilUnused();
 	if ( m_vbo )
 	{
 		glDeleteBuffers( 1, (GLuint*)&m_bufferID );
@@ -67,6 +71,13 @@ vsRenderBuffer::~vsRenderBuffer()
 	}
 }
 
+void
+vsRenderBuffer::WaitUntilUnused()
+{
+	if ( m_recorded && !m_frameLocal )
+		vsRenderThread::Sync();
+}
+
 void
 vsRenderBuffer::ResizeArray( int size )
 {
@@ -83,6 +94,7 @@ vsRenderBuffer::SetActiveSize( int size )
 void
 vsRenderBuffer::SetArraySize_Internal( int size )
 {
+	WaitUntilUnused();
 	if ( m_array && size > m_arrayBytes )
 	{
 		vsDeleteArray( m_array );
@@ -115,6 +127,7 @@ void
 vsRenderBuffer::SetArray_Internal( char *data, int size, vsRenderBuffer::BindType bindType )
 {
 	vsAssert( size, "Error:  Tried to set a zero-length GPU buffer!" );
+	WaitUntilUnused();
 
 	int bindPoints[BindType_MAX] =
 	{
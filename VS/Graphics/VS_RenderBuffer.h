@@ -87,6 +87,10 @@ private:
 	bool			m_vbo;
 	BindType		m_bindType;
 
+	mutable bool	m_recorded;		// we've been put into a display list
+	bool			m_frameLocal;
+
+	void	WaitUntilUnused();
 	void	SetArray_Internal( char *data, int bytes, BindType bindType);
 	void	SetArraySize_Internal( int bytes );
 	void	ResizeArray_Internal( int bytes ); // like the above, but retain saved array data.
@@ -247,6 +251,16 @@ public:
 
 	const bool IsVBO() { return m_vbo; }
 
+	// Called by vsDisplayList when it records a reference to us.  Once that's
+	// happened, changing or destroying this buffer waits for the render
+	// thread (if there is one) to finish any frame which might be using it.
+	void	MarkRecorded() const { m_recorded = true; }
+
+	// A frame-local buffer is only drawn in the frame it's filled, and its
+	// owner promises not to refill or destroy it until that frame has been
+	// rendered, so we don't need to wait for the render thread.
+	void	SetFrameLocal( bool frameLocal ) { m_frameLocal = frameLocal; }
+
 
 	// Advanced interface;  TODO is to figure out whether there's a nicer
 	// way to provide this kind of functionality.
@@ -14,6 +14,7 @@ class vsDisplayList;
 class vsRenderPipelineStage;
 
 #include "Utils/VS_Array.h"
+#include "Utils/VS_InlineArray.h"
 #include "Utils/VS_ArrayStore.h"
 #include "VS_RenderTarget.h"
 
@@ -64,7 +65,7 @@ struct RenderTargetRequest
 class RenderTargetRegistration
 {
 	vsRenderTarget *target;
-	vsArray<vsRenderPipelineStage*> user;
+	vsInlineArray<vsRenderPipelineStage*,4> user;
 	RenderTargetRequest request;
 
 public:
@@ -8,8 +8,16 @@
  */
 
 #include "VS_RenderPipelineStageScenes.h"
+#include "VS_Camera.h"
 #include "VS_Renderer.h"
 #include "VS_Scene.h"
+#include "VS_System.h"
+#include "VS/Threads/VS_JobSystem.h"
+#include "VS/Utils/VS_Profile.h"
+
+// smallest list we'll give a scene for parallel recording, however little it
+// has recorded so far.
+const size_t c_minSceneListSize = 1024 * 64;
 
 vsRenderPipelineStageScenes::vsRenderPipelineStageScenes( vsScene *scene, vsRenderTarget *target, const vsRenderer::Settings& settings, bool clear, vsCamera3D *customCamera ):
 	m_scene(new vsScene*[1]),
@@ -17,7 +25,11 @@ vsRenderPipelineStageScenes::vsRenderPipelineStageScenes( vsScene *scene, vsRend
 	m_target(target),
 	m_settings(settings),
 	m_customCamera(customCamera),
-	m_clear(clear)
+	m_clear(clear),
+	m_parallel(false),
+	m_sceneList(NULL),
+	m_sceneHighWater(NULL),
+	m_sceneCameraTransform(NULL)
 {
 	m_scene[0] = scene;
 }
@@ -28,7 +40,11 @@ vsRenderPipelineStageScenes::vsRenderPipelineStageScenes( vsScene **scenes, int
 	m_target(target),
 	m_settings(settings),
 	m_customCamera(customCamera),
-	m_clear(clear)
+	m_clear(clear),
+	m_parallel(false),
+	m_sceneList(NULL),
+	m_sceneHighWater(NULL),
+	m_sceneCameraTransform(NULL)
 {
 	for ( int i = 0; i < sceneCount; i++ )
 	{
@@ -38,35 +54,134 @@ vsRenderPipelineStageScenes::vsRenderPipelineStageScenes( vsScene **scenes, int
 
 vsRenderPipelineStageScenes::~vsRenderPipelineStageScenes()
 {
+	if ( m_sceneList )
+	{
+		for ( int i = 0; i < m_sceneCount; i++ )
+			vsDelete( m_sceneList[i] );
+		vsDeleteArray( m_sceneList );
+	}
+	vsDeleteArray( m_sceneHighWater );
+	vsDeleteArray( m_sceneCameraTransform );
 	vsDeleteArray(m_scene);
 }
 
+void
+vsRenderPipelineStageScenes::DrawScene( int i, vsDisplayList *list )
+{
+	if ( !m_scene[i] )
+		return;
+
+	if ( m_customCamera && m_scene[i]->Is3D() )
+	{
+		vsCamera3D *cam = m_scene[i]->GetCamera3D();
+		bool reference = m_scene[i]->CameraIsReference();
+		m_scene[i]->SetCamera3D(m_customCamera);
+		m_scene[i]->Draw( list );
+		m_scene[i]->SetCamera3D(cam, reference);
+	}
+	else
+	{
+		m_scene[i]->Draw( list );
+	}
+}
+
+bool
+vsRenderPipelineStageScenes::CanDrawInParallel()
+{
+	if ( !m_parallel || m_sceneCount < 2 || !vsJobSystem::Exists() )
+		return false;
+	if ( vsSystem::Instance()->GetPreferences()->GetDynamicBatching() )
+		return false;
+
+	// A scene which appears twice would be recorded by two threads at once.
+	for ( int i = 0; i < m_sceneCount; i++ )
+		for ( int j = i+1; j < m_sceneCount; j++ )
+			if ( m_scene[i] && m_scene[i] == m_scene[j] )
+				return false;
+	return true;
+}
+
+void
+vsRenderPipelineStageScenes::SizeSceneLists( size_t maxSize )
+{
+	// Keep every scene's list at least twice as big as anything that scene
+	// has recorded.  Lists only grow, and only between frames.
+	for ( int i = 0; i < m_sceneCount; i++ )
+	{
+		size_t size = vsMin( vsMax( c_minSceneListSize, m_sceneHighWater[i] * 2 ), maxSize );
+		if ( m_sceneList[i] && m_sceneList[i]->GetMaxSize() >= size )
+			continue;
+		vsDelete( m_sceneList[i] );
+		m_sceneList[i] = new vsDisplayList( size );
+	}
+}
+
 void
 vsRenderPipelineStageScenes::Draw( vsDisplayList *list )
 {
 	list->SetRenderTarget( m_target );
 	if ( m_clear )
 		list->ClearRenderTarget();
-	for ( int i = 0; i < m_sceneCount; i++ )
+
+	bool parallel = CanDrawInParallel();
+	if ( parallel && !m_sceneList )
 	{
-		if ( m_scene[i] )
+		// First time through, record serially and note how much each scene
+		// wrote, so we know how big to make its list.
+		m_sceneList = new vsDisplayList*[m_sceneCount];
+		m_sceneHighWater = new size_t[m_sceneCount];
+		m_sceneCameraTransform = new vsTransform2D[m_sceneCount];
+		for ( int i = 0; i < m_sceneCount; i++ )
+		{
+			size_t before = list->GetSize();
+			DrawScene( i, list );
+			m_sceneList[i] = NULL;
+			m_sceneHighWater[i] = list->GetSize() - before;
+		}
+		SizeSceneLists( list->GetMaxSize() );
+	}
+	else if ( parallel )
+	{
+		// 2D scenes set g_drawingCameraTransform, and 3D scenes' entities
+		// just use whatever the previous scene left there.  It's per-thread,
+		// so hand each scene the value it would have seen when drawn serially.
+		vsTransform2D cameraTransform = g_drawingCameraTransform;
+		for ( int i = 0; i < m_sceneCount; i++ )
+		{
+			m_sceneCameraTransform[i] = cameraTransform;
+			if ( m_scene[i] && m_scene[i]->IsEnabled() && !m_scene[i]->Is3D() )
+				cameraTransform = m_scene[i]->GetCamera()->GetCameraTransform();
+		}
+
+		vsJobSystem::Instance()->ParallelFor( m_sceneCount, 1, [this]( int i )
 		{
-			vsCamera3D *cam = NULL;
-			bool reference;
-			if ( m_customCamera && m_scene[i]->Is3D() )
-			{
-				cam = m_scene[i]->GetCamera3D();
-				reference = m_scene[i]->CameraIsReference();
-				m_scene[i]->SetCamera3D(m_customCamera);
-				m_scene[i]->Draw( list );
-				m_scene[i]->SetCamera3D(cam, reference);
-			}
-			else
-			{
-				m_scene[i]->Draw( list );
-			}
+			PROFILE("RecordScene");
+			g_drawingCameraTransform = m_sceneCameraTransform[i];
+			m_sceneList[i]->Clear();
+			DrawScene( i, m_sceneList[i] );
+		});
+
+		PROFILE("StitchScenes");
+		size_t total = 0;
+		for ( int i = 0; i < m_sceneCount; i++ )
+		{
+			size_t size = m_sceneList[i]->GetSize();
+			m_sceneHighWater[i] = vsMax( m_sceneHighWater[i], size );
+			total += size;
 		}
+		vsAssert( total <= list->GetMaxSize() - list->GetSize(), "Parallel scene recording overflowed the display list!" );
+
+		for ( int i = 0; i < m_sceneCount; i++ )
+			list->Append( *m_sceneList[i] );
+		g_drawingCameraTransform = cameraTransform;
+
+		SizeSceneLists( list->GetMaxSize() );
+	}
+	else
+	{
+		for ( int i = 0; i < m_sceneCount; i++ )
+			DrawScene( i, list );
 	}
+
 	list->ResolveRenderTarget( m_target );
 }
-
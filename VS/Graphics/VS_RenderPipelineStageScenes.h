@@ -14,6 +14,7 @@
 #include "VS_Renderer.h"
 
 class vsCamera3D;
+class vsTransform2D;
 class vsDisplayList;
 class vsScene;
 class vsRenderTarget;
@@ -26,12 +27,40 @@ class vsRenderPipelineStageScenes: public vsRenderPipelineStage
 	vsRenderer::Settings m_settings;
 	vsCamera3D *m_customCamera;
 	bool m_clear;
+
+	bool m_parallel;
+	vsDisplayList **m_sceneList;	// one per scene, for parallel recording;  created on first use
+	size_t *m_sceneHighWater;		// the most bytes each scene has ever recorded
+	vsTransform2D *m_sceneCameraTransform;	// g_drawingCameraTransform as each scene would find it, if recorded serially
+
+	void DrawScene( int i, vsDisplayList *list );
+	bool CanDrawInParallel();
+	void SizeSceneLists( size_t maxSize );
 public:
 	vsRenderPipelineStageScenes( vsScene *scene, vsRenderTarget *target, const vsRenderer::Settings& settings, bool clear, vsCamera3D *customCamera = NULL );
 	vsRenderPipelineStageScenes( vsScene **scenes, int sceneCount, vsRenderTarget *target, const vsRenderer::Settings& settings, bool clear, vsCamera3D *customCamera = NULL );
 	virtual ~vsRenderPipelineStageScenes();
 
 	virtual void Draw( vsDisplayList *list );
+
+	// If set, each of our scenes is recorded into a display list of its own,
+	// on the job system's threads, and those lists are then appended to the
+	// pipeline's list in scene order;  the result is exactly what serial
+	// recording would have produced.
+	//
+	// Only turn this on if recording our scenes doesn't touch anything they
+	// share:  no entity may be in more than one of our scenes, and entities'
+	// Draw() functions mustn't create or upload GPU resources, since job
+	// threads have no OpenGL context.  (Dynamic batching uploads while
+	// recording, so when it's enabled, we quietly record serially instead.)
+	//
+	// The first frame is recorded serially, to measure how much each scene
+	// writes;  after that, each scene's list is kept at twice that scene's
+	// high water mark (and grown between frames as that rises), so a scene
+	// which suddenly records far more than it ever has before can still
+	// overflow its list.  It's meant for stages with several busy scenes.
+	void SetParallelRecording( bool parallel ) { m_parallel = parallel; }
+	bool IsParallelRecording() const { return m_parallel; }
 };
 
 #endif // VS_RENDERPIPELINESTAGESCENES_H
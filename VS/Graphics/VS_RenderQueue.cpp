@@ -18,37 +18,110 @@
 #include "VS_DynamicBatchManager.h"
 
 #include "VS_MaterialInternal.h"
-
-#include "VS/VS_DisableDebugNew.h"
-#include <map>
-#include "VS/VS_EnableDebugNew.h"
+#include "VS_Shader.h"
+#include "VS_Texture.h"
+#include "VS_TextureInternal.h"
+
+#include "VS/Memory/VS_FrameArena.h"
+
+// Each element a stage draws gets a 64-bit sort key, and the stage draws its
+// elements in key order.  The top of the key is always:
+//
+//   8 bits:  material layer, biased so that negative layers sort first.
+//            Layers are still the way to control draw order, and must be
+//            in [-128..127].
+//   1 bit:   set for blended materials, so they draw after unblended ones
+//            in the same layer.
+//
+// The rest of an unblended element's key is its 32-bit render state and
+// then its 23-bit view-space depth.  The render state is:
+//
+//  10 bits:  shader (the GL program, or which default shader will be used).
+//  10 bits:  a hash of the material's textures.
+//  12 bits:  the material's sort ID.
+//
+// so unblended elements sort by state and then by depth, nearest first,
+// which groups together draws which share a shader, textures, and material,
+// so the renderer changes less state between them, and mostly draws the
+// nearest of each group first, to save on overdraw.
+//
+// Blended elements have to be drawn back to front to look right, and
+// regrouping them by state would change what they look like, so the rest of
+// their key is their depth, farthest first, and then the order in which they
+// were added to the stage.  In 2D scenes, where everything has depth zero,
+// that's plain painter's order within each layer.
+//
+// Shader and texture fields are derived from GL object names, and materials
+// from their creation order, so draw order doesn't depend on where anything
+// happens to be in memory.  The fields are truncated hashes;  when two
+// different things collide, we just get a few more state changes.  Elements
+// with equal keys draw in the order they were added.
+#define SORT_LAYER_SHIFT		(56)
+#define SORT_TRANSLUCENT_SHIFT	(55)
+#define SORT_OPAQUE_STATE_SHIFT	(23)
+#define SORT_TRANSLUCENT_DEPTH_SHIFT	(32)
+#define SORT_LAYER_MIN			(-128)
+#define SORT_LAYER_MAX			(127)
+
+#define SORT_STATE_SHADER_SHIFT		(22)
+#define SORT_STATE_TEXTURE_SHIFT	(12)
+#define SORT_STATE_SHADER_MASK		(0x3ff)
+#define SORT_STATE_TEXTURE_MASK		(0x3ff)
+#define SORT_STATE_MATERIAL_MASK	(0xfff)
+
+#define SORT_DEPTH_MAX			(0x7fffff)
+
+// the renderer only binds this many texture slots.
+#define SORT_TEXTURE_SLOTS		(16)
+
+// below this many elements, an insertion sort beats the radix sort.
+#define SORT_INSERTION_LIMIT	(64)
 
 class vsRenderQueueStage
 {
 public:
-	struct BatchMap;
 	struct BatchElement;
-	struct Batch;
+	struct SortEntry;
+	struct MaterialSlot;
 private:
 
-	BatchMap*			m_batchMap;
-	Batch*				m_batch;
-	int					m_batchCount;
+	vsArray<BatchElement*>	m_element;
+
+	// For dynamic batching, we need to find earlier simple elements which
+	// used the same material.  This is a small open-addressed table from
+	// material to the most recent such element;  each element links to the
+	// one before it.  It's emptied every frame.
+	MaterialSlot *		m_materialSlot;
+	int					m_materialSlotCount;	// always a power of two
+	int					m_materialSlotUsed;
+
+	// BatchElements and temporary display lists live in the frame arena;  we
+	// just need to remember to destroy the display lists when we're done.
+	vsArray<vsDisplayList*>	m_temporaryLists;
 
-	Batch *				m_batchPool;
-	BatchElement * 		m_batchElementPool;
+	vsRenderQueue::Stats	m_stats;
 
-	vsLinkedListStore<vsDisplayList>	m_temporaryLists;
+	const vsMatrix4x4 *	m_worldToView;	// NULL if we're not depth sorting
 
-	Batch *			FindBatch( vsMaterial *material );
+	BatchElement *	AllocElement( vsMaterial *material, const vsMatrix4x4 *matrix );
+	MaterialSlot *	FindMaterialSlot( vsMaterialInternal *material );
+	void			GrowMaterialSlots();
 
+	uint32_t			CalculateDepth( const vsMatrix4x4 *matrix );
+	static uint32_t		CalculateState( vsMaterialInternal *material );
+	static uint64_t		CalculateSortKey( vsMaterialInternal *material, uint32_t state, uint32_t depth, uint32_t sequence );
+	static SortEntry *	Sort( SortEntry *entry, SortEntry *scratch, int count );
 
 public:
 
 	vsRenderQueueStage();
 	~vsRenderQueueStage();
 
-	void			StartRender();
+	// Blended elements are sorted back to front, and unblended ones (mostly)
+	// front to back, by the depth of their matrix's origin as transformed
+	// by 'worldToView'.  If it's NULL, as for 2D scenes, elements aren't
+	// sorted by depth.
+	void			StartRender( const vsMatrix4x4 *worldToView );
 	void			Draw( vsDisplayList *list );	// write our batches into here.
 	void			EndRender();
 
@@ -65,6 +138,8 @@ public:
 
 	// For stuff which really doesn't want to keep its display list around, call this to get a temporary display list.
 	vsDisplayList *	MakeTemporaryBatchList( vsMaterial *material, const vsMatrix4x4 &matrix, int size );
+
+	const vsRenderQueue::Stats &	GetStats() const { return m_stats; }
 };
 
 
@@ -82,7 +157,10 @@ struct vsRenderQueueStage::BatchElement
 	vsRenderBuffer *vbo;
 	vsRenderBuffer *ibo;
 	vsFragment::SimpleType simpleType;
-	BatchElement *	next;
+	uint64_t		sortKey;
+	uint32_t		state;			// see CalculateState()
+	uint32_t		depth;			// see CalculateDepth()
+	BatchElement *	previousSimple;	// the previous simple element with the same material, for dynamic batching
 
 	vsDynamicBatch * batch;
 
@@ -97,173 +175,178 @@ struct vsRenderQueueStage::BatchElement
 		list(NULL),
 		vbo(NULL),
 		ibo(NULL),
-		next(NULL),
+		sortKey(0),
+		state(0),
+		depth(0),
+		previousSimple(NULL),
 		batch(NULL)
 	{
 	}
 
-	void Clear()
-	{
-		material = NULL;
-		shaderValues = NULL;
-		instanceMatrix = NULL;
-		instanceMatrixCount = 0;
-		instanceMatrixBuffer = NULL;
-		instanceColorBuffer = NULL;
-		instanceColor = NULL;
-		list = NULL;
-		vbo = NULL;
-		ibo = NULL;
-		batch = NULL;
-	}
-
 };
 
-struct vsRenderQueueStage::Batch
+struct vsRenderQueueStage::SortEntry
 {
-	vsMaterialInternal*	material;
-	BatchElement*		elementList;
-	Batch*				next;
-
-	Batch();
-	~Batch();
+	uint64_t		key;
+	BatchElement *	element;
 };
 
-struct vsRenderQueueStage::BatchMap
+struct vsRenderQueueStage::MaterialSlot
 {
-	std::map<vsMaterialInternal*,vsRenderQueueStage::Batch*> map;
+	vsMaterialInternal *	material;
+	BatchElement *			lastSimple;
 };
 
-vsRenderQueueStage::Batch::Batch():
-	material(NULL),
-	elementList(NULL),
-	next(NULL)
+vsRenderQueueStage::vsRenderQueueStage():
+	m_materialSlot(NULL),
+	m_materialSlotCount(0),
+	m_materialSlotUsed(0),
+	m_worldToView(NULL)
 {
 }
 
-vsRenderQueueStage::Batch::~Batch()
+vsRenderQueueStage::~vsRenderQueueStage()
 {
+	vsDeleteArray( m_materialSlot );
 }
 
-vsRenderQueueStage::vsRenderQueueStage():
-	m_batchMap(new BatchMap),
-	m_batch(NULL),
-	m_batchCount(0),
-	m_batchPool(NULL),
-	m_batchElementPool(NULL)
+uint32_t
+vsRenderQueueStage::CalculateDepth( const vsMatrix4x4 *matrix )
 {
+	if ( !m_worldToView || !matrix )
+		return 0;
+
+	float z = m_worldToView->ApplyTo( vsVector3D( matrix->w.x, matrix->w.y, matrix->w.z ) ).z;
+	if ( !(z > 0.f) )	// behind the camera, or NaN
+		return 0;
+
+	// Positive floats sort the same way as their bit patterns, so keep the
+	// exponent and the top of the mantissa;  that's about five significant
+	// digits at any distance.
+	uint32_t bits;
+	memcpy( &bits, &z, sizeof(bits) );
+	return vsMin( bits >> 8, (uint32_t)SORT_DEPTH_MAX );
 }
 
-vsRenderQueueStage::~vsRenderQueueStage()
+uint32_t
+vsRenderQueueStage::CalculateState( vsMaterialInternal *material )
 {
-	vsDelete( m_batchMap );
-	while( m_batchPool )
-	{
-		Batch *b = m_batchPool;
-		m_batchPool = m_batchPool->next;
-		vsDelete(b);
-	}
-	while( m_batchElementPool )
+	// Materials without a shader of their own get one of the renderer's
+	// defaults, chosen by draw mode and whether they're textured.
+	uint32_t shader;
+	if ( material->m_shader )
+		shader = material->m_shader->GetShaderId() + 4;
+	else
+		shader = (material->m_drawMode == DrawMode_Lit ? 2 : 0) + (material->m_texture[0] ? 1 : 0);
+
+	uint32_t textures = 0;
+	for ( int i = 0; i < SORT_TEXTURE_SLOTS; i++ )
 	{
-		BatchElement *e = m_batchElementPool;
-		m_batchElementPool = m_batchElementPool->next;
-		vsDelete(e);
+		vsTexture *t = material->m_texture[i];
+		if ( t )
+			textures = (textures ^ (t->GetResource()->GetTexture() + i)) * 0x9E3779B1u;
 	}
+	textures ^= textures >> 16;
+
+	return ((shader & SORT_STATE_SHADER_MASK) << SORT_STATE_SHADER_SHIFT) |
+		((textures & SORT_STATE_TEXTURE_MASK) << SORT_STATE_TEXTURE_SHIFT) |
+		(material->m_sortId & SORT_STATE_MATERIAL_MASK);
 }
 
-vsRenderQueueStage::Batch *
-vsRenderQueueStage::FindBatch( vsMaterial *material )
+uint64_t
+vsRenderQueueStage::CalculateSortKey( vsMaterialInternal *material, uint32_t state, uint32_t depth, uint32_t sequence )
 {
-	std::map<vsMaterialInternal*, vsRenderQueueStage::Batch*>::iterator it = m_batchMap->map.find(material->GetResource());
-	if ( it != m_batchMap->map.end() )
+	vsAssert( material->m_layer >= SORT_LAYER_MIN && material->m_layer <= SORT_LAYER_MAX,
+			vsFormatString("Material layer %d is outside [%d..%d];  it would draw in the wrong order", material->m_layer, SORT_LAYER_MIN, SORT_LAYER_MAX) );
+	uint64_t key = (uint64_t)(vsClamp( SORT_LAYER_MIN, material->m_layer, SORT_LAYER_MAX ) - SORT_LAYER_MIN) << SORT_LAYER_SHIFT;
+
+	if ( material->m_blend )
 	{
-		return it->second;
+		key |= (uint64_t)1 << SORT_TRANSLUCENT_SHIFT;
+		key |= (uint64_t)(SORT_DEPTH_MAX - depth) << SORT_TRANSLUCENT_DEPTH_SHIFT;
+		key |= sequence;
 	}
-
-	if ( !m_batchPool )
+	else
 	{
-		m_batchPool = new Batch;
+		key |= (uint64_t)state << SORT_OPAQUE_STATE_SHIFT;
+		key |= depth;
 	}
-	Batch *batch = m_batchPool;
-	m_batchPool = batch->next;
-	batch->next = NULL;
-	batch->material = material->GetResource();
+	return key;
+}
+
+vsRenderQueueStage::BatchElement *
+vsRenderQueueStage::AllocElement( vsMaterial *material, const vsMatrix4x4 *matrix )
+{
+	BatchElement *element = vsFrameArena::Instance()->New<BatchElement>();
+	element->material = material;
+	element->state = CalculateState( material->GetResource() );
+	element->depth = CalculateDepth( matrix );
+	element->sortKey = CalculateSortKey( material->GetResource(), element->state, element->depth, (uint32_t)m_element.ItemCount() );
+	m_element.AddItem( element );
+	return element;
+}
 
-	// insert this batch into our batch list, SORTED.
-	bool inserted = false;
+vsRenderQueueStage::MaterialSlot *
+vsRenderQueueStage::FindMaterialSlot( vsMaterialInternal *material )
+{
+	if ( (m_materialSlotUsed+1) * 2 > m_materialSlotCount )
+		GrowMaterialSlots();
 
-	if ( m_batch == NULL )
+	uint32_t mask = m_materialSlotCount - 1;
+	uint32_t i = material->m_sortId * 0x9E3779B1u;
+	for ( i &= mask; ; i = (i+1) & mask )
 	{
-		m_batch = batch;
-	}
-	else
-	{
-		if ( m_batch->material->m_layer > material->GetResource()->m_layer )
+		MaterialSlot *slot = &m_materialSlot[i];
+		if ( slot->material == material )
+			return slot;
+		if ( slot->material == NULL )
 		{
-			// we should sort before the first thing in the batch list.
-			batch->next = m_batch;
-			m_batch = batch;
-			inserted = true;
-		}
-		else
-		{
-			Batch *lb;
-			for(lb = m_batch; lb->next; lb = lb->next)
-			{
-				if ( lb->next->material->m_layer > material->GetResource()->m_layer )
-				{
-					batch->next = lb->next;
-					lb->next = batch;
-					inserted = true;
-					break;
-				}
-			}
-
-			if ( !inserted )
-			{
-				lb->next = batch;
-			}
+			slot->material = material;
+			m_materialSlotUsed++;
+			return slot;
 		}
 	}
-	m_batchCount++;
-	m_batchMap->map[material->GetResource()] = batch;
-
-	return batch;
 }
 
-
 void
-vsRenderQueueStage::AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisplayList *batchList )
+vsRenderQueueStage::GrowMaterialSlots()
 {
-	Batch *batch = FindBatch(material);
+	MaterialSlot *old = m_materialSlot;
+	int oldCount = m_materialSlotCount;
 
-	if ( !m_batchElementPool )
+	m_materialSlotCount = vsMax( 64, oldCount * 2 );
+	m_materialSlot = new MaterialSlot[m_materialSlotCount];
+	memset( m_materialSlot, 0, sizeof(MaterialSlot) * m_materialSlotCount );
+	m_materialSlotUsed = 0;
+
+	for ( int i = 0; i < oldCount; i++ )
 	{
-		m_batchElementPool = new BatchElement;
+		if ( old[i].material )
+			FindMaterialSlot( old[i].material )->lastSimple = old[i].lastSimple;
 	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
+	vsDeleteArray( old );
+}
+
+void
+vsRenderQueueStage::AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisplayList *batchList )
+{
+	BatchElement *element = AllocElement( material, &matrix );
 
-	element->material = material;
 	element->matrix = matrix;
 	element->list = batchList;
 	element->instanceMatrix = NULL;
 	element->instanceMatrixBuffer = NULL;
 	element->instanceColorBuffer = NULL;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 
 void
 vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsRenderBuffer* vbo, vsRenderBuffer* ibo, vsFragment::SimpleType simpleType)
 {
-	Batch *batch = FindBatch(material);
+	MaterialSlot *slot = NULL;
 
 	if ( vsSystem::Instance()->GetPreferences()->GetDynamicBatching() )
 	{
+		slot = FindMaterialSlot( material->GetResource() );
 		// Check for compatible simple BatchElements
 		// in this batch.  If I find one, we'll merge together.
 		//
@@ -284,7 +367,19 @@ vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &mat
 		if ( vsDynamicBatch::Supports( vbo->GetContentType() ) &&
 				vbo->GetPositionCount() < 200 ) // don't even try to merge things that are too big.
 		{
-			mergeCandidate = batch->elementList;
+			mergeCandidate = slot->lastSimple;
+
+			// Merged geometry draws wherever the candidate sorts to.  For
+			// blended materials, that's only the right place if nothing else
+			// has been added to this stage since the candidate, and it's at
+			// the same depth;  otherwise we'd break back-to-front and painter's
+			// order.
+			bool blended = material->GetResource()->m_blend;
+			if ( blended && mergeCandidate &&
+					( mergeCandidate != m_element[ m_element.ItemCount()-1 ] ||
+					  mergeCandidate->depth != CalculateDepth( &matrix ) ) )
+				mergeCandidate = NULL;
+
 			while(mergeCandidate)
 			{
 				// [TODO] I should also be checking whether there's space in the
@@ -311,7 +406,7 @@ vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &mat
 							break;
 					}
 				}
-				mergeCandidate = mergeCandidate->next;
+				mergeCandidate = blended ? NULL : mergeCandidate->previousSimple;
 			}
 		}
 
@@ -342,17 +437,8 @@ vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &mat
 		}
 	}
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
+	BatchElement *element = AllocElement( material, &matrix );
 
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
-
-	element->material = material;
 	element->matrix = matrix;
 	element->list = NULL;
 	element->vbo = vbo;
@@ -362,95 +448,51 @@ vsRenderQueueStage::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &mat
 	element->instanceMatrixBuffer = NULL;
 	element->instanceColorBuffer = NULL;
 
-	element->next = batch->elementList;
-	batch->elementList = element;
+	if ( slot )
+	{
+		element->previousSimple = slot->lastSimple;
+		slot->lastSimple = element;
+	}
 }
 
 void
 vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, int matrixCount, vsDisplayList *batchList )
 {
-	Batch *batch = FindBatch(material);
-
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
+	BatchElement *element = AllocElement( material, matrixCount > 0 ? matrix : NULL );
 
 	element->instanceMatrixCount = matrixCount;
 	element->instanceMatrix = matrix;
 	element->instanceMatrixBuffer = NULL;
 	element->instanceColorBuffer = NULL;
 	element->list = batchList;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 
 void
 vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, vsRenderBuffer *matrixBuffer, vsRenderBuffer *colorBuffer, vsDisplayList *batchList, vsShaderValues *values )
 {
-	Batch *batch = FindBatch(material);
+	BatchElement *element = AllocElement( material, NULL );
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
-
-	element->material = material;
 	element->shaderValues = values;
 	element->instanceMatrixBuffer = matrixBuffer;
 	element->instanceColorBuffer = colorBuffer;
 	element->list = batchList;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 
 void
 vsRenderQueueStage::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, const vsColor *color, int matrixCount, vsDisplayList *batchList, vsShaderValues *values )
 {
-	Batch *batch = FindBatch(material);
+	BatchElement *element = AllocElement( material, matrixCount > 0 ? matrix : NULL );
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
-
-	element->material = material;
 	element->shaderValues = values;
 	element->instanceMatrixCount = matrixCount;
 	element->instanceMatrix = matrix;
 	element->instanceColor = color;
 	element->list = batchList;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 void
 vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, int matrixCount, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType )
 {
-	Batch *batch = FindBatch(material);
-
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
+	BatchElement *element = AllocElement( material, matrixCount > 0 ? matrix : NULL );
 
 	element->instanceMatrixCount = matrixCount;
 	element->instanceMatrix = matrix;
@@ -459,52 +501,26 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix
 	element->vbo = vbo;
 	element->ibo = ibo;
 	element->simpleType = simpleType;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 
 void
 vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, vsRenderBuffer *matrixBuffer, vsRenderBuffer *colorBuffer, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType, vsShaderValues *values )
 {
-	Batch *batch = FindBatch(material);
+	BatchElement *element = AllocElement( material, NULL );
 
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
-
-	element->material = material;
 	element->shaderValues = values;
 	element->instanceMatrixBuffer = matrixBuffer;
 	element->instanceColorBuffer = colorBuffer;
 	element->vbo = vbo;
 	element->ibo = ibo;
 	element->simpleType = simpleType;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 
 void
 vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, const vsColor *color, int matrixCount, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType, vsShaderValues *values )
 {
-	Batch *batch = FindBatch(material);
-
-	if ( !m_batchElementPool )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = element->next;
-	element->next = NULL;
-	element->Clear();
+	BatchElement *element = AllocElement( material, matrixCount > 0 ? matrix : NULL );
 
-	element->material = material;
 	element->shaderValues = values;
 	element->instanceMatrixCount = matrixCount;
 	element->instanceMatrix = matrix;
@@ -512,123 +528,177 @@ vsRenderQueueStage::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix
 	element->vbo = vbo;
 	element->ibo = ibo;
 	element->simpleType = simpleType;
-
-	element->next = batch->elementList;
-	batch->elementList = element;
 }
 
 vsDisplayList *
 vsRenderQueueStage::MakeTemporaryBatchList( vsMaterial *material, const vsMatrix4x4 &matrix, int size )
 {
-	Batch *batch = FindBatch(material);
+	BatchElement *element = AllocElement( material, &matrix );
 
-	if ( m_batchElementPool == NULL )
-	{
-		m_batchElementPool = new BatchElement;
-	}
-	BatchElement *element = m_batchElementPool;
-	m_batchElementPool = m_batchElementPool->next;
-	element->next = NULL;
-	element->Clear();
-
-	element->material = material;
 	element->matrix = matrix;
-	element->list = new vsDisplayList(size);
-
-	element->next = batch->elementList;
-	batch->elementList = element;
+	vsFrameArena *arena = vsFrameArena::Instance();
+	char *buffer = arena->AllocArray<char>( size );
+	element->list = arena->New<vsDisplayList>( buffer, (size_t)size );
+	element->list->SetFrameLocal(true);
 	m_temporaryLists.AddItem(element->list);
 
 	return element->list;
 }
 
 void
-vsRenderQueueStage::StartRender()
+vsRenderQueueStage::StartRender( const vsMatrix4x4 *worldToView )
 {
-	m_batchCount = 0;
-	vsAssert( m_batch == NULL, "Batches not cleared?" );
-	//	m_batch = NULL;
+	vsAssert( m_element.IsEmpty(), "Batches not cleared?" );
+	m_worldToView = worldToView;
+	m_stats = vsRenderQueue::Stats();
+}
+
+vsRenderQueueStage::SortEntry *
+vsRenderQueueStage::Sort( SortEntry *entry, SortEntry *scratch, int count )
+{
+	// Both sorts are stable, so elements with equal keys keep the order in
+	// which they were added.
+	if ( count <= SORT_INSERTION_LIMIT )
+	{
+		for ( int i = 1; i < count; i++ )
+		{
+			SortEntry e = entry[i];
+			int j = i;
+			for ( ; j > 0 && entry[j-1].key > e.key; j-- )
+				entry[j] = entry[j-1];
+			entry[j] = e;
+		}
+		return entry;
+	}
 
+	// Least significant byte first.  Most frames only use a few layers,
+	// shaders, and so on, so skip any byte which is the same in every key.
+	for ( int shift = 0; shift < 64; shift += 8 )
+	{
+		int histogram[256] = {0};
+		for ( int i = 0; i < count; i++ )
+			histogram[(entry[i].key >> shift) & 0xff]++;
+		if ( histogram[(entry[0].key >> shift) & 0xff] == count )
+			continue;
+
+		int offset = 0;
+		for ( int i = 0; i < 256; i++ )
+		{
+			int bucketCount = histogram[i];
+			histogram[i] = offset;
+			offset += bucketCount;
+		}
+		for ( int i = 0; i < count; i++ )
+			scratch[ histogram[(entry[i].key >> shift) & 0xff]++ ] = entry[i];
 
+		SortEntry *swap = entry;
+		entry = scratch;
+		scratch = swap;
+	}
+	return entry;
 }
 
 void
 vsRenderQueueStage::Draw( vsDisplayList *list )
 {
-	for (Batch *b = m_batch; b; b = b->next)
+	int count = m_element.ItemCount();
+	if ( count == 0 )
+		return;
+
+	vsFrameArena *arena = vsFrameArena::Instance();
+	SortEntry *entry = arena->AllocArray<SortEntry>( count );
+	SortEntry *scratch = arena->AllocArray<SortEntry>( count );
+	for ( int i = 0; i < count; i++ )
 	{
-		for (BatchElement *e = b->elementList; e; e = e->next)
+		entry[i].key = m_element[i]->sortKey;
+		entry[i].element = m_element[i];
+	}
+	entry = Sort( entry, scratch, count );
+
+	vsMaterialInternal *lastMaterial = NULL;
+	uint32_t lastState = 0;
+	for ( int i = 0; i < count; i++ )
+	{
+		BatchElement *e = entry[i].element;
+		vsMaterialInternal *material = e->material->GetResource();
+		uint32_t changed = e->state ^ lastState;
+		if ( i == 0 || material != lastMaterial )
+			m_stats.materialChanges++;
+		if ( i == 0 || ((changed >> SORT_STATE_SHADER_SHIFT) & SORT_STATE_SHADER_MASK) )
+			m_stats.shaderChanges++;
+		if ( i == 0 || ((changed >> SORT_STATE_TEXTURE_SHIFT) & SORT_STATE_TEXTURE_MASK) )
+			m_stats.textureChanges++;
+		lastMaterial = material;
+		lastState = e->state;
+
+		list->SetMaterial( e->material );
+		if ( e->batch )
 		{
-			list->SetMaterial( e->material );
-			if ( e->batch )
-			{
-				list->SetMatrix4x4( vsMatrix4x4::Identity );
-				e->batch->Draw(list);
-				list->PopTransform();
-			}
+			list->SetMatrix4x4( vsMatrix4x4::Identity );
+			e->batch->Draw(list);
+			list->PopTransform();
+		}
+		else
+		{
+			if ( e->instanceMatrixBuffer )
+				list->SetMatrices4x4Buffer( e->instanceMatrixBuffer );
+			else if ( e->instanceMatrix )
+				list->SetMatrices4x4( e->instanceMatrix, e->instanceMatrixCount );
 			else
+				list->SetMatrix4x4( e->matrix );
+			list->SetShaderValues( e->shaderValues );
+			if ( e->instanceColorBuffer )
+				list->SetColorsBuffer( e->instanceColorBuffer );
+			else if ( e->instanceColor )
+				list->SetColors( e->instanceColor, e->instanceMatrixCount );
+
+			// Static lists, such as fragments', are referenced rather than
+			// copied;  they wait for the render thread before they're
+			// destroyed.  Anything else might be rebuilt before this frame
+			// is rendered, so it's copied.
+			if ( e->list && e->list->IsStatic() )
+				list->CallList( *e->list );
+			else if ( e->list )
+				list->Append( *e->list );
+			else if ( e->vbo && e->ibo )
 			{
-				if ( e->instanceMatrixBuffer )
-					list->SetMatrices4x4Buffer( e->instanceMatrixBuffer );
-				else if ( e->instanceMatrix )
-					list->SetMatrices4x4( e->instanceMatrix, e->instanceMatrixCount );
-				else
-					list->SetMatrix4x4( e->matrix );
-				list->SetShaderValues( e->shaderValues );
-				if ( e->instanceColorBuffer )
-					list->SetColorsBuffer( e->instanceColorBuffer );
-				else if ( e->instanceColor )
-					list->SetColors( e->instanceColor, e->instanceMatrixCount );
-
-				if ( e->list )
-					list->Append( *e->list );
-				else if ( e->vbo && e->ibo )
-				{
-					list->BindBuffer( e->vbo );
-					if ( e->simpleType == vsFragment::SimpleType_TriangleList )
-						list->TriangleListBuffer( e->ibo );
-					else if ( e->simpleType == vsFragment::SimpleType_TriangleFan )
-						list->TriangleFanBuffer( e->ibo );
-					else if ( e->simpleType == vsFragment::SimpleType_TriangleStrip )
-						list->TriangleStripBuffer( e->ibo );
-					list->ClearArrays();
-				}
-				list->PopTransform();
+				list->BindBuffer( e->vbo );
+				if ( e->simpleType == vsFragment::SimpleType_TriangleList )
+					list->TriangleListBuffer( e->ibo );
+				else if ( e->simpleType == vsFragment::SimpleType_TriangleFan )
+					list->TriangleFanBuffer( e->ibo );
+				else if ( e->simpleType == vsFragment::SimpleType_TriangleStrip )
+					list->TriangleStripBuffer( e->ibo );
+				list->ClearArrays();
 			}
+			list->PopTransform();
 		}
 	}
+	m_stats.elements += count;
 }
 
 void
 vsRenderQueueStage::EndRender()
 {
-	m_batchCount = 0;
-	Batch *last = NULL;
-	for (Batch *b = m_batch; b; b = b->next)
+	// elements were in the frame arena;  nothing to free.
+	m_element.Clear();
+	if ( m_materialSlotUsed )
 	{
-		last = b;
-		BatchElement *lastElement = b->elementList;
-		while ( lastElement->next )
-		{
-			lastElement->instanceMatrix = NULL;
-			lastElement->instanceMatrixCount = 0;
-			lastElement = lastElement->next;
-		}
-		lastElement->instanceMatrix = NULL;
-		lastElement->instanceMatrixCount = 0;
-		lastElement->next = m_batchElementPool;
-		m_batchElementPool = b->elementList;
-		b->elementList = NULL;
+		memset( m_materialSlot, 0, sizeof(MaterialSlot) * m_materialSlotCount );
+		m_materialSlotUsed = 0;
 	}
-	if ( last )
-	{
-		last->next = m_batchPool;
-		m_batchPool = m_batch;
-	}
-	m_batch = NULL;
 
+	for ( int i = 0; i < m_temporaryLists.ItemCount(); i++ )
+		m_temporaryLists[i]->~vsDisplayList();
 	m_temporaryLists.Clear();
-	m_batchMap->map.clear();
+}
+
+vsDrawCache::vsDrawCache():
+	m_valid(false),
+	m_cacheable(false),
+	m_outer(NULL),
+	m_genericStart(0)
+{
 }
 
 vsRenderQueue::vsRenderQueue( int stageCount, int genericListSize):
@@ -637,7 +707,8 @@ vsRenderQueue::vsRenderQueue( int stageCount, int genericListSize):
 	m_stage(new vsRenderQueueStage[4]),
 	m_stageCount(4),
 	m_transformStack(),
-	m_transformStackLevel(0)
+	m_transformStackLevel(0),
+	m_recording(NULL)
 	// m_orthographic(true)
 {
 }
@@ -655,11 +726,14 @@ vsRenderQueue::StartRender(vsScene *parent, int materialHideFlags)
 	m_parent = parent;
 	InitialiseTransformStack();
 
+	// 2D scenes aren't depth sorted, however far away things are.
+	const vsMatrix4x4 *worldToView = parent->Is3D() ? &m_worldToView : NULL;
 	for ( int i = 0; i < m_stageCount; i++ )
 	{
-		m_stage[i].StartRender();
+		m_stage[i].StartRender( worldToView );
 	}
 	m_genericList->Clear();
+	m_cacheStats = CacheStats();
 }
 
 void
@@ -674,9 +748,10 @@ vsRenderQueue::StartRender( const vsMatrix4x4& projection, const vsMatrix4x4& wo
 
 	for ( int i = 0; i < m_stageCount; i++ )
 	{
-		m_stage[i].StartRender();
+		m_stage[i].StartRender( &m_worldToView );
 	}
 	m_genericList->Clear();
+	m_cacheStats = CacheStats();
 }
 
 void
@@ -689,6 +764,16 @@ vsRenderQueue::Draw( vsDisplayList *list )
 	list->Append(*m_genericList);
 	m_stage[3].Draw(list);
 
+	m_stats = Stats();
+	for ( int i = 0; i < m_stageCount; i++ )
+	{
+		const Stats &stageStats = m_stage[i].GetStats();
+		m_stats.elements += stageStats.elements;
+		m_stats.materialChanges += stageStats.materialChanges;
+		m_stats.shaderChanges += stageStats.shaderChanges;
+		m_stats.textureChanges += stageStats.textureChanges;
+	}
+
 	DeinitialiseTransformStack();
 	vsAssert( m_transformStackLevel == 0, "Unbalanced push/pop of transforms?");
 }
@@ -696,6 +781,7 @@ vsRenderQueue::Draw( vsDisplayList *list )
 void
 vsRenderQueue::EndRender()
 {
+	vsAssert( m_recording == NULL, "Unbalanced BeginDrawCache/EndDrawCache?" );
 	for ( int i = 0; i < m_stageCount; i++ )
 	{
 		m_stage[i].EndRender();
@@ -806,6 +892,17 @@ vsRenderQueue::DeinitialiseTransformStack()
 
 void
 vsRenderQueue::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType )
+{
+	if ( m_recording )
+	{
+		vsDrawCache::Batch b = { NULL, material, matrix, NULL, vbo, ibo, simpleType };
+		m_recording->m_batch.AddItem( b );
+	}
+	AddSimpleBatch_Internal( material, matrix, vbo, ibo, simpleType );
+}
+
+void
+vsRenderQueue::AddSimpleBatch_Internal( vsMaterial *material, const vsMatrix4x4 &matrix, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType )
 {
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
@@ -817,6 +914,17 @@ vsRenderQueue::AddSimpleBatch( vsMaterial *material, const vsMatrix4x4 &matrix,
 
 void
 vsRenderQueue::AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisplayList *batch )
+{
+	if ( m_recording )
+	{
+		vsDrawCache::Batch b = { NULL, material, matrix, batch, NULL, NULL, vsFragment::SimpleType_TriangleList };
+		m_recording->m_batch.AddItem( b );
+	}
+	AddBatch_Internal( material, matrix, batch );
+}
+
+void
+vsRenderQueue::AddBatch_Internal( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisplayList *batch )
 {
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
@@ -829,6 +937,7 @@ vsRenderQueue::AddBatch( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisp
 void
 vsRenderQueue::AddInstanceBatch( vsMaterial *material, vsRenderBuffer *matrixBuffer, vsRenderBuffer *colorBuffer, vsDisplayList *batch, vsShaderValues *values )
 {
+	MarkUncacheable();
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
 
@@ -839,6 +948,7 @@ vsRenderQueue::AddInstanceBatch( vsMaterial *material, vsRenderBuffer *matrixBuf
 void
 vsRenderQueue::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, const vsColor *color, int instanceCount, vsDisplayList *batch, vsShaderValues *values)
 {
+	MarkUncacheable();
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
 
@@ -849,6 +959,7 @@ vsRenderQueue::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix
 void
 vsRenderQueue::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, int instanceCount, vsDisplayList *batch )
 {
+	MarkUncacheable();
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
 
@@ -859,6 +970,7 @@ vsRenderQueue::AddInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix
 void
 vsRenderQueue::AddSimpleInstanceBatch( vsMaterial *material, vsRenderBuffer *matrixBuffer, vsRenderBuffer *colorBuffer, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType, vsShaderValues *values )
 {
+	MarkUncacheable();
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
 
@@ -869,6 +981,7 @@ vsRenderQueue::AddSimpleInstanceBatch( vsMaterial *material, vsRenderBuffer *mat
 void
 vsRenderQueue::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, const vsColor *color, int instanceCount, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType, vsShaderValues *values)
 {
+	MarkUncacheable();
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
 
@@ -879,6 +992,7 @@ vsRenderQueue::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *
 void
 vsRenderQueue::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *matrix, int instanceCount, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType )
 {
+	MarkUncacheable();
 	if ( (material->GetResource()->m_flags & m_materialHideFlags) != 0 )
 		return; // don't draw!
 
@@ -888,11 +1002,22 @@ vsRenderQueue::AddSimpleInstanceBatch( vsMaterial *material, const vsMatrix4x4 *
 
 void
 vsRenderQueue::AddFragmentBatch( vsFragment *fragment )
+{
+	if ( m_recording )
+	{
+		vsDrawCache::Batch b = { fragment, NULL, GetMatrix(), NULL, NULL, NULL, vsFragment::SimpleType_TriangleList };
+		m_recording->m_batch.AddItem( b );
+	}
+	AddFragmentBatch_Internal( fragment, GetMatrix() );
+}
+
+void
+vsRenderQueue::AddFragmentBatch_Internal( vsFragment *fragment, const vsMatrix4x4 &matrix )
 {
 	if ( fragment->IsSimple() )
-		AddSimpleBatch( fragment->GetMaterial(), GetMatrix(), fragment->GetSimpleVBO(), fragment->GetSimpleIBO(), fragment->GetSimpleType() );
+		AddSimpleBatch_Internal( fragment->GetMaterial(), matrix, fragment->GetSimpleVBO(), fragment->GetSimpleIBO(), fragment->GetSimpleType() );
 	else
-		AddBatch( fragment->GetMaterial(), GetMatrix(), fragment->GetDisplayList() );
+		AddBatch_Internal( fragment->GetMaterial(), matrix, fragment->GetDisplayList() );
 }
 
 void
@@ -925,6 +1050,7 @@ vsRenderQueue::AddFragmentInstanceBatch( vsFragment *fragment, vsRenderBuffer *m
 vsDisplayList *
 vsRenderQueue::MakeTemporaryBatchList( vsMaterial *material, const vsMatrix4x4 &matrix, int size )
 {
+	MarkUncacheable();
 	int stageId = PickStageForMaterial( material );
 
 	return m_stage[stageId].MakeTemporaryBatchList( material, matrix, size );
@@ -933,11 +1059,90 @@ vsRenderQueue::MakeTemporaryBatchList( vsMaterial *material, const vsMatrix4x4 &
 vsDisplayList *
 vsRenderQueue::MakeTemporaryBatchList( vsMaterial *material, int size )
 {
+	MarkUncacheable();
 	int stageId = PickStageForMaterial( material );
 
 	return m_stage[stageId].MakeTemporaryBatchList( material, m_transformStack[0], size );
 }
 
+void
+vsRenderQueue::MarkUncacheable()
+{
+	if ( m_recording )
+		m_recording->m_cacheable = false;
+}
+
+bool
+vsRenderQueue::ReplayDrawCache( vsDrawCache *cache )
+{
+	if ( !cache->m_valid || cache->m_startMatrix != GetMatrix() )
+		return false;
+
+	for ( int i = 0; i < cache->m_batch.ItemCount(); i++ )
+	{
+		const vsDrawCache::Batch &b = cache->m_batch[i];
+		if ( b.fragment )
+		{
+			if ( b.fragment->IsVisible() )
+				AddFragmentBatch_Internal( b.fragment, b.matrix );
+		}
+		else if ( b.list )
+			AddBatch_Internal( b.material, b.matrix, b.list );
+		else
+			AddSimpleBatch_Internal( b.material, b.matrix, b.vbo, b.ibo, b.simpleType );
+
+		// If we're inside somebody else's recording, they need these too.
+		if ( m_recording )
+			m_recording->m_batch.AddItem( b );
+	}
+	m_cacheStats.hits++;
+	return true;
+}
+
+void
+vsRenderQueue::BeginDrawCache( vsDrawCache *cache )
+{
+	cache->m_batch.Clear();
+	cache->m_startMatrix = GetMatrix();
+	cache->m_valid = false;
+	cache->m_cacheable = true;
+	cache->m_genericStart = m_genericList->GetSize();
+	cache->m_outer = m_recording;
+	m_recording = cache;
+	m_cacheStats.misses++;
+}
+
+void
+vsRenderQueue::EndDrawCache( vsDrawCache *cache )
+{
+	vsAssert( m_recording == cache, "Unbalanced BeginDrawCache/EndDrawCache?" );
+	m_recording = cache->m_outer;
+	cache->m_outer = NULL;
+
+	// Generic list ops point at materials and display lists which we don't
+	// own, and which can change without anybody telling us.
+	if ( m_genericList->GetSize() != cache->m_genericStart )
+		cache->m_cacheable = false;
+
+	if ( !cache->m_cacheable )
+	{
+		m_cacheStats.uncacheable++;
+		if ( m_recording )
+			m_recording->m_cacheable = false;
+		return;
+	}
+
+	cache->m_valid = true;
+
+	// Our batches were recorded only into us;  an enclosing recording needs
+	// them too.
+	if ( m_recording )
+	{
+		for ( int i = 0; i < cache->m_batch.ItemCount(); i++ )
+			m_recording->m_batch.AddItem( cache->m_batch[i] );
+	}
+}
+
 vsRenderQueueStage *
 vsRenderQueue::GetStage( int i )
 {
@@ -15,6 +15,7 @@
 #include "VS/Graphics/VS_DisplayList.h"
 #include "VS/Graphics/VS_Fragment.h"
 #include "VS/Graphics/VS_Screen.h"
+#include "VS/Utils/VS_Array.h"
 #include "VS/Utils/VS_LinkedList.h"
 #include "VS/Utils/VS_LinkedListStore.h"
 #include "VS/Utils/VS_Pool.h"
@@ -31,8 +32,84 @@ class vsRenderQueueStage;
 
 #define MAX_STACK_DEPTH (20)
 
+// vsDrawCache remembers what an entity (and its children) drew the last time
+// it was drawn, so that the same thing can be submitted again without calling
+// Draw() at all.  See vsEntity::SetDrawCaching().
+//
+// What's remembered is the batches which were added to the render queue,
+// along with the matrix which was current when drawing started;  a cache is
+// only replayed under the same matrix.  Fragment batches remember the
+// fragment itself, so they pick up the fragment's current material, display
+// list and buffers when replayed, and are skipped if it's been hidden.
+//
+// Instance batches, temporary batch lists, and anything written into the
+// generic list refer to data which can change or go away without the entity
+// knowing (the generic list holds raw pointers to materials and called
+// display lists), so anything which draws them can't be cached, and just
+// draws normally every frame.
+class vsDrawCache
+{
+	struct Batch
+	{
+		vsFragment *			fragment;	// if set, everything except 'matrix' comes from the fragment
+		vsMaterial *			material;
+		vsMatrix4x4				matrix;
+		vsDisplayList *			list;		// if NULL, this is a simple batch
+		vsRenderBuffer *		vbo;
+		vsRenderBuffer *		ibo;
+		vsFragment::SimpleType	simpleType;
+	};
+
+	vsArray<Batch>	m_batch;
+	vsMatrix4x4		m_startMatrix;
+	bool			m_valid;
+	bool			m_cacheable;
+
+	// only used while recording
+	vsDrawCache *	m_outer;
+	size_t			m_genericStart;
+
+	friend class vsRenderQueue;
+
+public:
+
+	vsDrawCache();
+
+	void	Invalidate() { m_valid = false; }
+	bool	IsValid() const { return m_valid; }
+};
+
 class vsRenderQueue
 {
+public:
+
+	// Counted while the queue is written into a display list;  each stage
+	// draws its batches sorted so as to keep the state changes down.
+	struct Stats
+	{
+		int		elements;			// batch elements drawn
+		int		materialChanges;	// how many times consecutive elements used different materials
+		int		shaderChanges;		// likewise, shaders
+		int		textureChanges;		// likewise, sets of textures
+
+		Stats(): elements(0), materialChanges(0), shaderChanges(0), textureChanges(0) {}
+	};
+
+	// Counted between StartRender() and EndRender(), for entities which use
+	// vsDrawCache.
+	struct CacheStats
+	{
+		int		hits;			// draws replayed from a cache
+		int		misses;			// draws which had to be recorded
+		int		uncacheable;	// of those, recordings which couldn't be kept
+
+		CacheStats(): hits(0), misses(0), uncacheable(0) {}
+
+		float	GetHitRate() const { return (hits + misses) ? (float)hits / (hits + misses) : 0.f; }
+	};
+
+private:
+
 	vsScene *				m_parent;
 
 	vsDisplayList *			m_genericList;
@@ -50,8 +127,19 @@ class vsRenderQueue
 	float m_fov;
 	// bool m_orthographic;
 
+	Stats					m_stats;
+
+	vsDrawCache *			m_recording;	// innermost cache being recorded, if any
+	CacheStats				m_cacheStats;
+
 	int				PickStageForMaterial( vsMaterial *material );
 
+	// these don't record into m_recording
+	void			AddBatch_Internal( vsMaterial *material, const vsMatrix4x4 &matrix, vsDisplayList *batch );
+	void			AddSimpleBatch_Internal( vsMaterial *material, const vsMatrix4x4 &matrix, vsRenderBuffer *vbo, vsRenderBuffer *ibo, vsFragment::SimpleType simpleType );
+	void			AddFragmentBatch_Internal( vsFragment *fragment, const vsMatrix4x4 &matrix );
+	void			MarkUncacheable();
+
 	void			InitialiseTransformStack();
 	void			DeinitialiseTransformStack();
 
@@ -125,6 +213,20 @@ public:
 	vsDisplayList * GetGenericList() { return m_genericList; }
 
 	vsRenderQueueStage * GetStage( int i = 0 );
+
+	// Submits what 'cache' recorded, if it's still valid for the current
+	// matrix.  Returns false (and submits nothing) if it isn't;  in that case,
+	// draw normally between BeginDrawCache() and EndDrawCache() to record it
+	// again.  Caches may be recorded inside one another.
+	bool			ReplayDrawCache( vsDrawCache *cache );
+	void			BeginDrawCache( vsDrawCache *cache );
+	void			EndDrawCache( vsDrawCache *cache );
+	bool			IsRecordingDrawCache() const { return m_recording != NULL; }
+
+	// From the most recent Draw().
+	const Stats &	GetStats() const { return m_stats; }
+	// Since the most recent StartRender().
+	const CacheStats &	GetCacheStats() const { return m_cacheStats; }
 };
 
 #endif // VS_SCENE_DRAW_H
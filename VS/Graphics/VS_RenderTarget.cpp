@@ -8,6 +8,8 @@
 
 #include "VS_RenderTarget.h"
 #include "VS_TextureManager.h"
+#include "VS_RenderThread.h"
+#include "VS_Screen.h"
 #include "VS_OpenGL.h"
 #include <atomic>
 
@@ -53,7 +55,9 @@ vsRenderTarget::vsRenderTarget( Type t, const vsSurface::Settings &settings, boo
 		m_depthTexture = new vsTexture(name);
 	}
 
-	if ( !deferred )
+	// Framebuffer objects belong to the context which created them, so if
+	// the render thread is running, let it create us when it first binds us.
+	if ( !deferred && !vsRenderThread::IsRunning() )
 		Create();
 }
 
@@ -95,6 +99,9 @@ vsRenderTarget::Create()
 vsRenderTarget::~vsRenderTarget()
 {
 	GL_CHECK_SCOPED("vsRenderTarget::~vsRenderTarget");
+	vsScreen *screen = vsScreen::Instance();
+	if ( screen )
+		screen->SuspendRenderThread();
 
 	for ( int i = 0; i < m_bufferCount; i++ )
 	{
@@ -104,6 +111,9 @@ vsRenderTarget::~vsRenderTarget()
 	vsDelete( m_depthTexture );
 	vsDelete( m_textureSurface );
 	vsDelete( m_renderBufferSurface );
+
+	if ( screen )
+		screen->ResumeRenderThread();
 }
 
 vsTexture *
@@ -371,6 +381,10 @@ vsRenderTarget::Resize( int width, int height )
 	}
 	else
 	{
+		vsScreen *screen = vsScreen::Instance();
+		if ( screen )
+			screen->SuspendRenderThread();
+
 		if ( m_renderBufferSurface )
 			m_renderBufferSurface->Resize(width, height);
 		if ( m_textureSurface )
@@ -388,6 +402,9 @@ vsRenderTarget::Resize( int width, int height )
 		}
 		if ( m_depthTexture )
 			m_depthTexture->GetResource()->SetSurface( m_textureSurface, 0, true );
+
+		if ( screen )
+			screen->ResumeRenderThread();
 	}
 }
 
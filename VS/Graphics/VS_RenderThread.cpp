@@ -0,0 +1,132 @@
+/*
+ *  VS_RenderThread.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_RenderThread.h"
+
+#include "VS_DisplayList.h"
+#include "VS_Renderer_OpenGL3.h"
+#include "VS_OpenGL.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Utils/VS_Profiler.h"
+
+#include <SDL2/SDL.h>
+
+vsRenderThread * vsRenderThread::s_instance = NULL;
+
+vsRenderThread::vsRenderThread( vsRenderer_OpenGL3 *renderer ):
+	vsTask("RenderThread"),
+	m_renderer(renderer),
+	m_frameReady( new vsSemaphore(0) ),
+	m_frameDone( new vsSemaphore(0) ),
+	m_fifo(NULL),
+	m_fence(NULL),
+	m_submittedFrames(0),
+	m_completedFrames(0),
+	m_acknowledgedFrames(0),
+	m_owningThread( SDL_ThreadID() )
+{
+	vsAssert( s_instance == NULL, "Tried to create a second render thread!" );
+	s_instance = this;
+
+	// Give up the main context before the render thread tries to take it;
+	// a context may only be current on one thread at a time.
+	glFinish();
+	m_renderer->MakeResourceContextCurrent();
+
+	Start();
+}
+
+vsRenderThread::~vsRenderThread()
+{
+	WaitForIdle();
+	m_frameReady->Release();
+	Join();
+
+	m_frameDone->Release();
+	vsDelete( m_frameReady );
+	vsDelete( m_frameDone );
+
+	// anything we uploaded since the last submitted frame needs to be
+	// finished before the main context can see it.
+	glFinish();
+	m_renderer->MakeRenderContextCurrent();
+	s_instance = NULL;
+}
+
+int
+vsRenderThread::Run()
+{
+	vsProfiler::SetThreadName("RenderThread");
+	m_renderer->MakeRenderContextCurrent();
+
+	while ( m_frameReady->Wait() )
+	{
+		if ( m_fence )
+		{
+			// Don't start drawing until the GPU has finished whatever the
+			// main thread uploaded on the resource context for this frame.
+			GLsync fence = (GLsync)m_fence;
+			glWaitSync( fence, 0, GL_TIMEOUT_IGNORED );
+			glDeleteSync( fence );
+			m_fence = NULL;
+		}
+
+		m_renderer->PreRender( m_settings );
+		m_renderer->RenderDisplayList( m_fifo );
+		m_renderer->PostRender();
+
+		m_completedFrames.fetch_add(1, std::memory_order_release);
+		m_frameDone->Post();
+	}
+
+	m_renderer->ReleaseCurrentContext();
+	return 0;
+}
+
+void
+vsRenderThread::Submit( vsDisplayList *fifo, const vsRenderer::Settings &settings )
+{
+	vsAssert( SDL_ThreadID() == m_owningThread, "Frames may only be submitted from the thread which started the render thread" );
+	WaitForIdle();
+
+	// The render thread's context can't see our uploads until they've been
+	// flushed, and mustn't use them until they've actually executed.
+	m_fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	glFlush();
+	GL_CHECK("glFenceSync");
+
+	m_fifo = fifo;
+	m_settings = settings;
+	m_submittedFrames.fetch_add(1, std::memory_order_relaxed);
+	m_frameReady->Post();
+}
+
+void
+vsRenderThread::WaitForIdle()
+{
+	uint32_t submitted = m_submittedFrames.load(std::memory_order_relaxed);
+
+	if ( SDL_ThreadID() == m_owningThread )
+	{
+		while ( m_acknowledgedFrames != submitted )
+		{
+			m_frameDone->Wait();
+			m_acknowledgedFrames++;
+		}
+	}
+	else
+	{
+		// Some other thread (a loader, or a job) needs to modify something a
+		// frame might be using.  It can't consume m_frameDone without
+		// confusing the main thread, so just watch the completion count.
+		while ( m_completedFrames.load(std::memory_order_acquire) != submitted )
+			SDL_Delay(0);
+	}
+}
+
@@ -0,0 +1,107 @@
+/*
+ *  VS_RenderThread.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_RENDERTHREAD_H
+#define VS_RENDERTHREAD_H
+
+#include "VS/Graphics/VS_Renderer.h"
+#include "VS/Threads/VS_Task.h"
+#include <atomic>
+
+class vsDisplayList;
+class vsRenderer_OpenGL3;
+class vsSemaphore;
+
+// vsRenderThread owns the main OpenGL context and submits display lists to
+// it, so that the main thread can go on to update and record frame N+1 while
+// frame N is being rendered and presented.  vsScreen creates one when
+// threaded rendering is enabled;  games shouldn't normally need to talk to
+// it directly.
+//
+// At most one frame is ever in flight;  Submit() waits for the previous
+// frame to finish before handing over the next one.  That bounds latency to
+// one frame, and means that anything the main thread allocated for frame N
+// (frame arena memory, the FIFO display list which vsScreen double-buffers,
+// dynamic batches) only needs to survive until the end of frame N+1.
+//
+// Lifetime rules, while the render thread is running:
+//
+//  - Textures, render buffers, and shaders created on the main thread live
+//    on a shared 'resource' context.  Submit() fences that context, so
+//    anything uploaded before a frame is submitted is visible to it.
+//
+//  - vsRenderBuffers and vsMaterials which have been recorded into a display
+//    list call Sync() before they're modified or destroyed, so they can't be
+//    changed under a frame which is still being drawn.  vsRenderBuffers which
+//    are marked as frame-local skip that, and their owners must instead
+//    avoid reusing them until the frame which drew them has been rendered.
+//
+//  - Framebuffer objects aren't shared between contexts, so vsRenderTargets
+//    created while the render thread is running are created by the render
+//    thread the first time they're bound, and vsScreen suspends the render
+//    thread while render targets are destroyed or resized.
+//
+//  - Anything else a display list points at (vsShaderValues, raw vertex or
+//    matrix arrays passed by pointer) must stay valid and unchanged until
+//    the end of the following frame, or must be allocated from the
+//    vsFrameArena.
+
+class vsRenderThread : public vsTask
+{
+	static vsRenderThread *	s_instance;
+
+	vsRenderer_OpenGL3 *	m_renderer;
+	vsSemaphore *			m_frameReady;
+	vsSemaphore *			m_frameDone;
+
+	// The frame being handed to the render thread.  The main thread only
+	// writes these while the render thread is idle.
+	vsDisplayList *			m_fifo;
+	vsRenderer::Settings	m_settings;
+	void *					m_fence;
+
+	std::atomic<uint32_t>	m_submittedFrames;
+	std::atomic<uint32_t>	m_completedFrames;
+	uint32_t				m_acknowledgedFrames;	// owning thread only
+	unsigned long			m_owningThread;			// SDL_threadID of the thread which created us
+
+protected:
+
+	virtual int Run();
+
+public:
+
+	// Takes the main context away from the calling thread, which switches to
+	// the renderer's resource context.
+	vsRenderThread( vsRenderer_OpenGL3 *renderer );
+	// Finishes any frame in flight, and hands the main context back to the
+	// calling thread.
+	virtual ~vsRenderThread();
+
+	// Hands a recorded FIFO to the render thread, to be drawn and presented.
+	// Blocks until the previous frame has finished.
+	void	Submit( vsDisplayList *fifo, const vsRenderer::Settings &settings );
+
+	// Blocks until every submitted frame has been rendered.
+	void	WaitForIdle();
+
+	static bool	IsRunning() { return s_instance != NULL; }
+
+	// Frames are numbered from 1, in the order they're submitted;  the frame
+	// which the main thread is recording now is GetRecordingFrame().  With no
+	// render thread, that's always 0, and every frame is complete.
+	static uint32_t	GetRecordingFrame() { return s_instance ? s_instance->m_submittedFrames.load(std::memory_order_relaxed) + 1 : 0; }
+	static bool		IsFrameComplete( uint32_t frame ) { return !s_instance || (int32_t)(s_instance->m_completedFrames.load(std::memory_order_acquire) - frame) >= 0; }
+
+	// Call before modifying or destroying anything which a submitted frame
+	// might still be drawing.  Does nothing if there's no render thread.
+	static void	Sync() { if ( s_instance ) s_instance->WaitForIdle(); }
+};
+
+#endif // VS_RENDERTHREAD_H
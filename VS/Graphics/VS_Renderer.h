@@ -87,6 +87,7 @@ public:
 	vsRenderer(int width, int height, int depth, int flags);
 	virtual ~vsRenderer();
 
+	virtual bool	VideoModeChanged() = 0;	// cheap, and doesn't touch the GL context
 	virtual bool	CheckVideoMode() = 0;
 	virtual void	UpdateVideoMode(int width, int height, int depth, WindowType type, int bufferCount, bool antialias, bool vsync) = 0;
 	virtual void	NotifyResized(int width, int height) = 0;
@@ -18,7 +18,9 @@
 #include "VS_Matrix.h"
 #include "VS_RenderBuffer.h"
 #include "VS_RenderTarget.h"
+#include "VS_RenderThread.h"
 #include "VS_Screen.h"
+#include "VS_ScreenshotQueue.h"
 #include "VS_Shader.h"
 // #include "VS_ShaderRef.h"
 #include "VS_ShaderSuite.h"
@@ -63,6 +65,8 @@ extern "C" {
 SDL_Window *g_sdlWindow = NULL;
 static SDL_GLContext m_sdlGlContext;
 static SDL_GLContext m_loadingGlContext;
+static SDL_GLContext m_resourceGlContext = NULL;
+static GLuint s_resourceVao = 0;
 static vsMutex m_loadingGlContextMutex;
 
 bool g_crashOnTextureStateUsageWarning = false;
@@ -521,6 +525,9 @@ vsRenderer_OpenGL3::~vsRenderer_OpenGL3()
 	}
 	SDL_GL_DeleteContext( m_sdlGlContext );
 	SDL_GL_DeleteContext( m_loadingGlContext );
+	if ( m_resourceGlContext )
+		SDL_GL_DeleteContext( m_resourceGlContext );
+	m_resourceGlContext = NULL;
 	SDL_DestroyWindow( g_sdlWindow );
 	g_sdlWindow = NULL;
 }
@@ -626,16 +633,23 @@ vsRenderer_OpenGL3::CheckVideoMode()
 // 		m_viewportHeightPixels = m_heightPixels;
 // 		ResizeRenderTargetsToMatchWindow();
 // 	}
+	if ( VideoModeChanged() )
+	{
+		UpdateVideoMode( m_width, m_height, true, m_windowType, m_bufferCount, m_antialias, m_vsync );
+		return true;
+	}
+	return false;
+}
+
+bool
+vsRenderer_OpenGL3::VideoModeChanged()
+{
 #ifdef HIGHDPI_SUPPORTED
 	if ( m_flags & Flag_HighDPI )
 	{
 		int nowWidthPixels, nowHeightPixels;
 		SDL_GL_GetDrawableSize(g_sdlWindow, &nowWidthPixels, &nowHeightPixels);
-		if ( nowWidthPixels != m_widthPixels || nowHeightPixels != m_heightPixels )
-		{
-			UpdateVideoMode( m_width, m_height, true, m_windowType, m_bufferCount, m_antialias, m_vsync );
-			return true;
-		}
+		return ( nowWidthPixels != m_widthPixels || nowHeightPixels != m_heightPixels );
 	}
 #endif
 	return false;
@@ -834,6 +848,15 @@ vsRenderer_OpenGL3::PreRender(const Settings &s)
 void
 vsRenderer_OpenGL3::PostRender()
 {
+	if ( vsScreenshotQueue::Exists() && vsScreenshotQueue::Instance()->HasReadbackWork() )
+	{
+		// Copy the finished frame out before it's presented, since the back
+		// buffer's contents are undefined afterward.
+		PROFILE_GL("Screenshots");
+		m_window->Bind();
+		vsScreenshotQueue::Instance()->Readback( m_widthPixels, m_heightPixels );
+	}
+
 	{
 	PROFILE_GL("Swap");
 #if !TARGET_OS_IPHONE
@@ -872,7 +895,10 @@ vsRenderer_OpenGL3::PostRender()
 	// 	vsLog("Viewport:  %dx%d", m_viewportWidthPixels, m_viewportHeightPixels);
 	// }
 
-	vsDynamicBatchManager::Instance()->FrameRendered();
+	// The render thread mustn't touch the batch manager;  the main thread
+	// tells it when frames have been submitted, instead.
+	if ( !vsRenderThread::IsRunning() )
+		vsDynamicBatchManager::Instance()->FrameRendered();
 }
 
 void
@@ -1000,7 +1026,18 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 {
 	m_currentCameraPosition = vsVector3D::Zero;
 
-	vsDisplayList::op *op = list->PopOp();
+	const vsDisplayList::OpView *op = list->PopOpView();
+
+	// Lists reached through OpCode_CallList are read in place, without
+	// touching their read heads;  this is the stack of them we're inside.
+	struct CalledList
+	{
+		const char *	cursor;
+		const char *	end;
+	};
+	CalledList callStack[MAX_CALL_DEPTH];
+	int callDepth = 0;
+	vsDisplayList::OpView calledOp;
 	//vsVector3D	cursorPos;
 	//vsColor		cursorColor;
 	//vsColor		currentColor(-1,-1,-1,0);
@@ -1040,13 +1077,13 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 	{
 // #define LOG_OPS
 #ifdef LOG_OPS
-		vsLog("%s", vsDisplayList::GetOpCodeString(op->type).c_str());
+		vsLog("%s", vsDisplayList::GetOpCodeString(op->GetType()).c_str());
 #endif // LOG_OPS
-		switch( op->type )
+		switch( op->GetType() )
 		{
 			case vsDisplayList::OpCode_SetColor:
 				{
-					m_currentColor = op->data.GetColor();
+					m_currentColor = op->GetColor();
 					m_currentColors = NULL;
 					m_currentColorsBuffer = NULL;
 					break;
@@ -1054,7 +1091,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 			case vsDisplayList::OpCode_SetColors:
 				{
 					// m_currentColor = c_white;
-					m_currentColors = (vsColor*)op->data.p;
+					m_currentColors = (vsColor*)op->GetPointer();
 					m_currentColorsBuffer = NULL;
 					break;
 				}
@@ -1062,12 +1099,12 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					// m_currentColor = c_white;
 					m_currentColors = NULL;
-					m_currentColorsBuffer = (vsRenderBuffer*)op->data.p;
+					m_currentColorsBuffer = (vsRenderBuffer*)op->GetPointer();
 					break;
 				}
 			case vsDisplayList::OpCode_SetMaterial:
 				{
-					vsMaterial *material = (vsMaterial *)op->data.p;
+					vsMaterial *material = (vsMaterial *)op->GetPointer();
 					SetMaterialInternal( material->GetResource() );
 					SetMaterial( material );
 					m_currentColors = NULL;
@@ -1077,7 +1114,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 			case vsDisplayList::OpCode_SetRenderTarget:
 				{
 					PROFILE_GL("SetRenderTarget");
-					vsRenderTarget *target = (vsRenderTarget*)op->data.p;
+					vsRenderTarget *target = (vsRenderTarget*)op->GetPointer();
 					SetRenderTarget(target);
 					break;
 				}
@@ -1096,7 +1133,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE_GL("ResolveRenderTarget");
 					m_state.Flush(); // Since resolving a render target can involve a blit, flush render state first.
-					vsRenderTarget *target = (vsRenderTarget*)op->data.p;
+					vsRenderTarget *target = (vsRenderTarget*)op->GetPointer();
 					if ( target )
 						target->Resolve();
 					else // NULL target means main render target.
@@ -1107,14 +1144,14 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE_GL("Blit");
 					m_state.Flush(); // flush our renderer state before blitting!
-					vsRenderTarget *from = (vsRenderTarget*)op->data.p;
-					vsRenderTarget *to = (vsRenderTarget*)op->data.p2;
+					vsRenderTarget *from = (vsRenderTarget*)op->GetPointer();
+					vsRenderTarget *to = (vsRenderTarget*)op->GetPointer2();
 					from->BlitTo(to);
 					break;
 				}
 			case vsDisplayList::OpCode_PushTransform:
 				{
-					vsTransform2D t = op->data.GetTransform();
+					vsTransform2D t = op->GetTransform();
 
 					vsMatrix4x4 localToWorld = m_transformStack[m_currentTransformStackLevel] * t.GetMatrix();
 					m_transformStack[++m_currentTransformStackLevel] = localToWorld;
@@ -1126,10 +1163,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_PushTranslation:
 				{
-					vsVector3D &v = op->data.vector;
-
 					vsMatrix4x4 m;
-					m.SetTranslation(v);
+					m.SetTranslation( op->GetVector3D() );
 					vsMatrix4x4 localToWorld = m_transformStack[m_currentTransformStackLevel] * m;
 					m_transformStack[++m_currentTransformStackLevel] = localToWorld;
 					m_currentLocalToWorld = &m_transformStack[m_currentTransformStackLevel];
@@ -1139,7 +1174,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_PushMatrix4x4:
 				{
-					vsMatrix4x4 m = op->data.GetMatrix4x4();
+					vsMatrix4x4 m;
+					op->GetMatrix4x4( &m );
 					vsMatrix4x4 localToWorld = m_transformStack[m_currentTransformStackLevel] * m;
 					m_transformStack[++m_currentTransformStackLevel] = localToWorld;
 					m_currentLocalToWorld = &m_transformStack[m_currentTransformStackLevel];
@@ -1149,8 +1185,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetMatrix4x4:
 				{
-					const vsMatrix4x4& m = op->data.matrix4x4;
-					m_transformStack[++m_currentTransformStackLevel] = m;
+					op->GetMatrix4x4( &m_transformStack[++m_currentTransformStackLevel] );
 					m_currentLocalToWorld = &m_transformStack[m_currentTransformStackLevel];
 					m_currentLocalToWorldCount = 1;
 					m_currentLocalToWorldBuffer = NULL;
@@ -1158,8 +1193,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetMatrices4x4:
 				{
-					vsMatrix4x4 *m = (vsMatrix4x4*)op->data.p;
-					int count = op->data.i;
+					vsMatrix4x4 *m = (vsMatrix4x4*)op->GetPointer();
+					int count = op->GetCount();
 					m_transformStack[++m_currentTransformStackLevel] = m[0];
 					m_currentLocalToWorld = m;
 					m_currentLocalToWorldCount = count;
@@ -1168,7 +1203,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetMatrices4x4Buffer:
 				{
-					vsRenderBuffer *b = (vsRenderBuffer*)op->data.p;
+					vsRenderBuffer *b = (vsRenderBuffer*)op->GetPointer();
 					m_transformStack[++m_currentTransformStackLevel] = vsMatrix4x4::Identity;
 					m_currentLocalToWorld = NULL;
 					m_currentLocalToWorldCount = b->GetActiveMatrix4x4ArraySize();
@@ -1177,7 +1212,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetShaderValues:
 				{
-					vsShaderValues *sv = (vsShaderValues*)op->data.p;
+					vsShaderValues *sv = (vsShaderValues*)op->GetPointer();
 					m_currentShaderValues = sv;
 					break;
 				}
@@ -1196,7 +1231,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetWorldToViewMatrix4x4:
 				{
-					m_currentWorldToView = op->data.GetMatrix4x4();
+					op->GetMatrix4x4( &m_currentWorldToView );
 					break;
 				}
 			case vsDisplayList::OpCode_PopTransform:
@@ -1214,20 +1249,19 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetProjectionMatrix4x4:
 				{
-					vsMatrix4x4 &m = op->data.GetMatrix4x4();
-					m_currentViewToProjection = m;
+					op->GetMatrix4x4( &m_currentViewToProjection );
 					break;
 				}
 			case vsDisplayList::OpCode_VertexArray:
 				{
-					m_currentVertexArray = (vsVector3D*)op->data.p;
-					m_currentVertexArrayCount = op->data.i;
+					m_currentVertexArray = (vsVector3D*)op->GetArray();
+					m_currentVertexArrayCount = op->GetCount();
 					m_currentVertexBuffer = NULL;
 					break;
 				}
 			case vsDisplayList::OpCode_VertexBuffer:
 				{
-					m_currentVertexBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentVertexBuffer = (vsRenderBuffer *)op->GetPointer();
 					m_currentVertexArray = NULL;
 					m_currentVertexArrayCount = 0;
 					m_currentVertexBuffer->BindVertexBuffer( &m_state );
@@ -1235,13 +1269,13 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_NormalArray:
 				{
-					m_currentNormalArray = (vsVector3D*)op->data.p;
-					m_currentNormalArrayCount = op->data.i;
+					m_currentNormalArray = (vsVector3D*)op->GetArray();
+					m_currentNormalArrayCount = op->GetCount();
 					break;
 				}
 			case vsDisplayList::OpCode_NormalBuffer:
 				{
-					m_currentNormalBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentNormalBuffer = (vsRenderBuffer *)op->GetPointer();
 					m_currentNormalBuffer->BindNormalBuffer( &m_state );
 					m_currentNormalArray = NULL;
 					m_currentNormalArrayCount = 0;
@@ -1266,15 +1300,15 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_TexelArray:
 				{
-					m_currentTexelArray = (vsVector2D*)op->data.p;
-					m_currentTexelArrayCount = op->data.i;
-					vsRenderBuffer::BindTexelArray( &m_state, op->data.p, op->data.i );
+					m_currentTexelArray = (vsVector2D*)op->GetArray();
+					m_currentTexelArrayCount = op->GetCount();
+					vsRenderBuffer::BindTexelArray( &m_state, op->GetArray(), op->GetCount() );
 					m_state.SetBool( vsRendererState::ClientBool_TextureCoordinateArray, true );
 					break;
 				}
 			case vsDisplayList::OpCode_TexelBuffer:
 				{
-					m_currentTexelBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentTexelBuffer = (vsRenderBuffer *)op->GetPointer();
 					m_currentTexelArray = NULL;
 					m_currentTexelArrayCount = 0;
 					m_currentTexelBuffer->BindTexelBuffer( &m_state );
@@ -1287,13 +1321,13 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_ColorArray:
 				{
-					m_currentColorArray = (vsColor*)op->data.p;
-					m_currentColorArrayCount = op->data.i;
+					m_currentColorArray = (vsColor*)op->GetArray();
+					m_currentColorArrayCount = op->GetCount();
 					break;
 				}
 			case vsDisplayList::OpCode_ColorBuffer:
 				{
-					m_currentColorBuffer = (vsRenderBuffer *)op->data.p;
+					m_currentColorBuffer = (vsRenderBuffer *)op->GetPointer();
 					m_currentColorBuffer->BindColorBuffer( &m_state );
 					m_currentColorArray = 0;
 					m_currentColorArrayCount = 0;
@@ -1350,14 +1384,14 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					m_currentVertexArray = NULL;
 					m_currentVertexArrayCount = 0;
 
-					vsRenderBuffer *buffer = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *buffer = (vsRenderBuffer *)op->GetPointer();
 					buffer->Bind( &m_state );
 					break;
 				}
 			case vsDisplayList::OpCode_UnbindBuffer:
 				{
 					PROFILE_GL("UnbindBuffer");
-					vsRenderBuffer *buffer = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *buffer = (vsRenderBuffer *)op->GetPointer();
 					buffer->Unbind( &m_state );
 					break;
 				}
@@ -1365,14 +1399,14 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("LineListArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_LINES, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					vsRenderBuffer::DrawElementsImmediate( GL_LINES, op->GetArray(), op->GetCount(), m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_LineStripArray:
 				{
 					PROFILE("LineStripArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_LINE_STRIP, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					vsRenderBuffer::DrawElementsImmediate( GL_LINE_STRIP, op->GetArray(), op->GetCount(), m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_TriangleListArray:
@@ -1381,7 +1415,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					PROFILE("TriangleListArray");
 					FlushRenderState();
 
-					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLES, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLES, op->GetArray(), op->GetCount(), m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_TriangleStripArray:
@@ -1389,7 +1423,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					// PROFILE_GL("TriangleStripArray");
 					PROFILE("TriangleStripArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_STRIP, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
+					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_STRIP, op->GetArray(), op->GetCount(), m_currentLocalToWorldCount );
 					break;
 				}
 			case vsDisplayList::OpCode_TriangleStripBuffer:
@@ -1397,7 +1431,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					vsString section = m_currentLocalToWorldCount == 1 ? "TriangleStripBuffer" : "TriangleStripBufferInstanced";
 					PROFILE(section);
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)op->GetPointer();
 					ib->TriStripBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1407,7 +1441,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					PROFILE(section);
 					// PROFILE_GL("TriangleListBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)op->GetPointer();
 					ib->TriListBuffer(m_currentLocalToWorldCount);
 					// m_currentShader->ValidateCache( m_currentMaterial );
 					break;
@@ -1416,7 +1450,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("TriangleFanBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)op->GetPointer();
 					ib->TriFanBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1424,7 +1458,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("LineListBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)op->GetPointer();
 					ib->LineListBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1432,7 +1466,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("LineStripBuffer");
 					FlushRenderState();
-					vsRenderBuffer *ib = (vsRenderBuffer *)op->data.p;
+					vsRenderBuffer *ib = (vsRenderBuffer *)op->GetPointer();
 					ib->LineStripBuffer(m_currentLocalToWorldCount);
 					break;
 				}
@@ -1440,16 +1474,16 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				{
 					PROFILE("TriangleFanArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_FAN, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
-					// glDrawElements( GL_TRIANGLE_FAN, op->data.GetUInt(), GL_UNSIGNED_SHORT, op->data.p );
+					vsRenderBuffer::DrawElementsImmediate( GL_TRIANGLE_FAN, op->GetArray(), op->GetCount(), m_currentLocalToWorldCount );
+					// glDrawElements( GL_TRIANGLE_FAN, op->GetCount(), GL_UNSIGNED_SHORT, op->GetArray() );
 					break;
 				}
 			case vsDisplayList::OpCode_PointsArray:
 				{
 					PROFILE("PointsArray");
 					FlushRenderState();
-					vsRenderBuffer::DrawElementsImmediate( GL_POINTS, op->data.p, op->data.GetUInt(), m_currentLocalToWorldCount );
-					// glDrawElements( GL_POINTS, op->data.GetUInt(), GL_UNSIGNED_SHORT, op->data.p );
+					vsRenderBuffer::DrawElementsImmediate( GL_POINTS, op->GetArray(), op->GetCount(), m_currentLocalToWorldCount );
+					// glDrawElements( GL_POINTS, op->GetCount(), GL_UNSIGNED_SHORT, op->GetArray() );
 					break;
 				}
 			case vsDisplayList::OpCode_Light:
@@ -1457,7 +1491,8 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 					PROFILE("Light");
 					if ( m_lightCount < MAX_LIGHTS - 1 )
 					{
-						vsLight &l = op->data.light;
+						vsLight l;
+						op->GetLight( &l );
 						if ( l.m_type == vsLight::Type_Ambient )
 						{
 							m_lightStatus[m_lightCount].type = 1;
@@ -1491,9 +1526,10 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_Fog:
 				{
-					vsColor fogColor = op->data.fog.GetColor();
-					m_currentFogColor = fogColor;
-					m_currentFogDensity = op->data.fog.GetDensity();
+					vsFog fog;
+					op->GetFog( &fog );
+					m_currentFogColor = fog.GetColor();
+					m_currentFogDensity = fog.GetDensity();
 					break;
 				}
 			case vsDisplayList::OpCode_ClearFog:
@@ -1537,7 +1573,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 			case vsDisplayList::OpCode_EnableScissor:
 				{
 					m_state.SetBool( vsRendererState::Bool_ScissorTest, true );
-					const vsBox2D& box = op->data.box2D;
+					vsBox2D box = op->GetBox2D();
 					GLsizei x = (GLsizei)(box.GetMin().x * m_viewportWidthPixels);
 					GLsizei y = (GLsizei)(box.GetMin().y * m_viewportHeightPixels);
 					GLsizei wid = (GLsizei)(box.Width() * m_viewportWidthPixels);
@@ -1553,7 +1589,7 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_SetViewport:
 				{
-					const vsBox2D& box = op->data.box2D;
+					vsBox2D box = op->GetBox2D();
 					{
 						int currentTargetWidth = m_currentRenderTarget->GetViewportWidth();
 						int currentTargetHeight = m_currentRenderTarget->GetViewportHeight();
@@ -1573,14 +1609,27 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 				}
 			case vsDisplayList::OpCode_Debug:
 				{
-					if ( op->data.string == "screenshot" )
+					vsString message = op->GetString();
+					if ( message == "screenshot" )
 					{
 						static int foo = 0;
 						vsImage img(m_currentRenderTarget->Resolve(0));
 						img.SavePNG_FullAlpha(5, vsFormatString("screenshot-%d.png", foo++));
 					}
 					else
-						vsRenderDebug( op->data.string );
+						vsRenderDebug( message );
+					break;
+				}
+			case vsDisplayList::OpCode_CallList:
+				{
+					vsAssert( callDepth < MAX_CALL_DEPTH, "Display lists nested too deeply!" );
+					if ( callDepth < MAX_CALL_DEPTH )
+					{
+						const char *start = (const char *)op->GetPointer();
+						callStack[callDepth].cursor = start;
+						callStack[callDepth].end = start + op->GetCount();
+						callDepth++;
+					}
 					break;
 				}
 			default:
@@ -1589,7 +1638,16 @@ vsRenderer_OpenGL3::RawRenderDisplayList( vsDisplayList *list )
 		// GL_CHECK("RenderOp");
 		{
 			PROFILE("PopOp");
-			op = list->PopOp();
+			// reaching the end of a called list returns to its caller.
+			while ( callDepth > 0 && callStack[callDepth-1].cursor == callStack[callDepth-1].end )
+				callDepth--;
+			if ( callDepth > 0 )
+			{
+				callStack[callDepth-1].cursor = calledOp.Read( callStack[callDepth-1].cursor );
+				op = &calledOp;
+			}
+			else
+				op = list->PopOpView();
 		}
 	}
 }
@@ -2063,6 +2121,9 @@ vsRenderer_OpenGL3::DestroyShader(GLuint shader)
 vsImage *
 vsRenderer_OpenGL3::Screenshot()
 {
+	// Note that this stalls until the GPU has finished drawing;  to save
+	// screenshots without dropping frames, use vsScreenshotQueue instead.
+	//
 	// bind our main window, which isn't multisampled (since glReadPixels()
 	// doesn't support reading pixels from a framebuffer with MSAA enabled).
 	//
@@ -2225,6 +2286,41 @@ vsRenderer_OpenGL3::SetRenderTarget( vsRenderTarget *target )
 	}
 }
 
+void
+vsRenderer_OpenGL3::MakeRenderContextCurrent()
+{
+	SDL_GL_MakeCurrent( g_sdlWindow, m_sdlGlContext );
+	GL_CHECK("MakeRenderContextCurrent");
+}
+
+void
+vsRenderer_OpenGL3::MakeResourceContextCurrent()
+{
+	if ( !m_resourceGlContext )
+	{
+		// This must be created while our main context is current on this
+		// thread, so that it shares objects with it.
+		m_resourceGlContext = SDL_GL_CreateContext(g_sdlWindow);
+		vsAssertF( m_resourceGlContext, "Failed to create OpenGL resource context: %s", SDL_GetError() );
+
+		// Uploading into an element array buffer needs a bound vertex array
+		// object in core profiles, and VAOs aren't shared between contexts.
+		glGenVertexArrays(1, &s_resourceVao);
+		glBindVertexArray(s_resourceVao);
+	}
+	else
+	{
+		SDL_GL_MakeCurrent( g_sdlWindow, m_resourceGlContext );
+	}
+	GL_CHECK("MakeResourceContextCurrent");
+}
+
+void
+vsRenderer_OpenGL3::ReleaseCurrentContext()
+{
+	SDL_GL_MakeCurrent( g_sdlWindow, NULL );
+}
+
 void
 vsRenderer_OpenGL3::SetLoadingContext()
 {
@@ -33,6 +33,7 @@ class vsVector2D;
 struct SDL_Surface;
 
 #define MAX_STACK_LEVEL (30)
+#define MAX_CALL_DEPTH (8)
 #define CHECK_GL_ERRORS
 
 class vsRenderer_OpenGL3: public vsRenderer
@@ -126,6 +127,7 @@ public:
 
 	static vsRenderer_OpenGL3* Instance() { return static_cast<vsRenderer_OpenGL3*>(vsRenderer::Instance()); }
 
+	bool	VideoModeChanged();
 	bool	CheckVideoMode();
 	virtual void UpdateVideoMode(int width, int height, int depth, WindowType type, int bufferCount, bool antialias, bool vsync);
 	virtual void NotifyResized(int width, int height);
@@ -138,6 +140,15 @@ public:
 	virtual vsRenderTarget *GetMainRenderTarget() { return m_scene; }
 	virtual vsRenderTarget *GetPresentTarget() { return m_window; }
 
+	// Used by vsRenderThread.  While a render thread is running, it owns our
+	// main context, and the main thread makes GL calls (uploading textures
+	// and buffers, compiling shaders) on a separate 'resource' context which
+	// shares objects with it.  Framebuffer objects and vertex array objects
+	// are NOT shared between contexts.
+	void	MakeRenderContextCurrent();
+	void	MakeResourceContextCurrent();
+	void	ReleaseCurrentContext();
+
 	// sets an OpenGL context on the calling thread, for the purposes
 	// of loading data in the background.
 	void	SetLoadingContext();
@@ -20,7 +20,7 @@
 
 #include "VS_OpenGL.h"
 
-vsTransform2D	g_drawingCameraTransform = vsTransform2D::Zero;
+thread_local vsTransform2D	g_drawingCameraTransform = vsTransform2D::Zero;
 
 #if defined(DEBUG_SCENE)
 
@@ -255,7 +255,7 @@ vsScene::Draw( vsDisplayList *list, int flags )
 	{
 		if ( m_is3d || (!m_camera || entity->OnScreen( m_camera->GetCameraTransform() )) )
 		{
-			entity->Draw( m_queue );
+			entity->CachedDraw( m_queue );
 		}
 		entity = entity->GetNext();
 	}
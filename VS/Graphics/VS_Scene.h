@@ -14,6 +14,7 @@
 #include "VS/Math/VS_Vector.h"
 #include "VS/Math/VS_Transform.h"
 #include "VS/Graphics/VS_DisplayList.h"
+#include "VS/Graphics/VS_RenderQueue.h"
 #include "VS/Graphics/VS_Screen.h"
 
 class vsEntity;
@@ -24,7 +25,7 @@ class vsFog;
 class vsLight;
 class vsRenderQueue;
 
-extern vsTransform2D	g_drawingCameraTransform;	// this transform is active during Draw() calls, and should tell the camera transform in LOCAL coordinates!
+extern thread_local vsTransform2D	g_drawingCameraTransform;	// this transform is active during Draw() calls, and should tell the camera transform in LOCAL coordinates!  (Per thread, since scenes may be drawn in parallel)
 
 #define MAX_SCENE_LIGHTS	(8)
 #define MAX_SCENE_STACK		(20)
@@ -94,6 +95,9 @@ public:
 	void			Update( float timeStep );
 	void			Draw( vsDisplayList *list, int flags = 0 );
 
+	// How well our entities' draw caches worked during our most recent Draw().
+	const vsRenderQueue::CacheStats &	GetDrawCacheStats() const { return m_queue->GetCacheStats(); }
+
 	void			RegisterEntityOnTop( vsEntity *sprite );
 	void			RegisterEntityOnBottom( vsEntity *sprite );
 
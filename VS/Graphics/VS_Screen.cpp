@@ -15,10 +15,13 @@
 #include "VS_RenderPipelineStageScenes.h"
 #include "VS_Renderer_OpenGL3.h"
 #include "VS_RenderTarget.h"
+#include "VS_RenderThread.h"
 #include "VS_Scene.h"
+#include "VS_ScreenshotQueue.h"
 #include "VS_System.h"
 #include "VS_TextureManager.h"
 #include "VS_Profile.h"
+#include "VS_FrameArena.h"
 
 #include "VS_TimerSystem.h"
 
@@ -32,6 +35,14 @@ vsScreen::vsScreen(int width, int height, int depth, vsRenderer::WindowType wind
 	m_sceneCount(0),
 	m_fifoUsageLastFrame(0),
 	m_fifoHighWater(0),
+	m_arenaUsageLastFrame(0),
+	m_arenaHighWater(0),
+	m_fifoIndex(0),
+	m_renderThread(NULL),
+	m_renderThreadEnabled(false),
+	m_renderThreadSuspendCount(0),
+	m_parallelSceneRecording(false),
+	m_screenshots(NULL),
 	m_width(width),
 	m_height(height),
 	m_bufferCount(bufferCount),
@@ -68,21 +79,33 @@ vsScreen::vsScreen(int width, int height, int depth, vsRenderer::WindowType wind
 	m_aspectRatio = ((float)m_width)/((float)m_height);
 	vsLog("Screen Ratio:  %f", m_aspectRatio);
 
-	m_fifo = new vsDisplayList(c_fifoSize);
+	m_fifo[0] = new vsDisplayList(c_fifoSize);
+	m_fifo[1] = new vsDisplayList(c_fifoSize);
+
+	m_screenshots = new vsScreenshotQueue;
 }
 
 vsScreen::~vsScreen()
 {
+	SetRenderThreadEnabled(false);
 	vsLog(" >> FIFO High water mark:  %d of %d (%0.2f%% usage)", m_fifoHighWater, c_fifoSize, 100.f * (float)m_fifoHighWater / c_fifoSize);
+	if ( vsFrameArena::Instance() )
+	{
+		size_t arenaSize = vsFrameArena::Instance()->GetSize();
+		vsLog(" >> Frame arena High water mark:  %d of %d (%0.2f%% usage)", m_arenaHighWater, arenaSize, 100.f * (float)m_arenaHighWater / arenaSize);
+	}
 	DestroyScenes();
+	vsDelete( m_screenshots );	// needs the renderer's context
 	vsDelete( m_renderer );
-	vsDelete( m_fifo );
+	vsDelete( m_fifo[0] );
+	vsDelete( m_fifo[1] );
 	s_instance = NULL;
 }
 
 void
 vsScreen::NotifyResized(int width, int height)
 {
+	SuspendRenderThread();
 	m_width = width;
 	m_height = height;
 	m_renderer->NotifyResized(width, height);
@@ -101,6 +124,7 @@ vsScreen::NotifyResized(int width, int height)
 	vsLog("Screen aspect ratio:  %f", m_aspectRatio);
 	m_resized = true;
 	BuildDefaultPipeline();
+	ResumeRenderThread();
 }
 
 void
@@ -115,6 +139,7 @@ vsScreen::UpdateVideoMode(int width, int height, int depth, vsRenderer::WindowTy
 			vsync == m_vsync )
 		return;
 
+	SuspendRenderThread();
 	m_bufferCount = bufferCount;
 	m_aspectRatio = ((float)m_width)/((float)m_height);
 	m_depth = depth;
@@ -139,6 +164,7 @@ vsScreen::UpdateVideoMode(int width, int height, int depth, vsRenderer::WindowTy
 	vsLog("Screen aspect ratio:  %f", m_aspectRatio);
 	m_resized = true;
 	BuildDefaultPipeline();
+	ResumeRenderThread();
 }
 
 void
@@ -146,7 +172,17 @@ vsScreen::CheckVideoMode()
 {
 	// note that we might move and resize at the same time.  We don't ever
 	// want to set 'm_resized' to false, except in 'Update'!
-	m_resized |= m_renderer->CheckVideoMode();
+	//
+	// This runs on every window move, so don't stop the render thread
+	// unless we actually have render targets to resize;  just checking only
+	// needs it to be idle.
+	vsRenderThread::Sync();
+	if ( m_renderer->VideoModeChanged() )
+	{
+		SuspendRenderThread();
+		m_resized |= m_renderer->CheckVideoMode();
+		ResumeRenderThread();
+	}
 
 	if ( m_resized )
 	{
@@ -161,6 +197,7 @@ void
 vsScreen::CreateScenes(int count)
 {
 	DestroyScenes();
+	vsRenderThread::Sync();
 
 #if defined(DEBUG_SCENE)
 	count++;	// extra layer for our debug data
@@ -183,7 +220,9 @@ vsScreen::BuildDefaultPipeline()
 {
 	vsDelete( m_pipeline );
 	m_pipeline = new vsRenderPipeline(2);
-	m_pipeline->SetStage(0, new vsRenderPipelineStageScenes( m_scene, m_sceneCount, m_renderer->GetMainRenderTarget(), m_defaultRenderSettings, true ));
+	vsRenderPipelineStageScenes *scenes = new vsRenderPipelineStageScenes( m_scene, m_sceneCount, m_renderer->GetMainRenderTarget(), m_defaultRenderSettings, true );
+	scenes->SetParallelRecording( m_parallelSceneRecording );
+	m_pipeline->SetStage(0, scenes);
 	m_pipeline->SetStage(1, new vsRenderPipelineStageBlit( m_renderer->GetMainRenderTarget(), m_renderer->GetPresentTarget() ));
 }
 
@@ -202,6 +241,8 @@ vsScreen::GetPresentTarget()
 void
 vsScreen::DestroyScenes()
 {
+	// the frame in flight may still be drawing things these scenes own.
+	vsRenderThread::Sync();
 	if ( m_pipeline )
 		vsDelete( m_pipeline );
 	if ( m_scene )
@@ -239,36 +280,118 @@ vsScreen::DrawPipeline( vsRenderPipeline *pipeline )
 {
 	PROFILE_GL("DrawPipeline");
 	m_currentSettings = &m_defaultRenderSettings;
+	vsDisplayList *fifo = m_fifo[m_fifoIndex];
+
+	m_screenshots->Update();
 
+	if ( !m_renderThread )
 	{
 		PROFILE_GL("PreRender");
 		m_renderer->PreRender(m_defaultRenderSettings);
 	}
-	m_fifo->Clear();
+	fifo->Clear();
 	{
 		PROFILE("GatherRenderables");
-		pipeline->Draw(m_fifo);
+		pipeline->Draw(fifo);
 	}
 	vsTimerSystem::Instance()->EndGatherTime();
-	m_fifoUsageLastFrame = m_fifo->GetSize();
+	m_fifoUsageLastFrame = fifo->GetSize();
 	if ( m_fifoUsageLastFrame > m_fifoHighWater )
 	{
 		m_fifoHighWater = m_fifoUsageLastFrame;
 // #define TRACE_FIFO_SIZE
 #ifdef TRACE_FIFO_SIZE
 		vsLog(" >> New FIFO High water mark:  %d of %d (%0.2f%% usage)", m_fifoHighWater, c_fifoSize, 100.f * (float)m_fifoHighWater / c_fifoSize);
+#endif
+	}
+	m_arenaUsageLastFrame = vsFrameArena::Instance()->GetUsage();
+	if ( m_arenaUsageLastFrame > m_arenaHighWater )
+	{
+		m_arenaHighWater = m_arenaUsageLastFrame;
+#ifdef TRACE_FIFO_SIZE
+		size_t arenaSize = vsFrameArena::Instance()->GetSize();
+		vsLog(" >> New frame arena High water mark:  %d of %d (%0.2f%% usage)", m_arenaHighWater, arenaSize, 100.f * (float)m_arenaHighWater / arenaSize);
 #endif
 	}
 #ifdef DEBUG_SCENE
-	m_scene[m_sceneCount-1]->Draw(m_fifo);
+	m_scene[m_sceneCount-1]->Draw(fifo);
 #endif
-	m_renderer->RenderDisplayList(m_fifo);
-	vsTimerSystem::Instance()->EndDrawTime();
-	m_renderer->PostRender();
+	if ( m_renderThread )
+	{
+		// The render thread draws and presents this FIFO while we go on to
+		// record the next frame into the other one.
+		m_renderThread->Submit(fifo, m_defaultRenderSettings);
+		vsTimerSystem::Instance()->EndDrawTime();
+		m_fifoIndex = 1 - m_fifoIndex;
+	}
+	else
+	{
+		m_renderer->RenderDisplayList(fifo);
+		vsTimerSystem::Instance()->EndDrawTime();
+		m_renderer->PostRender();
+	}
+	vsDisplayList::FifoSubmitted();
 
 	m_currentSettings = NULL;
 }
 
+void
+vsScreen::StartRenderThread()
+{
+	if ( !m_renderThread )
+		m_renderThread = new vsRenderThread( static_cast<vsRenderer_OpenGL3*>(m_renderer) );
+}
+
+void
+vsScreen::StopRenderThread()
+{
+	vsDelete( m_renderThread );
+}
+
+void
+vsScreen::SetParallelSceneRecording( bool enabled )
+{
+	if ( enabled == m_parallelSceneRecording )
+		return;
+	m_parallelSceneRecording = enabled;
+	vsLog("Parallel scene recording %s", enabled ? "enabled" : "disabled");
+
+	if ( m_scene )
+		BuildDefaultPipeline();
+}
+
+void
+vsScreen::SetRenderThreadEnabled( bool enabled )
+{
+	if ( enabled == m_renderThreadEnabled )
+		return;
+	m_renderThreadEnabled = enabled;
+	vsLog("Render thread %s", enabled ? "enabled" : "disabled");
+
+	if ( m_renderThreadSuspendCount == 0 )
+	{
+		if ( enabled )
+			StartRenderThread();
+		else
+			StopRenderThread();
+	}
+}
+
+void
+vsScreen::SuspendRenderThread()
+{
+	if ( m_renderThreadSuspendCount++ == 0 )
+		StopRenderThread();
+}
+
+void
+vsScreen::ResumeRenderThread()
+{
+	vsAssert( m_renderThreadSuspendCount > 0, "Unbalanced call to ResumeRenderThread" );
+	if ( --m_renderThreadSuspendCount == 0 && m_renderThreadEnabled )
+		StartRenderThread();
+}
+
 vsScene *
 vsScreen::GetScene(int i)
 {
@@ -357,31 +480,46 @@ vsScreen::SupportsShaders()
 vsImage *
 vsScreen::Screenshot()
 {
-	return m_renderer->Screenshot();
+	SuspendRenderThread();
+	vsImage *result = m_renderer->Screenshot();
+	ResumeRenderThread();
+	return result;
 }
 
 vsImage *
 vsScreen::Screenshot_Async()
 {
-	return m_renderer->Screenshot_Async();
+	SuspendRenderThread();
+	vsImage *result = m_renderer->Screenshot_Async();
+	ResumeRenderThread();
+	return result;
 }
 
 vsImage *
 vsScreen::ScreenshotBack()
 {
-	return m_renderer->ScreenshotBack();
+	SuspendRenderThread();
+	vsImage *result = m_renderer->ScreenshotBack();
+	ResumeRenderThread();
+	return result;
 }
 
 vsImage *
 vsScreen::ScreenshotDepth()
 {
-	return m_renderer->ScreenshotDepth();
+	SuspendRenderThread();
+	vsImage *result = m_renderer->ScreenshotDepth();
+	ResumeRenderThread();
+	return result;
 }
 
 vsImage *
 vsScreen::ScreenshotAlpha()
 {
-	return m_renderer->ScreenshotAlpha();
+	SuspendRenderThread();
+	vsImage *result = m_renderer->ScreenshotAlpha();
+	ResumeRenderThread();
+	return result;
 }
 
 #if defined(DEBUG_SCENE)
@@ -23,6 +23,8 @@ class vsRenderPipeline;
 class vsScene;
 class vsRenderTarget;
 class vsImage;
+class vsRenderThread;
+class vsScreenshotQueue;
 
 
 class vsScreen
@@ -36,8 +38,19 @@ class vsScreen
 	int					m_sceneCount;	// how many layers we have
 	size_t				m_fifoUsageLastFrame;
 	size_t				m_fifoHighWater;
+	size_t				m_arenaUsageLastFrame;
+	size_t				m_arenaHighWater;
 
-	vsDisplayList *		m_fifo;			// our FIFO display list, for rendering
+	vsDisplayList *		m_fifo[2];		// our FIFO display lists, for rendering
+	int					m_fifoIndex;	// which FIFO we're recording into this frame
+
+	vsRenderThread *	m_renderThread;
+	bool				m_renderThreadEnabled;
+	int					m_renderThreadSuspendCount;
+
+	bool				m_parallelSceneRecording;
+
+	vsScreenshotQueue *	m_screenshots;
 
 	int					m_width;
 	int					m_height;
@@ -54,6 +67,8 @@ class vsScreen
     const vsRenderer::Settings *m_currentSettings;
 
 	void BuildDefaultPipeline();
+	void StartRenderThread();
+	void StopRenderThread();
 
 public:
 
@@ -102,9 +117,33 @@ public:
 
 	// Returns the maximum size of the fifo buffer containing our rendering
 	// commands, in bytes.
-	size_t			GetFifoSize() { return m_fifo->GetMaxSize(); }
+	size_t			GetFifoSize() { return m_fifo[0]->GetMaxSize(); }
 	// Returns the number of bytes we used in the fifo buffer last frame.
 	size_t			GetFifoUsage() { return m_fifoUsageLastFrame; }
+	// Returns the number of bytes of frame arena memory we used last frame,
+	// and the most we've ever used in a single frame.
+	size_t			GetFrameArenaUsage() { return m_arenaUsageLastFrame; }
+	size_t			GetFrameArenaHighWater() { return m_arenaHighWater; }
+
+	// When the render thread is enabled, Draw() records each frame and hands
+	// it off to a separate thread to be rendered and presented, and then
+	// returns immediately, so the next frame's update overlaps with this
+	// frame's rendering.  See VS_RenderThread.h for the rules that imposes.
+	void			SetRenderThreadEnabled( bool enabled );
+	bool			IsRenderThreadEnabled() { return m_renderThreadEnabled; }
+
+	// Temporarily stops the render thread (if there is one) and gives the
+	// main OpenGL context back to the calling thread, for operations which
+	// need it;  resizing the window, or creating or destroying framebuffers.
+	// Calls may nest, and must be balanced.
+	void			SuspendRenderThread();
+	void			ResumeRenderThread();
+
+	// Records the default pipeline's scenes in parallel on the job system.
+	// Off by default, since the game's entities must be safe to draw from
+	// other threads;  see vsRenderPipelineStageScenes::SetParallelRecording().
+	void			SetParallelSceneRecording( bool enabled );
+	bool			IsParallelSceneRecording() { return m_parallelSceneRecording; }
 
 	void			CreateScenes(int count);
 	void			DestroyScenes();
@@ -113,12 +152,17 @@ public:
 	void			Draw();
 	void			DrawPipeline( vsRenderPipeline *pipeline );
 
+	// These read the screen back immediately, stalling until the GPU has
+	// caught up.  To save screenshots to disk without stalling, use
+	// GetScreenshotQueue() instead.
 	vsImage *       Screenshot();
 	vsImage *       Screenshot_Async();
 	vsImage *       ScreenshotBack();
 	vsImage *       ScreenshotDepth();
 	vsImage *       ScreenshotAlpha();
 
+	vsScreenshotQueue *	GetScreenshotQueue() { return m_screenshots; }
+
 	vsScene *		GetScene(int i);
 
 #if defined(DEBUG_SCENE)
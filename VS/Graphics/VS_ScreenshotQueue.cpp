@@ -0,0 +1,299 @@
+/*
+ *  VS_ScreenshotQueue.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_ScreenshotQueue.h"
+
+#include "VS_Image.h"
+#include "VS_File.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Utils/VS_Profile.h"
+
+#include <SDL2/SDL.h>
+
+vsScreenshotQueue::vsScreenshotQueue( int maxInFlight ):
+	vsTask("ScreenshotEncoder"),
+	m_requestedHead(NULL),
+	m_requestedTail(NULL),
+	m_encodingHead(NULL),
+	m_encodingTail(NULL),
+	m_finishedHead(NULL),
+	m_finishedTail(NULL),
+	m_readingHead(NULL),
+	m_readingTail(NULL),
+	m_spareReadback(NULL),
+	m_maxInFlight( vsMax(1, maxInFlight) ),
+	m_recordInterval(0),
+	m_recordCountdown(0),
+	m_recordIndex(0),
+	m_recordCompression(1),
+	m_work( new vsSemaphore(0) )
+{
+	Start();
+}
+
+vsScreenshotQueue::~vsScreenshotQueue()
+{
+	// Release() stops the encoder after the capture it's working on, if any.
+	m_work->Release();
+	Join();
+	vsDelete( m_work );
+
+	if ( m_stats.captured > 0 )
+		LogStats();
+
+	Request *lists[4] = { m_requestedHead, m_readingHead, m_encodingHead, m_finishedHead };
+	for ( int i = 0; i < 4; i++ )
+	{
+		while ( lists[i] )
+		{
+			Request *r = lists[i];
+			lists[i] = r->next;
+			DeleteRequest( r );
+		}
+	}
+	vsDelete( m_spareReadback );
+}
+
+void
+vsScreenshotQueue::Append( Request *&head, Request *&tail, Request *request )
+{
+	request->next = NULL;
+	if ( tail )
+		tail->next = request;
+	else
+		head = request;
+	tail = request;
+}
+
+void
+vsScreenshotQueue::DeleteRequest( Request *request )
+{
+	vsDelete( request->readback );
+	vsDelete( request->pixels );
+	vsDelete( request );
+}
+
+bool
+vsScreenshotQueue::Capture( const vsString &filename, vsScreenshotCompleteFunction complete, void *data, int compression )
+{
+	m_lock.Lock();
+	if ( m_stats.inFlight >= m_maxInFlight )
+	{
+		m_stats.dropped++;
+		m_lock.Unlock();
+		return false;
+	}
+	m_stats.inFlight++;
+	m_stats.captured++;
+	m_lock.Unlock();
+
+	Request *r = new Request;
+	r->filename = filename;
+	r->compression = compression;
+	r->complete = complete;
+	r->data = data;
+	r->readback = NULL;
+	r->pixels = NULL;
+	r->success = false;
+
+	// The renderer might be finishing a frame right now, so this will be
+	// either that frame or the next one.
+	m_lock.Lock();
+	Append( m_requestedHead, m_requestedTail, r );
+	m_lock.Unlock();
+	return true;
+}
+
+void
+vsScreenshotQueue::StartRecording( const vsString &prefix, int interval, int compression )
+{
+	m_recordPrefix = prefix;
+	m_recordInterval = vsMax(1, interval);
+	m_recordCountdown = 0;
+	m_recordIndex = 0;
+	m_recordCompression = compression;
+	vsLog("Screenshots: recording every %d frames to '%s*.png'", m_recordInterval, prefix.c_str());
+}
+
+void
+vsScreenshotQueue::StopRecording()
+{
+	if ( !IsRecording() )
+		return;
+	m_recordInterval = 0;
+	vsLog("Screenshots: stopped recording after %d frames", m_recordIndex);
+	LogStats();
+}
+
+void
+vsScreenshotQueue::Update()
+{
+	if ( m_recordInterval > 0 && m_recordCountdown-- == 0 )
+	{
+		m_recordCountdown = m_recordInterval - 1;
+		// Dropped frames keep their numbers, so gaps in a recording show up
+		// as missing files.
+		Capture( vsFormatString("%s%05d.png", m_recordPrefix.c_str(), m_recordIndex++), NULL, NULL, m_recordCompression );
+	}
+
+	m_lock.Lock();
+	Request *r = m_finishedHead;
+	m_finishedHead = m_finishedTail = NULL;
+	m_lock.Unlock();
+
+	while ( r )
+	{
+		Request *next = r->next;
+		if ( r->complete )
+			r->complete( r->filename, r->success, r->data );
+
+		m_lock.Lock();
+		m_stats.inFlight--;
+		m_lock.Unlock();
+
+		DeleteRequest( r );
+		r = next;
+	}
+}
+
+bool
+vsScreenshotQueue::HasReadbackWork()
+{
+	// m_readingHead belongs to the render thread;  m_requestedHead doesn't.
+	if ( m_readingHead )
+		return true;
+
+	m_lock.Lock();
+	bool requested = ( m_requestedHead != NULL );
+	m_lock.Unlock();
+	return requested;
+}
+
+void
+vsScreenshotQueue::Readback( int width, int height )
+{
+	if ( !HasReadbackWork() )
+		return;
+
+	// Frames finish in order, so stop at the first one which isn't ready.
+	while ( m_readingHead && m_readingHead->readback->AsyncReadIsReady() )
+	{
+		Request *r = m_readingHead;
+		m_readingHead = r->next;
+		if ( !m_readingHead )
+			m_readingTail = NULL;
+
+		// Copy the pixels out, so the encoder doesn't need a GL context and
+		// the pixel buffer can be reused.
+		r->pixels = new vsImage( r->readback->GetWidth(), r->readback->GetHeight() );
+		r->pixels->Copy( r->readback );
+		if ( m_spareReadback )
+		{
+			vsDelete( r->readback );
+		}
+		else
+			m_spareReadback = r->readback;
+		r->readback = NULL;
+
+		m_lock.Lock();
+		Append( m_encodingHead, m_encodingTail, r );
+		m_lock.Unlock();
+		m_work->Post();
+	}
+
+	m_lock.Lock();
+	Request *r = m_requestedHead;
+	m_requestedHead = m_requestedTail = NULL;
+	m_lock.Unlock();
+
+	while ( r )
+	{
+		Request *next = r->next;
+		if ( m_spareReadback )
+		{
+			r->readback = m_spareReadback;
+			m_spareReadback = NULL;
+		}
+		else
+			r->readback = new vsImage;
+		r->readback->AsyncReadFramebuffer( width, height );
+		Append( m_readingHead, m_readingTail, r );
+		r = next;
+	}
+}
+
+void
+vsScreenshotQueue::Encode( Request *r )
+{
+	PROFILE("EncodeScreenshot");
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	r->pixels->SavePNG( r->compression, r->filename );
+	r->success = vsFile::Exists( r->filename );
+	if ( !r->success )
+		vsLog("Screenshots: couldn't write '%s'", r->filename.c_str());
+
+	// The pixels are big;  don't hold onto them until the main thread gets
+	// around to us.
+	vsDelete( r->pixels );
+
+	uint64_t end = SDL_GetPerformanceCounter();
+
+	m_lock.Lock();
+	m_stats.completed++;
+	if ( !r->success )
+		m_stats.failed++;
+	m_stats.encodeSeconds += (double)(end - start) / (double)SDL_GetPerformanceFrequency();
+	m_lock.Unlock();
+}
+
+int
+vsScreenshotQueue::Run()
+{
+	vsProfiler::SetThreadName("ScreenshotEncoder");
+	while ( m_work->Wait() )
+	{
+		m_lock.Lock();
+		Request *r = m_encodingHead;
+		if ( r )
+		{
+			m_encodingHead = r->next;
+			if ( !m_encodingHead )
+				m_encodingTail = NULL;
+		}
+		m_lock.Unlock();
+
+		if ( !r )
+			continue;
+
+		Encode( r );
+
+		m_lock.Lock();
+		Append( m_finishedHead, m_finishedTail, r );
+		m_lock.Unlock();
+	}
+	return 0;
+}
+
+vsScreenshotQueue::Stats
+vsScreenshotQueue::GetStats()
+{
+	m_lock.Lock();
+	Stats result = m_stats;
+	m_lock.Unlock();
+	return result;
+}
+
+void
+vsScreenshotQueue::LogStats()
+{
+	Stats s = GetStats();
+	vsLog("Screenshots: %d captured, %d completed (%d failed), %d dropped, %d in flight;  %0.1fms average encode",
+			s.captured, s.completed, s.failed, s.dropped, s.inFlight, s.GetAverageEncodeTime() * 1000.0);
+}
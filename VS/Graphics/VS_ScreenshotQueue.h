@@ -0,0 +1,149 @@
+/*
+ *  VS_ScreenshotQueue.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_SCREENSHOTQUEUE_H
+#define VS_SCREENSHOTQUEUE_H
+
+#include "VS/Utils/VS_Singleton.h"
+#include "VS/Threads/VS_Task.h"
+#include "VS/Threads/VS_Spinlock.h"
+
+class vsImage;
+class vsSemaphore;
+
+// vsScreenshotQueue saves screenshots as PNG files without stalling the game.
+//
+// Capture() asks for the next frame to finish rendering to be saved.  The
+// renderer copies that frame into a pixel buffer object just before it's
+// presented, and a frame or so later, once the GPU has finished the copy,
+// maps it and hands the pixels to a background thread to be compressed and
+// written out.  Each capture's optional 'complete' function is then called
+// on the main thread, from Update(), which vsScreen calls once per frame.
+//
+// StartRecording() captures every Nth frame automatically, into numbered
+// files, for making videos.
+//
+// Only a limited number of captures may be in flight at once, since each
+// one holds a whole frame's worth of pixels (more than once).  Captures
+// beyond that are dropped and counted, rather than making the game wait;
+// if recordings are dropping frames, record less often, or raise the limit
+// with SetMaxInFlight().
+//
+// Everything except Readback() and Run() is called from the main thread.
+
+// called on the main thread.  'success' is false if the file couldn't be written.
+typedef void (*vsScreenshotCompleteFunction)( const vsString &filename, bool success, void *data );
+
+class vsScreenshotQueue : public vsSingleton<vsScreenshotQueue>, public vsTask
+{
+public:
+
+	struct Stats
+	{
+		int		inFlight;		// captures which haven't completed yet
+
+		size_t	captured;		// captures which have been requested
+		size_t	completed;		// of which, have had their files written (or failed to)
+		size_t	failed;
+		size_t	dropped;		// captures we refused, because too many were in flight
+		double	encodeSeconds;	// total time spent compressing and writing
+
+		Stats(): inFlight(0), captured(0), completed(0), failed(0), dropped(0), encodeSeconds(0.0) {}
+
+		double	GetAverageEncodeTime() const { return completed ? encodeSeconds / completed : 0.0; }
+	};
+
+private:
+
+	struct Request
+	{
+		vsString						filename;
+		int								compression;
+		vsScreenshotCompleteFunction	complete;
+		void *							data;
+
+		vsImage *	readback;	// pixel buffer the GPU is copying the frame into
+		vsImage *	pixels;		// the frame, once it's been copied out of 'readback'
+		bool		success;
+
+		Request *	next;
+	};
+
+	vsSpinlock		m_lock;		// protects the lists and stats below
+	Request *		m_requestedHead;	// waiting for the next frame to be rendered
+	Request *		m_requestedTail;
+	Request *		m_encodingHead;		// pixels ready, waiting for the encoder
+	Request *		m_encodingTail;
+	Request *		m_finishedHead;		// written, waiting for Update()
+	Request *		m_finishedTail;
+	Stats			m_stats;
+
+	// renderer thread only
+	Request *		m_readingHead;		// waiting for the GPU to finish copying
+	Request *		m_readingTail;
+	vsImage *		m_spareReadback;	// pixel buffers are expensive to create, so we recycle one
+
+	// main thread only
+	int				m_maxInFlight;
+	int				m_recordInterval;	// frames;  0 if not recording
+	int				m_recordCountdown;
+	int				m_recordIndex;
+	int				m_recordCompression;
+	vsString		m_recordPrefix;
+
+	vsSemaphore *	m_work;
+
+	static void		Append( Request *&head, Request *&tail, Request *request );
+	void			DeleteRequest( Request *request );
+	void			Encode( Request *request );
+
+protected:
+
+	virtual int Run();
+
+public:
+
+	vsScreenshotQueue( int maxInFlight = 4 );
+	// Waits for any captures which are being encoded, and drops the rest
+	// without calling their 'complete' functions.  Needs the main OpenGL
+	// context, so must be destroyed while the render thread is stopped.
+	virtual ~vsScreenshotQueue();
+
+	// Saves the next rendered frame as a PNG file in the write directory.
+	// Returns false (and never calls 'complete') if the capture was dropped.
+	// 'compression' is in [0..9], as for vsImage::SavePNG().
+	bool	Capture( const vsString &filename, vsScreenshotCompleteFunction complete = NULL, void *data = NULL, int compression = 6 );
+
+	// Captures every 'interval'th frame to "<prefix>00000.png", "<prefix>00001.png",
+	// and so on, until StopRecording() is called.
+	void	StartRecording( const vsString &prefix, int interval = 1, int compression = 1 );
+	void	StopRecording();
+	bool	IsRecording() const { return m_recordInterval > 0; }
+
+	void	SetMaxInFlight( int maxInFlight ) { m_maxInFlight = vsMax(1, maxInFlight); }
+
+	// Calls 'complete' functions for finished captures, and makes this
+	// frame's capture if we're recording.
+	void	Update();
+
+	// Called by the renderer on whichever thread owns the main context,
+	// after drawing each frame and before presenting it, with the window's
+	// framebuffer bound for reading.
+	void	Readback( int width, int height );
+
+	// True if Readback() has anything to do this frame.  Called on the same
+	// thread as Readback(), so the renderer can skip binding the window when
+	// nothing's being captured.
+	bool	HasReadbackWork();
+
+	Stats	GetStats();
+	void	LogStats();
+};
+
+#endif // VS_SCREENSHOTQUEUE_H
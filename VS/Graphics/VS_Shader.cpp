@@ -253,6 +253,7 @@ vsShader::Compile( const vsString &vertexShader, const vsString &fragmentShader,
 			}
 
 			m_uniform[ui].name = name;
+			m_uniform[ui].nameId = vsStringId(name);
 			m_uniform[ui].loc = glGetUniformLocation(m_shader, name.c_str());
 			m_uniform[ui].type = type;
 			m_uniform[ui].arraySize = arraySize;
@@ -745,7 +746,7 @@ vsShader::Prepare( vsMaterial *material, vsShaderValues *values )
 			case GL_BOOL:
 				{
 					bool b;
-					if ( !values || !values->UniformB( m_uniform[i].name, b ) )
+					if ( !values || !values->UniformB( m_uniform[i].nameId, b ) )
 						 b = material->UniformB(i);
 					SetUniformValueB( i, b );
 					break;
@@ -755,7 +756,7 @@ vsShader::Prepare( vsMaterial *material, vsShaderValues *values )
 					// if ( m_uniform[i].arraySize == 1 )
 					{
 						float f;
-						if ( !values || !values->UniformF( m_uniform[i].name, f ) )
+						if ( !values || !values->UniformF( m_uniform[i].nameId, f ) )
 							f = material->UniformF(i);
 						SetUniformValueF( i, f );
 					}
@@ -764,7 +765,7 @@ vsShader::Prepare( vsMaterial *material, vsShaderValues *values )
 			case GL_FLOAT_VEC3:
 				{
 					vsVector4D v;
-					if ( !values || !values->UniformVec4( m_uniform[i].name, v ) )
+					if ( !values || !values->UniformVec4( m_uniform[i].nameId, v ) )
 						v = material->UniformVec4(i);
 					SetUniformValueVec3( i, v );
 					break;
@@ -772,7 +773,7 @@ vsShader::Prepare( vsMaterial *material, vsShaderValues *values )
 			case GL_FLOAT_VEC4:
 				{
 					vsVector4D v;
-					if ( !values || !values->UniformVec4( m_uniform[i].name, v ) )
+					if ( !values || !values->UniformVec4( m_uniform[i].nameId, v ) )
 						v = material->UniformVec4(i);
 					SetUniformValueVec4( i, v );
 					break;
@@ -780,7 +781,7 @@ vsShader::Prepare( vsMaterial *material, vsShaderValues *values )
 			case GL_FLOAT_MAT4:
 				{
 					vsMatrix4x4 v;
-					if ( !values || !values->UniformMat4( m_uniform[i].name, v ) )
+					if ( !values || !values->UniformMat4( m_uniform[i].nameId, v ) )
 						v = material->UniformMat4(i);
 					SetUniformValueMat4( i, v );
 					break;
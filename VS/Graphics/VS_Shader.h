@@ -19,6 +19,7 @@ class vsShaderValues;
 #include "VS/Math/VS_Vector.h"
 #include "VS_MaterialInternal.h"
 #include "VS/Utils/VS_AutomaticInstanceList.h"
+#include "VS/Utils/VS_StringId.h"
 
 class vsShader: public vsAutomaticInstanceList<vsShader>
 {
@@ -26,6 +27,7 @@ public:
 	struct Uniform
 	{
 		vsString name;
+		vsStringId nameId;	// for looking up values without hashing 'name' every frame
 		// struct
 		// {
 			int b;
@@ -22,8 +22,9 @@ void
 vsShaderValues::SetUniformF( const vsString& id, float value )
 {
 	{
-		m_value[id].f32 = value;
-		m_value[id].bound = false;
+		Value &v = m_value[id];
+		v.f32 = value;
+		v.bound = false;
 	}
 }
 
@@ -31,8 +32,9 @@ void
 vsShaderValues::SetUniformB( const vsString& id, bool value )
 {
 	{
-		m_value[id].b = value;
-		m_value[id].bound = false;
+		Value &v = m_value[id];
+		v.b = value;
+		v.bound = false;
 	}
 }
 
@@ -40,11 +42,12 @@ void
 vsShaderValues::SetUniformColor( const vsString& id, const vsColor& value )
 {
 	{
-		m_value[id].vec4[0] = value.r;
-		m_value[id].vec4[1] = value.g;
-		m_value[id].vec4[2] = value.b;
-		m_value[id].vec4[3] = value.a;
-		m_value[id].bound = false;
+		Value &v = m_value[id];
+		v.vec4[0] = value.r;
+		v.vec4[1] = value.g;
+		v.vec4[2] = value.b;
+		v.vec4[3] = value.a;
+		v.bound = false;
 	}
 }
 
@@ -52,11 +55,12 @@ void
 vsShaderValues::SetUniformVec3( const vsString& id, const vsVector3D& value )
 {
 	{
-		m_value[id].vec4[0] = value.x;
-		m_value[id].vec4[1] = value.y;
-		m_value[id].vec4[2] = value.z;
-		m_value[id].vec4[3] = 0.0;
-		m_value[id].bound = false;
+		Value &v = m_value[id];
+		v.vec4[0] = value.x;
+		v.vec4[1] = value.y;
+		v.vec4[2] = value.z;
+		v.vec4[3] = 0.0;
+		v.bound = false;
 	}
 }
 
@@ -64,11 +68,12 @@ void
 vsShaderValues::SetUniformVec4( const vsString& id, const vsVector4D& value )
 {
 	{
-		m_value[id].vec4[0] = value.x;
-		m_value[id].vec4[1] = value.y;
-		m_value[id].vec4[2] = value.z;
-		m_value[id].vec4[3] = value.w;
-		m_value[id].bound = false;
+		Value &v = m_value[id];
+		v.vec4[0] = value.x;
+		v.vec4[1] = value.y;
+		v.vec4[2] = value.z;
+		v.vec4[3] = value.w;
+		v.bound = false;
 	}
 }
 
@@ -76,8 +81,9 @@ bool
 vsShaderValues::BindUniformF( const vsString& id, const float* value )
 {
 	{
-		m_value[id].bind = value;
-		m_value[id].bound = true;
+		Value &v = m_value[id];
+		v.bind = value;
+		v.bound = true;
 		return true;
 	}
 	return false;
@@ -87,8 +93,9 @@ bool
 vsShaderValues::BindUniformB( const vsString& id, const bool* value )
 {
 	{
-		m_value[id].bind = value;
-		m_value[id].bound = true;
+		Value &v = m_value[id];
+		v.bind = value;
+		v.bound = true;
 		return true;
 	}
 	return false;
@@ -98,8 +105,9 @@ bool
 vsShaderValues::BindUniformColor( const vsString& id, const vsColor* value )
 {
 	{
-		m_value[id].bind = value;
-		m_value[id].bound = true;
+		Value &v = m_value[id];
+		v.bind = value;
+		v.bound = true;
 		return true;
 	}
 	return false;
@@ -109,8 +117,9 @@ bool
 vsShaderValues::BindUniformVec3( const vsString& id, const vsVector3D* value )
 {
 	{
-		m_value[id].bind = value;
-		m_value[id].bound = true;
+		Value &v = m_value[id];
+		v.bind = value;
+		v.bound = true;
 		return true;
 	}
 	return false;
@@ -120,8 +129,9 @@ bool
 vsShaderValues::BindUniformVec4( const vsString& id, const vsVector4D* value )
 {
 	{
-		m_value[id].bind = value;
-		m_value[id].bound = true;
+		Value &v = m_value[id];
+		v.bind = value;
+		v.bound = true;
 		return true;
 	}
 	return false;
@@ -131,8 +141,9 @@ bool
 vsShaderValues::BindUniformMat4( const vsString& id, const vsMatrix4x4* value )
 {
 	{
-		m_value[id].bind = value;
-		m_value[id].bound = true;
+		Value &v = m_value[id];
+		v.bind = value;
+		v.bound = true;
 		return true;
 	}
 	return false;
@@ -141,8 +152,13 @@ vsShaderValues::BindUniformMat4( const vsString& id, const vsMatrix4x4* value )
 bool
 vsShaderValues::Has( const vsString& name )
 {
-	return (m_value.FindItem(name) != NULL) ||
-		( m_parent && m_parent->Has(name) );
+	return FindValue(name) != NULL;
+}
+
+bool
+vsShaderValues::Has( const vsStringId& name )
+{
+	return FindValue(name) != NULL;
 }
 
 // float
@@ -182,16 +198,36 @@ vsShaderValues::Has( const vsString& name )
 // }
 //
 
+vsShaderValues::Value*
+vsShaderValues::FindValue( const char *name, uint32_t length, uint32_t hash )
+{
+	// hash once, and then walk up through our parents.
+	for ( vsShaderValues *values = this; values; values = values->m_parent )
+	{
+		Value* v = values->m_value.FindItem(name, length, hash);
+		if ( v )
+			return v;
+	}
+	return NULL;
+}
+
+vsShaderValues::Value*
+vsShaderValues::FindValue( const vsString& name )
+{
+	return FindValue( name.c_str(), (uint32_t)name.length(), vsCalculateHash(name) );
+}
+
+vsShaderValues::Value*
+vsShaderValues::FindValue( const vsStringId& name )
+{
+	return FindValue( name.c_str(), name.length(), name.GetHash() );
+}
+
 bool
-vsShaderValues::UniformF( const vsString& id, float& out )
+vsShaderValues::ReadF( const Value* v, float& out )
 {
-	Value* v = m_value.FindItem(id);
 	if ( !v )
-	{
-		if ( m_parent )
-			return m_parent->UniformF(id,out);
 		return false;
-	}
 	if ( v->bound )
 		out = *(float*)v->bind;
 	else
@@ -200,15 +236,10 @@ vsShaderValues::UniformF( const vsString& id, float& out )
 }
 
 bool
-vsShaderValues::UniformB( const vsString& id, bool& out )
+vsShaderValues::ReadB( const Value* v, bool& out )
 {
-	Value* v = m_value.FindItem(id);
 	if ( !v )
-	{
-		if ( m_parent )
-			return m_parent->UniformB(id,out);
 		return false;
-	}
 	if ( v->bound )
 		out = *(bool*)v->bind;
 	else
@@ -217,15 +248,10 @@ vsShaderValues::UniformB( const vsString& id, bool& out )
 }
 
 bool
-vsShaderValues::UniformVec4( const vsString& id, vsVector4D& out )
+vsShaderValues::ReadVec4( const Value* v, vsVector4D& out )
 {
-	Value* v = m_value.FindItem(id);
 	if ( !v )
-	{
-		if ( m_parent )
-			return m_parent->UniformVec4(id,out);
 		return false;
-	}
 	if ( v->bound )
 		out = *(vsVector4D*)v->bind;
 	else
@@ -234,15 +260,10 @@ vsShaderValues::UniformVec4( const vsString& id, vsVector4D& out )
 }
 
 bool
-vsShaderValues::UniformMat4( const vsString& id, vsMatrix4x4& out )
+vsShaderValues::ReadMat4( const Value* v, vsMatrix4x4& out )
 {
-	Value* v = m_value.FindItem(id);
 	if ( !v )
-	{
-		if ( m_parent )
-			return m_parent->UniformMat4(id,out);
 		return false;
-	}
 	if ( v->bound )
 		out = *(vsMatrix4x4*)v->bind;
 	// else
@@ -250,3 +271,50 @@ vsShaderValues::UniformMat4( const vsString& id, vsMatrix4x4& out )
 	return true;
 }
 
+bool
+vsShaderValues::UniformF( const vsString& id, float& out )
+{
+	return ReadF( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformB( const vsString& id, bool& out )
+{
+	return ReadB( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformVec4( const vsString& id, vsVector4D& out )
+{
+	return ReadVec4( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformMat4( const vsString& id, vsMatrix4x4& out )
+{
+	return ReadMat4( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformF( const vsStringId& id, float& out )
+{
+	return ReadF( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformB( const vsStringId& id, bool& out )
+{
+	return ReadB( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformVec4( const vsStringId& id, vsVector4D& out )
+{
+	return ReadVec4( FindValue(id), out );
+}
+
+bool
+vsShaderValues::UniformMat4( const vsStringId& id, vsMatrix4x4& out )
+{
+	return ReadMat4( FindValue(id), out );
+}
@@ -12,6 +12,7 @@
 
 #include "VS/Utils/VS_HashTable.h"
 #include "VS/Utils/VS_String.h"
+#include "VS/Utils/VS_StringId.h"
 
 class vsColor;
 class vsShader;
@@ -37,6 +38,14 @@ class vsShaderValues
 
 	vsShaderValues *m_parent;
 	vsHashTable<Value> m_value;
+
+	Value* FindValue( const char *name, uint32_t length, uint32_t hash );
+	Value* FindValue( const vsString& name );
+	Value* FindValue( const vsStringId& name );
+	static bool ReadF( const Value* v, float& out );
+	static bool ReadB( const Value* v, bool& out );
+	static bool ReadVec4( const Value* v, vsVector4D& out );
+	static bool ReadMat4( const Value* v, vsMatrix4x4& out );
 public:
 
 	vsShaderValues();
@@ -60,6 +69,13 @@ public:
 	bool UniformB( const vsString& name, bool& out );
 	bool UniformVec4( const vsString& name, vsVector4D& out );
 	bool UniformMat4( const vsString& name, vsMatrix4x4& out );
+
+	// These versions don't need to hash the name;  use them in per-frame code.
+	bool Has( const vsStringId& name );
+	bool UniformF( const vsStringId& name, float& out );
+	bool UniformB( const vsStringId& name, bool& out );
+	bool UniformVec4( const vsStringId& name, vsVector4D& out );
+	bool UniformMat4( const vsStringId& name, vsMatrix4x4& out );
 };
 
 #endif // VS_SHADERVALUES_H
@@ -15,7 +15,7 @@
 #include "VS_File.h"
 #include "VS_Record.h"
 
-extern vsTransform2D g_drawingCameraTransform;
+extern thread_local vsTransform2D g_drawingCameraTransform;
 
 vsSprite *
 vsSprite::Load( const vsString &filename )
@@ -205,6 +205,7 @@ vsSprite::SetDisplayList( vsDisplayList *list )
 {
 	m_displayList = list;
 	CalculateBoundingRadius();
+	InvalidateDrawCache();
 }
 
 void
@@ -212,6 +213,7 @@ vsSprite::AddFragment( vsFragment *fragment )
 {
 	if ( fragment )
 		m_fragment.AddItem( fragment );
+	InvalidateDrawCache();
 }
 
 void
@@ -219,12 +221,14 @@ vsSprite::DestroyFragment( vsFragment *fragment )
 {
 	if ( fragment )
 		m_fragment.RemoveItem( fragment );
+	InvalidateDrawCache();
 }
 
 void
 vsSprite::ClearFragments()
 {
 	m_fragment.Clear();
+	InvalidateDrawCache();
 }
 
 
@@ -341,4 +345,5 @@ vsSprite::Rotate(float angle)
     vsAngle a = m_transform.GetAngle();
     a.Rotate(angle);
     m_transform.SetAngle( a );
+	InvalidateDrawCache();
 }
@@ -55,17 +55,17 @@ public:
 
 	void				LoadFrom( vsRecord *record );
 
-	void				SetColor( vsColor c ) { m_color = c; m_useColor = true; }
+	void				SetColor( vsColor c ) { m_color = c; m_useColor = true; InvalidateDrawCache(); }
 	void				SetOverlay( vsOverlay *o ) { m_overlay = o; }
-	void				SetMaterial( const vsString &name ) { vsDelete( m_material ); m_material = new vsMaterial(name); }
-	void				SetMaterial( vsMaterial *mat ) { vsDelete( m_material ); m_material = mat; }
+	void				SetMaterial( const vsString &name ) { vsDelete( m_material ); m_material = new vsMaterial(name); InvalidateDrawCache(); }
+	void				SetMaterial( vsMaterial *mat ) { vsDelete( m_material ); m_material = mat; InvalidateDrawCache(); }
 
-	virtual void		SetPosition( const vsVector2D &pos ) { m_transform.SetTranslation( pos ); }
+	virtual void		SetPosition( const vsVector2D &pos ) { m_transform.SetTranslation( pos ); InvalidateDrawCache(); }
 	const vsVector2D &	GetPosition() { return m_transform.GetTranslation(); }
-	virtual void		SetAngle( const vsAngle &angle ) { m_transform.SetAngle( angle ); }
+	virtual void		SetAngle( const vsAngle &angle ) { m_transform.SetAngle( angle ); InvalidateDrawCache(); }
 	const vsAngle &		GetAngle() { return m_transform.GetAngle(); }
-	void				SetScale( float scale ) { m_transform.SetScale( vsVector2D(scale,scale) ); }
-	void				SetScale( const vsVector2D &scale ) { m_transform.SetScale( scale ); }
+	void				SetScale( float scale ) { m_transform.SetScale( vsVector2D(scale,scale) ); InvalidateDrawCache(); }
+	void				SetScale( const vsVector2D &scale ) { m_transform.SetScale( scale ); InvalidateDrawCache(); }
 	const vsVector2D &	GetScale() { return m_transform.GetScale(); }
 
 	vsVector2D			GetWorldPosition();	// try to get our world position.  Note that this will only work if all of our parents only adjust the draw transformation using vsSprite built-in transforms!
@@ -77,7 +77,7 @@ public:
 	vsFragment *		GetFragment(int i) { return m_fragment[i]; }
 	size_t				GetFragmentCount() { return m_fragment.ItemCount(); }
 
-	void				SetBoundingBox( const vsBox2D &box ) { m_boundingBox = box; }
+	void				SetBoundingBox( const vsBox2D &box ) { m_boundingBox = box; InvalidateDrawCache(); }
 	const vsBox2D &		GetBoundingBox() { return m_boundingBox; }
 	void				BuildBoundingBox();
 	void				CalculateBoundingRadius();
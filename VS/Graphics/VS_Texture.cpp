@@ -22,7 +22,20 @@ vsTexture::vsTexture( vsTexture *other ):
 {
 }
 
+vsTexture::vsTexture( vsTextureInternal *cached )
+{
+	m_resource = cached;
+	m_resource->AddReference();
+}
+
 vsTexture::~vsTexture()
 {
 }
 
+vsTexture *
+vsTexture::LoadAsync( const vsString &filename_in, vsTextureLoadedFunction callback, void *callbackData )
+{
+	vsTextureInternal *ti = vsTextureManager::Instance()->LoadTextureAsync( filename_in, callback, callbackData );
+	return new vsTexture( ti );
+}
+
@@ -12,15 +12,22 @@
 
 //class vsTextureInternal;
 #include "VS_TextureInternal.h"
+#include "VS_TextureLoader.h"
 #include "VS/Utils/VS_Cache.h"
 
 class vsTexture : public vsCacheReference<vsTextureInternal>
 {
+	vsTexture(vsTextureInternal *cached);
 public:
 	vsTexture(const vsString &filename_in);
 	vsTexture(vsTexture *other);
 	~vsTexture();
-	
+
+	// Returns a texture immediately, which will be loaded in the background.
+	// See vsTextureManager::LoadTextureAsync().
+	static vsTexture *	LoadAsync( const vsString &filename_in, vsTextureLoadedFunction callback = NULL, void *callbackData = NULL );
+
+	bool	IsLoaded() const { return GetResource()->IsLoaded(); }
 };
 
 #endif //VS_TEXTURE_H
@@ -28,7 +28,11 @@ vsTextureInternal::vsTextureInternal( const vsString &filename_in ):
 	vsResource(filename_in),
 	m_texture(0),
 	m_premultipliedAlpha(true),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	vsString filename = vsFile::GetFullFilename(filename_in);
 
@@ -40,7 +44,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsImage *maker ):
 	vsResource(name),
 	m_texture(0),
 	m_premultipliedAlpha(true),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	m_nearestSampling = false;
 }
@@ -49,7 +57,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsSurface *surface,
 	vsResource(name),
 	m_texture(0),
 	m_premultipliedAlpha(true),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	if ( surface )
 		m_texture = (depth) ? surface->m_depth : surface->m_texture;
@@ -60,7 +72,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsRenderBuffer *buff
 	vsResource(name),
 	m_texture(0),
 	m_premultipliedAlpha(false),
-	m_tbo(buffer)
+	m_tbo(buffer),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	GLuint t;
 	glGenTextures(1, &t);
@@ -81,6 +97,14 @@ vsTextureInternal::~vsTextureInternal()
 
 #else // TARGET_OS_IPHONE
 
+// bytes used by a texture with a full mipmap chain;  each level is a quarter
+// the size of the one above, so the whole chain adds about a third.
+static size_t MipmappedByteSize( int width, int height, int bytesPerPixel )
+{
+	size_t base = (size_t)width * height * bytesPerPixel;
+	return base + base / 3;
+}
+
 /* Quick utility function for texture creation */
 void
 vsTextureInternal::SetSurface( vsSurface* surface, int surfaceBuffer, bool depth )
@@ -104,7 +128,11 @@ vsTextureInternal::vsTextureInternal( const vsString &filename_in ):
 	m_texture(0),
 	m_depth(false),
 	m_premultipliedAlpha(false),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	vsImage image(filename_in);
 
@@ -133,6 +161,7 @@ vsTextureInternal::vsTextureInternal( const vsString &filename_in ):
 				image.RawData());
 		glGenerateMipmap(GL_TEXTURE_2D);
 		m_nearestSampling = false;
+		SetByteSize( MipmappedByteSize( w, h, 4 ) );
 	}
 }
 
@@ -141,19 +170,25 @@ vsTextureInternal::vsTextureInternal( const vsString&name, const vsArray<vsStrin
 	m_texture(0),
 	m_depth(false),
 	m_premultipliedAlpha(false),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	GLuint t;
 	glGenTextures(1, &t);
 	m_texture = t;
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 
+	size_t byteSize = 0;
 	for ( int i = 0; i < mipmaps.ItemCount(); i++ )
 	{
 		vsImage image(mipmaps[i]);
 
 		int w = image.GetWidth();
 		int h = image.GetHeight();
+		byteSize += (size_t)w * h * 4;
 
 		m_width = w;
 		m_height = w;
@@ -169,6 +204,7 @@ vsTextureInternal::vsTextureInternal( const vsString&name, const vsArray<vsStrin
 				GL_UNSIGNED_INT_8_8_8_8_REV,
 				image.RawData());
 	}
+	SetByteSize( byteSize );
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
@@ -191,7 +227,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsImage *image ):
 	m_texture(0),
 	m_depth(false),
 	m_premultipliedAlpha(false),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	int w = image->GetWidth();
 	int h = image->GetHeight();
@@ -216,6 +256,7 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsImage *image ):
 			image->RawData());
 	glGenerateMipmap(GL_TEXTURE_2D);
 	m_nearestSampling = false;
+	SetByteSize( MipmappedByteSize( w, h, 4 ) );
 }
 
 vsTextureInternal::vsTextureInternal( const vsString &name, vsFloatImage *image ):
@@ -223,7 +264,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsFloatImage *image
 	m_texture(0),
 	m_depth(false),
 	m_premultipliedAlpha(false),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	int w = image->GetWidth();
 	int h = image->GetHeight();
@@ -248,13 +293,18 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsFloatImage *image
 			image->RawData());
 	glGenerateMipmap(GL_TEXTURE_2D);
 	m_nearestSampling = false;
+	SetByteSize( MipmappedByteSize( w, h, 16 ) );
 }
 
 vsTextureInternal::vsTextureInternal( const vsString &name, vsRenderBuffer *buffer ):
 	vsResource(name),
 	m_texture(0),
 	m_premultipliedAlpha(false),
-	m_tbo(buffer)
+	m_tbo(buffer),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	GLuint t;
 	glGenTextures(1, &t);
@@ -266,11 +316,58 @@ vsTextureInternal::vsTextureInternal( const vsString &name, uint32_t glTextureId
 	vsResource(name),
 	m_texture(glTextureId),
 	m_premultipliedAlpha(false),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	m_nearestSampling = false;
 }
 
+vsTextureInternal::vsTextureInternal( const vsString &name, vsTextureInternal *placeholder ):
+	vsResource(name),
+	m_texture(placeholder->m_texture),
+	m_glTextureWidth(placeholder->m_width),
+	m_glTextureHeight(placeholder->m_height),
+	m_width(placeholder->m_width),
+	m_height(placeholder->m_height),
+	m_depth(false),
+	m_premultipliedAlpha(false),
+	m_tbo(NULL),
+	m_loaded(false),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
+{
+	m_nearestSampling = false;
+}
+
+void
+vsTextureInternal::FinishLoading( uint32_t glTextureId, int width, int height )
+{
+	vsAssert( !m_loaded, "Finished loading a texture which wasn't loading??" );
+
+	m_texture = glTextureId;
+	m_glTextureWidth = m_width = width;
+	m_glTextureHeight = m_height = height;
+	m_loaded = true;
+	SetByteSize( MipmappedByteSize( width, height, 4 ) );
+
+	ApplySamplingSettings();
+}
+
+void
+vsTextureInternal::ApplySamplingSettings()
+{
+	if ( m_nearestSampling )
+		SetNearestSampling();
+	else if ( !m_linearMipmaps )
+		SetLinearSampling(false);
+	if ( m_clampU || m_clampV )
+		ClampUV( m_clampU, m_clampV );
+}
+
 
 void
 vsTextureInternal::Blit( vsImage *image, const vsVector2D &where)
@@ -309,7 +406,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsSurface *surface,
 	m_height(0),
 	m_depth(depth),
 	m_premultipliedAlpha(true),
-	m_tbo(NULL)
+	m_tbo(NULL),
+	m_loaded(true),
+	m_linearMipmaps(true),
+	m_clampU(false),
+	m_clampV(false)
 {
 	if ( surface )
 	{
@@ -320,8 +421,11 @@ vsTextureInternal::vsTextureInternal( const vsString &name, vsSurface *surface,
 
 vsTextureInternal::~vsTextureInternal()
 {
-	GLuint t = m_texture;
-	glDeleteTextures(1, &t);
+	if ( m_loaded )
+	{
+		GLuint t = m_texture;
+		glDeleteTextures(1, &t);
+	}
 	m_texture = 0;
 
 
@@ -331,22 +435,27 @@ vsTextureInternal::~vsTextureInternal()
 void
 vsTextureInternal::SetNearestSampling()
 {
+	m_nearestSampling = true;
+	if ( !m_loaded )
+		return;
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	m_nearestSampling = true;
 }
 
 void
 vsTextureInternal::SetLinearSampling(bool linearMipmaps)
 {
+	m_nearestSampling = false;
+	m_linearMipmaps = linearMipmaps;
+	if ( !m_loaded )
+		return;
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	if ( linearMipmaps )
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	else
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	m_nearestSampling = false;
 }
 
 #endif // TARGET_OS_IPHONE
@@ -403,6 +512,10 @@ vsTextureInternal::SafeAddColour(uint32_t acolour, uint32_t bcolour)
 void
 vsTextureInternal::ClampUV( bool u, bool v )
 {
+	m_clampU = u;
+	m_clampV = v;
+	if ( !m_loaded )
+		return;
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, u ? GL_CLAMP_TO_EDGE : GL_REPEAT );
 	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, v ? GL_CLAMP_TO_EDGE : GL_REPEAT );
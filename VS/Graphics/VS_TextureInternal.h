@@ -37,6 +37,16 @@ class vsTextureInternal : public vsResource
 
 	bool		m_nearestSampling;
 
+	// While we're being loaded asynchronously, m_texture is the texture
+	// manager's shared placeholder, which mustn't be modified;  sampling
+	// settings are remembered here and applied once our real texture arrives.
+	bool		m_loaded;
+	bool		m_linearMipmaps;
+	bool		m_clampU;
+	bool		m_clampV;
+
+	void		ApplySamplingSettings();
+
 public:
 
 	vsTextureInternal( const vsString &string );
@@ -53,6 +63,12 @@ public:
 	// TODO:  THIS SHOULD GO AWAY!  Textures should all be created by VectorStorm!
 	vsTextureInternal( const vsString &name, uint32_t glTextureId );
 
+	// for textures which are being loaded in the background;  we show
+	// 'placeholder' until FinishLoading() is called.
+	vsTextureInternal( const vsString &name, vsTextureInternal *placeholder );
+	void FinishLoading( uint32_t glTextureId, int width, int height );
+	bool IsLoaded() const { return m_loaded; }
+
 	~vsTextureInternal();
 
 	void		Blit( vsImage *image, const vsVector2D& where);
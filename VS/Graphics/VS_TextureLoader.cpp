@@ -0,0 +1,220 @@
+/*
+ *  VS_TextureLoader.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_TextureLoader.h"
+
+#include "VS_Image.h"
+#include "VS_Renderer_OpenGL3.h"
+#include "VS_TextureInternal.h"
+#include "VS_RenderThread.h"
+#include "VS_OpenGL.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Utils/VS_Profile.h"
+
+vsTextureLoader::vsTextureLoader():
+	vsTask("TextureLoader"),
+	m_pendingHead(NULL),
+	m_pendingTail(NULL),
+	m_finishedHead(NULL),
+	m_finishedTail(NULL),
+	m_extraCallbacks(NULL),
+	m_inFlight(0),
+	m_work( new vsSemaphore(0) )
+{
+	Start();
+}
+
+vsTextureLoader::~vsTextureLoader()
+{
+	m_work->Release();
+	Join();
+	vsDelete( m_work );
+
+	// The thread's gone, so nobody else is touching the lists any more.
+	while ( m_extraCallbacks )
+	{
+		Request *r = m_extraCallbacks;
+		m_extraCallbacks = r->next;
+		vsDelete( r );
+	}
+	while ( m_pendingHead )
+	{
+		Request *r = m_pendingHead;
+		m_pendingHead = r->next;
+		r->texture->ReleaseReference();
+		vsDelete( r );
+	}
+	while ( m_finishedHead )
+	{
+		Request *r = m_finishedHead;
+		m_finishedHead = r->next;
+		GLuint t = r->glTexture;
+		glDeleteTextures(1, &t);
+		r->texture->ReleaseReference();
+		vsDelete( r );
+	}
+}
+
+void
+vsTextureLoader::Append( Request *&head, Request *&tail, Request *request )
+{
+	request->next = NULL;
+	if ( tail )
+		tail->next = request;
+	else
+		head = request;
+	tail = request;
+}
+
+void
+vsTextureLoader::Enqueue( vsTextureInternal *texture, vsTextureLoadedFunction callback, void *callbackData )
+{
+	Request *r = new Request;
+	r->texture = texture;
+	r->filename = texture->GetName();
+	r->callback = callback;
+	r->callbackData = callbackData;
+	r->glTexture = 0;
+	r->width = r->height = 0;
+
+	// Hold a reference, so the texture can't be evicted from the cache while
+	// we're working on it, even if everybody else lets go of it.
+	texture->AddReference();
+	m_inFlight++;
+
+	m_lock.Lock();
+	Append( m_pendingHead, m_pendingTail, r );
+	m_lock.Unlock();
+
+	m_work->Post();
+}
+
+void
+vsTextureLoader::AddCallback( vsTextureInternal *texture, vsTextureLoadedFunction callback, void *callbackData )
+{
+	Request *r = new Request;
+	r->texture = texture;
+	r->callback = callback;
+	r->callbackData = callbackData;
+	r->glTexture = 0;
+	r->width = r->height = 0;
+	r->next = m_extraCallbacks;
+	m_extraCallbacks = r;
+}
+
+int
+vsTextureLoader::Run()
+{
+	vsProfiler::SetThreadName("TextureLoader");
+	while ( m_work->Wait() )
+	{
+		m_lock.Lock();
+		Request *r = m_pendingHead;
+		if ( r )
+		{
+			m_pendingHead = r->next;
+			if ( !m_pendingHead )
+				m_pendingTail = NULL;
+		}
+		m_lock.Unlock();
+
+		if ( !r )
+			continue;
+
+		Load( r );
+
+		m_lock.Lock();
+		Append( m_finishedHead, m_finishedTail, r );
+		m_lock.Unlock();
+	}
+	return 0;
+}
+
+void
+vsTextureLoader::Load( Request *r )
+{
+	// Decoding is the slow part, and doesn't need a GL context, so don't
+	// hold the loading context (and its lock) while we do it.
+	PROFILE("LoadTexture");
+	vsImage *image = new vsImage( r->filename );
+	r->width = image->GetWidth();
+	r->height = image->GetHeight();
+
+	vsRenderer_OpenGL3 *renderer = vsRenderer_OpenGL3::Instance();
+	renderer->SetLoadingContext();
+
+	GLuint t;
+	glGenTextures(1, &t);
+	glBindTexture(GL_TEXTURE_2D, t);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D,
+			0,
+			GL_RGBA,
+			r->width, r->height,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_INT_8_8_8_8_REV,
+			image->RawData());
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	r->glTexture = t;
+
+	// ClearLoadingContext() waits on a fence, so once it returns the texture
+	// is complete and safe to use from any context.
+	renderer->ClearLoadingContext();
+
+	vsDelete( image );
+}
+
+int
+vsTextureLoader::CollectFinished()
+{
+	m_lock.Lock();
+	Request *r = m_finishedHead;
+	m_finishedHead = m_finishedTail = NULL;
+	m_lock.Unlock();
+
+	// The render thread reads texture IDs while it draws, so don't swap
+	// them under it.
+	if ( r )
+		vsRenderThread::Sync();
+
+	int count = 0;
+	while ( r )
+	{
+		Request *next = r->next;
+
+		r->texture->FinishLoading( r->glTexture, r->width, r->height );
+		if ( r->callback )
+			r->callback( r->texture, r->callbackData );
+
+		Request **extra = &m_extraCallbacks;
+		while ( *extra )
+		{
+			Request *e = *extra;
+			if ( e->texture == r->texture )
+			{
+				*extra = e->next;
+				e->callback( e->texture, e->callbackData );
+				vsDelete( e );
+			}
+			else
+				extra = &e->next;
+		}
+
+		r->texture->ReleaseReference();
+		vsDelete( r );
+
+		m_inFlight--;
+		count++;
+		r = next;
+	}
+	return count;
+}
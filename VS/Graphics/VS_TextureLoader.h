@@ -0,0 +1,87 @@
+/*
+ *  VS_TextureLoader.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_TEXTURELOADER_H
+#define VS_TEXTURELOADER_H
+
+#include "VS/Threads/VS_Task.h"
+#include "VS/Threads/VS_Spinlock.h"
+
+class vsSemaphore;
+class vsTextureInternal;
+
+typedef void (*vsTextureLoadedFunction)( vsTextureInternal *texture, void *data );
+
+// vsTextureLoader is a background thread which loads textures for
+// vsTextureManager::LoadTextureAsync().  It decodes each image file, uploads
+// it on the renderer's loading context, and waits on a fence until the GPU
+// has the texture, before handing it back.  The main thread collects
+// finished textures by calling CollectFinished() once per frame, which is
+// where they actually replace their placeholders and callbacks are called.
+//
+// Everything except Run() is called from the main thread.
+
+class vsTextureLoader : public vsTask
+{
+	struct Request
+	{
+		vsTextureInternal *		texture;
+		vsString				filename;
+		vsTextureLoadedFunction	callback;
+		void *					callbackData;
+
+		// filled in by the loader thread
+		uint32_t				glTexture;
+		int						width;
+		int						height;
+
+		Request *				next;
+	};
+
+	vsSpinlock		m_lock;		// protects the lists below
+	Request *		m_pendingHead;
+	Request *		m_pendingTail;
+	Request *		m_finishedHead;
+	Request *		m_finishedTail;
+
+	// main thread only
+	Request *		m_extraCallbacks;	// more callbacks for textures which are already queued
+	int				m_inFlight;			// requests which haven't been collected yet
+
+	vsSemaphore *	m_work;
+
+	static void	Append( Request *&head, Request *&tail, Request *request );
+	void		Load( Request *request );
+
+protected:
+
+	virtual int Run();
+
+public:
+
+	vsTextureLoader();
+	// Stops the thread.  Textures which were still loading are left as
+	// placeholders, and their callbacks are never called.
+	virtual ~vsTextureLoader();
+
+	// 'texture' should already be in the texture manager.  We keep a
+	// reference to it until its load has finished.
+	void	Enqueue( vsTextureInternal *texture, vsTextureLoadedFunction callback, void *callbackData );
+
+	// Adds another callback for a texture which has already been queued.
+	void	AddCallback( vsTextureInternal *texture, vsTextureLoadedFunction callback, void *callbackData );
+
+	// Swaps finished textures in and calls their callbacks.  Returns how many
+	// textures finished.
+	int		CollectFinished();
+
+	bool	IsIdle() const { return m_inFlight == 0; }
+};
+
+#endif // VS_TEXTURELOADER_H
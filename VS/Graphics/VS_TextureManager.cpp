@@ -12,14 +12,66 @@
 #include "VS_Texture.h"
 #include "VS_Image.h"
 #include "VS_TextureInternal.h"
+#include "VS_RenderThread.h"
 
 vsTextureManager::vsTextureManager():
-	vsCache<vsTextureInternal>(512)
+	vsCache<vsTextureInternal>(512),
+	m_loader(NULL),
+	m_placeholder(NULL)
 {
 }
 
+vsTextureManager::~vsTextureManager()
+{
+	vsDelete( m_loader );
+	vsDelete( m_placeholder );
+}
+
 vsTextureInternal *
 vsTextureManager::LoadTexture( const vsString &filename )
 {
 	return Get( filename );
 }
+
+vsTextureInternal *
+vsTextureManager::LoadTextureAsync( const vsString &filename, vsTextureLoadedFunction callback, void *callbackData )
+{
+	vsTextureInternal *existing = Find( filename );
+	if ( existing && existing->IsLoaded() )
+	{
+		m_stats.hits++;
+		if ( callback )
+			callback( existing, callbackData );
+		return existing;
+	}
+
+	if ( !m_loader )
+	{
+		vsImage image(1,1);	// transparent black
+		m_placeholder = new vsTextureInternal( "AsyncLoadPlaceholder", &image );
+		m_loader = new vsTextureLoader;
+	}
+
+	if ( existing )
+	{
+		// Somebody else already asked for this one, and it's still on its way.
+		m_stats.hits++;
+		if ( callback )
+			m_loader->AddCallback( existing, callback, callbackData );
+		return existing;
+	}
+
+	m_stats.misses++;
+	vsTextureInternal *texture = new vsTextureInternal( filename, m_placeholder );
+	Add( texture );
+	m_loader->Enqueue( texture, callback, callbackData );
+	return texture;
+}
+
+void
+vsTextureManager::Update()
+{
+	if ( m_loader )
+		m_loader->CollectFinished();
+	vsCache<vsTextureInternal>::Update();
+}
@@ -11,6 +11,7 @@
 #define VS_TEXTURE_MANAGER_H
 
 #include "VS_Texture.h"
+#include "VS_TextureLoader.h"
 
 class vsTextureInternal;
 
@@ -18,11 +19,30 @@ class vsTextureInternal;
 
 class vsTextureManager : public vsCache<vsTextureInternal>
 {
+	vsTextureLoader *	m_loader;		// created the first time we load asynchronously
+	vsTextureInternal *	m_placeholder;	// shown in place of textures which are still loading
+
 public:
-	
+
+	static vsTextureManager *	Instance() { return static_cast<vsTextureManager*>( vsCache<vsTextureInternal>::Instance() ); }
+
 	vsTextureManager();
+	virtual ~vsTextureManager();
 
 	vsTextureInternal *	LoadTexture( const vsString &name );
+
+	// Returns immediately.  If the texture isn't already loaded, it's loaded
+	// on a background thread;  until then it draws as a 1x1 transparent
+	// placeholder, and reports its size as 1x1.  Once it's ready (at the
+	// start of a later frame, on the main thread), 'callback' is called with
+	// it, if provided.  If the texture was already loaded or loading, the
+	// callback is called right away or along with the original request,
+	// respectively.
+	vsTextureInternal *	LoadTextureAsync( const vsString &name, vsTextureLoadedFunction callback = NULL, void *callbackData = NULL );
+
+	// Swaps in any textures which have finished loading, then does the
+	// usual cache housekeeping.
+	virtual void	Update();
 };
 
 
@@ -216,6 +216,7 @@ vsInput::AddAxis( int cid, const vsString& name, const vsString& description )
 		}
 
 		m_axis[cid].name = name;
+		m_axis[cid].nameId = vsStringId(name);
 	}
 	m_axis[cid].description = description;
 
@@ -397,7 +398,10 @@ vsInput::Load()
 				vsRecord *child = a.GetChild(j);
 				vsString label = child->GetLabel().AsString();
 				if ( label == "name" )
+				{
 					axis.name = child->GetToken(0).AsString();
+					axis.nameId = vsStringId(axis.name);
+				}
 				else if ( label == "DeviceControl" )
 				{
 					DeviceControl dc;
@@ -2455,6 +2459,27 @@ vsInput::GetAxisId(const vsString& name)
 	return -1;
 }
 
+const struct vsInputAxis*
+vsInput::GetAxis(const vsStringId& name)
+{
+	int id = GetAxisId(name);
+	if ( id >= 0 )
+		return &m_axis[id];
+	return NULL;
+}
+
+int
+vsInput::GetAxisId(const vsStringId& name)
+{
+	for ( int i = 0; i < m_axis.ItemCount(); i++ )
+	{
+		if ( m_axis[i].nameId == name )
+			return i;
+	}
+	vsLog("vsLog: Unable to find requested axis '%s'", name.c_str());
+	return -1;
+}
+
 vsString
 vsInput::GetBindDescription( const DeviceControl& dc )
 {
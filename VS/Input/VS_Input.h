@@ -15,6 +15,7 @@
 #include "Utils/VS_Singleton.h"
 #include "Utils/VS_Array.h"
 #include "Utils/VS_ArrayStore.h"
+#include "Utils/VS_StringId.h"
 
 #if defined __APPLE__
 #include "TargetConditionals.h"
@@ -163,6 +164,7 @@ public:
 struct vsInputAxis
 {
 	vsString name;
+	vsStringId nameId;
 	vsString description;
 
 	vsArray<DeviceControl> positive;
@@ -405,6 +407,8 @@ public:
 	const struct vsInputAxis& GetAxis(int i) { return m_axis[i]; }
 	const struct vsInputAxis* GetAxis(const vsString& name);
 	int GetAxisId(const vsString& name); // returns -1 for failure
+	const struct vsInputAxis* GetAxis(const vsStringId& name);
+	int GetAxisId(const vsStringId& name); // returns -1 for failure
 
 	vsString GetBindDescription( const DeviceControl& dc );
 
@@ -0,0 +1,118 @@
+/*
+ *  VS_FrameArena.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_FrameArena.h"
+
+vsFrameArena * vsFrameArena::s_instance = NULL;
+
+#define ALIGN_UP(x) (((x) + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1))
+
+vsFrameArena::vsFrameArena( size_t bytesPerFrame ):
+	m_current(0),
+	m_overflowHighWater(0)
+{
+	vsAssert(s_instance == NULL, "Multiple vsFrameArenas created??");
+	s_instance = this;
+
+	bytesPerFrame = ALIGN_UP(bytesPerFrame);
+	for ( int i = 0; i < 2; i++ )
+	{
+		m_buffer[i].memory = new char[bytesPerFrame];
+		m_buffer[i].size = bytesPerFrame;
+		m_buffer[i].used = 0;
+		m_buffer[i].overflow = NULL;
+		m_buffer[i].overflowBytes = 0;
+		vsAssert( ((uintptr_t)m_buffer[i].memory & (FRAME_ARENA_ALIGNMENT-1)) == 0, "Frame arena memory isn't aligned??" );
+	}
+}
+
+vsFrameArena::~vsFrameArena()
+{
+	Reset();
+	for ( int i = 0; i < 2; i++ )
+		vsDeleteArray( m_buffer[i].memory );
+
+	vsAssert(s_instance == this, "vsFrameArena instance isn't me??");
+	s_instance = NULL;
+}
+
+void *
+vsFrameArena::Alloc( size_t bytes )
+{
+	bytes = ALIGN_UP(bytes);
+	Buffer &buffer = m_buffer[m_current];
+
+	size_t offset = buffer.used.fetch_add( bytes, std::memory_order_relaxed );
+	if ( offset + bytes <= buffer.size )
+		return buffer.memory + offset;
+
+	return AllocOverflow( buffer, bytes );
+}
+
+void *
+vsFrameArena::AllocOverflow( Buffer &buffer, size_t bytes )
+{
+	size_t headerSize = ALIGN_UP(sizeof(Overflow));
+	char *memory = new char[ headerSize + bytes ];
+	Overflow *o = reinterpret_cast<Overflow*>(memory);
+	o->size = bytes;
+
+	m_overflowLock.Lock();
+	o->next = buffer.overflow;
+	buffer.overflow = o;
+	buffer.overflowBytes += bytes;
+	m_overflowLock.Unlock();
+
+	return memory + headerSize;
+}
+
+void
+vsFrameArena::ResetBuffer( Buffer &buffer )
+{
+	while ( buffer.overflow )
+	{
+		Overflow *o = buffer.overflow;
+		buffer.overflow = o->next;
+		char *memory = reinterpret_cast<char*>(o);
+		vsDeleteArray( memory );
+	}
+	buffer.overflowBytes = 0;
+	buffer.used = 0;
+}
+
+void
+vsFrameArena::NextFrame()
+{
+	Buffer &finished = m_buffer[m_current];
+	if ( finished.overflowBytes > m_overflowHighWater )
+	{
+		m_overflowHighWater = finished.overflowBytes;
+		vsLog(" >> Frame arena overflowed by %d bytes (arena is %d bytes);  consider making it larger.", m_overflowHighWater, finished.size);
+	}
+
+	m_current = 1 - m_current;
+	ResetBuffer( m_buffer[m_current] );
+}
+
+void
+vsFrameArena::Reset()
+{
+	for ( int i = 0; i < 2; i++ )
+		ResetBuffer( m_buffer[i] );
+}
+
+size_t
+vsFrameArena::GetUsage() const
+{
+	const Buffer &buffer = m_buffer[m_current];
+	size_t used = buffer.used.load( std::memory_order_relaxed );
+	if ( used > buffer.size )
+		used = buffer.size;
+	return used + buffer.overflowBytes;
+}
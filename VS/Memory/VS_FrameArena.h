@@ -0,0 +1,106 @@
+/*
+ *  VS_FrameArena.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_FRAMEARENA_H
+#define VS_FRAMEARENA_H
+
+#include "VS/Threads/VS_Spinlock.h"
+#include <atomic>
+
+#include "VS/VS_DisableDebugNew.h"
+#include <new>
+#include <utility>
+#include "VS/VS_EnableDebugNew.h"
+
+// vsFrameArena hands out memory which only needs to live for a frame or so;
+// temporary display lists, render queue bookkeeping, scratch arrays of
+// instance matrices, and so on.  Allocation is just a pointer bump, and
+// nothing is ever individually freed;  instead, the whole arena is reset
+// once per frame by coreGame::Go().
+//
+// The arena is double-buffered:  memory allocated during frame 'n' remains
+// valid until the end of frame 'n+1', so it's safe to hand it to anything
+// which might still be looking at last frame's data.
+//
+// Destructors are never run for objects placed into the arena;  if you put
+// something non-trivial in here, you're responsible for destroying it
+// yourself before the arena is reset.
+//
+// If a frame needs more memory than the arena holds, we fall back to
+// allocating from the current heap (and free that memory again when the
+// arena is reset).  That's slow, so if you see the "overflowed" warning in
+// the log, make the arena bigger.
+
+#define FRAME_ARENA_ALIGNMENT (16)
+
+class vsFrameArena
+{
+	static vsFrameArena *	s_instance;
+
+	struct Overflow
+	{
+		Overflow *	next;
+		size_t		size;
+	};
+
+	struct Buffer
+	{
+		char *				memory;
+		size_t				size;
+		std::atomic<size_t>	used;
+		Overflow *			overflow;
+		size_t				overflowBytes;
+	};
+
+	Buffer			m_buffer[2];
+	int				m_current;
+	vsSpinlock		m_overflowLock;
+	size_t			m_overflowHighWater;
+
+	void *			AllocOverflow( Buffer &buffer, size_t size );
+	void			ResetBuffer( Buffer &buffer );
+
+public:
+
+	static vsFrameArena * Instance() { return s_instance; }
+
+	vsFrameArena( size_t bytesPerFrame );
+	~vsFrameArena();
+
+	// Threads may allocate concurrently with each other, but not with
+	// NextFrame() or Reset();  other threads must have finished allocating
+	// before the main thread crosses the frame boundary, and mustn't start
+	// again until it has.  Returned memory is aligned to
+	// FRAME_ARENA_ALIGNMENT bytes.
+	void *	Alloc( size_t bytes );
+
+	template<typename T>
+	T *		AllocArray( size_t count ) { return reinterpret_cast<T*>( Alloc( sizeof(T) * count ) ); }
+
+	// Constructs a T in the arena.  Remember that its destructor will never
+	// be called unless you call it yourself!
+#include "VS/VS_DisableDebugNew.h"
+	template<typename T, typename... Args>
+	T *		New( Args&&... args ) { return new( Alloc( sizeof(T) ) ) T( std::forward<Args>(args)... ); }
+#include "VS/VS_EnableDebugNew.h"
+
+	// Called once per frame, from coreGame::Go().  Throws away everything
+	// allocated during the frame *before* the one which just finished.
+	// No other thread may be inside Alloc() while this runs.
+	void	NextFrame();
+
+	// Throws away everything in both buffers.  Nobody may be holding
+	// arena memory when this is called.
+	void	Reset();
+
+	size_t	GetUsage() const;	// bytes allocated so far this frame, including overflow
+	size_t	GetSize() const { return m_buffer[m_current].size; }
+};
+
+#endif // VS_FRAMEARENA_H
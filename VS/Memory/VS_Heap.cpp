@@ -18,13 +18,25 @@ vsHeap *g_globalHeap;
 
 vsHeap * vsHeap::s_current = NULL;
 
+#if defined(VS_COMPACT_HEAP_HEADERS)
+int vsHeap::s_defaultSampleRate = HEAP_DEFAULT_SAMPLE_RATE;
+#endif
+
 #define MAX_HEAP_STACK (4)
 static vsHeap *	s_stack[MAX_HEAP_STACK] = {NULL,NULL,NULL,NULL};
 
+#define NO_PREV_BLOCK (0xffffffff)
+
 #undef new
 #undef malloc
 #undef free
 
+static inline memFreeLinks *
+Links( memBlock *block )
+{
+	return (memFreeLinks *)((char *)block + HEAP_HEADER_SIZE);
+}
+
 vsHeap::vsHeap(vsString name, size_t size):
 	m_name(name)
 {
@@ -43,32 +55,41 @@ vsHeap::vsHeap(vsString name, size_t size):
 		exit(1);
 	}
 
+	// Blocks are tracked in HEAP_BLOCK_ALIGNMENT units, so trim our memory
+	// down to a whole number of aligned units.
+	char *alignedStart = (char *)(((uintptr_t)m_startOfMemory + HEAP_BLOCK_ALIGNMENT - 1) & ~(uintptr_t)(HEAP_BLOCK_ALIGNMENT - 1));
+	size -= (alignedStart - (char *)m_startOfMemory);
+	size &= ~(size_t)(HEAP_BLOCK_ALIGNMENT - 1);
+
+	m_startOfMemory = alignedStart;
 	m_endOfMemory = (void *)((char *)m_startOfMemory + size);
 	m_memorySize = size;
 
 	m_memoryUsed = 0;
 	m_highWaterMark = 0;
+	m_usedBlockCount = 0;
 	m_totalAllocations = 0;
 
-	m_leakMark = 0;
-
-	//	for ( int i = 0; i < MAX_ALLOCATIONS; i++ )
-	//	{
-	//		m_unusedBlockList.Append( &m_blockStore[i] );
-	//	}
+	for ( int i = 0; i < HEAP_SMALL_BIN_COUNT; i++ )
+		m_smallBin[i] = NULL;
+	m_smallBinMap = 0;
+	m_largeTree = NULL;
+	m_freeBlockCount = 0;
+
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	m_sample = NULL;
+	m_sampleCapacity = 0;
+	m_sampleCount = 0;
+	m_samplesDropped = 0;
+	m_sampleRate = s_defaultSampleRate;
+#endif
 
 	memBlock *iniBlock = (memBlock *)m_startOfMemory;
-	iniBlock->m_start = m_startOfMemory;
-	iniBlock->m_end = m_endOfMemory;
-	iniBlock->m_size = m_memorySize;
-	iniBlock->m_sizeRequested = m_memorySize;
-	iniBlock->m_used = false;
-	iniBlock->m_next = NULL;
-	iniBlock->m_prev = NULL;
-	iniBlock->m_nextBlock = NULL;
-	iniBlock->m_prevBlock = NULL;
-
-	m_unusedBlockList.Append( iniBlock );
+	memset( iniBlock, 0, sizeof(memBlock) );
+	iniBlock->m_prevBlock = NO_PREV_BLOCK;
+	iniBlock->SetSize( m_memorySize );
+
+	InsertFreeBlock( iniBlock );
 #endif // VS_OVERLOAD_ALLOCATORS
 }
 
@@ -77,6 +98,10 @@ vsHeap::~vsHeap()
 	if ( s_current == this )
 	{
 	}
+	ForgetThreadCaches();
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	free( m_sample );
+#endif
 }
 
 void
@@ -110,25 +135,185 @@ vsHeap::Pop( vsHeap *oldCurrent /* == NULL */ )
 	s_current = s_stack[0];
 }
 
+
 memBlock *
-vsHeap::FindFreeMemBlockOfSize( size_t size )
+vsHeap::GetNextBlock( memBlock *block )
 {
-	memBlock *block = m_unusedBlockList.m_next;
-	size_t largestBlockSize = 0;
-	bool foundMemBlockForAlloc = false;
+	memBlock *next = (memBlock *)((char *)block + block->GetSize());
+	if ( next >= m_endOfMemory )
+		return NULL;
+	return next;
+}
+
+memBlock *
+vsHeap::GetPrevBlock( memBlock *block )
+{
+	if ( block->m_prevBlock == NO_PREV_BLOCK )
+		return NULL;
+	return (memBlock *)((char *)m_startOfMemory + ((size_t)block->m_prevBlock << HEAP_BLOCK_SHIFT));
+}
+
+void
+vsHeap::SetPrevBlock( memBlock *block, memBlock *prev )
+{
+	block->m_prevBlock = (uint32_t)(((char *)prev - (char *)m_startOfMemory) >> HEAP_BLOCK_SHIFT);
+}
+
+// Helpers for our best-fit tree of large free blocks.  The tree is a treap,
+// ordered by block size (and then by address, so that every key is unique),
+// and heap-ordered by a priority derived from each block's address.  This
+// keeps the tree balanced in expectation without needing to store any extra
+// balancing information in our blocks.
+
+static inline uint32_t
+TreePriority( memBlock *block )
+{
+	return (uint32_t)(((uintptr_t)block >> HEAP_BLOCK_SHIFT) * 2654435761u);
+}
+
+static inline bool
+TreeLess( memBlock *a, memBlock *b )
+{
+	if ( a->m_units != b->m_units )
+		return a->m_units < b->m_units;
+	return a < b;
+}
 
-	while(block)
+static void
+TreeInsert( memBlock *&root, memBlock *block )
+{
+	if ( root == NULL )
 	{
-		if ( block->m_used == false && block->m_size >= size )
+		Links(block)->treeLeft = NULL;
+		Links(block)->treeRight = NULL;
+		root = block;
+	}
+	else if ( TreeLess( block, root ) )
+	{
+		TreeInsert( Links(root)->treeLeft, block );
+		if ( TreePriority(Links(root)->treeLeft) > TreePriority(root) )
 		{
-			return block;
+			// rotate right
+			memBlock *left = Links(root)->treeLeft;
+			Links(root)->treeLeft = Links(left)->treeRight;
+			Links(left)->treeRight = root;
+			root = left;
 		}
+	}
+	else
+	{
+		TreeInsert( Links(root)->treeRight, block );
+		if ( TreePriority(Links(root)->treeRight) > TreePriority(root) )
+		{
+			// rotate left
+			memBlock *right = Links(root)->treeRight;
+			Links(root)->treeRight = Links(right)->treeLeft;
+			Links(right)->treeLeft = root;
+			root = right;
+		}
+	}
+}
+
+// Joins two subtrees, where everything in 'a' sorts before everything in 'b'.
+static memBlock *
+TreeJoin( memBlock *a, memBlock *b )
+{
+	if ( a == NULL )
+		return b;
+	if ( b == NULL )
+		return a;
+	if ( TreePriority(a) > TreePriority(b) )
+	{
+		Links(a)->treeRight = TreeJoin( Links(a)->treeRight, b );
+		return a;
+	}
+	Links(b)->treeLeft = TreeJoin( a, Links(b)->treeLeft );
+	return b;
+}
 
-		if ( block->m_used == false && block->m_size > largestBlockSize )
-			largestBlockSize = block->m_size;
+static void
+TreeRemove( memBlock *&root, memBlock *block )
+{
+	if ( root == block )
+		root = TreeJoin( Links(block)->treeLeft, Links(block)->treeRight );
+	else if ( TreeLess( block, root ) )
+		TreeRemove( Links(root)->treeLeft, block );
+	else
+		TreeRemove( Links(root)->treeRight, block );
+}
+
+static inline int
+LowestSetBit( uint64_t bits )
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(bits);
+#else
+	int result = 0;
+	while ( (bits & 1) == 0 )
+	{
+		bits >>= 1;
+		result++;
+	}
+	return result;
+#endif
+}
+
+void
+vsHeap::InsertFreeBlock( memBlock *block )
+{
+	size_t size = block->GetSize();
+	if ( size < HEAP_SMALL_BLOCK_LIMIT )
+	{
+		int bin = (int)(size >> HEAP_SMALL_BIN_SHIFT);
+		memFreeLinks *links = Links(block);
+		links->prev = NULL;
+		links->next = m_smallBin[bin];
+		if ( links->next )
+			Links(links->next)->prev = block;
+		m_smallBin[bin] = block;
+		m_smallBinMap |= ((uint64_t)1 << bin);
+	}
+	else
+	{
+		TreeInsert( m_largeTree, block );
+	}
+	m_freeBlockCount++;
+}
+
+void
+vsHeap::RemoveFreeBlock( memBlock *block )
+{
+	size_t size = block->GetSize();
+	if ( size < HEAP_SMALL_BLOCK_LIMIT )
+	{
+		int bin = (int)(size >> HEAP_SMALL_BIN_SHIFT);
+		memFreeLinks *links = Links(block);
+		if ( links->prev )
+			Links(links->prev)->next = links->next;
+		else
+			m_smallBin[bin] = links->next;
+		if ( links->next )
+			Links(links->next)->prev = links->prev;
 
-		block = block->m_next;
+		if ( m_smallBin[bin] == NULL )
+			m_smallBinMap &= ~((uint64_t)1 << bin);
+	}
+	else
+	{
+		TreeRemove( m_largeTree, block );
 	}
+	m_freeBlockCount--;
+}
+
+memBlock *
+vsHeap::FindFreeMemBlockOfSize( size_t size )
+{
+	memBlock *block = FindFreeMemBlockOfSize_Internal(size);
+	if ( block )
+		return block;
+
+	size_t largestBlockSize = GetLargestFreeBlockSize();
+	bool foundMemBlockForAlloc = false;
 
 #ifdef _WIN32
 	vsLog("Unable to find block of size %lu in heap of size %lu.  Largest block available is %lu.", size, m_memorySize, largestBlockSize);
@@ -139,59 +324,529 @@ vsHeap::FindFreeMemBlockOfSize( size_t size )
 	return NULL;
 }
 
-void *
-vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
+memBlock *
+vsHeap::FindFreeMemBlockOfSize_Internal( size_t size )
 {
-	m_lock.Lock();
+	// 'size' is always a multiple of our size class granularity, so the
+	// smallest non-empty bin at or above its own bin is guaranteed to fit.
+	if ( size < HEAP_SMALL_BLOCK_LIMIT )
+	{
+		uint64_t candidates = m_smallBinMap & (~(uint64_t)0 << (size >> HEAP_SMALL_BIN_SHIFT));
+		if ( candidates )
+			return m_smallBin[ LowestSetBit(candidates) ];
+	}
 
-	size_t size = size_requested;
-	size += sizeof( memBlock ) + sizeof( unsigned long );		// we need to allocate enough space for our new 'memBlock' header, and some bytes on the end.
-	size = (size+31) & 0xffffffe0;								// round 'size' up to the nearest 32 bytes, to force alignment.
+	// find the smallest large block which will fit.
+	memBlock *best = NULL;
+	memBlock *node = m_largeTree;
+	while ( node )
+	{
+		if ( node->GetSize() >= size )
+		{
+			best = node;
+			node = Links(node)->treeLeft;
+		}
+		else
+			node = Links(node)->treeRight;
+	}
+	return best;
+}
 
-	memBlock *block = FindFreeMemBlockOfSize(size);
+size_t
+vsHeap::GetLargestFreeBlockSize()
+{
+	memBlock *node = m_largeTree;
+	if ( node )
+	{
+		while ( Links(node)->treeRight )
+			node = Links(node)->treeRight;
+		return node->GetSize();
+	}
+
+	size_t largestBlockSize = 0;
+	for ( int i = HEAP_SMALL_BIN_COUNT-1; i >= 0 && largestBlockSize == 0; i-- )
+	{
+		for ( memBlock *block = m_smallBin[i]; block; block = Links(block)->next )
+			largestBlockSize = vsMax( largestBlockSize, block->GetSize() );
+	}
+	return largestBlockSize;
+}
+
+#if defined(VS_COMPACT_HEAP_HEADERS)
 
-	void * end = (void *)((char *)block->m_start + size);
+// Our sampled debug information lives in an open-addressed hash table keyed
+// on block address, using linear probing.  It's allocated directly from the
+// system, so that it doesn't take space from (or recurse into) the heap.
 
-	if ( block->m_size > (size_t)(size + sizeof( memBlock )) )	// enough extra unused space to allocate another memblock out of it?
+static inline size_t
+SampleHash( memBlock *block, size_t capacity )
+{
+	return (size_t)((((uintptr_t)block >> HEAP_BLOCK_SHIFT) * 2654435761u) & (capacity-1));
+}
+
+void
+vsHeap::AddSample( memBlock *block, const char *file, int line, int blockId, size_t sizeRequested )
+{
+	m_sampleLock.Lock();
+	if ( m_sample == NULL )
 	{
-		// block is larger than we asked for;  we need to split it.
-		memBlock *split = (memBlock *)end;
+		m_sampleCapacity = 4096;
+		m_sample = (Sample *)malloc( sizeof(Sample) * m_sampleCapacity );
+		memset( m_sample, 0, sizeof(Sample) * m_sampleCapacity );
+	}
+	// keep the table at most 3/4 full, so probes stay short.
+	if ( m_sample && (m_sampleCount+1) * 4 <= m_sampleCapacity * 3 )
+	{
+		size_t i = SampleHash( block, m_sampleCapacity );
+		while ( m_sample[i].block )
+			i = (i+1) & (m_sampleCapacity-1);
+
+		Sample &s = m_sample[i];
+		s.block = block;
+		s.debug.m_sizeRequested = sizeRequested;
+		s.debug.m_blockId = blockId;
+		s.debug.m_line = line;
+		s.debug.m_filename[0] = 0;
+		if ( file )
+			strncpy( s.debug.m_filename, file, 127 );
+		s.debug.m_filename[127] = 0;
+		m_sampleCount++;
+
+		block->SetFlag( memBlock::Flag_Sampled, true );
+	}
+	else
+		m_samplesDropped++;
+	m_sampleLock.Unlock();
+}
 
-		split->m_start = end;
-		split->m_end = block->m_end;
-		split->m_size = block->m_size - size;
-		split->m_used = false;
+bool
+vsHeap::GetSample( memBlock *block, memBlockDebug *out )
+{
+	if ( !block->HasFlag( memBlock::Flag_Sampled ) )
+		return false;
 
-		block->AppendBlock(split);
+	bool found = false;
+	m_sampleLock.Lock();
+	for ( size_t i = SampleHash( block, m_sampleCapacity ); m_sample[i].block; i = (i+1) & (m_sampleCapacity-1) )
+	{
+		if ( m_sample[i].block == block )
+		{
+			*out = m_sample[i].debug;
+			found = true;
+			break;
+		}
+	}
+	m_sampleLock.Unlock();
+	return found;
+}
 
-		block->m_end = end;
-		block->m_size = size;
+void
+vsHeap::RemoveSample( memBlock *block )
+{
+	if ( !block->HasFlag( memBlock::Flag_Sampled ) )
+		return;
+	block->SetFlag( memBlock::Flag_Sampled, false );
+
+	m_sampleLock.Lock();
+	size_t mask = m_sampleCapacity-1;
+	size_t i = SampleHash( block, m_sampleCapacity );
+	while ( m_sample[i].block != block )
+		i = (i+1) & mask;
+
+	// Remove by shifting later entries in this probe sequence back into the
+	// hole, so that lookups never need tombstones.
+	size_t hole = i;
+	for ( size_t j = (i+1) & mask; m_sample[j].block; j = (j+1) & mask )
+	{
+		size_t home = SampleHash( m_sample[j].block, m_sampleCapacity );
+		bool canMove = ( hole <= j ) ? ( home <= hole || home > j ) : ( home <= hole && home > j );
+		if ( canMove )
+		{
+			m_sample[hole] = m_sample[j];
+			hole = j;
+		}
+	}
+	m_sample[hole].block = NULL;
+	m_sampleCount--;
+	m_sampleLock.Unlock();
+}
+
+void
+vsHeap::SetDefaultDebugSampleRate( int rate )
+{
+	s_defaultSampleRate = rate;
+}
 
-		m_unusedBlockList.Append(split);
-		//block->Append(split);
+void
+vsHeap::SetDebugSampleRate( int rate )
+{
+	m_sampleRate = rate;
+}
+
+#else
+
+void
+vsHeap::SetDefaultDebugSampleRate( int rate )
+{
+	// without compact headers, we always record everything.
+}
+
+void
+vsHeap::SetDebugSampleRate( int rate )
+{
+}
+
+#endif // VS_COMPACT_HEAP_HEADERS
+
+// vsHeapThreadCache
+//
+//   Each thread keeps a small cache of recently freed blocks for each vsHeap
+//   it uses, so that most small allocations and frees never need to take the
+//   heap's lock.  Blocks sitting in a thread cache are still 'used' from the
+//   heap's point of view (they remain in its block list, and count towards
+//   its memory usage), but they're flagged as cached so that they aren't
+//   reported as leaks.  Caches are refilled from and flushed back to their
+//   heap in batches, so the lock is taken once per batch instead of once per
+//   allocation.
+//
+class vsHeapThreadCache
+{
+public:
+	struct Slot
+	{
+		vsHeap *	heap;
+		memBlock *	head[HEAP_CACHE_BIN_COUNT];	// singly linked through the blocks' user areas
+		int			count[HEAP_CACHE_BIN_COUNT];
+		vsHeap::CacheStats stats;
+
+		void Clear()
+		{
+			heap = NULL;
+			for ( int i = 0; i < HEAP_CACHE_BIN_COUNT; i++ )
+			{
+				head[i] = NULL;
+				count[i] = 0;
+			}
+			stats = vsHeap::CacheStats();
+		}
+	};
+
+	Slot				m_slot[HEAP_CACHE_SLOT_COUNT];
+	int					m_threadId;
+	vsHeapThreadCache *	m_nextCache;
+	vsHeapThreadCache *	m_prevCache;
+
+	vsHeapThreadCache();
+	~vsHeapThreadCache();
+
+	Slot *	GetSlot( vsHeap *heap );
+	void	Flush( Slot *slot, int bin, int count );
+	void	ReleaseSlot( Slot *slot );
+};
+
+static vsSpinlock			s_threadCacheLock;	// protects our list of thread caches
+static vsHeapThreadCache *	s_threadCacheList = NULL;
+static int					s_nextThreadId = 0;
+
+static thread_local vsHeapThreadCache t_threadCache;
+
+static inline memBlock *&
+CachedNext( memBlock *block )
+{
+	return Links(block)->next;
+}
+
+vsHeapThreadCache::vsHeapThreadCache():
+	m_nextCache(NULL),
+	m_prevCache(NULL)
+{
+	for ( int i = 0; i < HEAP_CACHE_SLOT_COUNT; i++ )
+		m_slot[i].Clear();
+
+	s_threadCacheLock.Lock();
+	m_threadId = s_nextThreadId++;
+	m_nextCache = s_threadCacheList;
+	if ( m_nextCache )
+		m_nextCache->m_prevCache = this;
+	s_threadCacheList = this;
+	s_threadCacheLock.Unlock();
+}
+
+vsHeapThreadCache::~vsHeapThreadCache()
+{
+	// our thread is exiting;  hand all our cached blocks back to their heaps.
+	for ( int i = 0; i < HEAP_CACHE_SLOT_COUNT; i++ )
+		ReleaseSlot( &m_slot[i] );
+
+	s_threadCacheLock.Lock();
+	if ( m_prevCache )
+		m_prevCache->m_nextCache = m_nextCache;
+	else
+		s_threadCacheList = m_nextCache;
+	if ( m_nextCache )
+		m_nextCache->m_prevCache = m_prevCache;
+	s_threadCacheLock.Unlock();
+}
+
+vsHeapThreadCache::Slot *
+vsHeapThreadCache::GetSlot( vsHeap *heap )
+{
+	Slot *empty = NULL;
+	for ( int i = 0; i < HEAP_CACHE_SLOT_COUNT; i++ )
+	{
+		if ( m_slot[i].heap == heap )
+			return &m_slot[i];
+		if ( !empty && m_slot[i].heap == NULL )
+			empty = &m_slot[i];
+	}
+	if ( empty )
+	{
+		// Claim under the list lock, so a vsHeap being destroyed can't miss us.
+		s_threadCacheLock.Lock();
+		empty->heap = heap;
+		s_threadCacheLock.Unlock();
 	}
-	block->Extract();
-	m_blockList.Append(block);
+	// if we're already caching for too many heaps, we'll just return NULL,
+	// and allocations from this heap will go directly to the heap.
+	return empty;
+}
 
-	if ( file )
+void
+vsHeapThreadCache::Flush( Slot *slot, int bin, int count )
+{
+	vsHeap *heap = slot->heap;
+	heap->m_lock.Lock();
+	for ( int i = 0; i < count && slot->head[bin]; i++ )
 	{
-		strncpy( block->m_filename, file, 127 );
+		memBlock *block = slot->head[bin];
+		slot->head[bin] = CachedNext(block);
+		slot->count[bin]--;
+
+		block->SetFlag( memBlock::Flag_Cached, false );
+		heap->FreeBlock_Locked(block);
+	}
+	heap->m_lock.Unlock();
+	slot->stats.flushes++;
+}
+
+void
+vsHeapThreadCache::ReleaseSlot( Slot *slot )
+{
+	if ( slot->heap )
+	{
+		for ( int bin = 0; bin < HEAP_CACHE_BIN_COUNT; bin++ )
+		{
+			if ( slot->count[bin] )
+				Flush( slot, bin, slot->count[bin] );
+		}
+		s_threadCacheLock.Lock();
+		slot->heap->m_retiredCacheStats.Add( slot->stats );
+		slot->Clear();
+		s_threadCacheLock.Unlock();
+	}
+}
+
+void
+vsHeap::CacheStats::Add( const CacheStats &other )
+{
+	hits += other.hits;
+	misses += other.misses;
+	frees += other.frees;
+	flushes += other.flushes;
+	crossThreadFrees += other.crossThreadFrees;
+	cachedBlocks += other.cachedBlocks;
+}
+
+void
+vsHeap::GetThreadCacheStats( CacheStats &stats )
+{
+	s_threadCacheLock.Lock();
+	stats = m_retiredCacheStats;
+	for ( vsHeapThreadCache *cache = s_threadCacheList; cache; cache = cache->m_nextCache )
+	{
+		for ( int i = 0; i < HEAP_CACHE_SLOT_COUNT; i++ )
+		{
+			vsHeapThreadCache::Slot &slot = cache->m_slot[i];
+			if ( slot.heap == this )
+			{
+				stats.Add( slot.stats );
+				for ( int bin = 0; bin < HEAP_CACHE_BIN_COUNT; bin++ )
+					stats.cachedBlocks += slot.count[bin];
+			}
+		}
+	}
+	s_threadCacheLock.Unlock();
+}
+
+void
+vsHeap::ForgetThreadCaches()
+{
+	// we're going away, so any blocks which threads have cached from us are
+	// about to become invalid.  Drop them on the floor.
+	s_threadCacheLock.Lock();
+	for ( vsHeapThreadCache *cache = s_threadCacheList; cache; cache = cache->m_nextCache )
+	{
+		for ( int i = 0; i < HEAP_CACHE_SLOT_COUNT; i++ )
+		{
+			if ( cache->m_slot[i].heap == this )
+				cache->m_slot[i].Clear();
+		}
+	}
+	s_threadCacheLock.Unlock();
+}
+
+void
+vsHeap::FlushThreadCache()
+{
+	vsHeapThreadCache::Slot *slot = t_threadCache.GetSlot(this);
+	if ( slot )
+	{
+		for ( int bin = 0; bin < HEAP_CACHE_BIN_COUNT; bin++ )
+		{
+			if ( slot->count[bin] )
+				t_threadCache.Flush( slot, bin, slot->count[bin] );
+		}
+	}
+}
+
+memBlock *
+vsHeap::AllocBlock_Locked( size_t size )
+{
+	memBlock *block = FindFreeMemBlockOfSize(size);
+	RemoveFreeBlock(block);
+
+	if ( block->GetSize() >= size + HEAP_MIN_BLOCK_SIZE )	// enough extra unused space to allocate another memblock out of it?
+	{
+		// block is larger than we asked for;  we need to split it.
+		memBlock *split = (memBlock *)((char *)block + size);
+		memset( split, 0, sizeof(memBlock) );
+		split->SetSize( block->GetSize() - size );
+		SetPrevBlock( split, block );
+
+		memBlock *next = GetNextBlock(split);
+		if ( next )
+			SetPrevBlock( next, split );
+
+		block->SetSize( size );
+
+		InsertFreeBlock(split);
 	}
-	block->m_line = line;
-	block->m_blockId = (int)m_totalAllocations++;
-	block->m_allocType = allocType;
-	block->m_sizeRequested = size_requested;
 
 	block->m_used = true;
-	void *result = (void *)((char *)block->m_start + sizeof(memBlock));
+	block->m_flags = 0;
 
-	m_memoryUsed += block->m_size;
+	m_usedBlockCount++;
+	m_memoryUsed += block->GetSize();
 	if ( m_memoryUsed > m_highWaterMark )
 	{
 		m_highWaterMark = m_memoryUsed;
 		/*if ( m_highWaterMark > 1024 * 1024 )
 		  TraceMemoryBlocks();*/
 	}
+	return block;
+}
+
+void
+vsHeap::FreeBlock_Locked( memBlock *block )
+{
+	// check if we can merge together with the prev or the next block.
+	block->m_used = false;
+	block->m_flags = 0;
+	m_usedBlockCount--;
+	m_memoryUsed -= block->GetSize();
+
+	memBlock *nextBlock = GetNextBlock(block);
+	memBlock *prevBlock = GetPrevBlock(block);
+
+	if ( nextBlock && !nextBlock->m_used )
+	{
+		// next block isn't being used;  let's merge it into us!
+		RemoveFreeBlock(nextBlock);
+		block->SetSize( block->GetSize() + nextBlock->GetSize() );
+	}
+	if ( prevBlock && !prevBlock->m_used )
+	{
+		// previous block isn't being used;  let's merge ourself into it!
+		// It will change size class, so it needs to be re-filed.
+		RemoveFreeBlock(prevBlock);
+		prevBlock->SetSize( prevBlock->GetSize() + block->GetSize() );
+		block = prevBlock;
+	}
+
+	memBlock *following = GetNextBlock(block);
+	if ( following )
+		SetPrevBlock( following, block );
+
+	InsertFreeBlock(block);
+}
+
+void *
+vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
+{
+	size_t size = size_requested;
+	size += HEAP_HEADER_SIZE + HEAP_GUARD_SIZE;					// we need to allocate enough space for our 'memBlock' header, and some bytes on the end.
+	size = (size+HEAP_BLOCK_ALIGNMENT-1) & ~(size_t)(HEAP_BLOCK_ALIGNMENT-1);	// round 'size' up to the nearest 32 bytes, to force alignment.
+	size = vsMax( size, HEAP_MIN_BLOCK_SIZE );
+
+	memBlock *block = NULL;
+	int bin = (int)(size >> HEAP_SMALL_BIN_SHIFT);
+	vsHeapThreadCache::Slot *slot = ( bin < HEAP_CACHE_BIN_COUNT ) ? t_threadCache.GetSlot(this) : NULL;
+
+	if ( slot )
+	{
+		if ( slot->head[bin] == NULL )
+		{
+			// nothing cached of this size;  grab a batch of blocks from the heap.
+			// Only the first one is required;  if the heap is nearly full, we
+			// stop early rather than running it out of memory just to fill a cache.
+			slot->stats.misses++;
+			m_lock.Lock();
+			for ( int i = 0; i < HEAP_CACHE_REFILL_COUNT; i++ )
+			{
+				if ( i > 0 && !FindFreeMemBlockOfSize_Internal(size) )
+					break;
+				memBlock *fill = AllocBlock_Locked(size);
+				fill->SetFlag( memBlock::Flag_Cached, true );
+				CachedNext(fill) = slot->head[bin];
+				slot->head[bin] = fill;
+				slot->count[bin]++;
+			}
+			m_lock.Unlock();
+		}
+		else
+			slot->stats.hits++;
+
+		block = slot->head[bin];
+		slot->head[bin] = CachedNext(block);
+		slot->count[bin]--;
+		block->m_flags = 0;
+	}
+	else
+	{
+		m_lock.Lock();
+		block = AllocBlock_Locked(size);
+		m_lock.Unlock();
+	}
+
+	int blockId = (int)m_totalAllocations++;
+	block->m_allocType = allocType;
+	block->m_allocThread = (uint16_t)t_threadCache.m_threadId;
+	block->SetFlag( memBlock::Flag_AfterMark, true );
+
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	if ( m_sampleRate > 0 && (blockId % m_sampleRate) == 0 )
+		AddSample( block, file, line, blockId, size_requested );
+#else
+	if ( file )
+	{
+		strncpy( block->m_debug.m_filename, file, 127 );
+	}
+	block->m_debug.m_line = line;
+	block->m_debug.m_blockId = blockId;
+	block->m_debug.m_sizeRequested = size_requested;
+#endif
+
+	void *result = (void *)((char *)block + HEAP_HEADER_SIZE);
 
 	if ( allocType != Type_Heap )
 	{
@@ -199,18 +854,18 @@ vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
 		// memory hasn't been initialised by the user.  (No need to do this if this
 		// memory is just being used within another vsHeap)
 
-		memset(result, 0xcdcdcdcd, block->m_size - sizeof( memBlock ) );
+		memset(result, 0xcdcdcdcd, block->GetSize() - HEAP_HEADER_SIZE );
 	}
 
+#if defined(HEAP_GUARD_ENABLED)
 	// write a special code just past the end of what the user thinks we're
 	// giving them.  We'll check that the user hasn't written over our special
 	// code when they free the block, as that would indicate that they've overwritten
 	// an array or somesuch.
-	void * safety = (void *)((char *)block->m_end - sizeof(unsigned long));
+	void * safety = (void *)((char *)block + block->GetSize() - sizeof(unsigned long));
 	unsigned long *safetyLong = (unsigned long *)safety;
 	*safetyLong = 0xeeeeeeee;
-
-	m_lock.Unlock();
+#endif
 
 	return result;
 }
@@ -218,88 +873,76 @@ vsHeap::Alloc(size_t size_requested, const char *file, int line, int allocType)
 void
 vsHeap::Free(void *p, int allocType)
 {
-	m_lock.Lock();
-
-	p = (void *)((char *)p - sizeof(memBlock));	// adjust pointer to point to the start of its memBlock header
+	p = (void *)((char *)p - HEAP_HEADER_SIZE);	// adjust pointer to point to the start of its memBlock header
 
 	memBlock *block = (memBlock *)p;
-	//memBlock *block = m_blockList.m_next;
-	//bool foundBlockToFree = false;
 
-	//while ( block )
-	//{
-	//	if ( block->m_start == p )
-	{
-		// make sure the user hasn't overwritten our code past the end of their memory block.
-		void * safety = (void *)((char *)block->m_end - sizeof(unsigned long));
-		unsigned long *safetyLong = (unsigned long *)safety;
-		vsAssert( *safetyLong == 0xeeeeeeee, "Buffer overflow detected!" );	// if we hit this assert, someone has overwritten the bounds of this memory buffer!
+#if defined(HEAP_GUARD_ENABLED)
+	// make sure the user hasn't overwritten our code past the end of their memory block.
+	void * safety = (void *)((char *)block + block->GetSize() - sizeof(unsigned long));
+	unsigned long *safetyLong = (unsigned long *)safety;
+	vsAssert( *safetyLong == 0xeeeeeeee, "Buffer overflow detected!" );	// if we hit this assert, someone has overwritten the bounds of this memory buffer!
+#endif
 
-		if( block->m_allocType != allocType )
+	if( block->m_allocType != allocType )
+	{
+		const char *allocFunction[] =
 		{
-			const char *allocFunction[] =
-			{
-				"vsHeap constructor",
-				"Static alloc",
-				"malloc",
-				"new",
-				"new []"
-			};
-			const char *freeFunction[] =
-			{
-				"vsHeap destructor",
-				"None",
-				"free",
-				"delete",
-				"delete []"
-			};
-			vsLog("Error:  Allocation from %s line %d was allocated using %s", block->m_filename, block->m_line, allocFunction[(int)block->m_allocType]);
-			vsLog("Error:   but was freed using %s;  should have been %s!", freeFunction[allocType], freeFunction[(int)block->m_allocType]);
-		}
+			"vsHeap constructor",
+			"Static alloc",
+			"malloc",
+			"new",
+			"new []"
+		};
+		const char *freeFunction[] =
+		{
+			"vsHeap destructor",
+			"None",
+			"free",
+			"delete",
+			"delete []"
+		};
+#if defined(VS_COMPACT_HEAP_HEADERS)
+		memBlockDebug debug;
+		if ( GetSample( block, &debug ) )
+			vsLog("Error:  Allocation from %s line %d was allocated using %s", debug.m_filename, debug.m_line, allocFunction[(int)block->m_allocType]);
+		else
+			vsLog("Error:  Allocation from an unsampled location was allocated using %s", allocFunction[(int)block->m_allocType]);
+#else
+		vsLog("Error:  Allocation from %s line %d was allocated using %s", block->m_debug.m_filename, block->m_debug.m_line, allocFunction[(int)block->m_allocType]);
+#endif
+		vsLog("Error:   but was freed using %s;  should have been %s!", freeFunction[allocType], freeFunction[(int)block->m_allocType]);
+	}
 
-		// check if we can merge together with the prev or the next block.
-		void *	userArea = (void *)((char *)block->m_start + sizeof(memBlock));
-		size_t	userSize = block->m_size - sizeof(memBlock);
-		memset(userArea, 0xdddddddd, userSize );
-		block->m_used = false;
-		m_memoryUsed -= block->m_size;
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	RemoveSample( block );
+#endif
 
-		memBlock *nextBlock = block->m_nextBlock;
-		memBlock *prevBlock = block->m_prevBlock;
+	void *	userArea = (void *)((char *)block + HEAP_HEADER_SIZE);
+	size_t	userSize = block->GetSize() - HEAP_HEADER_SIZE;
+	memset(userArea, 0xdddddddd, userSize );
 
-		if ( nextBlock && !nextBlock->m_used )
-		{
-			//memBlock *nextBlock = block->m_next;
+	int bin = (int)(block->GetSize() >> HEAP_SMALL_BIN_SHIFT);
+	vsHeapThreadCache::Slot *slot = ( bin < HEAP_CACHE_BIN_COUNT ) ? t_threadCache.GetSlot(this) : NULL;
 
-			// next block isn't being used;  let's merge it into us!
-			block->m_end = nextBlock->m_end;
-			block->m_size += nextBlock->m_size;
+	if ( slot )
+	{
+		slot->stats.frees++;
+		if ( block->m_allocThread != (uint16_t)t_threadCache.m_threadId )
+			slot->stats.crossThreadFrees++;
 
-			nextBlock->ExtractBlock();
-			nextBlock->Extract();
-		}
-		if ( prevBlock && prevBlock != &m_unusedBlockList && !prevBlock->m_used )
-		{
-			// previous block isn't being used;  let's merge ourself into it!
-			prevBlock->m_end = block->m_end;
-			prevBlock->m_size += block->m_size;
-			block->ExtractBlock();
-			block->Extract();
-			m_lock.Unlock();
-			return;
-		}
+		block->m_flags = memBlock::Flag_Cached;
+		CachedNext(block) = slot->head[bin];
+		slot->head[bin] = block;
+		slot->count[bin]++;
 
-		block->Extract();
-		m_unusedBlockList.Append(block);
-		//foundBlockToFree = true;
-		m_lock.Unlock();
+		if ( slot->count[bin] > HEAP_CACHE_MAX_COUNT )
+			t_threadCache.Flush( slot, bin, slot->count[bin] - HEAP_CACHE_REFILL_COUNT );
 		return;
 	}
-	//	block = block->m_next;
-	//}
-
-	//vsAssert(foundBlockToFree, "Tried to free a block we didn't allocate!");	// tried to free a block we didn't know about!
 
+	m_lock.Lock();
+	FreeBlock_Locked(block);
 	m_lock.Unlock();
 }
 
@@ -309,51 +952,103 @@ vsHeap::PrintStatus()
 #ifdef VS_OVERLOAD_ALLOCATORS
 	vsLog(" >> MEMORY STATUS");
 
+	m_lock.Lock();
 	size_t bytesFree = m_memorySize - m_memoryUsed;
-	size_t largestBlock = 0;
-
-	memBlock *block = m_unusedBlockList.m_next;
+	size_t largestBlock = GetLargestFreeBlockSize();
+	size_t freeBlocks = m_freeBlockCount;
+	size_t usedBlocks = m_usedBlockCount;
+	m_lock.Unlock();
 
-	while ( block )
-	{
-		if ( !block->m_used && block->m_size > largestBlock )
-			largestBlock = block->m_size;
+	CacheStats cache;
+	GetThreadCacheStats(cache);
+	size_t cacheAllocs = cache.hits + cache.misses;
+	float cacheHitRate = cacheAllocs ? (100.0f * cache.hits / cacheAllocs) : 0.f;
 
-		block = block->m_next;
-	}
+	size_t headerBytes = usedBlocks * (HEAP_HEADER_SIZE + HEAP_GUARD_SIZE);
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	size_t savedBytes = usedBlocks * sizeof(memBlockDebug);
+#endif
 
 #ifdef _WIN32
 	vsLog(" >> Heap current usage %lu / %lu (%0.2f%% usage)", m_memoryUsed, m_memorySize, 100.0f*m_memoryUsed/m_memorySize);
 	vsLog(" >> Heap highwater usage %lu / %lu (%0.2f%% usage)", m_highWaterMark, m_memorySize, 100.0f*m_highWaterMark/m_memorySize);
 	vsLog(" >> Heap largest free block %lu / %lu bytes free (%0.2f%% fragmentation)", largestBlock, bytesFree, 100.0f - (100.0f*largestBlock / bytesFree) );
+	vsLog(" >> Heap free blocks: %lu", freeBlocks);
+	vsLog(" >> Heap thread caches: %lu blocks cached, %0.2f%% hit rate, %lu flushes, %lu cross-thread frees", cache.cachedBlocks, cacheHitRate, cache.flushes, cache.crossThreadFrees);
+	vsLog(" >> Heap block overhead: %lu bytes across %lu used blocks", headerBytes, usedBlocks);
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	vsLog(" >> Heap compact headers saved %lu bytes;  %lu allocations sampled, %lu samples dropped", savedBytes, m_sampleCount, m_samplesDropped);
+#endif
 #else
 	vsLog(" >> Heap current usage %zu / %zu (%0.2f%% usage)", m_memoryUsed, m_memorySize, 100.0f*m_memoryUsed/m_memorySize);
 	vsLog(" >> Heap highwater usage %zu / %zu (%0.2f%% usage)", m_highWaterMark, m_memorySize, 100.0f*m_highWaterMark/m_memorySize);
 	vsLog(" >> Heap largest free block %zu / %zu bytes free (%0.2f%% fragmentation)", largestBlock, bytesFree, 100.0f - (100.0f*largestBlock / bytesFree) );
+	vsLog(" >> Heap free blocks: %zu", freeBlocks);
+	vsLog(" >> Heap thread caches: %zu blocks cached, %0.2f%% hit rate, %zu flushes, %zu cross-thread frees", cache.cachedBlocks, cacheHitRate, cache.flushes, cache.crossThreadFrees);
+	vsLog(" >> Heap block overhead: %zu bytes across %zu used blocks", headerBytes, usedBlocks);
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	vsLog(" >> Heap compact headers saved %zu bytes;  %zu allocations sampled, %zu samples dropped", savedBytes, m_sampleCount, m_samplesDropped);
+#endif
 #endif
 #endif // VS_OVERLOAD_ALLOCATORS
 
 }
 
+void
+vsHeap::SetMarkForLeakTesting()
+{
+	// Everything which currently exists was allocated before the mark.
+	m_lock.Lock();
+	for ( memBlock *block = GetFirstBlock(); block; block = GetNextBlock(block) )
+	{
+		if ( block->m_used )
+			block->SetFlag( memBlock::Flag_AfterMark, false );
+	}
+	m_lock.Unlock();
+}
+
+bool
+vsHeap::IsLeak( memBlock *block )
+{
+	return block->m_used &&
+		!block->HasFlag( memBlock::Flag_Cached ) &&
+		block->HasFlag( memBlock::Flag_AfterMark );
+}
+
+void
+vsHeap::LogBlock( memBlock *block, bool includeHeapName )
+{
+	vsString prefix = includeHeapName ? m_name + ":" : vsEmptyString;
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	memBlockDebug debug;
+	if ( !GetSample( block, &debug ) )
+	{
+		vsLog("[%s?] (unsampled) : %d bytes", prefix.c_str(), block->GetSize() - HEAP_HEADER_SIZE - HEAP_GUARD_SIZE);
+		return;
+	}
+#else
+	memBlockDebug &debug = block->m_debug;
+#endif
+	vsLog("[%s%d] %s:%d : %d bytes", prefix.c_str(), debug.m_blockId, debug.m_filename, debug.m_line, debug.m_sizeRequested);
+}
+
 void
 vsHeap::CheckForLeaks()
 {
 	m_lock.Lock();
 	bool foundLeak = false;
-	memBlock *block = m_blockList.m_next;
 
-	while ( block )
+	for ( memBlock *block = GetFirstBlock(); block; block = GetNextBlock(block) )
 	{
-		if ( block->m_used && block->m_blockId > m_leakMark )
+		if ( IsLeak(block) )
 		{
 			if ( !foundLeak )
 			{
 				vsLog("\nERROR:  LEAKS DETECTED!\n-------------------\nLeaked blocks follow:\n");
 				foundLeak = true;
 			}
-			vsLog("[%s:%d] %s:%d : %d bytes", m_name.c_str(), block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
+			LogBlock( block, true );
 		}
-		block = block->m_next;
 	}
 	m_lock.Unlock();
 
@@ -363,93 +1058,23 @@ vsHeap::CheckForLeaks()
 void
 vsHeap::TraceMemoryBlocks()
 {
-	memBlock *block = m_blockList.m_next;
-
-	while ( block )
+	for ( memBlock *block = GetFirstBlock(); block; block = GetNextBlock(block) )
 	{
-		if ( block->m_used )
-		{
-#ifdef _WIN32
-			vsLog("[%d] %s:%d : %lu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
-#else
-			vsLog("[%d] %s:%d : %zu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
-#endif
-		}
-		block = block->m_next;
+		if ( block->m_used && !block->HasFlag( memBlock::Flag_Cached ) )
+			LogBlock( block, false );
 	}
 }
 
 void
 vsHeap::PrintBlockList()
 {
-	memBlock *block = m_blockList.m_next;
-
-	while ( block )
+	for ( memBlock *block = GetFirstBlock(); block; block = GetNextBlock(block) )
 	{
-#ifdef _WIN32
-		vsLog("[%d] %s:%d : %lu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
-#else
-		vsLog("[%d] %s:%d : %zu bytes", block->m_blockId, block->m_filename, block->m_line, block->m_sizeRequested);
-#endif
-		block = block->m_next;
+		if ( block->m_used )
+			LogBlock( block, false );
 	}
 }
 
-memBlock::memBlock():
-	m_start(0),
-	m_end(0),
-	m_size(0),
-	m_used(false),
-	m_next(NULL),
-	m_prev(NULL)
-{
-}
-
-
-void
-memBlock::Append( memBlock *block )
-{
-	block->m_next = m_next;
-	block->m_prev = this;
-
-	if ( m_next )
-		m_next->m_prev = block;
-	m_next = block;
-}
-
-void
-memBlock::Extract()
-{
-	if ( m_next )
-		m_next->m_prev = m_prev;
-	if ( m_prev )
-		m_prev->m_next = m_next;
-
-	m_next = m_prev = NULL;
-}
-
-void
-memBlock::AppendBlock( memBlock *block )
-{
-	block->m_nextBlock = m_nextBlock;
-	block->m_prevBlock = this;
-
-	if ( m_nextBlock )
-		m_nextBlock->m_prevBlock = block;
-	m_nextBlock = block;
-}
-
-void
-memBlock::ExtractBlock()
-{
-	if ( m_nextBlock )
-		m_nextBlock->m_prevBlock = m_prevBlock;
-	if ( m_prevBlock )
-		m_prevBlock->m_nextBlock = m_nextBlock;
-
-	m_nextBlock = m_prevBlock = NULL;
-}
-
 void * MyMalloc(size_t size, const char *fileName, int lineNumber, int allocType)
 {
 	void * result;
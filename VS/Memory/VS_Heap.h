@@ -10,40 +10,88 @@
 #ifndef MEM_HEAP_H
 #define MEM_HEAP_H
 
+#include "VS_Config.h"
 #include "VS/Threads/VS_Spinlock.h"
+#include <atomic>
 
+// Blocks are always a multiple of this many bytes, and start on this alignment.
+#define HEAP_BLOCK_SHIFT (5)
+#define HEAP_BLOCK_ALIGNMENT (1 << HEAP_BLOCK_SHIFT)
 
-class memBlock
+// Full debugging information about an allocation.  Without
+// VS_COMPACT_HEAP_HEADERS, every block header carries one of these.  With it,
+// they're only recorded for a sample of allocations, in a side table.
+struct memBlockDebug
 {
-public:
-
-	void *		m_start;
-	void *		m_end;
-	size_t		m_size;
 	size_t		m_sizeRequested;
 	int			m_blockId;
-
-	char		m_filename[128];
 	int			m_line;
+	char		m_filename[128];
+};
 
-	char		m_allocType;
+class memBlock
+{
+public:
 
-	bool		m_used;
+	enum
+	{
+		Flag_Cached = BIT(0),		// sitting in a thread's cache;  'used', but not by the user.
+		Flag_Sampled = BIT(1),		// has an entry in the heap's sampled debug table
+		Flag_AfterMark = BIT(2)		// allocated since the last SetMarkForLeakTesting()
+	};
+
+	uint32_t	m_prevBlock;	// offset of the previous block in memory, in HEAP_BLOCK_ALIGNMENT units
+	uint32_t	m_units;		// size of this block, in HEAP_BLOCK_ALIGNMENT units
+
+	// 'm_used' is only ever changed under the heap's lock;  the other fields
+	// below belong to whoever currently owns the block.
+	uint8_t		m_used;
+	uint8_t		m_flags;
+	uint8_t		m_allocType;
+	uint8_t		m_unused;
+	uint16_t	m_allocThread;	// id of the thread which allocated this block
+
+#if !defined(VS_COMPACT_HEAP_HEADERS)
+	memBlockDebug	m_debug;
+#endif
+
+	size_t	GetSize() const { return (size_t)m_units << HEAP_BLOCK_SHIFT; }
+	void	SetSize( size_t size ) { m_units = (uint32_t)(size >> HEAP_BLOCK_SHIFT); }
+
+	bool	HasFlag( int flag ) const { return (m_flags & flag) != 0; }
+	void	SetFlag( int flag, bool set ) { if ( set ) m_flags |= flag; else m_flags &= ~flag; }
+};
 
-	memBlock *	m_next;
-	memBlock *	m_prev;
+// The user's memory starts this many bytes into each block.
+#define HEAP_HEADER_SIZE ((sizeof(memBlock) + 15) & ~(size_t)15)
 
-	memBlock *	m_nextBlock;
-	memBlock *	m_prevBlock;
+// While a block is free, we keep its free list links in the space which the
+// user would otherwise be using.  Small free blocks are doubly linked through
+// 'next' and 'prev';  large ones live in a best-fit tree through 'treeLeft'
+// and 'treeRight'.
+struct memFreeLinks
+{
+	memBlock *	next;
+	memBlock *	prev;
+	memBlock *	treeLeft;
+	memBlock *	treeRight;
+};
 
-	memBlock();
+// Smallest block we'll ever create;  big enough to hold its free list links.
+#define HEAP_MIN_BLOCK_SIZE ((HEAP_HEADER_SIZE + sizeof(memFreeLinks) + HEAP_BLOCK_ALIGNMENT - 1) & ~(size_t)(HEAP_BLOCK_ALIGNMENT - 1))
 
-	void Extract();
-	void Append( memBlock *block );
+// We write a guard value just past the end of each user allocation, to detect
+// overruns.  Compact headers only do this in debug builds.
+#if !defined(VS_COMPACT_HEAP_HEADERS) || defined(_DEBUG)
+#define HEAP_GUARD_ENABLED
+#define HEAP_GUARD_SIZE (sizeof(unsigned long))
+#else
+#define HEAP_GUARD_SIZE (0)
+#endif
 
-	void ExtractBlock();
-	void AppendBlock( memBlock *block );
-};
+// With compact headers, record debug information for one in this many
+// allocations, by default.
+#define HEAP_DEFAULT_SAMPLE_RATE (64)
 
 enum
 {
@@ -54,6 +102,23 @@ enum
 	Type_NewArray
 };
 
+// Free blocks smaller than this many bytes are kept in exact size-class
+// free lists;  larger free blocks are kept in a best-fit tree.
+#define HEAP_SMALL_BIN_COUNT (64)
+#define HEAP_SMALL_BIN_SHIFT (HEAP_BLOCK_SHIFT)
+#define HEAP_SMALL_BLOCK_LIMIT (HEAP_SMALL_BIN_COUNT << HEAP_SMALL_BIN_SHIFT)
+
+// Blocks from the smallest HEAP_CACHE_BIN_COUNT size classes are cached per
+// thread, so that most small allocations never need to take the heap's lock.
+// Caches are refilled HEAP_CACHE_REFILL_COUNT blocks at a time, and flushed
+// back down to that many once they hold more than HEAP_CACHE_MAX_COUNT.
+#define HEAP_CACHE_BIN_COUNT (24)
+#define HEAP_CACHE_REFILL_COUNT (16)
+#define HEAP_CACHE_MAX_COUNT (64)
+#define HEAP_CACHE_SLOT_COUNT (4)	// number of vsHeaps each thread can cache for
+
+class vsHeapThreadCache;
+
 class vsHeap
 {
 #define MAX_ALLOCATIONS (4096)
@@ -65,20 +130,79 @@ class vsHeap
 
 	size_t	m_memoryUsed;
 	size_t	m_highWaterMark;
-	size_t	m_totalAllocations;
-
-	int		m_leakMark;
+	size_t	m_usedBlockCount;
+	std::atomic<size_t>	m_totalAllocations;
 
-	memBlock	m_blockList;
-	memBlock	m_unusedBlockList;
 //	memBlock	m_blockStore[MAX_ALLOCATIONS];
 
+	memBlock *	m_smallBin[HEAP_SMALL_BIN_COUNT];	// free lists, one per 32-byte size class
+	uint64_t	m_smallBinMap;						// bit 'n' set if m_smallBin[n] is non-empty
+	memBlock *	m_largeTree;						// best-fit tree of large free blocks
+	size_t		m_freeBlockCount;
+
+#if defined(VS_COMPACT_HEAP_HEADERS)
+	struct Sample
+	{
+		memBlock *		block;
+		memBlockDebug	debug;
+	};
+	Sample *	m_sample;				// open-addressed table of sampled blocks
+	size_t		m_sampleCapacity;
+	size_t		m_sampleCount;
+	size_t		m_samplesDropped;		// samples we couldn't record because the table was full
+	int			m_sampleRate;
+	vsSpinlock	m_sampleLock;
+
+	static int	s_defaultSampleRate;
+
+	void		AddSample( memBlock *block, const char *file, int line, int blockId, size_t sizeRequested );
+	bool		GetSample( memBlock *block, memBlockDebug *out );
+	void		RemoveSample( memBlock *block );
+#endif // VS_COMPACT_HEAP_HEADERS
+
 	static vsHeap * s_current;
 
 	memBlock *	FindFreeMemBlockOfSize(size_t size);
+	memBlock *	FindFreeMemBlockOfSize_Internal(size_t size);	// returns NULL rather than asserting
+	void		InsertFreeBlock(memBlock *block);
+	void		RemoveFreeBlock(memBlock *block);
+	size_t		GetLargestFreeBlockSize();
 //	memBlock *	GetUnusedMemBlock();
 	vsSpinlock m_lock;
 
+	memBlock *	GetFirstBlock() { return (memBlock *)m_startOfMemory; }
+	memBlock *	GetNextBlock( memBlock *block );
+	memBlock *	GetPrevBlock( memBlock *block );
+	void		SetPrevBlock( memBlock *block, memBlock *prev );
+
+	memBlock *	AllocBlock_Locked(size_t size);
+	void		FreeBlock_Locked(memBlock *block);
+	void		ForgetThreadCaches();
+
+	bool		IsLeak( memBlock *block );
+	void		LogBlock( memBlock *block, bool includeHeapName );
+
+public:
+
+	struct CacheStats
+	{
+		size_t	hits;				// allocations served from a thread cache
+		size_t	misses;				// allocations which had to refill a thread cache
+		size_t	frees;				// frees into a thread cache
+		size_t	flushes;			// batches of blocks returned from a thread cache to the heap
+		size_t	crossThreadFrees;	// frees of blocks which were allocated by another thread
+		size_t	cachedBlocks;		// blocks currently held in thread caches
+
+		CacheStats(): hits(0), misses(0), frees(0), flushes(0), crossThreadFrees(0), cachedBlocks(0) {}
+		void Add( const CacheStats &other );
+	};
+
+private:
+
+	CacheStats	m_retiredCacheStats;	// stats from thread caches which have been released
+
+	friend class vsHeapThreadCache;
+
 public:
 	vsHeap(vsString name, size_t bufferSize);
 	vsHeap(vsString name, void *buffer, int bufferSize);
@@ -98,7 +222,18 @@ public:
 	void	CheckForLeaks();
 	void	TraceMemoryBlocks();
 
-	void	SetMarkForLeakTesting() { m_leakMark = (int)m_totalAllocations; }
+	// Should be called while no other threads are allocating from this heap.
+	void	SetMarkForLeakTesting();
+
+	// Returns the blocks in the calling thread's cache for this heap.
+	void	FlushThreadCache();
+	void	GetThreadCacheStats( CacheStats &stats );
+
+	// With compact headers, only one allocation in 'rate' records where it
+	// was allocated from.  '1' records everything;  '0' records nothing.
+	// Without compact headers, every allocation is always recorded.
+	void		SetDebugSampleRate( int rate );
+	static void	SetDefaultDebugSampleRate( int rate );
 };
 
 
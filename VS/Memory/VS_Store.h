@@ -42,6 +42,7 @@ public:
 			vsStore( const vsStore& store ); // make a copy of the other store
 	virtual ~vsStore();
 
+	char *	GetBuffer()		{ return m_buffer; }
 	char *	GetReadHead()	{ return m_readHead; }
 	char *	GetWriteHead()	{ return m_writeHead; }
 	inline size_t		BytesLeftForWriting() const { return (size_t)(m_bufferEnd - m_writeHead); }
@@ -38,6 +38,9 @@ m_responder(NULL)
 
 	m_bodyDef.userData = this;
 	m_bodyDef.type = (isStatic)? b2_staticBody : b2_dynamicBody;
+
+	m_snapshotAngle = 0.f;
+	m_snapshotAngularVelocity = 0.f;
 }
 
 vsCollisionObject::~vsCollisionObject()
@@ -54,6 +57,15 @@ vsCollisionObject::~vsCollisionObject()
 	}
 }
 
+bool
+vsCollisionObject::IsStepping()
+{
+	vsCollisionSystem *system = vsCollisionSystem::Instance();
+	return system && system->IsStepping();
+}
+
+#define CHECK_NOT_STEPPING() vsAssert( !IsStepping(), "Can't modify physics bodies while the world is stepping;  see VS_CollisionSystem.h" )
+
 void
 vsCollisionObject::SetCircle(colCircle *circle, float density)
 {
@@ -162,6 +174,7 @@ vsCollisionObject::AddBox(const vsVector2D &extents, const vsVector2D &position,
 void
 vsCollisionObject::AddRotationJointTo(vsCollisionObject *other, const vsVector2D &jointPos, float minAngle, float maxAngle)
 {
+	CHECK_NOT_STEPPING();
 	vsAssert(m_jointCount < MAX_JOINTS, "Ran out of joints!");
 
 	b2RevoluteJointDef	jointDef;
@@ -192,6 +205,7 @@ vsCollisionObject::AddRotationJointTo(vsCollisionObject *other, const vsVector2D
 void
 vsCollisionObject::DestroyRotationJointTo(vsCollisionObject *other)
 {
+	CHECK_NOT_STEPPING();
 	for ( int i = 0; i < m_jointCount; i++ )
 	{
 		if ( m_joint[i] && m_jointPartner[i] == other )
@@ -303,6 +317,7 @@ vsCollisionObject::NotifyCollision( vsCollisionObject *other, const vsVector2D &
 bool
 vsCollisionObject::IsOnSurface()
 {
+	vsAssert( !IsStepping(), "Can't read contacts while the world is stepping;  see VS_CollisionSystem.h" );
 	bool result = false;
 
 	b2ContactEdge *node = m_body->GetContactList();
@@ -330,9 +345,21 @@ vsCollisionObject::IsOnSurface()
 	return result;
 }
 
+void
+vsCollisionObject::TakeSnapshot()
+{
+	b2Vec2 p = m_body->GetPosition();
+	b2Vec2 v = m_body->GetLinearVelocity();
+	m_snapshotPosition.Set(p.x, p.y);
+	m_snapshotAngle = m_body->GetAngle();
+	m_snapshotVelocity.Set(v.x, v.y);
+	m_snapshotAngularVelocity = m_body->GetAngularVelocity();
+}
+
 void
 vsCollisionObject::SetPosition( const vsVector2D &pos )
 {
+	CHECK_NOT_STEPPING();
 	b2Vec2 p(pos.x,pos.y);
 
 	m_body->SetTransform(p, m_body->GetAngle());
@@ -341,6 +368,9 @@ vsCollisionObject::SetPosition( const vsVector2D &pos )
 vsVector2D
 vsCollisionObject::GetPosition()
 {
+	if ( IsStepping() )
+		return m_snapshotPosition;
+
 	b2Vec2 p = m_body->GetPosition();
 
 	return vsVector2D(p.x,p.y);
@@ -349,12 +379,16 @@ vsCollisionObject::GetPosition()
 void
 vsCollisionObject::SetAngle( const vsAngle &ang )
 {
+	CHECK_NOT_STEPPING();
 	m_body->SetTransform(m_body->GetPosition(), ang.Get());
 }
 
 vsAngle
 vsCollisionObject::GetAngle()
 {
+	if ( IsStepping() )
+		return vsAngle(m_snapshotAngle);
+
 	float r = m_body->GetAngle();
 
 	return vsAngle(r);
@@ -371,6 +405,7 @@ vsCollisionObject::SetVelocity( const vsVector2D &velocity, float angularVelocit
 void
 vsCollisionObject::SetVelocity( const vsVector2D &velocity )
 {
+	CHECK_NOT_STEPPING();
 	b2Vec2 v( velocity.x, velocity.y );
 
 	m_body->SetLinearVelocity(v);
@@ -379,6 +414,7 @@ vsCollisionObject::SetVelocity( const vsVector2D &velocity )
 void
 vsCollisionObject::SetAngularVelocity( float angularVelocity )
 {
+	CHECK_NOT_STEPPING();
 	m_body->SetAngularVelocity(angularVelocity);
 }
 
@@ -409,6 +445,9 @@ vsCollisionObject::SetRestitution(float restitution)
 vsVector2D
 vsCollisionObject::GetVelocity()
 {
+	if ( IsStepping() )
+		return m_snapshotVelocity;
+
 	b2Vec2 v = m_body->GetLinearVelocity();
 	vsVector2D vel(v.x,v.y);
 
@@ -418,6 +457,9 @@ vsCollisionObject::GetVelocity()
 float
 vsCollisionObject::GetAngularVelocity()
 {
+	if ( IsStepping() )
+		return m_snapshotAngularVelocity;
+
 	return m_body->GetAngularVelocity();
 }
 
@@ -451,6 +493,7 @@ void
 vsCollisionObject::AddForce( const vsVector2D &force )
 {
 	vsAssert(m_body, "Tried to add force without a body!");
+	CHECK_NOT_STEPPING();
 	b2Vec2 f(force.x, force.y);
 	b2Vec2 w = m_body->GetWorldCenter();
 	m_body->ApplyForce( f, w, true );
@@ -460,6 +503,7 @@ void
 vsCollisionObject::AddTorque( float torque )
 {
 	vsAssert(m_body, "Tried to apply torque without a body!");
+	CHECK_NOT_STEPPING();
 	m_body->ApplyTorque( torque, true );
 }
 
@@ -470,6 +514,7 @@ vsCollisionObject::SetCollisionsActive(bool active)
 
 	if ( currentlyActive != active )
 	{
+		CHECK_NOT_STEPPING();
 		if ( active )
 		{
 			RegisterObject();
@@ -525,6 +570,7 @@ vsCollisionObject::DeregisterObject()
 void
 vsCollisionObject::SetJointMotorSpeed( int jointId, float speed, float maxTorque )
 {
+	CHECK_NOT_STEPPING();
 	m_body->SetAwake(true);
 	m_joint[jointId]->EnableMotor(true);
 	m_joint[jointId]->SetMotorSpeed(speed);
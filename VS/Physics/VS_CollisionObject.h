@@ -105,6 +105,15 @@ class vsCollisionObject
 
 	vsCollisionResponder *	m_responder;
 
+	// Our body's state as of the start of the physics step which is running
+	// in the background, if there is one.  (See VS_CollisionSystem.h)
+	vsVector2D	m_snapshotPosition;
+	float		m_snapshotAngle;
+	vsVector2D	m_snapshotVelocity;
+	float		m_snapshotAngularVelocity;
+
+	bool		IsStepping();
+
 	void		RegisterObject();
 	void		DeregisterObject();
 	void		SetCollisionsActive_Internal( bool active );
@@ -135,6 +144,9 @@ public:
 
 	bool		IsActive() { return !!(m_body); }
 
+	// Called by vsCollisionSystem before it steps the world in the background.
+	void		TakeSnapshot();
+
 	virtual void		Update( float timeStep );
 
 	vsVector2D			GetPosition();
@@ -15,10 +15,14 @@
 #include "VS_EnableDebugNew.h"
 
 #include "VS_Vector.h"
+#include "VS_Array.h"
+#include "VS_Profile.h"
 
 vsCollisionSystem *		vsCollisionSystem::s_instance = NULL;
 
 #define DEFAULT_WORLD_SIZE (10000.f)
+#define STEP_INCREMENT (1.0f / 60.0f)
+#define STEP_ITERATIONS (10)
 
 float vsCollisionSystem::s_left = -DEFAULT_WORLD_SIZE;
 float vsCollisionSystem::s_right = DEFAULT_WORLD_SIZE;
@@ -53,36 +57,78 @@ class vsCollisionSystemDestructionListener : public b2DestructionListener
 
 	};*/
 
+struct vsCollisionContact
+{
+	vsCollisionObject *	one;
+	vsCollisionObject *	two;
+	vsVector2D			where;
+};
+
 class vsCollisionSystemContactListener : public b2ContactListener
 	{
+		vsArray<vsCollisionContact>	m_deferred;
+		bool						m_defer;
+
+		void Notify( const vsCollisionContact &contact )
+		{
+			if ( contact.one )
+			{
+				contact.one->NotifyCollision(contact.two, contact.where);
+			}
+			if ( contact.two )
+			{
+				contact.two->NotifyCollision(contact.one, contact.where);
+			}
+		}
+
+	public:
+
+		vsCollisionSystemContactListener():
+			m_defer(false)
+		{
+		}
+
+		// While deferring, contacts are only collected, to be reported later
+		// by NotifyDeferred().
+		void SetDeferred( bool defer ) { m_defer = defer; }
+
+		void NotifyDeferred()
+		{
+			for ( int i = 0; i < m_deferred.ItemCount(); i++ )
+				Notify( m_deferred[i] );
+			m_deferred.Clear();
+		}
+
 		virtual void BeginContact(b2Contact* point)
 		{
 			b2Vec2 vec = point->GetManifold()->localPoint;
-			vsVector2D where( vec.x, vec.y );
 
 			b2Body *bOne = point->GetFixtureA()->GetBody();
 			b2Body *bTwo = point->GetFixtureB()->GetBody();
 
-			vsCollisionObject *cOne = NULL;
-			vsCollisionObject *cTwo = NULL;
+			vsCollisionContact contact;
+			contact.one = NULL;
+			contact.two = NULL;
+			contact.where.Set( vec.x, vec.y );
 
 			if ( bOne )
-				cOne = (vsCollisionObject *)bOne->GetUserData();
+				contact.one = (vsCollisionObject *)bOne->GetUserData();
 			if ( bTwo )
-				cTwo = (vsCollisionObject *)bTwo->GetUserData();
+				contact.two = (vsCollisionObject *)bTwo->GetUserData();
 
-			if ( cOne )
-			{
-				cOne->NotifyCollision(cTwo, where);
-			}
-			if ( cTwo )
-			{
-				cTwo->NotifyCollision(cOne, where);
-			}
+			if ( m_defer )
+				m_deferred.AddItem( contact );
+			else
+				Notify( contact );
 		}
 	};
 
-vsCollisionSystem::vsCollisionSystem()
+vsCollisionSystem::vsCollisionSystem():
+	m_world(NULL),
+	m_timeBucket(0.f),
+	m_stepMode(StepMode_Serial),
+	m_stepDue(false),
+	m_stepping(false)
 {
 	s_instance = this;
 }
@@ -162,6 +208,9 @@ vsCollisionSystem::Init()
 void
 vsCollisionSystem::Deinit()
 {
+	FinishStep();
+	m_stepDue = false;
+
 	vsDelete(m_world);
 	vsDelete(m_destructionListener);
 	//vsDelete(m_boundaryListener);
@@ -177,6 +226,7 @@ vsCollisionSystem::Deinit()
 void
 vsCollisionSystem::SetGravity( const vsVector2D &gravity )
 {
+	vsAssert( !m_stepping, "Can't modify the physics world while it's stepping;  see VS_CollisionSystem.h" );
 	b2Vec2 g(gravity.x,gravity.y);
 
 	m_world->SetGravity( g );
@@ -198,21 +248,102 @@ vsCollisionSystem::DeregisterObject( vsCollisionObject *object )
 void
 vsCollisionSystem::Update(float timeStep)
 {
-	const float c_stepIncrement = ( 1.0f / 60.0f );
-	const int32_t iterations = 10;
+	// Normally nothing's running by now, but a game which drives its own
+	// frames might not have called FinishStep().
+	FinishStep();
 
 	m_timeBucket += timeStep;
 
 	if ( m_timeBucket > 1.0f )
-		m_timeBucket = c_stepIncrement;
+		m_timeBucket = STEP_INCREMENT;
 
-	//while ( m_timeBucket >= c_stepIncrement )
+	//while ( m_timeBucket >= STEP_INCREMENT )
 	//{
-		m_world->Step( c_stepIncrement, iterations, iterations );
-		m_timeBucket -= c_stepIncrement;
+		if ( m_stepMode == StepMode_Serial )
+		{
+			Step();
+		}
+		else
+		{
+			// If the last frame's step never began, take it now, so we never
+			// skip one.
+			if ( m_stepDue )
+				Step();
+			m_stepDue = true;
+		}
+		m_timeBucket -= STEP_INCREMENT;
 	//}
 }
 
+void
+vsCollisionSystem::Step()
+{
+	PROFILE("PhysicsStep");
+	m_world->Step( STEP_INCREMENT, STEP_ITERATIONS, STEP_ITERATIONS );
+}
+
+void
+vsCollisionSystem::StepJob( void *data )
+{
+	vsCollisionSystem *system = reinterpret_cast<vsCollisionSystem*>(data);
+	system->Step();
+}
+
+void
+vsCollisionSystem::SetStepMode( StepMode mode )
+{
+	FinishStep();
+	if ( mode == StepMode_Serial && m_stepDue )
+	{
+		// switching to serial between Update() and BeginStep();  this frame's
+		// step has to happen now, or it never will.
+		Step();
+	}
+	m_stepDue = false;
+	m_stepMode = mode;
+}
+
+void
+vsCollisionSystem::BeginStep()
+{
+	if ( !m_stepDue || !m_world )
+		return;
+	m_stepDue = false;
+
+	if ( !vsJobSystem::Exists() )
+	{
+		Step();
+		return;
+	}
+
+	for ( b2Body *body = m_world->GetBodyList(); body; body = body->GetNext() )
+	{
+		vsCollisionObject *object = (vsCollisionObject *)body->GetUserData();
+		if ( object )
+			object->TakeSnapshot();
+	}
+
+	m_contactListener->SetDeferred(true);
+	m_stepping = true;
+	vsJobSystem::Instance()->Run( &StepJob, this, &m_stepJob );
+}
+
+void
+vsCollisionSystem::FinishStep()
+{
+	if ( !m_stepping )
+		return;
+
+	{
+		PROFILE("WaitForPhysics");
+		vsJobSystem::Instance()->Wait( &m_stepJob );
+	}
+	m_stepping = false;
+
+	m_contactListener->SetDeferred(false);
+	m_contactListener->NotifyDeferred();
+}
+
 class vsCollisionSystemQueryCallback: public b2QueryCallback
 {
 	vsCollisionObject **m_resultArray;
@@ -268,6 +399,8 @@ public:
 int
 vsCollisionSystem::FindColObjectsUnder( const vsVector2D &where, float radius, vsCollisionObject **resultArray, int maxResults )
 {
+	vsAssert( !m_stepping, "Can't query the physics world while it's stepping;  see VS_CollisionSystem.h" );
+
     b2AABB aabb;
     aabb.lowerBound.Set(where.x-radius, where.y-radius);
     aabb.upperBound.Set(where.x+radius, where.y+radius);
@@ -14,6 +14,7 @@
 #include "VS/Utils/VS_Singleton.h"
 #include "VS/Math/VS_Vector.h"
 #include "VS/Math/VS_Transform.h"
+#include "VS/Threads/VS_JobSystem.h"
 
 class vsPhysicsSprite;
 class b2World;
@@ -40,8 +41,39 @@ struct colRecord
 };
 */
 
+// Box2D stepping can happen in one of two ways:
+//
+// StepMode_Serial (the default) steps the world during Update(), at the
+// start of each frame, and calls collision callbacks from inside the step.
+// It's entirely deterministic, so use it for replays.
+//
+// StepMode_Overlapped steps the world on a job system worker while the
+// frame is being drawn;  coreGame calls BeginStep() just before drawing and
+// FinishStep() just afterward.  The world goes through exactly the same
+// sequence of steps as in serial mode, but between those two calls it
+// belongs to the worker:
+//
+//  - vsCollisionObject's Get functions return a snapshot of each body,
+//    taken when the step began, so drawing code can still read them.
+//  - Anything which would modify the world (creating or destroying bodies,
+//    setting positions or velocities, applying forces) asserts.
+//  - Collision callbacks are collected during the step, and called on the
+//    main thread from FinishStep(), in the order Box2D reported them.  That
+//    is the sync point;  by the time the next frame's update begins, every
+//    callback from the last step has been made.
+
 class vsCollisionSystem : public coreGameSystem
 {
+public:
+
+	enum StepMode
+	{
+		StepMode_Serial,
+		StepMode_Overlapped
+	};
+
+private:
+
 	static vsCollisionSystem *	s_instance;
 
 	b2World *		m_world;
@@ -58,6 +90,14 @@ class vsCollisionSystem : public coreGameSystem
 
 	float			m_timeBucket;
 
+	StepMode		m_stepMode;
+	bool			m_stepDue;		// Update() has been called, but we haven't stepped yet
+	bool			m_stepping;		// a step is running on a worker
+	vsJobCounter	m_stepJob;
+
+	void			Step();
+	static void		StepJob( void *data );
+
 public:
 
 					vsCollisionSystem();
@@ -80,6 +120,14 @@ public:
 
 	virtual void	Update( float timeStep );
 
+	void			SetStepMode( StepMode mode );
+	StepMode		GetStepMode() { return m_stepMode; }
+
+	// Overlapped stepping;  see above.  These do nothing in serial mode.
+	void			BeginStep();
+	void			FinishStep();
+	bool			IsStepping() { return m_stepping; }
+
 //	void			RegisterObject( vsCollisionObject *sprite );
 //	void			DeregisterObject( vsCollisionObject *sprite );
 
@@ -0,0 +1,549 @@
+/*
+ *  VS_JobSystem.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_JobSystem.h"
+#include "VS_Semaphore.h"
+#include "VS_Task.h"
+#include "VS/Utils/VS_Pool.h"
+#include "VS/Utils/VS_Profiler.h"
+
+#include "VS/VS_DisableDebugNew.h"
+#include <thread>
+#include "VS/VS_EnableDebugNew.h"
+
+#define JOB_POOL_SIZE (4096)
+#define JOB_DEQUE_SIZE (4096)			// per thread;  must be a power of two
+#define JOB_SPINS_BEFORE_SLEEP (64)
+#define PARALLEL_FOR_JOBS_PER_THREAD (4)
+#define PARALLEL_FOR_MAX_JOBS (256)
+
+struct vsJob
+{
+	vsJobFunction	function;
+	void *			data;
+	vsJobCounter *	counter;
+	vsJob *			next;		// in the shared queue, or in a counter's waiting list
+};
+
+static thread_local int t_threadIndex = -1;
+static thread_local uint32_t t_stealSeed = 0;
+
+// A Chase-Lev work-stealing deque.  The owning thread pushes and pops at the
+// bottom;  any other thread may steal from the top.
+class vsJobDeque
+{
+	std::atomic<int64_t>	m_top;
+	std::atomic<int64_t>	m_bottom;
+	std::atomic<vsJob*>		m_slot[JOB_DEQUE_SIZE];
+
+public:
+	vsJobDeque():
+		m_top(0),
+		m_bottom(0)
+	{
+		for ( int i = 0; i < JOB_DEQUE_SIZE; i++ )
+			m_slot[i].store( NULL, std::memory_order_relaxed );
+	}
+
+	// Owner only.  Returns false if the deque is full.
+	bool Push( vsJob *job )
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+		int64_t top = m_top.load(std::memory_order_acquire);
+		if ( bottom - top >= JOB_DEQUE_SIZE )
+			return false;
+		m_slot[bottom & (JOB_DEQUE_SIZE-1)].store( job, std::memory_order_relaxed );
+		m_bottom.store( bottom+1, std::memory_order_release );
+		return true;
+	}
+
+	// Owner only.
+	vsJob * Pop()
+	{
+		int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+		m_bottom.store( bottom, std::memory_order_relaxed );
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t top = m_top.load(std::memory_order_relaxed);
+
+		if ( top > bottom )
+		{
+			// empty
+			m_bottom.store( bottom+1, std::memory_order_relaxed );
+			return NULL;
+		}
+
+		vsJob *job = m_slot[bottom & (JOB_DEQUE_SIZE-1)].load(std::memory_order_relaxed);
+		if ( top == bottom )
+		{
+			// Last one;  race any thieves for it.
+			if ( !m_top.compare_exchange_strong( top, top+1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+				job = NULL;
+			m_bottom.store( bottom+1, std::memory_order_relaxed );
+		}
+		return job;
+	}
+
+	// Any thread.  May return NULL if we lose a race with another thread,
+	// even though the deque isn't empty.
+	vsJob * Steal()
+	{
+		int64_t top = m_top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t bottom = m_bottom.load(std::memory_order_acquire);
+		if ( top >= bottom )
+			return NULL;
+
+		vsJob *job = m_slot[top & (JOB_DEQUE_SIZE-1)].load(std::memory_order_relaxed);
+		if ( !m_top.compare_exchange_strong( top, top+1, std::memory_order_seq_cst, std::memory_order_relaxed ) )
+			return NULL;
+		return job;
+	}
+};
+
+class vsJobWorker : public vsTask
+{
+	vsJobSystem *	m_system;
+	int				m_index;
+
+protected:
+	virtual int Run();
+
+public:
+	vsJobWorker( vsJobSystem *system, int index ):
+		vsTask( vsFormatString("vsJobWorker%d", index) ),
+		m_system(system),
+		m_index(index)
+	{
+	}
+};
+
+int
+vsJobWorker::Run()
+{
+	t_threadIndex = m_index;
+	t_stealSeed = m_index;
+	vsProfiler::SetThreadName( vsFormatString("JobWorker %d", m_index).c_str() );
+
+	int idleSpins = 0;
+	while ( m_system->m_running.load(std::memory_order_acquire) )
+	{
+		vsJob *job = m_system->FindJob( m_index );
+		if ( job )
+		{
+			m_system->Execute( job );
+			idleSpins = 0;
+			continue;
+		}
+
+		if ( ++idleSpins < JOB_SPINS_BEFORE_SLEEP )
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Announce that we're going to sleep, then look one more time, so that
+		// a job which was submitted just before we announced isn't missed.
+		m_system->m_sleeping.fetch_add( 1, std::memory_order_seq_cst );
+		job = m_system->FindJob( m_index );
+		if ( job )
+		{
+			// If somebody already took our sleeping count to wake us, we'll
+			// just get one spurious wakeup later on.
+			int sleeping = m_system->m_sleeping.load(std::memory_order_relaxed);
+			while ( sleeping > 0 && !m_system->m_sleeping.compare_exchange_weak( sleeping, sleeping-1 ) )
+				;
+			m_system->Execute( job );
+			idleSpins = 0;
+			continue;
+		}
+		if ( !m_system->m_wake->Wait() )
+			break;
+		idleSpins = 0;
+	}
+	return 0;
+}
+
+vsJobCounter::vsJobCounter():
+	m_count(0),
+	m_waiting(NULL),
+	m_released(false)
+{
+}
+
+vsJobCounter::~vsJobCounter()
+{
+	vsAssert( IsDone(), "vsJobCounter destroyed while it still has jobs in flight!" );
+}
+
+vsJobSystem::vsJobSystem( int threadCount ):
+	m_sharedHead(NULL),
+	m_sharedTail(NULL),
+	m_sharedCount(0),
+	m_sleeping(0),
+	m_running(true),
+	m_jobsInFlight(0),
+	m_jobsRun(0),
+	m_jobsStolen(0),
+	m_jobsRunInline(0)
+{
+	vsAssert( t_threadIndex == -1, "Creating a vsJobSystem from one of its own threads?" );
+
+	m_threadCount = vsMax( 2, threadCount );
+	m_jobPool = new vsPool<vsJob>( JOB_POOL_SIZE, vsPool<vsJob>::Type_Static, vsPool<vsJob>::Access_ThreadSafe );
+	m_wake = new vsSemaphore(0);
+
+	m_deque = new vsJobDeque*[m_threadCount];
+	for ( int i = 0; i < m_threadCount; i++ )
+		m_deque[i] = new vsJobDeque;
+
+	t_threadIndex = 0;
+	t_stealSeed = 0;
+
+	m_worker = new vsJobWorker*[m_threadCount];
+	m_worker[0] = NULL;
+	for ( int i = 1; i < m_threadCount; i++ )
+	{
+		m_worker[i] = new vsJobWorker( this, i );
+		m_worker[i]->Start();
+	}
+	vsLog("Job system:  started %d worker threads", m_threadCount-1);
+}
+
+vsJobSystem::~vsJobSystem()
+{
+	vsAssert( t_threadIndex == 0, "vsJobSystem must be destroyed from the thread which created it" );
+
+	// Let everything that's been submitted finish before we pull the
+	// threads out from under it.
+	while ( m_jobsInFlight.load(std::memory_order_acquire) > 0 )
+	{
+		vsJob *job = FindJob( 0 );
+		if ( job )
+			Execute( job );
+		else
+			std::this_thread::yield();
+	}
+
+	m_running.store( false, std::memory_order_release );
+	m_wake->Release();
+	for ( int i = 1; i < m_threadCount; i++ )
+	{
+		m_worker[i]->Join();
+		vsDelete( m_worker[i] );
+	}
+	vsDeleteArray( m_worker );
+
+	LogStats();
+
+	for ( int i = 0; i < m_threadCount; i++ )
+		vsDelete( m_deque[i] );
+	vsDeleteArray( m_deque );
+	vsDelete( m_wake );
+	vsDelete( m_jobPool );
+
+	t_threadIndex = -1;
+}
+
+int
+vsJobSystem::GetCurrentThreadIndex()
+{
+	return t_threadIndex;
+}
+
+vsJob *
+vsJobSystem::AllocateJob( vsJobFunction function, void *data, vsJobCounter *counter )
+{
+	vsJob *job = m_jobPool->TryBorrow();
+	if ( job )
+	{
+		job->function = function;
+		job->data = data;
+		job->counter = counter;
+		job->next = NULL;
+	}
+	return job;
+}
+
+void
+vsJobSystem::AddToCounter( vsJobCounter *counter, int count )
+{
+	counter->m_lock.Lock();
+	if ( counter->m_count.fetch_add( count, std::memory_order_relaxed ) == 0 )
+		counter->m_released = false;
+	counter->m_lock.Unlock();
+}
+
+void
+vsJobSystem::FinishCounter( vsJobCounter *counter )
+{
+	vsJob *waiting = NULL;
+
+	counter->m_lock.Lock();
+	if ( counter->m_count.load(std::memory_order_relaxed) == 1 )
+	{
+		// We're the last job.  Once m_count reaches zero, whoever's waiting
+		// on this counter may destroy it, so take everything we need first,
+		// and make the decrement the very last thing we do to it.
+		waiting = counter->m_waiting;
+		counter->m_waiting = NULL;
+		counter->m_released = true;
+		counter->m_lock.Unlock();
+		counter->m_count.fetch_sub( 1, std::memory_order_release );
+	}
+	else
+	{
+		counter->m_count.fetch_sub( 1, std::memory_order_release );
+		counter->m_lock.Unlock();
+	}
+
+	while ( waiting )
+	{
+		vsJob *next = waiting->next;
+		waiting->next = NULL;
+		Schedule( waiting );
+		waiting = next;
+	}
+}
+
+bool
+vsJobSystem::Defer( vsJob *job, vsJobCounter *after )
+{
+	bool deferred = false;
+	after->m_lock.Lock();
+	if ( after->m_count.load(std::memory_order_relaxed) > 0 && !after->m_released )
+	{
+		job->next = after->m_waiting;
+		after->m_waiting = job;
+		deferred = true;
+	}
+	after->m_lock.Unlock();
+	return deferred;
+}
+
+void
+vsJobSystem::Execute( vsJob *job )
+{
+	job->function( job->data );
+	vsJobCounter *counter = job->counter;
+	m_jobPool->Return( job );
+
+	if ( counter )
+		FinishCounter( counter );
+	m_jobsRun.fetch_add( 1, std::memory_order_relaxed );
+	m_jobsInFlight.fetch_sub( 1, std::memory_order_release );
+}
+
+void
+vsJobSystem::RunInline( vsJobFunction function, void *data, vsJobCounter *counter )
+{
+	function( data );
+	if ( counter )
+		FinishCounter( counter );
+	m_jobsRunInline.fetch_add( 1, std::memory_order_relaxed );
+	m_jobsInFlight.fetch_sub( 1, std::memory_order_release );
+}
+
+void
+vsJobSystem::Schedule( vsJob *job )
+{
+	int index = t_threadIndex;
+	if ( index >= 0 )
+	{
+		if ( !m_deque[index]->Push( job ) )
+		{
+			// Our deque is full;  there's plenty of work queued up already,
+			// so just do this one ourselves, right now.
+			vsJobFunction function = job->function;
+			void *data = job->data;
+			vsJobCounter *counter = job->counter;
+			m_jobPool->Return( job );
+			RunInline( function, data, counter );
+			return;
+		}
+	}
+	else
+	{
+		m_sharedLock.Lock();
+		if ( m_sharedTail )
+			m_sharedTail->next = job;
+		else
+			m_sharedHead = job;
+		m_sharedTail = job;
+		m_sharedCount.fetch_add( 1, std::memory_order_release );
+		m_sharedLock.Unlock();
+	}
+	WakeWorkers( 1 );
+}
+
+void
+vsJobSystem::WakeWorkers( int count )
+{
+	// Pairs with the worker announcing that it's about to sleep and then
+	// looking for work one last time;  either it sees our job, or we see it.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int sleeping = m_sleeping.load(std::memory_order_relaxed);
+	while ( count > 0 && sleeping > 0 )
+	{
+		if ( m_sleeping.compare_exchange_weak( sleeping, sleeping-1 ) )
+		{
+			m_wake->Post();
+			count--;
+		}
+	}
+}
+
+vsJob *
+vsJobSystem::PopShared()
+{
+	if ( m_sharedCount.load(std::memory_order_acquire) == 0 )
+		return NULL;
+
+	vsJob *job = NULL;
+	m_sharedLock.Lock();
+	if ( m_sharedHead )
+	{
+		job = m_sharedHead;
+		m_sharedHead = job->next;
+		if ( !m_sharedHead )
+			m_sharedTail = NULL;
+		m_sharedCount.fetch_sub( 1, std::memory_order_relaxed );
+	}
+	m_sharedLock.Unlock();
+	return job;
+}
+
+vsJob *
+vsJobSystem::FindJob( int threadIndex )
+{
+	vsJob *job = NULL;
+	if ( threadIndex >= 0 )
+	{
+		job = m_deque[threadIndex]->Pop();
+		if ( job )
+			return job;
+	}
+
+	job = PopShared();
+	if ( job )
+		return job;
+
+	// Start stealing from a different victim each time, so thieves don't
+	// all pile onto the same deque.
+	t_stealSeed = t_stealSeed * 1664525 + 1013904223;
+	int start = (t_stealSeed >> 16) % m_threadCount;
+	for ( int i = 0; i < m_threadCount; i++ )
+	{
+		int victim = (start + i) % m_threadCount;
+		if ( victim == threadIndex )
+			continue;
+		job = m_deque[victim]->Steal();
+		if ( job )
+		{
+			m_jobsStolen.fetch_add( 1, std::memory_order_relaxed );
+			return job;
+		}
+	}
+	return NULL;
+}
+
+void
+vsJobSystem::Run( vsJobFunction function, void *data, vsJobCounter *counter, vsJobCounter *after )
+{
+	m_jobsInFlight.fetch_add( 1, std::memory_order_relaxed );
+	if ( counter )
+		AddToCounter( counter, 1 );
+
+	vsJob *job = AllocateJob( function, data, counter );
+	if ( !job )
+	{
+		// Every job is in use, so there's plenty of work queued up already;
+		// just do this one ourselves.
+		if ( after )
+			Wait( after );
+		RunInline( function, data, counter );
+		return;
+	}
+
+	if ( after && Defer( job, after ) )
+		return;
+	Schedule( job );
+}
+
+void
+vsJobSystem::Wait( vsJobCounter *counter )
+{
+	int index = t_threadIndex;
+	while ( !counter->IsDone() )
+	{
+		vsJob *job = FindJob( index );
+		if ( job )
+			Execute( job );
+		else
+			std::this_thread::yield();
+	}
+}
+
+struct vsParallelForRange
+{
+	vsParallelForFunction	function;
+	void *					data;
+	int						begin;
+	int						end;
+};
+
+static void RunParallelForRange( void *data )
+{
+	vsParallelForRange *range = (vsParallelForRange*)data;
+	range->function( range->begin, range->end, range->data );
+}
+
+void
+vsJobSystem::ParallelFor( int count, int grainSize, vsParallelForFunction function, void *data )
+{
+	if ( count <= 0 )
+		return;
+
+	// A few ranges per thread, so that threads which finish early can steal
+	// work from threads which got slow ranges.
+	int maxRanges = vsMin( m_threadCount * PARALLEL_FOR_JOBS_PER_THREAD, PARALLEL_FOR_MAX_JOBS );
+	int rangeSize = vsMax( vsMax( grainSize, 1 ), (count + maxRanges - 1) / maxRanges );
+	int rangeCount = (count + rangeSize - 1) / rangeSize;
+
+	if ( rangeCount == 1 )
+	{
+		function( 0, count, data );
+		return;
+	}
+
+	vsParallelForRange range[PARALLEL_FOR_MAX_JOBS];
+	for ( int i = 0; i < rangeCount; i++ )
+	{
+		range[i].function = function;
+		range[i].data = data;
+		range[i].begin = i * rangeSize;
+		range[i].end = vsMin( count, (i+1) * rangeSize );
+	}
+
+	// Submit all but the first range, then do the first one ourselves.
+	vsJobCounter counter;
+	for ( int i = 1; i < rangeCount; i++ )
+		Run( &RunParallelForRange, &range[i], &counter );
+	RunParallelForRange( &range[0] );
+	Wait( &counter );
+}
+
+void
+vsJobSystem::LogStats()
+{
+	vsLog("Job system:  %d threads, %d jobs run (%d stolen), %d run inline",
+			m_threadCount,
+			m_jobsRun.load(),
+			m_jobsStolen.load(),
+			m_jobsRunInline.load());
+}
@@ -0,0 +1,153 @@
+/*
+ *  VS_JobSystem.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_JOBSYSTEM_H
+#define VS_JOBSYSTEM_H
+
+#include "VS/Utils/VS_Singleton.h"
+#include "VS/Threads/VS_Spinlock.h"
+#include <atomic>
+
+// The job system runs small pieces of work ("jobs") on a set of worker
+// threads;  one per hardware thread, counting the main thread, which also
+// runs jobs whenever it's waiting for some to finish.
+//
+// Each worker keeps its own queue of jobs, and takes work from the back of
+// its own queue;  a worker which runs out steals from the front of somebody
+// else's.  Jobs which are submitted from the main thread or from a worker
+// go onto that thread's own queue;  jobs submitted from any other thread go
+// into a shared queue which all the workers check.
+//
+// Jobs are grouped together using a vsJobCounter.  Each job submitted with
+// a counter increments it, and decrements it again when it finishes, so
+// waiting for a counter to reach zero waits for every job which was submitted
+// against it (fork/join).  A job may also be submitted to run after a counter
+// reaches zero, which is how dependencies between groups of jobs are
+// expressed, without anybody having to block:
+//
+//		vsJobCounter physics, render;
+//		js->Run( StepBodies, world, &physics );
+//		js->Run( RecordDrawLists, scene, &render, &physics );	// runs once StepBodies is done
+//		js->Wait( &render );
+//
+// Jobs must not block waiting on anything except vsJobSystem::Wait(), and
+// must not touch vsHeap::Push()/Pop(), which are main-thread only.
+
+typedef void (*vsJobFunction)( void *data );
+typedef void (*vsParallelForFunction)( int begin, int end, void *data );
+
+struct vsJob;
+template<class T> class vsPool;
+
+class vsJobCounter
+{
+	std::atomic<int>	m_count;
+	vsSpinlock			m_lock;		// protects the members below, and changes to m_count
+	vsJob *				m_waiting;	// jobs to start once m_count reaches zero
+	bool				m_released;	// m_waiting has been started;  we're finishing
+
+	friend class vsJobSystem;
+
+	vsJobCounter( const vsJobCounter& );
+	vsJobCounter& operator=( const vsJobCounter& );
+public:
+	vsJobCounter();
+	~vsJobCounter();
+
+	// Once a counter is done, adding more jobs to it starts it over again.
+	// Don't add more jobs to a counter that other jobs are waiting on.
+	bool	IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+	int		GetCount() const { return m_count.load(std::memory_order_relaxed); }
+};
+
+class vsJobDeque;
+class vsJobWorker;
+
+class vsJobSystem : public vsSingleton<vsJobSystem>
+{
+	vsPool<vsJob> *		m_jobPool;
+	vsJobDeque **		m_deque;		// [0] belongs to the main thread, [n] to worker n
+	vsJobWorker **		m_worker;		// [0] is unused;  the main thread isn't a vsTask.
+	int					m_threadCount;	// including the main thread
+
+	// Jobs submitted from threads which don't own a deque.
+	vsSpinlock			m_sharedLock;
+	vsJob *				m_sharedHead;
+	vsJob *				m_sharedTail;
+	std::atomic<int>	m_sharedCount;
+
+	std::atomic<int>	m_sleeping;
+	class vsSemaphore *	m_wake;
+	std::atomic<bool>	m_running;
+
+	std::atomic<int>	m_jobsInFlight;
+	std::atomic<int>	m_jobsRun;
+	std::atomic<int>	m_jobsStolen;
+	std::atomic<int>	m_jobsRunInline;
+
+	vsJob *	AllocateJob( vsJobFunction function, void *data, vsJobCounter *counter );
+	void	Schedule( vsJob *job );
+	void	Execute( vsJob *job );
+	void	AddToCounter( vsJobCounter *counter, int count );
+	void	FinishCounter( vsJobCounter *counter );
+	bool	Defer( vsJob *job, vsJobCounter *after );
+	void	RunInline( vsJobFunction function, void *data, vsJobCounter *counter );
+	vsJob *	FindJob( int threadIndex );
+	vsJob *	PopShared();
+	void	WakeWorkers( int count );
+
+	template<typename F>
+	static void	ParallelForTrampoline( int begin, int end, void *data )
+	{
+		const F &functor = *reinterpret_cast<const F*>(data);
+		for ( int i = begin; i < end; i++ )
+			functor(i);
+	}
+
+	friend class vsJobWorker;
+
+public:
+
+	// 'threadCount' is the total number of threads which will run jobs,
+	// including the calling thread, which becomes the job system's main
+	// thread.  One fewer worker threads are created (but always at least one).
+	vsJobSystem( int threadCount );
+	~vsJobSystem();
+
+	// Submits a job.  If 'counter' is non-NULL, it's incremented now and
+	// decremented when the job finishes.  If 'after' is non-NULL, the job
+	// won't start until 'after' reaches zero.
+	void	Run( vsJobFunction function, void *data, vsJobCounter *counter = NULL, vsJobCounter *after = NULL );
+
+	// Waits for 'counter' to reach zero, running other jobs while it waits.
+	void	Wait( vsJobCounter *counter );
+
+	// Calls function(begin, end, data) for consecutive ranges covering
+	// [0..count), spread across all threads, and returns once they're all
+	// finished.  Ranges are at least 'grainSize' items long (except the last
+	// one), so choose a grain big enough that each range is worth a job.
+	void	ParallelFor( int count, int grainSize, vsParallelForFunction function, void *data );
+
+	// Calls functor(i) for each i in [0..count).
+	template<typename F>
+	void	ParallelFor( int count, int grainSize, const F &functor )
+	{
+		ParallelFor( count, grainSize, &ParallelForTrampoline<F>, const_cast<F*>(&functor) );
+	}
+
+	int		GetThreadCount() const { return m_threadCount; }
+
+	// Returns which thread we're running on;  0 for the main thread, 1 to
+	// GetThreadCount()-1 for workers, and -1 for any other thread.
+	static int	GetCurrentThreadIndex();
+
+	void	LogStats();
+};
+
+#endif // VS_JOBSYSTEM_H
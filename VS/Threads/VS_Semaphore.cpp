@@ -62,11 +62,15 @@ vsSemaphore::Post()
 void
 vsSemaphore::Release()
 {
+	// Take the mutex, so that a thread which has just checked m_released
+	// inside Wait() can't miss our broadcast.
+	pthread_mutex_lock(&m_semaphore.mutex);
 	if ( !m_released )
 	{
 		m_released = true;
 		pthread_cond_broadcast(&m_semaphore.cond);
 	}
+	pthread_mutex_unlock(&m_semaphore.mutex);
 }
 
 #else
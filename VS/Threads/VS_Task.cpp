@@ -37,7 +37,6 @@ DWORD WINAPI vsTask::DoStartThread( LPVOID arg )
 	task->m_done = false;
 	result = task->Run();
 	task->m_done = true;
-	task->m_thread = 0L;
 
 #ifdef UNIX
 	return (void*)result;
@@ -68,6 +67,20 @@ vsTask::~vsTask()
 	}
 }
 
+void
+vsTask::Join()
+{
+	if ( m_thread == 0 )
+		return;
+#ifdef UNIX
+	pthread_join( m_thread, NULL );
+#else
+	WaitForSingleObject( m_thread, INFINITE );
+	CloseHandle( m_thread );
+#endif
+	m_thread = 0;
+}
+
 void
 vsTask::Start()
 {
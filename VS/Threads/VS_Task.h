@@ -48,6 +48,10 @@ public:
 	void Start();
 	bool IsDone() { return m_done; }
 
+	// Blocks until the thread's Run() function has returned, and releases
+	// the thread.  Safe to call on a task which was never started.
+	void Join();
+
 };
 
 #endif // VS_TASK_H
@@ -13,6 +13,13 @@
 
 #include "VS/Utils/VS_Demangle.h"
 
+// We construct items in place inside vsArray storage, so we can't have the
+// debug 'new' macro active anywhere in here.
+#include "VS/VS_DisableDebugNew.h"
+#include <new>
+#include <type_traits>
+#include <utility>
+
 template<class T> class vsArray;
 
 template<class T>
@@ -45,11 +52,20 @@ public:
 template<class T>
 class vsArray
 {
+	// Our storage is raw, uninitialised memory;  only the first
+	// 'm_arrayLength' entries are ever constructed.  Types which can be
+	// copied with memcpy are moved around that way;  everything else is
+	// moved element by element.
+	static const bool c_trivial = std::is_trivially_copyable<T>::value;
+
 	T *					m_array;
 	int					m_arrayLength;		// how many things actually in our array?
 	int					m_arrayStorage;		// how big is our storage?  (We can fit this many things into our array without resizing it)
 
-	int	FindEntry( T item ) const
+	T *					m_inlineArray;		// if we're a vsInlineArray, this is the storage inside it.  Never freed.
+	int					m_inlineStorage;	// how many things fit into m_inlineArray
+
+	int	FindEntry( const T& item ) const
 	{
 		for ( int i = 0; i < m_arrayLength; i++ )
 		{
@@ -60,31 +76,191 @@ class vsArray
 		return npos;
 	}
 
-public:
+	static T *	AllocateStorage( int count )
+	{
+		if ( count <= 0 )
+			return NULL;
+		return (T*)malloc( sizeof(T) * count );
+	}
 
-	typedef vsArrayIterator<T> Iterator;
+	static void	FreeStorage( T *storage )
+	{
+		if ( storage )
+			free( storage );
+	}
 
-	vsArray( const vsArray<T>& other )
+	static void	DestroyRange( T *begin, T *end )
 	{
-		m_array = new T[ other.ItemCount() ];
-		m_arrayLength = other.ItemCount();
-		m_arrayStorage = m_arrayLength;
-		for ( int i = 0; i < m_arrayLength; i++ )
+		if ( !std::is_trivially_destructible<T>::value )
+		{
+			for ( T *i = begin; i != end; i++ )
+				i->~T();
+		}
+	}
+
+	// move 'count' constructed items from 'from' into uninitialised memory
+	// at 'to', leaving 'from' uninitialised.
+	static void	Relocate( T *to, T *from, int count )
+	{
+		if ( c_trivial )
 		{
-			m_array[i] = other.m_array[i];
+			if ( count > 0 )
+				memcpy( (void*)to, (const void*)from, sizeof(T) * count );
 		}
+		else
+		{
+			for ( int i = 0; i < count; i++ )
+			{
+				new (&to[i]) T( std::move(from[i]) );
+				from[i].~T();
+			}
+		}
+	}
+
+	bool	IsUsingInlineStorage() const
+	{
+		return m_array == m_inlineArray;
 	}
 
-	explicit vsArray( int initialStorage = 4 )
+	// destroy all our items and go back to our initial (inline, or empty) storage.
+	void	ReleaseStorage()
 	{
-		m_array = new T[ initialStorage ];
+		DestroyRange( m_array, m_array + m_arrayLength );
+		if ( !IsUsingInlineStorage() )
+			FreeStorage( m_array );
+		m_array = m_inlineArray;
 		m_arrayLength = 0;
-		m_arrayStorage = initialStorage;
+		m_arrayStorage = m_inlineStorage;
+	}
+
+	// only call on an empty array!
+	void	EnsureStorage( int count )
+	{
+		if ( count > m_arrayStorage )
+		{
+			if ( !IsUsingInlineStorage() )
+				FreeStorage( m_array );
+			m_array = AllocateStorage( count );
+			m_arrayStorage = count;
+		}
+	}
+
+	// only call on an empty array!
+	void	CopyFrom( const vsArray<T>& other )
+	{
+		EnsureStorage( other.m_arrayLength );
+		m_arrayLength = other.m_arrayLength;
+		if ( c_trivial )
+		{
+			if ( m_arrayLength > 0 )
+				memcpy( (void*)m_array, (const void*)other.m_array, sizeof(T) * m_arrayLength );
+		}
+		else
+		{
+			for ( int i = 0; i < m_arrayLength; i++ )
+				new (&m_array[i]) T( other.m_array[i] );
+		}
+	}
+
+	// only call on an empty array!
+	void	TakeFrom( vsArray<T>& other )
+	{
+		if ( other.m_array && !other.IsUsingInlineStorage() )
+		{
+			// steal their heap storage
+			if ( !IsUsingInlineStorage() )
+				FreeStorage( m_array );
+			m_array = other.m_array;
+			m_arrayStorage = other.m_arrayStorage;
+		}
+		else
+		{
+			// their items are inside them;  we have to move them out individually.
+			EnsureStorage( other.m_arrayLength );
+			Relocate( m_array, other.m_array, other.m_arrayLength );
+		}
+		m_arrayLength = other.m_arrayLength;
+
+		other.m_array = other.m_inlineArray;
+		other.m_arrayLength = 0;
+		other.m_arrayStorage = other.m_inlineStorage;
+	}
+
+	void	Grow()
+	{
+		Reserve( vsMax( 4, m_arrayStorage * 2 ) );
+	}
+
+	// close up the gap left by removing the item at 'index', preserving order.
+	void	RemoveAt( int index )
+	{
+		if ( c_trivial )
+		{
+			if ( index < m_arrayLength-1 )
+				memmove( (void*)&m_array[index], (const void*)&m_array[index+1], sizeof(T) * (m_arrayLength-1-index) );
+		}
+		else
+		{
+			for ( int i = index; i < m_arrayLength-1; i++ )
+			{
+				m_array[i] = std::move(m_array[i+1]);
+			}
+			m_array[m_arrayLength-1].~T();
+		}
+		m_arrayLength--;
+	}
+
+protected:
+
+	// for vsInlineArray;  'inlineStorage' is uninitialised memory with room
+	// for 'inlineCount' items, which we'll use until we need more than that.
+	vsArray( T *inlineStorage, int inlineCount ):
+		m_array( inlineStorage ),
+		m_arrayLength( 0 ),
+		m_arrayStorage( inlineCount ),
+		m_inlineArray( inlineStorage ),
+		m_inlineStorage( inlineCount )
+	{
+	}
+
+public:
+
+	typedef vsArrayIterator<T> Iterator;
+
+	vsArray( const vsArray<T>& other ):
+		m_array( NULL ),
+		m_arrayLength( 0 ),
+		m_arrayStorage( 0 ),
+		m_inlineArray( NULL ),
+		m_inlineStorage( 0 )
+	{
+		CopyFrom( other );
+	}
+
+	vsArray( vsArray<T>&& other ):
+		m_array( NULL ),
+		m_arrayLength( 0 ),
+		m_arrayStorage( 0 ),
+		m_inlineArray( NULL ),
+		m_inlineStorage( 0 )
+	{
+		TakeFrom( other );
+	}
+
+	explicit vsArray( int initialStorage = 4 ):
+		m_inlineArray( NULL ),
+		m_inlineStorage( 0 )
+	{
+		m_array = AllocateStorage( initialStorage );
+		m_arrayLength = 0;
+		m_arrayStorage = m_array ? initialStorage : 0;
 	}
 
 	virtual ~vsArray()
 	{
-		vsDeleteArray( m_array );
+		DestroyRange( m_array, m_array + m_arrayLength );
+		if ( !IsUsingInlineStorage() )
+			FreeStorage( m_array );
 	}
 
 	T&		Get( const vsArrayIterator<T> &iter ) const
@@ -94,40 +270,63 @@ public:
 
 	virtual void	Clear()
 	{
+		DestroyRange( m_array, m_array + m_arrayLength );
 		m_arrayLength = 0;
 	}
 
 	virtual void	PopBack()
 	{
 		m_arrayLength--;
+		DestroyRange( m_array + m_arrayLength, m_array + m_arrayLength + 1 );
 	}
 
 	void	AddItem( const T &item )
 	{
-		if ( m_arrayLength < m_arrayStorage )
+		if ( m_arrayLength == m_arrayStorage )
 		{
-			m_array[ m_arrayLength++ ] = item;
+			// 'item' might live inside our own storage, so copy it before we
+			// reallocate.
+			T copy( item );
+			Grow();
+			new (&m_array[ m_arrayLength++ ]) T( std::move(copy) );
+			return;
 		}
-		else
+		new (&m_array[ m_arrayLength++ ]) T( item );
+	}
+
+	void	AddItem( T &&item )
+	{
+		if ( m_arrayLength == m_arrayStorage )
 		{
-			// reallocate our array and copy data into it.
-			int newSize = vsMax( 4, m_arrayStorage * 2 );
-			Reserve(newSize);
-			return AddItem( item );
+			T moved( std::move(item) );
+			Grow();
+			new (&m_array[ m_arrayLength++ ]) T( std::move(moved) );
+			return;
 		}
+		new (&m_array[ m_arrayLength++ ]) T( std::move(item) );
+	}
+
+	// Constructs a new item in place at the end of the array, passing 'args'
+	// to its constructor.  Returns the new item.
+	template<typename... Args>
+	T&		EmplaceBack( Args&&... args )
+	{
+		if ( m_arrayLength == m_arrayStorage )
+			Grow();
+		T *result = new (&m_array[ m_arrayLength ]) T( std::forward<Args>(args)... );
+		m_arrayLength++;
+		return *result;
 	}
 
 	void Reserve( int newSize )
 	{
-		if ( newSize <= m_arrayLength )
+		if ( newSize <= m_arrayStorage )
 			return;
 
-		T *newArray = new T[newSize];
-		for ( int i = 0; i < m_arrayLength; i++ )
-		{
-			newArray[i] = m_array[i];
-		}
-		vsDeleteArray( m_array );
+		T *newArray = AllocateStorage( newSize );
+		Relocate( newArray, m_array, m_arrayLength );
+		if ( !IsUsingInlineStorage() )
+			FreeStorage( m_array );
 		m_array = newArray;
 
 		m_arrayStorage = newSize;
@@ -138,11 +337,7 @@ public:
 		int index = FindEntry(item);
 		if ( index != npos )
 		{
-			for ( int i = index; i < m_arrayLength-1; i++ )
-			{
-				m_array[i] = m_array[i+1];
-			}
-			m_arrayLength--;
+			RemoveAt( index );
 		}
 		return index != npos;
 	}
@@ -152,17 +347,26 @@ public:
 		int index = item.m_current;
 		if ( index != npos )
 		{
-			for ( int i = index; i < m_arrayLength-1; i++ )
-			{
-				m_array[i] = m_array[i+1];
-			}
-			m_arrayLength--;
+			RemoveAt( index );
 		}
 		if ( index < m_arrayLength )
 			return item;
 		return End();
 	}
 
+	// Removes the item at 'index' by moving the last item into its place.
+	// O(1), but doesn't preserve the order of the array.
+	void	RemoveSwap( int index )
+	{
+		vsAssert(index >= 0 && index < m_arrayLength,
+				vsFormatString("Out of bounds vsArray RemoveSwap: requested element %d, capacity of %d (array of %s)", index, ItemCount(), Demangle( typeid(T).name() ) )
+				);
+		int last = m_arrayLength-1;
+		if ( index != last )
+			m_array[index] = std::move( m_array[last] );
+		PopBack();
+	}
+
 	void	RemoveDuplicates()
 	{
 		vsArrayIterator<T> it = Begin();
@@ -183,12 +387,12 @@ public:
 		}
 	}
 
-	bool	Contains( T item ) const
+	bool	Contains( const T& item ) const
 	{
 		return (npos != FindEntry(item));
 	}
 
-	int		Find( T item ) const
+	int		Find( const T& item ) const
 	{
 		return FindEntry(item);
 	}
@@ -252,26 +456,35 @@ public:
 	void SetArraySize( int size )
 	{
 		// add or remove elements to make us this size.
-		while( ItemCount() > size )
+		if ( ItemCount() > size )
 		{
-			PopBack();
+			DestroyRange( m_array + size, m_array + m_arrayLength );
+			m_arrayLength = size;
 		}
-		while ( ItemCount() < size )
+		if ( ItemCount() < size )
 		{
-			AddItem( T() );
+			Reserve( size );
+			while ( ItemCount() < size )
+			{
+				EmplaceBack();
+			}
 		}
 	}
 
 	void operator=( const vsArray<T>& other )
 	{
-		vsDeleteArray(m_array);
-		m_array = new T[ other.ItemCount() ];
-		m_arrayLength = other.ItemCount();
-		m_arrayStorage = m_arrayLength;
-		for ( int i = 0; i < m_arrayLength; i++ )
-		{
-			m_array[i] = other.m_array[i];
-		}
+		if ( this == &other )
+			return;
+		ReleaseStorage();
+		CopyFrom( other );
+	}
+
+	void operator=( vsArray<T>&& other )
+	{
+		if ( this == &other )
+			return;
+		ReleaseStorage();
+		TakeFrom( other );
 	}
 
 	bool operator==( const vsArray<T>& other ) const
@@ -289,5 +502,7 @@ public:
 	static const int npos = -1;
 };
 
+#include "VS/VS_EnableDebugNew.h"
+
 #endif // VS_ARRAY_H
 
@@ -130,6 +130,9 @@ void handler(int sig) {
 			fprintf(stderr, "Caught %d\n", sig);
 			break;
 	}
+	// get whatever we've logged out of the async queue before we go.
+	vsLog_FlushFromSignal();
+
 	// print out all the frames to stderr
 
 	vsBacktrace();
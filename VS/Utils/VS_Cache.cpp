@@ -9,3 +9,235 @@
 
 #include "VS_Cache.h"
 
+
+vsCacheBase * vsCacheBase::s_first = NULL;
+
+vsCacheBase::vsCacheBase():
+	m_referencedHead(NULL),
+	m_unreferencedHead(NULL),
+	m_unreferencedTail(NULL),
+	m_budget(0),
+	m_evictionsPerFrame(4)
+{
+	m_nextCache = s_first;
+	s_first = this;
+}
+
+vsCacheBase::~vsCacheBase()
+{
+	vsAssert( m_referencedHead == NULL && m_unreferencedHead == NULL, "vsCacheBase destroyed while still holding resources??" );
+
+	vsCacheBase **link = &s_first;
+	while ( *link != this )
+		link = &(*link)->m_nextCache;
+	*link = m_nextCache;
+}
+
+void
+vsCacheBase::Link( vsResource *resource, bool unreferenced, bool atTail )
+{
+	resource->m_cachePrev = NULL;
+	resource->m_cacheNext = NULL;
+	resource->m_cacheUnreferenced = unreferenced;
+
+	if ( !unreferenced )
+	{
+		resource->m_cacheNext = m_referencedHead;
+		if ( m_referencedHead )
+			m_referencedHead->m_cachePrev = resource;
+		m_referencedHead = resource;
+		return;
+	}
+
+	if ( atTail )
+	{
+		resource->m_cachePrev = m_unreferencedTail;
+		if ( m_unreferencedTail )
+			m_unreferencedTail->m_cacheNext = resource;
+		else
+			m_unreferencedHead = resource;
+		m_unreferencedTail = resource;
+	}
+	else
+	{
+		resource->m_cacheNext = m_unreferencedHead;
+		if ( m_unreferencedHead )
+			m_unreferencedHead->m_cachePrev = resource;
+		else
+			m_unreferencedTail = resource;
+		m_unreferencedHead = resource;
+	}
+	m_stats.unreferencedCount++;
+	m_stats.unreferencedBytes += resource->m_byteSize;
+}
+
+void
+vsCacheBase::Unlink( vsResource *resource )
+{
+	bool unreferenced = resource->m_cacheUnreferenced;
+	vsResource *&head = unreferenced ? m_unreferencedHead : m_referencedHead;
+
+	if ( resource->m_cachePrev )
+		resource->m_cachePrev->m_cacheNext = resource->m_cacheNext;
+	else
+		head = resource->m_cacheNext;
+
+	if ( resource->m_cacheNext )
+		resource->m_cacheNext->m_cachePrev = resource->m_cachePrev;
+	else if ( unreferenced )
+		m_unreferencedTail = resource->m_cachePrev;
+
+	resource->m_cachePrev = NULL;
+	resource->m_cacheNext = NULL;
+
+	if ( unreferenced )
+	{
+		m_stats.unreferencedCount--;
+		m_stats.unreferencedBytes -= resource->m_byteSize;
+	}
+}
+
+void
+vsCacheBase::Track( vsResource *resource )
+{
+	vsAssert( resource->m_cache == NULL, "Resource is already in a cache??" );
+	m_lock.Lock();
+	resource->m_cache = this;
+	m_stats.residentCount++;
+	m_stats.residentBytes += resource->m_byteSize;
+
+	bool unreferenced = ( resource->GetReferenceCount() == 0 );
+	Link( resource, unreferenced, unreferenced && resource->IsTransient() );
+	m_lock.Unlock();
+}
+
+void
+vsCacheBase::Untrack( vsResource *resource )
+{
+	vsAssert( resource->m_cache == this, "Resource isn't in this cache??" );
+	m_lock.Lock();
+	Unlink( resource );
+	m_stats.residentCount--;
+	m_stats.residentBytes -= resource->m_byteSize;
+	resource->m_cache = NULL;
+	m_lock.Unlock();
+}
+
+void
+vsCacheBase::OnReferenceCountChanged( vsResource *resource )
+{
+	m_lock.Lock();
+	bool unreferenced = ( resource->GetReferenceCount() == 0 );
+	if ( unreferenced != resource->m_cacheUnreferenced )
+	{
+		Unlink( resource );
+
+		// Transient resources go straight to the back of the queue, to be
+		// evicted first.
+		Link( resource, unreferenced, unreferenced && resource->IsTransient() );
+	}
+	m_lock.Unlock();
+}
+
+void
+vsCacheBase::OnResized( vsResource *resource, size_t oldBytes )
+{
+	m_lock.Lock();
+	m_stats.residentBytes += resource->m_byteSize - oldBytes;
+	if ( resource->m_cacheUnreferenced )
+		m_stats.unreferencedBytes += resource->m_byteSize - oldBytes;
+	m_lock.Unlock();
+}
+
+void
+vsCacheBase::EvictResource( vsResource *resource )
+{
+	m_stats.evictions++;
+	m_stats.evictedBytes += resource->m_byteSize;
+	Evict( resource );
+}
+
+void
+vsCacheBase::DeleteAll()
+{
+	while ( m_referencedHead )
+		Evict( m_referencedHead );
+	while ( m_unreferencedHead )
+		Evict( m_unreferencedHead );
+}
+
+void
+vsCacheBase::ResetCounters()
+{
+	m_stats.hits = 0;
+	m_stats.misses = 0;
+	m_stats.evictions = 0;
+	m_stats.evictedBytes = 0;
+}
+
+void
+vsCacheBase::LogStats( const char *cacheName ) const
+{
+	vsLog("%s: %d hits, %d misses, %d evictions (%d bytes), %d resources resident (%d bytes, budget %d)",
+			cacheName,
+			(int)m_stats.hits,
+			(int)m_stats.misses,
+			(int)m_stats.evictions,
+			(int)m_stats.evictedBytes,
+			(int)m_stats.residentCount,
+			(int)m_stats.residentBytes,
+			(int)m_budget);
+}
+
+vsResource *
+vsCacheBase::NextResource( vsResource *resource ) const
+{
+	if ( resource == NULL )
+		return m_referencedHead ? m_referencedHead : m_unreferencedHead;
+	if ( resource->m_cacheNext )
+		return resource->m_cacheNext;
+	if ( !resource->m_cacheUnreferenced )
+		return m_unreferencedHead;
+	return NULL;
+}
+
+vsResource *
+vsCacheBase::PickVictim( bool onlyIfNeeded )
+{
+	m_lock.Lock();
+	vsResource *victim = m_unreferencedTail;
+	if ( victim && onlyIfNeeded )
+	{
+		bool overBudget = ( m_budget > 0 && m_stats.residentBytes > m_budget );
+		if ( !overBudget && !victim->IsTransient() )
+			victim = NULL;
+	}
+	m_lock.Unlock();
+	return victim;
+}
+
+void
+vsCacheBase::Update()
+{
+	for ( int i = 0; i < m_evictionsPerFrame; i++ )
+	{
+		vsResource *victim = PickVictim( true );
+		if ( !victim )
+			break;
+		EvictResource( victim );
+	}
+}
+
+void
+vsCacheBase::UpdateAll()
+{
+	for ( vsCacheBase *cache = s_first; cache; cache = cache->m_nextCache )
+		cache->Update();
+}
+
+void
+vsCacheBase::CollectGarbage()
+{
+	while ( vsResource *victim = PickVictim( false ) )
+		EvictResource( victim );
+}
@@ -12,18 +12,37 @@
 
 #include "VS_HashTable.h"
 #include "VS/Utils/VS_Singleton.h"
+#include "VS/Threads/VS_Spinlock.h"
+#include <atomic>
 
 template <typename T> class vsCache;
+class vsCacheBase;
+
+// References may be added and released from any thread, as long as the
+// reference count can't be zero at the time;  that is, a thread which isn't
+// the main thread may copy a reference that somebody is already holding,
+// but only the main thread may take the first reference to a resource (as
+// vsCache::Get() does), since an unreferenced resource might be evicted at
+// any moment.
 
 class vsResource
 {
 	vsString		m_name;
-	int				m_refCount;
+	std::atomic<int>	m_refCount;
 	bool			m_transient; // if true, we get destroyed immediately if our refcount reaches 0.
 
+	// Bookkeeping for the vsCache which owns us (if any), protected by the
+	// cache's lock.
+	vsCacheBase *	m_cache;
+	vsResource *	m_cachePrev;
+	vsResource *	m_cacheNext;
+	bool			m_cacheUnreferenced;	// which of the cache's lists we're on
+	size_t			m_byteSize;
+	friend class vsCacheBase;
+
 public:
 
-						vsResource( const vsString &name ) { m_name = name; m_refCount = 0; m_transient = false; }
+						vsResource( const vsString &name ): m_refCount(0) { m_name = name; m_transient = false; m_cache = NULL; m_cachePrev = m_cacheNext = NULL; m_cacheUnreferenced = false; m_byteSize = 0; }
 	virtual				~vsResource()
 	{
 		if ( GetReferenceCount() != 0 )
@@ -32,14 +51,146 @@ public:
 
 	void				SetTransient() { m_transient = true; }
 
-	void				AddReference()	{ m_refCount++; }
-	void				ReleaseReference()	{ m_refCount--; }
-	int					GetReferenceCount() const { return m_refCount; }
+	inline void			AddReference();
+	inline void			ReleaseReference();
+	int					GetReferenceCount() const { return m_refCount.load(std::memory_order_relaxed); }
 	bool				IsTransient() const { return m_transient; }
 
 	const vsString &	GetName() const { return m_name; }
+
+	// Roughly how much memory this resource is holding onto (including
+	// memory on the GPU), for the cache's memory budget.
+	inline void			SetByteSize( size_t bytes );
+	size_t				GetByteSize() const { return m_byteSize; }
 };
 
+// vsCacheBase is the part of vsCache which doesn't care about the type of
+// resource it holds.
+//
+// Every resource in a cache is on one of two lists;  resources which are
+// being referenced, and resources which aren't.  The unreferenced list is
+// kept in least-recently-used order.  Unreferenced resources stay loaded (so
+// that asking for them again is cheap) until the cache is over its memory
+// budget, at which point Update() evicts the least recently used of them,
+// a few at a time so that no single frame pays for freeing lots of
+// resources at once.  Transient resources are evicted as soon as they're
+// unreferenced, budget or not.
+//
+// A budget of zero means "no budget";  unreferenced resources are then only
+// freed by CollectGarbage().
+//
+// Everything here is main thread only, except for the reference count
+// bookkeeping (see vsResource), which takes m_lock.
+
+class vsCacheBase
+{
+public:
+
+	struct Stats
+	{
+		size_t	hits;				// Get() calls which found the resource already loaded
+		size_t	misses;				// Get() calls which had to load the resource
+		size_t	evictions;			// resources freed by Update() or CollectGarbage()
+		size_t	evictedBytes;
+		size_t	residentCount;		// resources currently in the cache
+		size_t	residentBytes;
+		size_t	unreferencedCount;	// of which, currently not referenced by anybody
+		size_t	unreferencedBytes;
+
+		Stats(): hits(0), misses(0), evictions(0), evictedBytes(0), residentCount(0), residentBytes(0), unreferencedCount(0), unreferencedBytes(0) {}
+	};
+
+private:
+
+	static vsCacheBase *	s_first;	// every cache, so UpdateAll() can find them
+	vsCacheBase *			m_nextCache;
+
+	// Doubly linked through vsResource::m_cachePrev/m_cacheNext.  The
+	// unreferenced list runs from most recently used (head) to least
+	// recently used (tail), which is where we evict from.
+	vsResource *	m_referencedHead;
+	vsResource *	m_unreferencedHead;
+	vsResource *	m_unreferencedTail;
+
+	size_t			m_budget;
+	int				m_evictionsPerFrame;
+
+	vsSpinlock		m_lock;		// protects the lists, and the stats they affect
+
+	vsResource *	PickVictim( bool onlyIfNeeded );
+
+	void			Link( vsResource *resource, bool unreferenced, bool atTail );
+	void			Unlink( vsResource *resource );
+
+protected:
+
+	Stats			m_stats;
+
+	void			Track( vsResource *resource );
+	void			Untrack( vsResource *resource );
+
+	// Remove the resource from the cache and delete it.
+	virtual void	Evict( vsResource *resource ) = 0;
+	void			EvictResource( vsResource *resource );
+
+	void			DeleteAll();
+
+public:
+
+	vsCacheBase();
+	virtual ~vsCacheBase();
+
+	// Called by vsResource as its reference count goes to or from zero.
+	// Moves the resource to whichever list matches its count by now, so
+	// it doesn't matter in which order racing threads get here.
+	void			OnReferenceCountChanged( vsResource *resource );
+	void			OnResized( vsResource *resource, size_t oldBytes );
+
+	void			SetBudget( size_t bytes ) { m_budget = bytes; }
+	size_t			GetBudget() const { return m_budget; }
+	void			SetEvictionsPerFrame( int count ) { m_evictionsPerFrame = count; }
+
+	const Stats &	GetStats() const { return m_stats; }
+	void			ResetCounters();
+	void			LogStats( const char *cacheName ) const;
+
+	// Walks every resource in the cache, referenced or not.  Start with NULL;
+	// returns NULL when there are no more.  Don't add or remove resources in
+	// the middle of a walk.
+	vsResource *	NextResource( vsResource *resource ) const;
+
+	// Does this frame's share of eviction.  UpdateAll() is called once per
+	// frame, from coreGame::Go().
+	virtual void	Update();
+	static void		UpdateAll();
+
+	// Immediately frees every resource which isn't referenced.
+	void			CollectGarbage();
+};
+
+void
+vsResource::AddReference()
+{
+	if ( m_refCount.fetch_add(1, std::memory_order_relaxed) == 0 && m_cache )
+		m_cache->OnReferenceCountChanged(this);
+}
+
+void
+vsResource::ReleaseReference()
+{
+	if ( m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1 && m_cache )
+		m_cache->OnReferenceCountChanged(this);
+}
+
+void
+vsResource::SetByteSize( size_t bytes )
+{
+	size_t oldBytes = m_byteSize;
+	m_byteSize = bytes;
+	if ( m_cache )
+		m_cache->OnResized( this, oldBytes );
+}
+
 template <typename T>
 class vsCacheReference
 {
@@ -68,196 +219,97 @@ public:
 
 // "T" must be derived from the vsResource class, above
 template <typename T>
-class vsCacheEntry
+class vsCache : public vsSingleton< vsCache<T> >, public vsCacheBase
 {
-public:
-	vsResource *		m_item;
-
-	vsString			m_key;
-	uint32_t				m_keyHash;
-
-	vsCacheEntry<T> *	m_next;
+	vsHashTable<T*>		m_table;
 
-	vsCacheEntry() { m_item = NULL; m_key = vsEmptyString; m_keyHash = 0; m_next = NULL; }
-	vsCacheEntry( vsCache<T> *cache, T * object, const vsString &key, int keyHash ) { m_item = object; m_key = key; m_keyHash = keyHash, m_next = NULL; }
-
-	~vsCacheEntry()
-	{
-		vsDelete( m_item );
-	}
-
-	T *		GetItem()		{ return reinterpret_cast<T*>(m_item); }
-};
-
-template <typename T>
-class vsCache : public vsSingleton< vsCache<T> >
-{
 protected:
-	vsCacheEntry<T>		*m_bucket;
-	int					m_bucketCount;
-
-	// we're going to need to shift our results to the right to give ourselves
-	// the right number of bits to index into a bucket.  Our hashes are 32-bit,
-	// so if we have two buckets, we need to shift right by 31 bits.  If we have
-	// four buckets, we need to shift right by 30 bits.  And so on.
-	int					m_shift;
-
-	uint32_t HashToBucket(uint32_t hash)
-	{
-		// Fibonocci hash.  We're going to multiply by
-		// (uint32_t::max / golden_ratio) (adjusted to be odd),
-		// and then shift down to produce the right number of bits.
-		//
-		const uint32_t factor = 2654435839U;
-		return (hash * factor) >> m_shift;
-	}
-
-	vsCacheEntry<T>*		FindHashEntry( const vsString &key )
-	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-
-		vsCacheEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return NULL;
-	}
-
 
 	void	Remove( T* item )
 	{
-		vsString &key = item->GetName();
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-
-		vsCacheEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
-		{
-			if ( ent->m_next->m_keyHash == hash && ent->m_next->m_key == key )
-			{
-				vsCacheEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				vsDelete( toDelete );
-				break;
-			}
-		}
+		// There may be more than one resource with this name (if somebody
+		// called Add() with a duplicate);  the latest shadows the others,
+		// so make sure we remove this one and not just the latest.
+		m_table.RemoveMatchingItemWithKey( item, item->GetName() );
+		Untrack( item );
 	}
 
-	vsCacheEntry<T> *	Find( const vsString &key )
+	virtual void	Evict( vsResource *resource )
 	{
-		vsCacheEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
-		{
-			return ent;
-		}
-		return NULL;
+		T *item = static_cast<T*>(resource);
+		Remove( item );
+		vsDelete( item );
 	}
 
 public:
 
-	vsCache(int bucketCount)
+	vsCache(int bucketCount):
+		m_table(bucketCount)
 	{
-		m_bucketCount = vsNextPowerOfTwo(bucketCount);
-		m_shift = 32 - vsHighBitPosition(m_bucketCount);
-
-		m_bucket = new vsCacheEntry<T>[m_bucketCount];
 	}
 
 	~vsCache()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			while ( m_bucket[i].m_next )
-			{
-				vsCacheEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
-
-				vsDelete( toDelete );
-			}
-		}
-		vsDeleteArray( m_bucket );
+		LogStats( Demangle( typeid(T).name() ).c_str() );
+		DeleteAll();
 	}
 
 	void	Add( T* item )
 	{
-		const vsString &key = item->GetName();
-		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		vsCacheEntry<T> *ent = new vsCacheEntry<T>( this, item, key, hash );
+		if ( m_table.FindItem( item->GetName() ) )
+			vsLog("Warning:  Added a second resource named '%s' to the cache", item->GetName().c_str());
 
-		int bucket = HashToBucket(hash);
+		// Anything which doesn't tell us otherwise is assumed to be about
+		// as big as itself.
+		if ( item->GetByteSize() == 0 )
+			item->SetByteSize( sizeof(T) );
 
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		m_table.AddItemWithKey( item, item->GetName() );
+		Track( item );
 	}
 
 	T *	Get( const vsString &name )
 	{
-		vsCacheEntry<T> *ce = Find( name );
-		if ( ce )
-		{
-			return ce->GetItem();
-		}
-		else
+		T** ent = m_table.FindItem( name );
+		if ( ent )
 		{
-			T *object = new T(name);
-			Add( object );
-			return Get( name );
+			m_stats.hits++;
+			return *ent;
 		}
+		m_stats.misses++;
+		T *object = new T(name);
+		Add( object );
+		return object;
 	}
 
-	void	Release( T* object )
+	// Returns the resource if it's in the cache, without loading it.
+	T *	Find( const vsString &name )
 	{
-		vsCacheEntry<T> *ce = Find( object->GetName() );
-		vsAssert(ce, "Error:  released object wasn't actually in cache??");
-		if ( ce )
-		{
-			ce->ReleaseReference();
-
-			if ( ce->m_item->IsTransient() &&
-					ce->m_item->GetReferenceCount() == 0 )
-			{
-				Remove( object );
-			}
-		}
+		T** ent = m_table.FindItem( name );
+		return ent ? *ent : NULL;
 	}
 
-	void	CollectGarbage()
+	// Doesn't need to hash the name, unless the resource has to be loaded.
+	T *	Get( const vsStringId &name )
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
+		T** ent = m_table.FindItem( name );
+		if ( ent )
 		{
-			vsCacheEntry<T> *ent = &m_bucket[i];
-			while( ent->m_next )
-			{
-				vsCacheEntry<T> *toDelete = ent->m_next;
-				if ( toDelete->m_item->GetReferenceCount() == 0 )
-				{
-					ent->m_next = toDelete->m_next;
-
-					vsDelete( toDelete );
-				}
-				else
-				{
-					ent = ent->m_next;
-				}
-			}
+			m_stats.hits++;
+			return *ent;
 		}
+		return Get( name.AsString() );
 	}
 
-	/*
-	void	Add( T* object )
+	void	Release( T* object )
 	{
-		vsCacheEntry<T> *ce = m_table.FindItem( object->GetName() );
-		vsAssert(!ce, "Error:  released object wasn't actually in cache??");
+		vsAssert(m_table.FindItem( object->GetName() ), "Error:  released object wasn't actually in cache??");
 
-		m_table.AddItemWithKey( new vsCacheEntry<T>(object), object->GetName() );
-	}*/
+		// If that was the last reference, the object is now on our
+		// unreferenced list;  if it's transient, it'll be freed on our next
+		// Update().
+		object->ReleaseReference();
+	}
 };
 
 #endif // VS_CACHE_H
-
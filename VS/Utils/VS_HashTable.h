@@ -11,142 +11,545 @@
 #define VS_HASHTABLE_H
 
 #include "VS/Utils/VS_Debug.h"
+#include "VS/Utils/VS_Array.h"
+#include "VS/Utils/VS_StringId.h"
 #include "VS/Math/VS_Math.h"
 
+#include "VS/VS_DisableDebugNew.h"
+#include <new>
+#include <string.h>
+#include <type_traits>
+#include "VS/VS_EnableDebugNew.h"
+
 uint32_t vsCalculateHash(const char * data, uint32_t len);
+inline uint32_t vsCalculateHash(const vsString& key) { return vsCalculateHash(key.c_str(), (uint32_t)key.length()); }
+
+// vsHashTable maps string keys to items.
+//
+// It's an open-addressed table, using Robin Hood probing.  The table itself
+// is just a byte of metadata (probe distance) per slot, plus a slot array
+// holding each key's full hash and a pointer to its entry, so a lookup
+// normally touches two cache lines and only compares strings whose hashes
+// match exactly.  Entries (the key and item) live in separate fixed-size
+// chunks, and never move once they've been added;  pointers returned by
+// FindItem() and operator[] remain valid until that key is removed.
+//
+// Adding an item with a key which is already in the table doesn't replace
+// the existing item;  the new item shadows it.  Lookups find the newest
+// item for a key, and removing that key removes the newest item, which
+// reveals the one it was shadowing.
+//
+// When the table fills up, it doesn't rehash everything at once.  Instead,
+// it allocates a new table twice the size and moves a few entries across on
+// each subsequent insertion or removal, so no single call pays for the
+// whole rehash.
+//
+// Keys can be looked up as a vsString, a const char *, a vsStringId (which
+// carries its hash with it), or with a hash which the caller calculated
+// earlier with vsCalculateHash().  While a table has only ever held a few
+// entries (a vsShaderValues, typically), looking up a vsString or a
+// const char * just compares it against each key, as hashing the key
+// would cost more than that.
 
 template <typename T>
-class vsHashEntry
+class vsHashTable
 {
-public:
-	T					m_item;
-	vsString			m_key;
-	uint32_t				m_keyHash;
+	struct Entry
+	{
+		vsString	m_key;
+		Entry *		m_shadowed;		// older entry with the same key, if any
+		uint32_t	m_index;
+		bool		m_hidden;		// shadowed by a newer entry with the same key
+		T			m_item;
 
-	vsHashEntry<T> *	m_next;
+		Entry( const T& item, const vsString& key, uint32_t index ): m_key(key), m_shadowed(NULL), m_index(index), m_hidden(false), m_item(item) {}
+	};
 
-	vsHashEntry(): m_key() { m_keyHash = 0, m_next = NULL; }
-	vsHashEntry( const T &t, const vsString &key, int keyHash ) : m_item(t) { m_key = key; m_keyHash = keyHash, m_next = NULL; }
-};
+	// Entries are allocated in chunks of this many.
+	enum
+	{
+		c_entryChunkShift = 5,
+		c_entryChunkSize = (1 << c_entryChunkShift),
+		c_entryChunkMask = (c_entryChunkSize - 1)
+	};
+	struct EntryChunk
+	{
+		typename std::aligned_storage<sizeof(Entry), alignof(Entry)>::type	m_entry[c_entryChunkSize];
+		uint32_t	m_live;		// one bit per entry which is currently constructed
+	};
 
-template <typename T>
-class vsHashTable
-{
-	vsHashEntry<T>		*m_bucket;
-	int					m_bucketCount;
+	// We index into this on every small-table lookup, so it's a bare array
+	// rather than a (bounds-checked) vsArray.
+	EntryChunk **			m_entryChunk;
+	int						m_entryChunkCount;
+	int						m_entryChunkStorage;
+	vsArray<uint32_t>		m_freeEntry;
+	uint32_t				m_entryHighWater;	// entry indices below this have been handed out at least once
+
+	// Metadata values.  Anything else is the slot's probe distance plus one.
+	enum
+	{
+		c_empty = 0,
+		c_moved = 0xff,		// only used in a table which is being drained during growth
+		c_maxDistance = 0xfd
+	};
+
+	struct Slot
+	{
+		uint32_t	m_hash;
+		Entry *		m_entry;
+	};
+
+	struct Table
+	{
+		uint8_t *	m_meta;
+		Slot *		m_slot;
+		uint32_t	m_capacity;
+		uint32_t	m_mask;
+		int			m_shift;
+		int			m_count;
+
+		Table(): m_meta(NULL), m_slot(NULL), m_capacity(0), m_mask(0), m_shift(0), m_count(0) {}
+
+		uint32_t	Home( uint32_t hash ) const
+		{
+			// Fibonacci hash.  We're going to multiply by
+			// (uint32_t::max / golden_ratio) (adjusted to be odd),
+			// and then shift down to produce the right number of bits.
+			//
+			const uint32_t factor = 2654435839U;
+			return (hash * factor) >> m_shift;
+		}
+	};
+
+	Table		m_table;
+	Table		m_oldTable;			// while growing;  entries we haven't moved into m_table yet
+	uint32_t	m_oldTableCursor;	// slots in m_oldTable below this have already been moved
+
+	int			m_itemCount;
+
+	// How many slots of m_oldTable to move across on each insertion or
+	// removal.  Needs to be large enough that we've always finished moving
+	// before m_table fills up.
+	enum { c_growthStep = 8 };
+
+	// While no more than this many entries have ever been allocated, we
+	// find unhashed keys by comparing against every entry.
+	enum { c_linearScanLimit = 8 };
+
+	Entry *		GetEntry( uint32_t index ) const
+	{
+		return reinterpret_cast<Entry*>( &m_entryChunk[index >> c_entryChunkShift]->m_entry[index & c_entryChunkMask] );
+	}
+
+	Entry *		AllocEntry( const T &item, const vsString &key )
+	{
+		uint32_t index;
+		if ( !m_freeEntry.IsEmpty() )
+		{
+			index = m_freeEntry[ m_freeEntry.ItemCount()-1 ];
+			m_freeEntry.PopBack();
+		}
+		else
+		{
+			index = m_entryHighWater++;
+			if ( (index & c_entryChunkMask) == 0 )
+				AddEntryChunk();
+		}
+		m_entryChunk[index >> c_entryChunkShift]->m_live |= 1u << (index & c_entryChunkMask);
+#include "VS/VS_DisableDebugNew.h"
+		return new( GetEntry(index) ) Entry( item, key, index );
+#include "VS/VS_EnableDebugNew.h"
+	}
 
-	// we're going to need to shift our results to the right to give ourselves
-	// the right number of bits to index into a bucket.  Our hashes are 32-bit,
-	// so if we have two buckets, we need to shift right by 31 bits.  If we have
-	// four buckets, we need to shift right by 30 bits.  And so on.
-	int					m_shift;
+	void		AddEntryChunk()
+	{
+		if ( m_entryChunkCount == m_entryChunkStorage )
+		{
+			m_entryChunkStorage = vsMax( 4, m_entryChunkStorage * 2 );
+			EntryChunk **chunks = new EntryChunk*[m_entryChunkStorage];
+			for ( int i = 0; i < m_entryChunkCount; i++ )
+				chunks[i] = m_entryChunk[i];
+			vsDeleteArray( m_entryChunk );
+			m_entryChunk = chunks;
+		}
+		EntryChunk *chunk = new EntryChunk;
+		chunk->m_live = 0;
+		m_entryChunk[m_entryChunkCount++] = chunk;
+	}
 
-	uint32_t HashToBucket(uint32_t hash)
+	void		FreeEntry( Entry *entry )
 	{
-		// Fibonocci hash.  We're going to multiply by
-		// (uint32_t::max / golden_ratio) (adjusted to be odd),
-		// and then shift down to produce the right number of bits.
-		//
-		const uint32_t factor = 2654435839U;
-		return (hash * factor) >> m_shift;
+		uint32_t index = entry->m_index;
+		entry->~Entry();
+		m_entryChunk[index >> c_entryChunkShift]->m_live &= ~(1u << (index & c_entryChunkMask));
+		m_freeEntry.AddItem( index );
 	}
 
-	vsHashEntry<T>*		FindHashEntry( const vsString &key )
+	static void	AllocTable( Table &table, uint32_t capacity )
 	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
+		table.m_capacity = capacity;
+		table.m_mask = capacity - 1;
+		table.m_shift = 32 - vsHighBitPosition(capacity);
+		table.m_count = 0;
+		table.m_meta = new uint8_t[capacity];
+		table.m_slot = new Slot[capacity];
+		memset( table.m_meta, c_empty, capacity );
+	}
+
+	static void	FreeTable( Table &table )
+	{
+		vsDeleteArray( table.m_meta );
+		vsDeleteArray( table.m_slot );
+		table = Table();
+	}
+
+	static bool	KeyMatches( const Entry *entry, const char *key, uint32_t length )
+	{
+		const vsString &entryKey = entry->m_key;
+		return entryKey.length() == length && memcmp( entryKey.c_str(), key, length ) == 0;
+	}
+
+	// Returns the slot holding 'key', or -1.
+	static int	FindSlot( const Table &table, const char *key, uint32_t length, uint32_t hash )
+	{
+		if ( table.m_count == 0 )
+			return -1;
+
+		uint32_t pos = table.Home(hash);
+		for ( uint32_t distance = 0; ; distance++ )
+		{
+			uint8_t meta = table.m_meta[pos];
+			if ( meta == c_empty )
+				return -1;
+			if ( meta != c_moved )
+			{
+				// Robin Hood invariant;  if our key were here, it would have
+				// displaced this closer-to-home one.
+				if ( (uint32_t)(meta-1) < distance )
+					return -1;
+				const Slot &slot = table.m_slot[pos];
+				if ( slot.m_hash == hash && KeyMatches( slot.m_entry, key, length ) )
+					return (int)pos;
+			}
+			pos = (pos + 1) & table.m_mask;
+		}
+	}
 
-		vsHashEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
+	static void	InsertSlot( Table &table, Slot slot )
+	{
+		uint32_t pos = table.Home(slot.m_hash);
+		uint32_t distance = 0;
+		while ( table.m_meta[pos] != c_empty )
 		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
+			uint32_t existingDistance = table.m_meta[pos] - 1;
+			if ( existingDistance < distance )
 			{
-				return ent;
+				// take from the rich;  the existing slot is closer to its
+				// home than we are, so we take its place and carry on
+				// looking for somewhere to put it instead.
+				Slot displaced = table.m_slot[pos];
+				table.m_slot[pos] = slot;
+				table.m_meta[pos] = (uint8_t)(distance + 1);
+				slot = displaced;
+				distance = existingDistance;
 			}
-			ent = ent->m_next;
+			pos = (pos + 1) & table.m_mask;
+			distance++;
+			vsAssert( distance <= c_maxDistance, "vsHashTable probe distance overflow??" );
+		}
+		table.m_slot[pos] = slot;
+		table.m_meta[pos] = (uint8_t)(distance + 1);
+		table.m_count++;
+	}
+
+	static void	RemoveSlot( Table &table, uint32_t pos )
+	{
+		// Backward-shift deletion;  pull each following slot back by one
+		// until we hit one which is empty or already at its home.
+		uint32_t next = (pos + 1) & table.m_mask;
+		while ( table.m_meta[next] != c_empty && table.m_meta[next] != 1 )
+		{
+			table.m_slot[pos] = table.m_slot[next];
+			table.m_meta[pos] = table.m_meta[next] - 1;
+			pos = next;
+			next = (next + 1) & table.m_mask;
+		}
+		table.m_meta[pos] = c_empty;
+		table.m_count--;
+	}
+
+	void		ContinueGrowth( uint32_t steps )
+	{
+		while ( m_oldTable.m_meta && steps-- > 0 )
+		{
+			if ( m_oldTableCursor == m_oldTable.m_capacity || m_oldTable.m_count == 0 )
+			{
+				vsAssert( m_oldTable.m_count == 0, "vsHashTable lost entries while growing??" );
+				FreeTable( m_oldTable );
+				break;
+			}
+			uint8_t &meta = m_oldTable.m_meta[m_oldTableCursor];
+			if ( meta != c_empty && meta != c_moved )
+			{
+				InsertSlot( m_table, m_oldTable.m_slot[m_oldTableCursor] );
+				m_oldTable.m_count--;
+			}
+			// Mark the slot as moved rather than empty, so that probes for
+			// keys further along still walk past it.
+			meta = c_moved;
+			m_oldTableCursor++;
+		}
+	}
+
+	void		StartGrowth()
+	{
+		// If we were still draining a previous table, finish that first.
+		ContinueGrowth( m_oldTable.m_capacity + 1 );
+
+		m_oldTable = m_table;
+		m_oldTableCursor = 0;
+		AllocTable( m_table, m_oldTable.m_capacity * 2 );
+	}
+
+	// Returns the slot holding 'key' in either table, or NULL.
+	Slot *		FindSlot( const char *key, uint32_t length, uint32_t hash ) const
+	{
+		int pos = FindSlot( m_table, key, length, hash );
+		if ( pos >= 0 )
+			return &m_table.m_slot[pos];
+		if ( m_oldTable.m_meta )
+		{
+			pos = FindSlot( m_oldTable, key, length, hash );
+			if ( pos >= 0 )
+				return &m_oldTable.m_slot[pos];
 		}
 		return NULL;
 	}
 
-public:
+	Entry *		FindEntryLinear( const char *key, uint32_t length ) const
+	{
+		uint32_t live = m_entryHighWater ? m_entryChunk[0]->m_live : 0;
+		for ( uint32_t index = 0; index < m_entryHighWater; index++ )
+		{
+			Entry *entry = GetEntry(index);
+			// check the first character ourselves;  it rules out most
+			// same-length keys without a call to memcmp().
+			if ( (live & (1u << index)) &&
+					entry->m_key.length() == length &&
+					(length == 0 || entry->m_key[0] == key[0]) &&
+					KeyMatches( entry, key, length ) &&
+					!entry->m_hidden )
+				return entry;
+		}
+		return NULL;
+	}
 
-	vsHashTable(int bucketCount)
+	// Returns the slot holding 'key' in either table, or -1.  Like every
+	// removal, it moves any growth along by a step first.
+	int			FindSlotForRemoval( const vsString &key, Table *&table )
 	{
-		m_bucketCount = vsNextPowerOfTwo(bucketCount);
-		m_shift = 32 - vsHighBitPosition(m_bucketCount);
+		uint32_t hash = vsCalculateHash(key);
+		ContinueGrowth( c_growthStep );
 
-		m_bucket = new vsHashEntry<T>[m_bucketCount];
+		table = &m_table;
+		int pos = FindSlot( m_table, key.c_str(), (uint32_t)key.length(), hash );
+		if ( pos < 0 && m_oldTable.m_meta )
+		{
+			table = &m_oldTable;
+			pos = FindSlot( m_oldTable, key.c_str(), (uint32_t)key.length(), hash );
+		}
+		return pos;
 	}
 
-	~vsHashTable()
+	void		RemoveNewestEntry( Table &table, int pos )
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
+		Entry *entry = table.m_slot[pos].m_entry;
+		if ( entry->m_shadowed )
 		{
-			while ( m_bucket[i].m_next )
-			{
-				vsHashEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
+			// uncover the entry this one was shadowing;  the slot stays.
+			table.m_slot[pos].m_entry = entry->m_shadowed;
+			entry->m_shadowed->m_hidden = false;
+		}
+		else if ( &table == &m_table )
+		{
+			RemoveSlot( m_table, pos );
+		}
+		else
+		{
+			// don't shift anything in a table we're draining;  just mark
+			// the slot as moved.
+			m_oldTable.m_meta[pos] = c_moved;
+			m_oldTable.m_count--;
+		}
+		FreeEntry( entry );
+		m_itemCount--;
+	}
 
-				vsDelete( toDelete );
-			}
+	Entry *		AddEntry( const T &item, const vsString &key, uint32_t hash )
+	{
+		Slot *existing = FindSlot( key.c_str(), (uint32_t)key.length(), hash );
+		if ( existing )
+		{
+			// Shadow the existing entry;  it comes back if this one is removed.
+			Entry *result = AllocEntry( item, key );
+			result->m_shadowed = existing->m_entry;
+			existing->m_entry->m_hidden = true;
+			existing->m_entry = result;
+			m_itemCount++;
+			return result;
 		}
-		vsDeleteArray( m_bucket );
+
+		ContinueGrowth( c_growthStep );
+		// Keep the load factor at or below 3/4.
+		if ( (uint32_t)(m_table.m_count + 1) * 4 > m_table.m_capacity * 3 )
+			StartGrowth();
+
+		Slot slot;
+		slot.m_hash = hash;
+		slot.m_entry = AllocEntry( item, key );
+		InsertSlot( m_table, slot );
+		m_itemCount++;
+		return slot.m_entry;
 	}
 
-	void	AddItemWithKey( const T &item, const vsString &key )
+	vsHashTable( const vsHashTable& );
+	vsHashTable& operator=( const vsHashTable& );
+
+public:
+
+	vsHashTable(int bucketCount):
+		m_entryChunk(NULL),
+		m_entryChunkCount(0),
+		m_entryChunkStorage(0),
+		m_entryHighWater(0),
+		m_oldTableCursor(0),
+		m_itemCount(0)
 	{
-		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		vsHashEntry<T> *ent = new vsHashEntry<T>( item, key, hash );
+		AllocTable( m_table, vsNextPowerOfTwo( vsMax( bucketCount, 8 ) ) );
+	}
 
-		int bucket = HashToBucket(hash);
+	~vsHashTable()
+	{
+		Clear();
+		FreeTable( m_table );
+		vsDeleteArray( m_entryChunk );
+	}
+
+	void	Clear()
+	{
+		FreeTable( m_oldTable );
+		for ( int i = 0; i < m_entryChunkCount; i++ )
+		{
+			for ( int j = 0; j < c_entryChunkSize; j++ )
+				if ( m_entryChunk[i]->m_live & (1u << j) )
+					GetEntry( (i << c_entryChunkShift) + j )->~Entry();
+			vsDelete( m_entryChunk[i] );
+		}
+		m_entryChunkCount = 0;
+		m_freeEntry.Clear();
+		m_entryHighWater = 0;
+		m_oldTableCursor = 0;
+		m_itemCount = 0;
 
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		memset( m_table.m_meta, c_empty, m_table.m_capacity );
+		m_table.m_count = 0;
 	}
 
+	void	AddItemWithKey( const T &item, const vsString &key ) { AddEntry( item, key, vsCalculateHash(key) ); }
+	void	AddItemWithKey( const T &item, const vsString &key, uint32_t hash ) { AddEntry( item, key, hash ); }
+
+	// Removes the newest item with this key.
 	void	RemoveItemWithKey( const T &item, const vsString &key )
 	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = HashToBucket(hash);
-		bool found = false;
+		Table *table;
+		int pos = FindSlotForRemoval( key, table );
+		vsAssert(pos >= 0, "Error: couldn't find key??");
+		if ( pos >= 0 )
+			RemoveNewestEntry( *table, pos );
+	}
+
+	// Removes the item with this key which is equal to 'item', even if a
+	// newer item is shadowing it.  Returns false if there's no such item.
+	bool	RemoveMatchingItemWithKey( const T &item, const vsString &key )
+	{
+		Table *table;
+		int pos = FindSlotForRemoval( key, table );
+		if ( pos < 0 )
+			return false;
 
-		vsHashEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
+		Entry *newest = table->m_slot[pos].m_entry;
+		if ( newest->m_item == item )
 		{
-			if ( ent->m_next->m_keyHash == hash && ent->m_next->m_key == key )
+			RemoveNewestEntry( *table, pos );
+			return true;
+		}
+		for ( Entry *entry = newest; entry->m_shadowed; entry = entry->m_shadowed )
+		{
+			Entry *shadowed = entry->m_shadowed;
+			if ( shadowed->m_item == item )
 			{
-				vsHashEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				found = true;
-
-				vsDelete( toDelete );
-				break;
+				entry->m_shadowed = shadowed->m_shadowed;
+				FreeEntry( shadowed );
+				m_itemCount--;
+				return true;
 			}
-			ent = ent->m_next;
 		}
-		vsAssert(found, "Error: couldn't find key??");
+		return false;
 	}
 
-	T *		FindItem( const vsString &key )
+	T *		FindItem( const char *key, uint32_t length, uint32_t hash ) const
 	{
-		vsHashEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
+		Slot *slot = FindSlot( key, length, hash );
+		if ( slot )
 		{
-			return &ent->m_item;
+			return &slot->m_entry->m_item;
 		}
 		return NULL;
 	}
 
+	T *		FindItem( const char *key, uint32_t length ) const
+	{
+		if ( m_entryHighWater <= c_linearScanLimit )
+		{
+			Entry *ent = FindEntryLinear( key, length );
+			return ent ? &ent->m_item : NULL;
+		}
+		return FindItem( key, length, vsCalculateHash(key, length) );
+	}
+
+	T *		FindItem( const vsString &key ) const { return FindItem( key.c_str(), (uint32_t)key.length() ); }
+	T *		FindItem( const vsString &key, uint32_t hash ) const { return FindItem( key.c_str(), (uint32_t)key.length(), hash ); }
+	T *		FindItem( const vsStringId &key ) const { return FindItem( key.c_str(), key.length(), key.GetHash() ); }
+	T *		FindItem( const char *key ) const { return FindItem( key, (uint32_t)strlen(key) ); }
+
 	T& operator[]( const vsString& key )
 	{
 		T* result = FindItem(key);
 		if ( result )
 			return *result;
-		T newItem;
-		AddItemWithKey( newItem, key );
-		return *FindItem(key);
+		return AddEntry( T(), key, vsCalculateHash(key) )->m_item;
+	}
+
+	int		ItemCount() const { return m_itemCount; }
+
+	// Walks every item in the table, including shadowed ones, in no
+	// particular order.  Start with 'cursor' at zero;  returns NULL when
+	// there are no more items.  Don't add or remove items in the middle
+	// of a walk.
+	T *		NextItem( int &cursor ) const
+	{
+		for ( uint32_t index = cursor; index < m_entryHighWater; index++ )
+		{
+			if ( m_entryChunk[index >> c_entryChunkShift]->m_live & (1u << (index & c_entryChunkMask)) )
+			{
+				cursor = index + 1;
+				return &GetEntry(index)->m_item;
+			}
+		}
+		cursor = m_entryHighWater;
+		return NULL;
 	}
 };
 
 #endif // VS_HASHTABLE_H
-
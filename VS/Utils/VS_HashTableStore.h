@@ -13,113 +13,62 @@
 
 #include "VS_HashTable.h"
 
-template <typename T>
-class vsHashStoreEntry
-{
-public:
-	T *					m_item;
-	vsString			m_key;
-	uint32_t				m_keyHash;
-
-	vsHashStoreEntry<T> *	m_next;
-
-	vsHashStoreEntry() : m_item(NULL) { m_key = vsEmptyString; m_keyHash = 0, m_next = NULL; }
-	vsHashStoreEntry( T *t, const vsString &key, int keyHash ) : m_item(t) { m_key = key; m_keyHash = keyHash, m_next = NULL; }
-};
+// vsHashTableStore is a vsHashTable which owns the items put into it;  it
+// deletes them when they're removed, or when the store itself is destroyed.
 
 template <typename T>
 class vsHashTableStore
 {
-	vsHashStoreEntry<T>		*m_bucket;
-	int					m_bucketCount;
-
-	vsHashStoreEntry<T>*		FindHashEntry( const vsString &key )
-	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = hash % m_bucketCount;
+	vsHashTable<T*>		m_table;
 
-		vsHashStoreEntry<T> *ent = m_bucket[bucket].m_next;
-		while( ent )
-		{
-			if ( ent->m_keyHash == hash && ent->m_key == key )
-			{
-				return ent;
-			}
-			ent = ent->m_next;
-		}
-		return NULL;
-	}
+	vsHashTableStore( const vsHashTableStore& );
+	vsHashTableStore& operator=( const vsHashTableStore& );
 
 public:
 
-	vsHashTableStore(int bucketCount)
+	vsHashTableStore(int bucketCount):
+		m_table(bucketCount)
 	{
-		m_bucketCount = bucketCount;
-
-		m_bucket = new vsHashStoreEntry<T>[m_bucketCount];
 	}
 
 	~vsHashTableStore()
 	{
-		for ( int i = 0; i < m_bucketCount; i++ )
-		{
-			while ( m_bucket[i].m_next )
-			{
-				vsHashStoreEntry<T> *toDelete = m_bucket[i].m_next;
-				m_bucket[i].m_next = toDelete->m_next;
-
-				vsDelete( toDelete->m_item );
-				vsDelete( toDelete );
-			}
-		}
-		vsDeleteArray( m_bucket );
+		int cursor = 0;
+		while ( T** item = m_table.NextItem(cursor) )
+			vsDelete( *item );
 	}
 
 	void	AddItemWithKey( T* item, const vsString &key )
 	{
-		uint32_t hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		vsHashStoreEntry<T> *ent = new vsHashStoreEntry<T>( item, key, hash );
-
-		int bucket = hash % m_bucketCount;
-
-		ent->m_next = m_bucket[bucket].m_next;
-		m_bucket[bucket].m_next = ent;
+		vsAssert( m_table.FindItem(key) == NULL, "vsHashTableStore already has an item with that key??" );
+		m_table.AddItemWithKey( item, key );
 	}
 
 	void	RemoveItemWithKey( T* item, const vsString &key )
 	{
-		uint32_t  hash = vsCalculateHash(key.c_str(), (uint32_t)key.length());
-		int bucket = hash % m_bucketCount;
-		bool found = false;
-
-		vsHashStoreEntry<T> *ent = &m_bucket[bucket];
-		while( ent->m_next )
+		T** ent = m_table.FindItem(key);
+		if ( ent )
 		{
-			if ( ent->m_next->m_keyHash == hash && ent->m_next->m_key == key )
-			{
-				vsHashStoreEntry<T> *toDelete = ent->m_next;
-				ent->m_next = toDelete->m_next;
-				found = true;
-
-				vsDelete( toDelete->m_item );
-				vsDelete( toDelete );
-				break;
-			}
-			ent = ent->m_next;
+			T* toDelete = *ent;
+			m_table.RemoveItemWithKey( toDelete, key );
+			vsDelete( toDelete );
 		}
-		vsAssert(found, "Error: couldn't find key??");
+		vsAssert(ent, "Error: couldn't find key??");
 	}
 
-	T *		FindItem( const vsString &key )
+	T *		FindItem( const vsString &key ) const
 	{
-		vsHashStoreEntry<T> *ent = FindHashEntry(key);
-		if ( ent )
-		{
-			return ent->m_item;
-		}
-		return NULL;
+		T** ent = m_table.FindItem(key);
+		return ent ? *ent : NULL;
 	}
+
+	T *		FindItem( const char *key ) const
+	{
+		T** ent = m_table.FindItem(key);
+		return ent ? *ent : NULL;
+	}
+
+	int		ItemCount() const { return m_table.ItemCount(); }
 };
 
 #endif // VS_HASHTABLE_H
-
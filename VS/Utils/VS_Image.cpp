@@ -179,14 +179,18 @@ vsImage::Read( vsTexture *texture )
 
 void
 vsImage::PrepForAsyncRead( vsTexture *texture )
+{
+	PrepForAsyncRead( texture->GetResource()->GetWidth(), texture->GetResource()->GetHeight() );
+}
+
+void
+vsImage::PrepForAsyncRead( int width, int height )
 {
 	if ( m_pbo == 0 )
 		glGenBuffers(1, &m_pbo);
 
 	glBindBuffer( GL_PIXEL_PACK_BUFFER, m_pbo);
-	size_t width = texture->GetResource()->GetWidth();
-	size_t height = texture->GetResource()->GetHeight();
-	if ( width != m_width || height != m_height )
+	if ( (unsigned int)width != m_width || (unsigned int)height != m_height )
 	{
 		m_width = width;
 		m_height = height;
@@ -248,6 +252,24 @@ vsImage::AsyncReadRenderTarget(vsRenderTarget *target, int buffer)
 	GL_CHECK("glFenceSync");
 }
 
+void
+vsImage::AsyncReadFramebuffer( int width, int height )
+{
+	GL_CHECK_SCOPED("AsyncReadFramebuffer");
+	PrepForAsyncRead( width, height );
+
+	if ( m_sync != 0 )
+		glDeleteSync( m_sync );
+
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, m_pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0,0,width,height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	GL_CHECK("glReadPixels");
+	glBindBuffer( GL_PIXEL_PACK_BUFFER, 0);
+
+	m_sync = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
+
 bool
 vsImage::AsyncReadIsReady()
 {
@@ -462,24 +484,14 @@ vsImage::BakePNG(int compression)
 	int err = SDL_LockSurface( image );
 	vsAssert(!err, "Couldn't lock surface??");
 	vsAssert(image->format->BytesPerPixel == 4, "Didn't get a 4-byte surface??");
+	// Our pixels are already bytes in RGBA order, same as the surface, so we
+	// can copy them a row at a time.  (This is the slow part of saving
+	// screenshots, after the compression itself)
 	for ( size_t v = 0; v < m_height; v++ )
 	{
-		for ( size_t u = 0; u < m_width; u++ )
-		{
-			int i = v*image->pitch + u*4;
-			int ri = i;
-			int gi = ri+1;
-			int bi = ri+2;
-			int ai = ri+3;
-
-			// flip our image.  Our image is stored upside-down, relative to a standard SDL Surface.
-			vsColor pixel = GetPixel(u,(m_height-1)-v);
-
-			((unsigned char*)image->pixels)[ri] = (unsigned char)(255.f * pixel.r);
-			((unsigned char*)image->pixels)[gi] = (unsigned char)(255.f * pixel.g);
-			((unsigned char*)image->pixels)[bi] = (unsigned char)(255.f * pixel.b);
-			((unsigned char*)image->pixels)[ai] = (unsigned char)(255.f * pixel.a);
-		}
+		// flip our image.  Our image is stored upside-down, relative to a standard SDL Surface.
+		const uint32_t *row = &m_pixel[ PixelIndex(0, (m_height-1)-v) ];
+		memcpy( (unsigned char*)image->pixels + v*image->pitch, row, m_width * sizeof(uint32_t) );
 	}
 	//
 	// now, let's save out our surface.
@@ -50,11 +50,13 @@ public:
 	// to pre-allocate space, so that it happens at a desirable time, instead of
 	// stuttering the first time you read back data.
 	void			PrepForAsyncRead( vsTexture *texture );
+	void			PrepForAsyncRead( int width, int height );
 	bool			IsOK() { return m_pixel != NULL; }
 
 	void			Read( vsTexture *texture );
 	void			AsyncRead( vsTexture *texture );
 	void			AsyncReadRenderTarget(vsRenderTarget *target, int buffer);
+	void			AsyncReadFramebuffer( int width, int height ); // reads from whatever framebuffer is currently bound for reading
 	bool			AsyncReadIsReady();
 
 	void			AsyncMap(); // map our async-read data into ourselves so we can be accessed to get pixels directly
@@ -0,0 +1,68 @@
+/*
+ *  VS_InlineArray.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_INLINEARRAY_H
+#define VS_INLINEARRAY_H
+
+#include "VS/Utils/VS_Array.h"
+
+// vsInlineArray is a vsArray which carries storage for its first N items
+// inside itself, and only goes to the heap if it grows past that.  Use it
+// for small, short-lived arrays (or small arrays inside frequently created
+// objects), where the heap allocation would otherwise cost more than the
+// contents.
+//
+// It *is* a vsArray, so it can be passed to anything which takes a
+// vsArray<T>&.
+
+template<class T, int N>
+class vsInlineArray : public vsArray<T>
+{
+	// Note that we hand this to vsArray before we've been constructed, so
+	// it must stay a plain block of memory.
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type	m_inline[N];
+
+public:
+
+	vsInlineArray():
+		vsArray<T>( reinterpret_cast<T*>( m_inline ), N )
+	{
+	}
+
+	vsInlineArray( const vsInlineArray<T,N>& other ):
+		vsArray<T>( reinterpret_cast<T*>( m_inline ), N )
+	{
+		vsArray<T>::operator=( other );
+	}
+
+	vsInlineArray( vsInlineArray<T,N>&& other ):
+		vsArray<T>( reinterpret_cast<T*>( m_inline ), N )
+	{
+		vsArray<T>::operator=( std::move(other) );
+	}
+
+	vsInlineArray( const vsArray<T>& other ):
+		vsArray<T>( reinterpret_cast<T*>( m_inline ), N )
+	{
+		vsArray<T>::operator=( other );
+	}
+
+	vsInlineArray( vsArray<T>&& other ):
+		vsArray<T>( reinterpret_cast<T*>( m_inline ), N )
+	{
+		vsArray<T>::operator=( std::move(other) );
+	}
+
+	void operator=( const vsInlineArray<T,N>& other ) { vsArray<T>::operator=( other ); }
+	void operator=( vsInlineArray<T,N>&& other ) { vsArray<T>::operator=( std::move(other) ); }
+	void operator=( const vsArray<T>& other ) { vsArray<T>::operator=( other ); }
+	void operator=( vsArray<T>&& other ) { vsArray<T>::operator=( std::move(other) ); }
+};
+
+#endif // VS_INLINEARRAY_H
@@ -13,25 +13,197 @@
 #include <cstdarg>
 #include <cstdio>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
 #include "VS_File.h"
+#include "VS/Threads/VS_Semaphore.h"
+#include "VS/Threads/VS_Task.h"
+#include <physfs.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #ifdef MSVC
 #define vsprintf vsprintf_s
 #endif
 
+#ifdef _WIN32
+#define LOG_NEWLINE "\r\n"
+#else
+#define LOG_NEWLINE "\n"
+#endif
+
+#define LOG_QUEUE_SIZE (4096)	// records;  must be a power of two
+#define LOG_INLINE_TEXT (240)	// longer messages are allocated separately
+
+// One queued message.  The queue is a bounded multi-producer queue in the
+// style of Dmitry Vyukov's;  each slot's 'sequence' says whether it's free
+// for the producer at a given position, or full for the consumer.
+struct vsLogRecord
+{
+	std::atomic<uint32_t>	sequence;
+	uint64_t				time;
+	int						thread;
+	bool					error;
+	size_t					length;
+	char *					overflow;
+	char					text[LOG_INLINE_TEXT];
+
+	const char *	GetText() const { return overflow ? overflow : text; }
+};
+
+class vsLogWriter : public vsTask
+{
+protected:
+	virtual int Run();
+public:
+	vsLogWriter(): vsTask("LogWriter") {}
+};
+
 // static PHYSFS_File* s_log = NULL;
 static vsFile *s_log = NULL;
 
+static vsLogRecord s_queue[LOG_QUEUE_SIZE];
+static std::atomic<uint32_t> s_enqueuePos(0);
+static std::atomic<uint32_t> s_dequeuePos(0);	// only modified while holding s_drainLock
+// Held while draining the queue, and while touching s_log.  It's a raw SDL
+// mutex, created by vsLog_Start() and never destroyed, since messages can
+// still arrive during static destruction.
+static SDL_mutex *s_drainLock = NULL;
+static std::atomic<bool> s_async(false);
+static std::atomic<int> s_producers(0);		// threads which may be about to enqueue
+static std::atomic<bool> s_writerSleeping(false);
+static std::atomic<uint32_t> s_dropped(0);		// since the writer last reported it
+static std::atomic<size_t> s_totalDropped(0);
+static std::atomic<int> s_nextThreadId(0);
+static std::atomic<bool> s_stopWriter(false);
+static std::atomic<bool> s_crashed(false);		// vsLog_FlushFromSignal() has run
+#ifndef _WIN32
+static int s_logFd = -1;	// raw descriptor onto log.txt, for vsLog_FlushFromSignal()
+#endif
+// The writer's wakeup semaphore lives for the whole program, since producers
+// may still be posting to it during vsLog_End().
+struct vsLogSemaphore : public vsSemaphore
+{
+	vsLogSemaphore(): vsSemaphore(0) {}
+	~vsLogSemaphore() { Release(); }
+};
+static vsLogSemaphore s_work;
+static vsLogWriter *s_writer = NULL;
+static uint64_t s_startTime = 0;
+static double s_ticksPerSecond = 1.0;
+
+static thread_local int t_logThreadId = -1;
+static thread_local bool t_isLogWriter = false;
+
+static void vsLog_AtExit()
+{
+	vsLog_End();
+}
+
+static void vsLog_Lock()
+{
+	if ( s_drainLock )
+		SDL_LockMutex( s_drainLock );
+}
+
+static void vsLog_Unlock()
+{
+	if ( s_drainLock )
+		SDL_UnlockMutex( s_drainLock );
+}
+
 void vsLog_Start()
 {
+	if ( s_log )
+		return;
+
+	if ( !s_drainLock )
+		s_drainLock = SDL_CreateMutex();
+
+	vsLog_Lock();
 	s_log = new vsFile("log.txt", vsFile::MODE_WriteDirectly);
 	// s_log = PHYSFS_openWrite( "log.txt" );
+	vsLog_Unlock();
+
+#ifndef _WIN32
+	// The crash handler can't go through PhysFS, so it gets its own
+	// descriptor onto the same file.
+	const char *writeDir = PHYSFS_getWriteDir();
+	if ( writeDir )
+	{
+		const char *separator = PHYSFS_getDirSeparator();
+		vsString path = vsFormatString("%s%slog.txt", writeDir, separator);
+		s_logFd = open( path.c_str(), O_WRONLY | O_APPEND );
+	}
+#endif
+
+	for ( uint32_t i = 0; i < LOG_QUEUE_SIZE; i++ )
+		s_queue[i].sequence.store( i, std::memory_order_relaxed );
+	s_enqueuePos.store(0, std::memory_order_relaxed);
+	s_dequeuePos.store(0, std::memory_order_relaxed);
+	s_startTime = SDL_GetPerformanceCounter();
+	s_ticksPerSecond = (double)SDL_GetPerformanceFrequency();
+
+	s_stopWriter.store(false, std::memory_order_relaxed);
+	s_writer = new vsLogWriter;
+	s_async.store(true, std::memory_order_seq_cst);
+	s_writer->Start();
+
+	// 'exit()' gets called from our assert and crash handlers, and by games;
+	// make sure whatever's still queued makes it out.
+	static bool registeredAtExit = false;
+	if ( !registeredAtExit )
+	{
+		atexit( vsLog_AtExit );
+		registeredAtExit = true;
+	}
 }
 
 void vsLog_End()
 {
+	s_async.store(false, std::memory_order_seq_cst);
+
+	// If we crashed, the crash handler has already written out what it
+	// could, and the thread it interrupted may be holding the drain lock.
+	if ( s_crashed.load(std::memory_order_seq_cst) )
+		return;
+
+	// If the writer itself is failing, we can't wait for it;  just let the
+	// process go down.
+	if ( t_isLogWriter )
+		return;
+
+	// Anyone who saw s_async before we cleared it may still be enqueueing;
+	// wait for them, so the final flush gets their messages.
+	while ( s_producers.load(std::memory_order_seq_cst) > 0 )
+		SDL_Delay(0);
+
+	if ( s_writer )
+	{
+		s_stopWriter.store(true, std::memory_order_seq_cst);
+		s_work.Post();
+		s_writer->Join();
+		vsDelete( s_writer );
+	}
+	vsLog_Flush();
+
+	// Synchronous logging may be happening on other threads by now.
+	vsLog_Lock();
 	delete s_log;
+	s_log = NULL;
 	// PHYSFS_close(s_log);
+	vsLog_Unlock();
+#ifndef _WIN32
+	if ( s_logFd >= 0 )
+	{
+		close( s_logFd );
+		s_logFd = -1;
+	}
+#endif
 }
 
 void vsLog_Show()
@@ -43,18 +215,250 @@ void vsLog_Show()
 	// }
 }
 
-void vsLog_(const vsString &str)
+size_t vsLog_GetDroppedCount()
 {
-	fprintf(stdout, "%s\n", str.c_str());
-	if ( s_log )
+	return s_totalDropped.load(std::memory_order_relaxed);
+}
+
+static bool vsLog_HasQueued()
+{
+	uint32_t pos = s_dequeuePos.load(std::memory_order_relaxed);
+	return s_queue[pos & (LOG_QUEUE_SIZE-1)].sequence.load(std::memory_order_seq_cst) == pos + 1;
+}
+
+static void vsLog_WriteConsole( bool error, const vsString &text )
+{
+	if ( text.empty() )
+		return;
+	FILE *stream = error ? stderr : stdout;
+	fwrite( text.c_str(), 1, text.size(), stream );
+	fflush( stream );
+}
+
+// Writes out everything currently in the queue, in one batch.  Returns the
+// number of messages written.
+static int vsLog_Drain()
+{
+	vsLog_Lock();
+
+	vsString fileText;
+	vsString consoleText;
+	bool consoleError = false;
+	int count = 0;
+
+	uint32_t dropped = s_dropped.exchange(0, std::memory_order_relaxed);
+	if ( dropped )
 	{
-#ifdef _WIN32
-		vsString fullLine = str + "\r\n";
-#else
-		vsString fullLine = str + "\n";
+		vsString message = vsFormatString("(%u log messages dropped)", dropped);
+		consoleText += message + "\n";
+		fileText += message + LOG_NEWLINE;
+	}
+
+	uint32_t pos = s_dequeuePos.load(std::memory_order_relaxed);
+	while ( true )
+	{
+		vsLogRecord *record = &s_queue[pos & (LOG_QUEUE_SIZE-1)];
+		if ( record->sequence.load(std::memory_order_acquire) != pos + 1 )
+			break;
+
+		// Console output stays in order across stdout and stderr.
+		if ( record->error != consoleError )
+		{
+			vsLog_WriteConsole( consoleError, consoleText );
+			consoleText.clear();
+			consoleError = record->error;
+		}
+		const char *text = record->GetText();
+		consoleText.append( text, record->length );
+		consoleText += '\n';
+
+		if ( s_log )
+		{
+			double seconds = (record->time - s_startTime) / s_ticksPerSecond;
+			fileText += vsFormatString("%10.4f [%2d] ", seconds, record->thread);
+			fileText.append( text, record->length );
+			fileText += LOG_NEWLINE;
+		}
+
+		vsDeleteArray( record->overflow );
+		record->sequence.store( pos + LOG_QUEUE_SIZE, std::memory_order_release );
+		pos++;
+		count++;
+	}
+	s_dequeuePos.store(pos, std::memory_order_relaxed);
+
+	vsLog_WriteConsole( consoleError, consoleText );
+	if ( s_log && !fileText.empty() )
+		s_log->WriteBytes( (const void*)fileText.c_str(), fileText.size() );
+
+	vsLog_Unlock();
+	return count;
+}
+
+void vsLog_Flush()
+{
+	// We might be crashing inside a drain on the writer thread;  don't
+	// deadlock on ourselves.
+	if ( t_isLogWriter )
+		return;
+	vsLog_Drain();
+}
+
+#ifndef _WIN32
+static void vsLog_WriteRaw( int fd, const char *text, size_t length )
+{
+	while ( length > 0 )
+	{
+		ssize_t written = write( fd, text, length );
+		if ( written <= 0 )
+			return;
+		text += written;
+		length -= written;
+	}
+}
 #endif
+
+void vsLog_FlushFromSignal()
+{
+	s_crashed.store(true, std::memory_order_seq_cst);
+#ifndef _WIN32
+	// Nothing in here may allocate, format, or wait on a lock;  the thread
+	// we interrupted might be holding it.  So we only take the drain lock
+	// if it's free, and write out each record's text as-is, without the
+	// timestamp and thread ID which the writer would have added.
+	if ( !s_drainLock || SDL_TryLockMutex( s_drainLock ) != 0 )
+		return;
+
+	uint32_t pos = s_dequeuePos.load(std::memory_order_relaxed);
+	while ( true )
+	{
+		vsLogRecord *record = &s_queue[pos & (LOG_QUEUE_SIZE-1)];
+		if ( record->sequence.load(std::memory_order_acquire) != pos + 1 )
+			break;
+
+		const char *text = record->GetText();
+		int consoleFd = record->error ? STDERR_FILENO : STDOUT_FILENO;
+		vsLog_WriteRaw( consoleFd, text, record->length );
+		vsLog_WriteRaw( consoleFd, "\n", 1 );
+		if ( s_logFd >= 0 )
+		{
+			vsLog_WriteRaw( s_logFd, text, record->length );
+			vsLog_WriteRaw( s_logFd, LOG_NEWLINE, sizeof(LOG_NEWLINE)-1 );
+		}
+
+		// any overflow text is leaked rather than freed;  we're going down.
+		record->sequence.store( pos + LOG_QUEUE_SIZE, std::memory_order_release );
+		pos++;
+	}
+	s_dequeuePos.store(pos, std::memory_order_relaxed);
+	SDL_UnlockMutex( s_drainLock );
+#endif
+}
+
+int
+vsLogWriter::Run()
+{
+	t_isLogWriter = true;
+	while ( true )
+	{
+		if ( vsLog_Drain() > 0 )
+			continue;
+
+		// Producers only post when they see we're asleep, so that logging
+		// doesn't cost a syscall per message.  Check the queue again after
+		// saying we're asleep, in case something arrived in between.
+		s_writerSleeping.store(true, std::memory_order_seq_cst);
+		if ( !vsLog_HasQueued() && !s_stopWriter.load(std::memory_order_seq_cst) )
+			s_work.Wait();
+		s_writerSleeping.store(false, std::memory_order_seq_cst);
+
+		if ( s_stopWriter.load(std::memory_order_seq_cst) )
+			break;
+	}
+	return 0;
+}
+
+static bool vsLog_Enqueue( const vsString &str, bool error )
+{
+	if ( t_logThreadId < 0 )
+		t_logThreadId = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+	vsLogRecord *record;
+	uint32_t pos = s_enqueuePos.load(std::memory_order_relaxed);
+	while ( true )
+	{
+		record = &s_queue[pos & (LOG_QUEUE_SIZE-1)];
+		uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+		int32_t diff = (int32_t)(sequence - pos);
+		if ( diff == 0 )
+		{
+			if ( s_enqueuePos.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed) )
+				break;
+		}
+		else if ( diff < 0 )
+		{
+			// full;  the writer hasn't caught up.
+			s_dropped.fetch_add(1, std::memory_order_relaxed);
+			s_totalDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+			pos = s_enqueuePos.load(std::memory_order_relaxed);
+	}
+
+	record->time = SDL_GetPerformanceCounter();
+	record->thread = t_logThreadId;
+	record->error = error;
+	record->length = str.size();
+	record->overflow = NULL;
+	if ( str.size() < LOG_INLINE_TEXT )
+		memcpy( record->text, str.c_str(), str.size() );
+	else
+	{
+		record->overflow = new char[str.size()];
+		memcpy( record->overflow, str.c_str(), str.size() );
+	}
+	record->sequence.store( pos + 1, std::memory_order_seq_cst );
+
+	if ( s_writerSleeping.exchange(false, std::memory_order_seq_cst) )
+		s_work.Post();
+	return true;
+}
+
+// Queues the message if logging is asynchronous, and returns whether it was.
+// Producers announce themselves before checking s_async, so once vsLog_End()
+// has cleared it and seen no producers, nobody can still be about to enqueue.
+static bool vsLog_EnqueueIfAsync( const vsString &str, bool error )
+{
+	s_producers.fetch_add(1, std::memory_order_seq_cst);
+	bool async = s_async.load(std::memory_order_seq_cst);
+	if ( async )
+		vsLog_Enqueue( str, error );
+	s_producers.fetch_sub(1, std::memory_order_release);
+	return async;
+}
+
+static void vsLog_WriteSync( const vsString &str, bool error )
+{
+	fprintf(error ? stderr : stdout, "%s\n", str.c_str());
+
+	// After a crash, whoever holds the lock may never let it go.
+	if ( s_crashed.load(std::memory_order_relaxed) )
+		return;
+
+	vsLog_Lock();
+	if ( s_log )
+	{
+		vsString fullLine = str + LOG_NEWLINE;
 		s_log->WriteBytes( (const void*)fullLine.c_str(), fullLine.size() );
 	}
+	vsLog_Unlock();
+}
+
+void vsLog_(const vsString &str)
+{
+	if ( !vsLog_EnqueueIfAsync( str, false ) )
+		vsLog_WriteSync( str, false );
 }
 
 
@@ -66,16 +470,8 @@ void vsLog(fmt::CStringRef format, fmt::ArgList args)
 
 void vsErrorLog_(const vsString &str)
 {
-	fprintf(stderr, "%s\n", str.c_str() );
-	if ( s_log )
-	{
-#ifdef _WIN32
-		vsString fullLine = str + "\r\n";
-#else
-		vsString fullLine = str + "\n";
-#endif
-		s_log->WriteBytes( (const void*)fullLine.c_str(), fullLine.size() );
-	}
+	if ( !vsLog_EnqueueIfAsync( str, true ) )
+		vsLog_WriteSync( str, true );
 }
 
 void vsErrorLog(fmt::CStringRef format, fmt::ArgList args)
@@ -83,4 +479,3 @@ void vsErrorLog(fmt::CStringRef format, fmt::ArgList args)
 	vsString str = fmt::sprintf(format,args);
 	vsErrorLog_(str);
 }
-
@@ -17,9 +17,23 @@
 // use this when an assert is thrown, so that end-users can more easily find the
 // log file so they can e-mail it to us.  (TODO:  Consider whether we want to set
 // up a system which will cause asserts to submit logs to us anonymously, instead?)
+//
+// While the log file is open, vsLog() doesn't write anything itself;  it
+// timestamps the message, tags it with the calling thread's ID, and drops it
+// into a lock-free queue for a background writer thread, so that logging never
+// stalls the game or serialises the threads doing it.  If the queue is ever
+// full, messages are dropped (and counted) rather than waiting for room.
+// vsLog_Flush() writes out everything which has been queued so far, right now,
+// on the calling thread;  it's called automatically when we exit.
+// vsLog_FlushFromSignal() is the crash handler's version;  it's safe to call
+// from a signal handler, but gives up if another thread is mid-flush, and
+// afterwards vsLog_End() does nothing.
 void vsLog_Start();
 void vsLog_End();
 void vsLog_Show();
+void vsLog_Flush();
+void vsLog_FlushFromSignal();
+size_t vsLog_GetDroppedCount();	// total messages dropped because the queue was full
 
 #include "Utils/fmt/printf.h"
 
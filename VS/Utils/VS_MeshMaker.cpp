@@ -12,16 +12,23 @@
 #include "VS_Mesh.h"
 
 #include "VS_Box.h"
+#include "VS_JobSystem.h"
 
 #include "VS_DisableDebugNew.h"
 #include <vector>
 #include <list>
+#include <algorithm>
+#include <cmath>
 #include "VS_EnableDebugNew.h"
 
 
 #define MAX_MESH_MAKER_MATERIALS (10)
 #define MAX_MESH_MAKER_STRIPS (1000)
 
+#define WELD_DISTANCE (0.01f)	// vertices further apart than this never weld
+#define BAKE_GRAIN_SIZE (1024)	// corners per job
+#define WELD_GRAIN_SIZE (256)	// weld groups per job
+
 static float s_mergeTolerance = 0.4f;
 //static float s_splitFactor = 0.707f;
 
@@ -43,6 +50,30 @@ public:
 	}
 };
 
+// One corner of one triangle, each of which either creates a new vertex or
+// welds onto an existing one.
+struct vsMeshMakerCorner
+{
+	vsMeshMakerTriangle *	triangle;
+	int						vertex;
+
+	const vsVector3D &	GetPosition() const { return triangle->m_vertex[vertex].GetPosition(); }
+};
+
+// A corner's place in a spatial hash grid with cells WELD_DISTANCE across,
+// so that corners which might weld are always in the same or neighbouring
+// cells.  Hash collisions only cost us some extra distance checks.
+struct vsMeshMakerCell
+{
+	uint64_t	key;
+	int			corner;
+
+	bool operator<( const vsMeshMakerCell &other ) const
+	{
+		return key < other.key || ( key == other.key && corner < other.corner );
+	}
+};
+
 struct vsMeshMaker::InternalData
 {
 	vsMesh *	m_mesh;
@@ -52,8 +83,90 @@ struct vsMeshMaker::InternalData
 	int									m_materialCount;
 
 	std::vector<vsMeshMakerTriangleEdge>	m_triangleEdge;
+
+	// Bake() working data.  Corners which are close enough to weld are
+	// "neighbours";  chains of neighbours form "weld groups", which can't
+	// affect each other and so can be welded in parallel.
+	std::vector<vsMeshMakerCorner>		m_corner;
+	std::vector<int>					m_neighbourStart;	// corner i's neighbours are m_neighbour[m_neighbourStart[i]..m_neighbourStart[i+1])
+	std::vector<int>					m_neighbour;		// (only earlier corners, in ascending order)
+	std::vector<int>					m_groupStart;		// likewise for the corners in each weld group
+	std::vector<int>					m_group;
+	std::vector<char>					m_created;			// did corner i create the vertex in m_vertex[i]?
+	std::vector<int>					m_weldedTo;			// which m_vertex slot corner i ended up using
 };
 
+template<typename F>
+static void ForEach( bool parallel, int count, int grainSize, const F &functor )
+{
+	if ( parallel && count > grainSize )
+		vsJobSystem::Instance()->ParallelFor( count, grainSize, functor );
+	else
+	{
+		for ( int i = 0; i < count; i++ )
+			functor(i);
+	}
+}
+
+static inline int64_t WeldCellCoordinate( float value )
+{
+	return (int64_t)floorf( value / WELD_DISTANCE );
+}
+
+static inline uint64_t WeldCellKey( int64_t x, int64_t y, int64_t z )
+{
+	return ((uint64_t)x * 0x9E3779B97F4A7C15ULL) ^ ((uint64_t)y * 0xC2B2AE3D27D4EB4FULL) ^ ((uint64_t)z * 0x165667B19E3779F9ULL);
+}
+
+// Finds the corners before 'corner' which are within WELD_DISTANCE of it.
+// Returns how many there are, and writes them into 'out' in ascending order,
+// if 'out' isn't NULL.
+static int FindCloseCorners( const std::vector<vsMeshMakerCorner> &corners, const std::vector<vsMeshMakerCell> &cells, int corner, int *out )
+{
+	const vsVector3D &position = corners[corner].GetPosition();
+	const float sqDistance = WELD_DISTANCE * WELD_DISTANCE;
+	int64_t x = WeldCellCoordinate( position.x );
+	int64_t y = WeldCellCoordinate( position.y );
+	int64_t z = WeldCellCoordinate( position.z );
+
+	uint64_t visited[27];
+	int visitedCount = 0;
+	int count = 0;
+
+	for ( int dx = -1; dx <= 1; dx++ )
+	for ( int dy = -1; dy <= 1; dy++ )
+	for ( int dz = -1; dz <= 1; dz++ )
+	{
+		vsMeshMakerCell probe;
+		probe.key = WeldCellKey( x+dx, y+dy, z+dz );
+		probe.corner = -1;
+
+		// two neighbouring cells could hash to the same key;  don't count
+		// their corners twice.
+		bool duplicate = false;
+		for ( int i = 0; i < visitedCount; i++ )
+			duplicate |= ( visited[i] == probe.key );
+		if ( duplicate )
+			continue;
+		visited[visitedCount++] = probe.key;
+
+		std::vector<vsMeshMakerCell>::const_iterator iter = std::lower_bound( cells.begin(), cells.end(), probe );
+		for ( ; iter != cells.end() && iter->key == probe.key && iter->corner < corner; iter++ )
+		{
+			if ( (corners[iter->corner].GetPosition() - position).SqLength() <= sqDistance )
+			{
+				if ( out )
+					out[count] = iter->corner;
+				count++;
+			}
+		}
+	}
+
+	if ( out )
+		std::sort( out, out + count );
+	return count;
+}
+
 
 
 vsMeshMakerTriangleVertex::vsMeshMakerTriangleVertex()
@@ -232,9 +345,9 @@ vsMeshMakerTriangle::IsDegenerate() const
 
 vsMeshMaker::vsMeshMaker( int flags )
 {
-	m_octree = NULL;
 	m_buildingNormals = flags & Flag_BuildNormals;
 	m_attemptMerge = !(flags & Flag_NoMerge);
+	m_parallel = !(flags & Flag_SingleThreaded);
 	m_triangleCount = 0;
 //	m_triangle = new vsMeshMakerTriangle[maxTriangleCount];
 
@@ -252,12 +365,12 @@ vsMeshMaker::vsMeshMaker( int flags )
 	//m_cellCount = MAKER_CELLS * MAKER_CELLS * MAKER_CELLS;
 	//m_cell = new vsMeshMakerCell[m_cellCount];
 	m_vertex = NULL;
+	m_vertexCount = 0;
 }
 
 vsMeshMaker::~vsMeshMaker()
 {
 	//vsDeleteArray( m_cell );
-	vsDelete( m_octree );
 	vsDeleteArray( m_vertex );
 	for ( int i = 0; i < MAX_MESH_MAKER_MATERIALS; i++ )
 	{
@@ -353,45 +466,135 @@ vsMeshMaker::BakeTriangleEdge( vsMeshMakerTriangle *triangle, int vertA, int ver
 	m_internalData->m_triangleEdge.push_back(e);
 }
 
+void
+vsMeshMaker::FindWeldNeighbours()
+{
+	const std::vector<vsMeshMakerCorner> &corners = m_internalData->m_corner;
+	std::vector<int> &start = m_internalData->m_neighbourStart;
+	std::vector<int> &neighbour = m_internalData->m_neighbour;
+	int cornerCount = (int)corners.size();
+
+	std::vector<vsMeshMakerCell> cells( cornerCount );
+	ForEach( m_parallel, cornerCount, BAKE_GRAIN_SIZE, [&]( int i )
+	{
+		const vsVector3D &position = corners[i].GetPosition();
+		cells[i].key = WeldCellKey( WeldCellCoordinate(position.x), WeldCellCoordinate(position.y), WeldCellCoordinate(position.z) );
+		cells[i].corner = i;
+	});
+	std::sort( cells.begin(), cells.end() );
+
+	// Count everybody's neighbours, so we know where to store them, then go
+	// around again and store them.
+	start.assign( cornerCount+1, 0 );
+	ForEach( m_parallel, cornerCount, BAKE_GRAIN_SIZE, [&]( int i )
+	{
+		start[i+1] = FindCloseCorners( corners, cells, i, NULL );
+	});
+	for ( int i = 0; i < cornerCount; i++ )
+		start[i+1] += start[i];
+
+	neighbour.resize( start[cornerCount] );
+	ForEach( m_parallel, cornerCount, BAKE_GRAIN_SIZE, [&]( int i )
+	{
+		FindCloseCorners( corners, cells, i, neighbour.data() + start[i] );
+	});
+}
+
+void
+vsMeshMaker::FindWeldGroups()
+{
+	const std::vector<int> &start = m_internalData->m_neighbourStart;
+	const std::vector<int> &neighbour = m_internalData->m_neighbour;
+	int cornerCount = (int)m_internalData->m_corner.size();
+
+	// union-find, always keeping the lowest corner as the root, so that the
+	// groups come out in the same order no matter how they were found.
+	std::vector<int> root( cornerCount );
+	for ( int i = 0; i < cornerCount; i++ )
+	{
+		root[i] = i;
+		for ( int n = start[i]; n < start[i+1]; n++ )
+		{
+			int a = i;
+			while ( root[a] != a )
+				a = root[a] = root[root[a]];
+			int b = neighbour[n];
+			while ( root[b] != b )
+				b = root[b] = root[root[b]];
+			if ( a != b )
+				root[ vsMax(a,b) ] = vsMin(a,b);
+		}
+	}
+
+	// Roots always come before their members, so one forward pass finds
+	// every corner's final root.
+	std::vector<int> groupId( cornerCount );
+	int groupCount = 0;
+	for ( int i = 0; i < cornerCount; i++ )
+	{
+		root[i] = root[ root[i] ];
+		groupId[i] = ( root[i] == i ) ? groupCount++ : groupId[ root[i] ];
+	}
+
+	std::vector<int> &groupStart = m_internalData->m_groupStart;
+	std::vector<int> &group = m_internalData->m_group;
+	groupStart.assign( groupCount+1, 0 );
+	for ( int i = 0; i < cornerCount; i++ )
+		groupStart[ groupId[i]+1 ]++;
+	for ( int g = 0; g < groupCount; g++ )
+		groupStart[g+1] += groupStart[g];
+
+	std::vector<int> cursor( groupStart.begin(), groupStart.end()-1 );
+	group.resize( cornerCount );
+	for ( int i = 0; i < cornerCount; i++ )
+		group[ cursor[ groupId[i] ]++ ] = i;
+}
+
+void
+vsMeshMaker::WeldGroup( int g )
+{
+	const std::vector<int> &groupStart = m_internalData->m_groupStart;
+	for ( int n = groupStart[g]; n < groupStart[g+1]; n++ )
+	{
+		int corner = m_internalData->m_group[n];
+		int slot = WeldVertex( corner );
+		m_internalData->m_weldedTo[corner] = slot;
+		m_vertex[slot].AddTriangle( m_internalData->m_corner[corner].triangle );
+	}
+}
+
 int
-vsMeshMaker::BakeTriangleVertex( vsMeshMakerTriangleVertex &vertex, const vsVector3D &faceNormal )
+vsMeshMaker::WeldVertex( int corner )
 {
+	vsMeshMakerTriangle *triangle = m_internalData->m_corner[corner].triangle;
+	vsMeshMakerTriangleVertex &vertex = triangle->m_vertex[ m_internalData->m_corner[corner].vertex ];
+	const vsVector3D &faceNormal = triangle->m_faceNormal;
+	std::vector<char> &created = m_internalData->m_created;
+
 	if ( m_attemptMerge )
 	{
 		float bestPriority = -1.f;
 		vsMeshMakerTriangleVertex *best = NULL;
+		int bestSlot = -1;
 
-		vsVector2D deltaTexel;
-
-		const float testDistance = 1.1f;
-		vsArray<vsMeshMakerTriangleVertex*> array;
-		m_octree->FindPointsWithin( &array, vertex.GetPosition(), testDistance );
-
-		for (int i = 0; i < array.ItemCount(); i++)
+		// Our neighbours are every earlier corner close enough to weld with,
+		// in order;  the ones which created vertices are our candidates.
+		const std::vector<int> &start = m_internalData->m_neighbourStart;
+		for ( int n = start[corner]; n < start[corner+1]; n++ )
 		{
-			//vsMeshMakerTriangleVertex *other = &m_vertex[i];
-			vsMeshMakerTriangleVertex *other = array[i];
+			int slot = m_internalData->m_neighbour[n];
+			if ( !created[slot] )
+				continue;
+
+			vsMeshMakerTriangleVertex *other = &m_vertex[slot];
 			if ( m_buildingNormals )
 			{
 				const float epsilon = 0.01f;
 				const float sqEpsilon = epsilon*epsilon;
 
 				const bool closeEnough = (other->GetPosition() - vertex.GetPosition()).SqLength() < sqEpsilon;
-				//			bool texelMatches = ((other.m_texel - m_texel).SqLength() < sqEpsilon);
 
-				deltaTexel = other->GetTexel() - vertex.GetTexel();
-				if ( deltaTexel.x > 1.f )
-				{
-					deltaTexel.x -= vsFloor(deltaTexel.x);
-				}
-				if ( deltaTexel.y > 1.f )
-				{
-					deltaTexel.y -= vsFloor(deltaTexel.y);
-				}
-				//			const bool texelMatches = deltaTexel.SqLength() < sqEpsilon;
-				bool texelMatches = true;
-
-				if ( closeEnough && texelMatches )
+				if ( closeEnough )
 				{
 					float priority = other->GetMergePriorityWith(vertex, faceNormal);
 
@@ -399,6 +602,7 @@ vsMeshMaker::BakeTriangleVertex( vsMeshMakerTriangleVertex &vertex, const vsVect
 					{
 						bestPriority = priority;
 						best = other;
+						bestSlot = slot;
 					}
 				}
 			}
@@ -406,7 +610,7 @@ vsMeshMaker::BakeTriangleVertex( vsMeshMakerTriangleVertex &vertex, const vsVect
 			{
 				if ( *other == vertex )
 				{
-					return i;
+					return slot;
 				}
 			}
 		}
@@ -418,35 +622,27 @@ vsMeshMaker::BakeTriangleVertex( vsMeshMakerTriangleVertex &vertex, const vsVect
 			bool didMerge = best->AttemptMergeWith(&newVertex, faceNormal);
 			if ( didMerge )
 			{
-				return best->m_index;
+				return bestSlot;
 			}
 			else
 			{
 				// did a fake merge.
-				newVertex.m_index = m_vertexCount;
-				m_vertex[m_vertexCount] = newVertex;
-				//cell->m_vertexIndex.push_back(m_vertexCount);
-				m_octree->AddPoint( &m_vertex[m_vertexCount] );
-				m_vertexCount++;
-
-				return m_vertexCount-1;
+				m_vertex[corner] = newVertex;
+				created[corner] = true;
+				return corner;
 			}
 		}
 	}
 
-	vertex.m_index = m_vertexCount;
-	m_vertex[m_vertexCount] = vertex;
-	m_octree->AddPoint( &m_vertex[m_vertexCount] );
-	//cell->m_vertexIndex.push_back(m_vertexCount);
+	m_vertex[corner] = vertex;
+	created[corner] = true;
 
 	if ( m_buildingNormals )
 	{
-		m_vertex[m_vertexCount].SetNormal( faceNormal );
+		m_vertex[corner].SetNormal( faceNormal );
 	}
 
-	m_vertexCount++;
-
-	return m_vertexCount-1;
+	return corner;
 }
 
 int
@@ -468,14 +664,9 @@ vsMeshMaker::BakeTriangleMaterial( vsMaterial *material )
 void
 vsMeshMaker::BuildTriangleStripsForMaterial( int matId )
 {
-	int count = m_internalData->m_materialTriangle[matId].size();
-	//vsLog("Total triangle count:  %d", count);
-
+	// the list itself was sized by Bake(), since that isn't threadsafe.
 	std::vector<vsMeshMakerTriangle>::iterator t = m_internalData->m_materialTriangle[matId].begin();
 
-	m_internalData->m_mesh->SetTriangleListTriangleCount( matId, count );
-	m_internalData->m_mesh->SetTriangleListMaterial( matId, m_internalData->m_material[matId] );
-
 	while( t != m_internalData->m_materialTriangle[matId].end() )
 	{
 		m_internalData->m_mesh->AddTriangleToList( matId, t->m_vertex[0].m_index, t->m_vertex[1].m_index, t->m_vertex[2].m_index );
@@ -486,89 +677,149 @@ vsMeshMaker::BuildTriangleStripsForMaterial( int matId )
 vsMesh *
 vsMeshMaker::Bake()
 {
-	vsDelete( m_octree );
-	m_cellBounds.Clear();
+	// Baking is spread across the job system's threads, but produces exactly
+	// the same mesh as Flag_SingleThreaded does:  corners are welded in the
+	// same order within each weld group, groups can't affect each other, and
+	// vertices are numbered in the order in which their corners come.
+	m_parallel = m_parallel && vsJobSystem::Exists();
+
+	std::vector<vsMeshMakerCorner> &corners = m_internalData->m_corner;
+	int cornerCount = m_triangleCount * 3;
+	corners.resize( cornerCount );
+	int c = 0;
 	for ( int matId = 0; matId < m_internalData->m_materialCount; matId++ )
 	{
 		std::vector<vsMeshMakerTriangle> *triangleList = &m_internalData->m_materialTriangle[matId];
-		//int triangleCount = m_internalData->m_materialTriangle[matId].size();
-
-		std::vector<vsMeshMakerTriangle>::iterator iter;
-
-		for ( iter = triangleList->begin(); iter != triangleList->end(); iter++ )
+		for ( size_t t = 0; t < triangleList->size(); t++ )
 		{
-			vsMeshMakerTriangle *triangle = &*iter;
-			m_cellBounds.ExpandToInclude( triangle->m_vertex[0].GetPosition() );
-			m_cellBounds.ExpandToInclude( triangle->m_vertex[1].GetPosition() );
-			m_cellBounds.ExpandToInclude( triangle->m_vertex[2].GetPosition() );
+			for ( int v = 0; v < 3; v++ )
+			{
+				corners[c].triangle = &(*triangleList)[t];
+				corners[c].vertex = v;
+				c++;
+			}
 		}
 	}
-	m_cellBounds.Expand( 20.0f );
-	m_octree = new vsPointOctree<vsMeshMakerTriangleVertex>( m_cellBounds, 16 );
 
+	// 1 - build a list of unique vertices, converting our triangles to refer to indices, instead.
 
-	// build a list of unique vertices, converting our triangles to refer to indices, instead.
+	vsDeleteArray( m_vertex );
+	m_vertex = new vsMeshMakerTriangleVertex[cornerCount];
+	m_internalData->m_created.assign( cornerCount, false );
+	m_internalData->m_weldedTo.assign( cornerCount, 0 );
 
-	int maxVertexCount = m_triangleCount * 3;
-	m_vertexCount = 0;
-	m_vertex = new vsMeshMakerTriangleVertex[maxVertexCount];
-	for ( int matId = 0; matId < m_internalData->m_materialCount; matId++ )
+	if ( m_attemptMerge )
 	{
-		std::vector<vsMeshMakerTriangle> *triangleList = &m_internalData->m_materialTriangle[matId];
-		//int triangleCount = m_internalData->m_materialTriangle[matId].size();
+		FindWeldNeighbours();
+		FindWeldGroups();
+	}
+	else
+	{
+		// nothing welds, so every corner is on its own.
+		m_internalData->m_neighbourStart.assign( cornerCount+1, 0 );
+		m_internalData->m_groupStart.resize( cornerCount+1 );
+		m_internalData->m_group.resize( cornerCount );
+		for ( int i = 0; i < cornerCount; i++ )
+		{
+			m_internalData->m_groupStart[i] = i;
+			m_internalData->m_group[i] = i;
+		}
+		m_internalData->m_groupStart[cornerCount] = cornerCount;
+	}
 
-		std::vector<vsMeshMakerTriangle>::iterator iter;
-		//vsLog("Baking %d triangles.", triangleList->size());
+	int groupCount = (int)m_internalData->m_groupStart.size() - 1;
+	ForEach( m_parallel, groupCount, WELD_GRAIN_SIZE, [this]( int g )
+	{
+		WeldGroup( g );
+	});
 
-		for ( iter = triangleList->begin(); iter != triangleList->end(); iter++ )
+	const std::vector<char> &created = m_internalData->m_created;
+	std::vector<int> index( cornerCount );
+	m_vertexCount = 0;
+	int flags = 0;
+	for ( int i = 0; i < cornerCount; i++ )
+	{
+		if ( created[i] )
 		{
-			vsMeshMakerTriangle *triangle = &*iter;
-
-			triangle->m_vertex[0].m_index = BakeTriangleVertex( triangle->m_vertex[0], triangle->m_faceNormal );
-			m_vertex[iter->m_vertex[0].m_index].AddTriangle(triangle);
-			triangle->m_vertex[1].m_index = BakeTriangleVertex( triangle->m_vertex[1], triangle->m_faceNormal );
-			m_vertex[iter->m_vertex[1].m_index].AddTriangle(triangle);
-			triangle->m_vertex[2].m_index = BakeTriangleVertex( triangle->m_vertex[2], triangle->m_faceNormal );
-			m_vertex[iter->m_vertex[2].m_index].AddTriangle(triangle);
+			index[i] = m_vertexCount++;
+			flags |= m_vertex[i].m_flags;
 		}
 	}
 
+	ForEach( m_parallel, cornerCount, BAKE_GRAIN_SIZE, [&]( int i )
+	{
+		if ( created[i] )
+			m_vertex[i].m_index = index[i];
+		corners[i].triangle->m_vertex[ corners[i].vertex ].m_index = index[ m_internalData->m_weldedTo[i] ];
+	});
+
 	//vsLog("Ended up with %d vertices.", m_vertexCount);
-	m_internalData->m_mesh = new vsMesh(m_vertexCount, m_internalData->m_materialCount);
+	vsMesh *mesh = new vsMesh(m_vertexCount, m_internalData->m_materialCount);
+	m_internalData->m_mesh = mesh;
+
+	// vsMesh creates its buffers on first use, so create them here, before
+	// any other threads go filling them in.
+	if ( m_vertexCount > 0 )
+	{
+		if ( flags & vsMeshMakerTriangleVertex::Flag_Position )
+			mesh->SetVertex(0, vsVector3D::Zero);
+		if ( flags & vsMeshMakerTriangleVertex::Flag_Normal )
+			mesh->SetNormal(0, vsVector3D::Zero);
+		if ( flags & vsMeshMakerTriangleVertex::Flag_Color )
+			mesh->SetColor(0, c_white);
+		if ( flags & vsMeshMakerTriangleVertex::Flag_Texel )
+			mesh->SetTexel(0, vsVector2D::Zero);
+	}
 
-	for ( int i = 0; i < m_vertexCount; i++ )
+	ForEach( m_parallel, cornerCount, BAKE_GRAIN_SIZE, [&]( int i )
 	{
-		if ( m_vertex[i].m_flags & vsMeshMakerTriangleVertex::Flag_Position )
+		if ( !created[i] )
+			return;
+		const vsMeshMakerTriangleVertex &vertex = m_vertex[i];
+		int id = index[i];
+		if ( vertex.m_flags & vsMeshMakerTriangleVertex::Flag_Position )
 		{
-			m_internalData->m_mesh->SetVertex(i, m_vertex[i].GetPosition());
+			mesh->SetVertex(id, vertex.GetPosition());
 		}
-		if ( m_vertex[i].m_flags & vsMeshMakerTriangleVertex::Flag_Normal )
+		if ( vertex.m_flags & vsMeshMakerTriangleVertex::Flag_Normal )
 		{
-			m_internalData->m_mesh->SetNormal(i, m_vertex[i].GetNormal());
+			mesh->SetNormal(id, vertex.GetNormal());
 		}
-		if ( m_vertex[i].m_flags & vsMeshMakerTriangleVertex::Flag_Color )
+		if ( vertex.m_flags & vsMeshMakerTriangleVertex::Flag_Color )
 		{
-			m_internalData->m_mesh->SetColor(i, m_vertex[i].GetColor());
+			mesh->SetColor(id, vertex.GetColor());
 		}
-		if ( m_vertex[i].m_flags & vsMeshMakerTriangleVertex::Flag_Texel )
+		if ( vertex.m_flags & vsMeshMakerTriangleVertex::Flag_Texel )
 		{
-			m_internalData->m_mesh->SetTexel(i, m_vertex[i].GetTexel());
+			mesh->SetTexel(id, vertex.GetTexel());
 		}
-	}
+	});
 
 	// 2 - for each material, build triangle strips using their indices.
 
 	for ( int matId = 0; matId < m_internalData->m_materialCount; matId++ )
 	{
-		BuildTriangleStripsForMaterial( matId );
+		mesh->SetTriangleListTriangleCount( matId, (int)m_internalData->m_materialTriangle[matId].size() );
+		mesh->SetTriangleListMaterial( matId, m_internalData->m_material[matId] );
 	}
+	ForEach( m_parallel, m_internalData->m_materialCount, 0, [this]( int matId )
+	{
+		BuildTriangleStripsForMaterial( matId );
+	});
 
 	// 3 - using all of the above data, build a vsMesh containing the vertices, materials, and triangle strips.
-	m_internalData->m_mesh->Bake();
+	mesh->Bake();
+
+	// the working data can be huge;  don't hang onto it.
+	std::vector<vsMeshMakerCorner>().swap( m_internalData->m_corner );
+	std::vector<int>().swap( m_internalData->m_neighbourStart );
+	std::vector<int>().swap( m_internalData->m_neighbour );
+	std::vector<int>().swap( m_internalData->m_groupStart );
+	std::vector<int>().swap( m_internalData->m_group );
+	std::vector<char>().swap( m_internalData->m_created );
+	std::vector<int>().swap( m_internalData->m_weldedTo );
 
-	vsMesh *result = m_internalData->m_mesh;
 	m_internalData->m_mesh = NULL;
 
-	return result;
+	return mesh;
 }
-
@@ -92,19 +92,23 @@ class vsMeshMaker
 
 	int					m_triangleCount;
 
-	vsPointOctree<vsMeshMakerTriangleVertex> *m_octree;
-	vsBox3D				m_cellBounds;
-
+	// During Bake(), m_vertex has one slot per triangle corner;  each slot
+	// holds the vertex which that corner created, if it didn't weld onto an
+	// existing one.
 	vsMeshMakerTriangleVertex *m_vertex;
 	int				m_vertexCount;
 
 	bool			m_buildingNormals;
 	bool			m_attemptMerge;
+	bool			m_parallel;
 
 	InternalData		*m_internalData;
 
 	void			BakeTriangleEdge( vsMeshMakerTriangle *triangle, int vertA, int vertB );
-	int				BakeTriangleVertex( vsMeshMakerTriangleVertex &vertex, const vsVector3D &faceNormal );
+	void			FindWeldNeighbours();
+	void			FindWeldGroups();
+	void			WeldGroup( int group );
+	int				WeldVertex( int corner );
 	int				BakeTriangleMaterial( vsMaterial *material );
 	void			BuildTriangleStripsForMaterial( int matId );
 
@@ -113,7 +117,8 @@ public:
 	enum
 	{
 		Flag_BuildNormals = BIT(0),
-		Flag_NoMerge = BIT(1)
+		Flag_NoMerge = BIT(1),
+		Flag_SingleThreaded = BIT(2)	// bake on the calling thread only.  The result is identical either way.
 	};
 					vsMeshMaker( int flags = 0 );
 					~vsMeshMaker();
@@ -168,7 +168,7 @@ vsOctree::DrawNode( int nodeId, const vsCamera3D *camera, vsRenderQueue *queue )
 		{
 			vsOctreeModelInfo *info = *i;
 			
-			info->m_model->Draw(queue);
+			info->m_model->CachedDraw(queue);
 		}
 		
 		
@@ -10,16 +10,154 @@
 #ifndef VS_POOL_H
 #define VS_POOL_H
 
-#include "VS_VolatileArray.h"
+#include "VS/Utils/VS_Array.h"
+#include "VS/Threads/VS_Spinlock.h"
+#include <atomic>
+
+// vsPool keeps a set of pre-constructed objects which can be borrowed and
+// returned, instead of being created and destroyed.  Objects are NOT
+// re-constructed when they're borrowed;  they come back in whatever state
+// they were in when they were last returned.
+//
+// Objects are created in contiguous chunks, and unused objects are kept in a
+// free list which is threaded through the chunk slots themselves, so both
+// Borrow() and Return() are O(1) and never touch the heap (except when an
+// expandable pool needs to grow).
+//
+// By default a pool may only be used from one thread at a time.  Pools
+// created with Access_ThreadSafe keep their free list in a lock-free stack,
+// and may be borrowed from and returned to from any thread;  only growing an
+// expandable pool takes a lock.
 
 template<class T>
 class vsPool
 {
-	vsVolatileArray<T*>				m_unusedList;
+	struct Slot
+	{
+		T						object;		// must be first;  Return() casts back from it.
+		Slot *					next;		// free list link, for single-threaded pools
+		std::atomic<uint32_t>	nextIndex;	// free list link, for thread-safe pools
+		uint32_t				index;
+	};
+
+	// Thread-safe pools pack a slot index (plus one, so zero is "empty") into
+	// the bottom 32 bits of the free list head, and a tag which changes on
+	// every push and pop into the top 32 bits, so that a stale pop can't
+	// succeed after the same slot has been popped and pushed again.
+	static uint64_t		MakeHead( uint64_t tag, uint32_t index ) { return (tag << 32) | index; }
+	static uint32_t		HeadIndex( uint64_t head ) { return (uint32_t)(head & 0xffffffff); }
+	static uint64_t		HeadTag( uint64_t head ) { return head >> 32; }
 
-	int						m_count;
-	int						m_unusedCount;
+	vsArray<Slot*>			m_chunk;
+	Slot *					m_unused;		// single-threaded free list
+
+	std::atomic<uint64_t>	m_unusedHead;	// thread-safe free list
+	std::atomic<Slot**>		m_slotTable;	// thread-safe pools look slots up by index
+	vsArray<Slot**>			m_retiredSlotTables;
+	vsSpinlock				m_growLock;
+
+	std::atomic<int>		m_count;
+	std::atomic<int>		m_unusedCount;
 	bool					m_expandable;
+	bool					m_threadSafe;
+
+	int		GetGrowSize() const
+	{
+		// Grow by modest amounts;  pooled objects often own other resources
+		// (vsDynamicBatch owns GPU buffers), so we'd rather not create lots of
+		// them which will never be used.
+		return vsMax( 16, m_count.load(std::memory_order_relaxed) / 2 );
+	}
+
+	void	AddChunk( int count )
+	{
+		Slot *chunk = new Slot[count];
+		m_chunk.AddItem( chunk );
+
+		if ( m_threadSafe )
+		{
+			// Publish a new slot table before any of the new slots can appear
+			// on the free list.  Other threads may still be reading the old
+			// table, so we keep it around until the pool is destroyed.
+			int first = m_count.load(std::memory_order_relaxed);
+			Slot **oldTable = m_slotTable.load(std::memory_order_relaxed);
+			Slot **table = new Slot*[first + count];
+			for ( int i = 0; i < first; i++ )
+				table[i] = oldTable[i];
+			for ( int i = 0; i < count; i++ )
+			{
+				chunk[i].index = first + i;
+				table[first + i] = &chunk[i];
+			}
+			m_slotTable.store( table, std::memory_order_release );
+			if ( oldTable )
+				m_retiredSlotTables.AddItem( oldTable );
+
+			m_count.fetch_add( count, std::memory_order_relaxed );
+			for ( int i = 0; i < count; i++ )
+				Push( &chunk[i] );
+		}
+		else
+		{
+			for ( int i = count-1; i >= 0; i-- )
+			{
+				chunk[i].next = m_unused;
+				m_unused = &chunk[i];
+			}
+			m_count.fetch_add( count, std::memory_order_relaxed );
+			m_unusedCount.fetch_add( count, std::memory_order_relaxed );
+		}
+	}
+
+	void	Push( Slot *slot )
+	{
+		uint64_t head = m_unusedHead.load(std::memory_order_relaxed);
+		do
+		{
+			slot->nextIndex.store( HeadIndex(head), std::memory_order_relaxed );
+		} while ( !m_unusedHead.compare_exchange_weak( head, MakeHead( HeadTag(head)+1, slot->index+1 ), std::memory_order_release, std::memory_order_relaxed ) );
+		m_unusedCount.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	Slot *	Pop()
+	{
+		uint64_t head = m_unusedHead.load(std::memory_order_acquire);
+		while ( HeadIndex(head) != 0 )
+		{
+			// Read the table *after* the head;  any slot we can see on the
+			// free list is guaranteed to be in the table we load here.
+			Slot *slot = m_slotTable.load(std::memory_order_acquire)[ HeadIndex(head)-1 ];
+			uint32_t next = slot->nextIndex.load(std::memory_order_relaxed);
+			if ( m_unusedHead.compare_exchange_weak( head, MakeHead( HeadTag(head)+1, next ), std::memory_order_acquire, std::memory_order_acquire ) )
+			{
+				m_unusedCount.fetch_sub( 1, std::memory_order_relaxed );
+				return slot;
+			}
+		}
+		return NULL;
+	}
+
+	T*	BorrowThreadSafe()
+	{
+		Slot *slot = Pop();
+		while ( !slot )
+		{
+			vsAssert( m_expandable, "No more available!" );
+
+			m_growLock.Lock();
+			// Somebody else may have grown the pool (or returned something)
+			// while we were waiting for the lock.
+			if ( m_unusedCount.load(std::memory_order_relaxed) <= 0 )
+				AddChunk( GetGrowSize() );
+			m_growLock.Unlock();
+
+			slot = Pop();
+		}
+		return &slot->object;
+	}
+
+	vsPool( const vsPool& );
+	vsPool& operator=( const vsPool& );
 
 public:
 
@@ -28,64 +166,95 @@ public:
 		Type_Static,
 		Type_Expandable
 	};
-	vsPool( int maxCount, Type t = Type_Static ):
-		m_count(maxCount),
-		m_unusedCount(maxCount),
-		m_expandable( (t == Type_Expandable) )
+	enum Access
 	{
-		for ( int i = 0; i < m_count; i++ )
-		{
-			m_unusedList.AddItem( new T );
-		}
+		Access_SingleThreaded,
+		Access_ThreadSafe
+	};
+	vsPool( int maxCount, Type t = Type_Static, Access a = Access_SingleThreaded ):
+		m_unused(NULL),
+		m_unusedHead(0),
+		m_slotTable(NULL),
+		m_count(0),
+		m_unusedCount(0),
+		m_expandable( (t == Type_Expandable) ),
+		m_threadSafe( (a == Access_ThreadSafe) )
+	{
+		if ( maxCount > 0 )
+			AddChunk( maxCount );
 	}
 
 	~vsPool()
 	{
 		vsAssert(m_count ==  m_unusedCount, "Not all instances returned to the pool before pool shutdown??");
 
-		while ( !m_unusedList.IsEmpty() )
-		{
-			T* object = *m_unusedList.Begin();
-			m_unusedList.RemoveItem( object );
-			vsDelete(object);
-		}
+		for ( int i = 0; i < m_chunk.ItemCount(); i++ )
+			vsDeleteArray( m_chunk[i] );
+		Slot **table = m_slotTable.load();
+		vsDeleteArray( table );
+		for ( int i = 0; i < m_retiredSlotTables.ItemCount(); i++ )
+			vsDeleteArray( m_retiredSlotTables[i] );
 	}
 
 	T*	Borrow()
 	{
-		if ( !m_expandable )
-		{
-			vsAssert( m_unusedCount > 0, "No more available!" );
-		}
-		if ( m_unusedCount <= 0 )
+		if ( m_threadSafe )
+			return BorrowThreadSafe();
+
+		if ( !m_unused )
 		{
-			m_unusedCount++;
-			m_count++;
-			m_unusedList.AddItem( new T );
+			vsAssert( m_expandable, "No more available!" );
+			AddChunk( GetGrowSize() );
 		}
-		m_unusedCount--;
 
-		T* result = m_unusedList[0];
-		m_unusedList.RemoveItem(result);
-		//m_usedList.AddItem(result);
+		Slot *slot = m_unused;
+		m_unused = slot->next;
+		m_unusedCount.store( m_unusedCount.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed );
+		return &slot->object;
+	}
 
-		vsAssert( m_unusedCount == m_unusedList.ItemCount(), "Out of sync pool counts??" );
-		return result;
+	// Like Borrow(), but never grows the pool;  returns NULL if there's
+	// nothing available right now.
+	T*	TryBorrow()
+	{
+		Slot *slot;
+		if ( m_threadSafe )
+			slot = Pop();
+		else
+		{
+			slot = m_unused;
+			if ( slot )
+			{
+				m_unused = slot->next;
+				m_unusedCount.store( m_unusedCount.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed );
+			}
+		}
+		return slot ? &slot->object : NULL;
 	}
 
 	void Return( T* item )
 	{
-		m_unusedCount++;
+		Slot *slot = reinterpret_cast<Slot*>(item);
+
+		if ( m_threadSafe )
+		{
+			Push( slot );
+			return;
+		}
 
-		//m_usedList.RemoveItem(item);
-		m_unusedList.AddItem(item);
-		vsAssert( m_unusedCount == m_unusedList.ItemCount(), "Out of sync pool counts??" );
+		slot->next = m_unused;
+		m_unused = slot;
+		m_unusedCount.store( m_unusedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed );
+		vsAssert( m_unusedCount <= m_count, "Returned more objects to the pool than it contains??" );
 	}
 
 	bool IsEmpty()
 	{
 		return (m_unusedCount == 0 && !m_expandable);
 	}
+
+	int	GetCount() const { return m_count; }
+	int	GetUnusedCount() const { return m_unusedCount; }
 };
 
 #endif // VS_POOL_H
@@ -18,15 +18,15 @@
 //
 // It's important to note that this profiler is NOT threadsafe.
 //
-// This should be considered to be a temporary class;  I'm likely to
-// replace it entirely, to cope with the lack of thread safety.  But I
-// needed something to track down performance differences between platforms,
-// and this was able to do the job today.
+// By default, the 'PROFILE' and 'PROFILE_GL' macros now record zones into
+// vsProfiler (VS_Profiler.h) instead, which is threadsafe, always compiled
+// in, and captured on demand into a Chrome trace.  Set VSPL_PROFILE to one of
+// the other modes below to use this older profiler (and its GPU queries)
+// instead, from the main thread only.
 //
 // If you're going to use profiling functionality, I advise you only
 // use the 'PROFILE' and 'PROFILE_GL' macros;  every other interface
-// provided here is likely to go away or change before this code reaches the
-// 'master' branch.
+// provided here is likely to go away or change.
 
 #ifndef VS_PROFILE_H
 #define VS_PROFILE_H
@@ -34,10 +34,13 @@
 #define VSPL_PROFILE_NONE 0
 #define VSPL_PROFILE_CPU 1
 #define VSPL_PROFILE_CPU_AND_GPU 2
+#define VSPL_PROFILE_ZONES 3
 
 
 // #define VSPL_PROFILE VSPL_PROFILE_CPU_AND_GPU
-#define VSPL_PROFILE VSPL_PROFILE_NONE
+#define VSPL_PROFILE VSPL_PROFILE_ZONES
+
+#include "VS_Profiler.h"
 
 #include "VS_DisableDebugNew.h"
 #include <vector>
@@ -147,6 +150,9 @@ public:
 #elif VSPL_PROFILE == VSPL_PROFILE_CPU_AND_GPU
 #define PROFILE(name) VSProfileLib __profile(name)
 #define PROFILE_GL(name) VSProfileLib __profile(name, true)
+#elif VSPL_PROFILE == VSPL_PROFILE_ZONES
+#define PROFILE(name) vsProfileZone __profile(name)
+#define PROFILE_GL(name) vsProfileZone __profile(name)
 #endif
 
 #endif // VS_PROFILE_H
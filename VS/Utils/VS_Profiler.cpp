@@ -0,0 +1,384 @@
+/*
+ *  VS_Profiler.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_Profiler.h"
+
+#include "VS_File.h"
+#include "VS_StringId.h"
+#include "VS/Threads/VS_Spinlock.h"
+
+#include <cstring>
+
+#define PROFILER_CHUNK_EVENTS (4096)
+#define PROFILER_MAX_CHUNKS (64)		// per thread, per capture;  about 250,000 zones
+#define PROFILER_WRITE_BATCH (64*1024)
+
+struct vsProfilerEvent
+{
+	const char *	name;
+	uint64_t		start;
+	uint64_t		end;
+};
+
+struct vsProfilerChunk
+{
+	vsProfilerEvent		event[PROFILER_CHUNK_EVENTS];
+	vsProfilerChunk *	next;
+};
+
+// Everything one thread has recorded.  Only the owning thread writes events;
+// the main thread reads them when writing out a capture, up to 'count'.
+// Chunks are kept from one capture to the next, and only freed at Shutdown().
+// When a thread exits, its record goes onto a free list for the next new
+// thread to take over, chunks and all, so threads which come and go (like
+// the render thread, across suspend and resume) don't leak a record each.
+struct vsProfilerThread
+{
+	int						id;
+	char					name[32];
+	std::atomic<uint32_t>	generation;	// which capture our events belong to
+	std::atomic<uint32_t>	count;
+	std::atomic<uint32_t>	dropped;
+
+	// owner only
+	vsProfilerChunk *		head;
+	vsProfilerChunk *		current;
+	int						currentIndex;
+	int						chunkCount;
+
+	vsProfilerThread *		next;
+	vsProfilerThread *		nextFree;	// while on the free list
+};
+
+std::atomic<bool> vsProfiler::s_capturing(false);
+
+static std::atomic<uint32_t> s_generation(1);	// records start at generation 0, meaning "no events"
+static std::atomic<uint32_t> s_registry(1);	// bumped by Shutdown(), to forget every thread's buffer
+static vsSpinlock s_threadLock;
+static vsProfilerThread *s_threads = NULL;
+static vsProfilerThread *s_freeThreads = NULL;	// records whose threads have exited
+static int s_nextThreadId = 1;					// 0 is the frame track
+
+// main thread only
+static int s_framesRequested = 0;
+static int s_framesLeft = 0;
+static int s_frameCount = 0;
+static uint64_t *s_frameStart = NULL;
+static vsString s_filename;
+static uint64_t s_startTicks = 0;
+static uint64_t s_startCounter = 0;
+
+// The calling thread's record.  Destroyed when the thread exits, which
+// hands the record back.
+struct vsProfilerThreadHandle
+{
+	vsProfilerThread *	thread;
+	uint32_t			registry;
+
+	vsProfilerThreadHandle(): thread(NULL), registry(0) {}
+	~vsProfilerThreadHandle();
+};
+
+static thread_local vsProfilerThreadHandle t_handle;
+
+vsProfilerThreadHandle::~vsProfilerThreadHandle()
+{
+	s_threadLock.Lock();
+	// If Shutdown() has happened since we got our record, it's already gone.
+	if ( thread && registry == s_registry.load(std::memory_order_relaxed) )
+	{
+		thread->nextFree = s_freeThreads;
+		s_freeThreads = thread;
+	}
+	s_threadLock.Unlock();
+	thread = NULL;
+}
+
+// Must hold s_threadLock.  A free record can be taken over unless it has
+// events in the most recent capture, which may not have been written yet.
+static vsProfilerThread * TakeFreeThread_Internal()
+{
+	uint32_t generation = s_generation.load(std::memory_order_relaxed);
+	for ( vsProfilerThread **link = &s_freeThreads; *link; link = &(*link)->nextFree )
+	{
+		vsProfilerThread *thread = *link;
+		if ( thread->generation.load(std::memory_order_relaxed) == generation )
+			continue;
+		*link = thread->nextFree;
+		return thread;
+	}
+	return NULL;
+}
+
+static vsProfilerThread * GetThread()
+{
+	vsProfilerThreadHandle &handle = t_handle;
+	uint32_t registry = s_registry.load(std::memory_order_acquire);
+	if ( handle.thread && handle.registry == registry )
+		return handle.thread;
+
+	s_threadLock.Lock();
+	vsProfilerThread *thread = TakeFreeThread_Internal();
+	if ( !thread )
+	{
+		thread = new vsProfilerThread;
+		thread->head = NULL;
+		thread->chunkCount = 0;
+		thread->next = s_threads;
+		s_threads = thread;
+	}
+	// a new id, so a recycled record shows up as a new track.
+	thread->id = s_nextThreadId++;
+	thread->name[0] = 0;
+	thread->generation.store(0, std::memory_order_relaxed);
+	thread->count.store(0, std::memory_order_relaxed);
+	thread->dropped.store(0, std::memory_order_relaxed);
+	thread->current = NULL;
+	thread->currentIndex = 0;
+	thread->nextFree = NULL;
+	s_threadLock.Unlock();
+
+	handle.thread = thread;
+	handle.registry = registry;
+	return thread;
+}
+
+void
+vsProfiler::Startup()
+{
+	SetThreadName("Main");
+}
+
+void
+vsProfiler::Shutdown()
+{
+	s_capturing.store(false, std::memory_order_seq_cst);
+	s_framesRequested = 0;
+	vsDeleteArray( s_frameStart );
+
+	// Every other thread should be gone by now.
+	s_threadLock.Lock();
+	s_registry.fetch_add(1, std::memory_order_release);
+	while ( s_threads )
+	{
+		vsProfilerThread *thread = s_threads;
+		s_threads = thread->next;
+		while ( thread->head )
+		{
+			vsProfilerChunk *chunk = thread->head;
+			thread->head = chunk->next;
+			vsDelete( chunk );
+		}
+		vsDelete( thread );
+	}
+	s_freeThreads = NULL;
+	s_nextThreadId = 1;
+	s_threadLock.Unlock();
+}
+
+void
+vsProfiler::SetThreadName( const char *name )
+{
+	vsProfilerThread *thread = GetThread();
+	strncpy( thread->name, name, sizeof(thread->name)-1 );
+	thread->name[sizeof(thread->name)-1] = 0;
+}
+
+void
+vsProfiler::StartCapture( int frames, const vsString &filename )
+{
+	if ( IsCaptureRequested() )
+	{
+		vsLog("Profiler: ignoring capture request;  a capture is already under way");
+		return;
+	}
+	s_framesRequested = vsMax( 1, frames );
+	s_filename = filename;
+}
+
+bool
+vsProfiler::IsCaptureRequested()
+{
+	return s_framesRequested > 0 || s_capturing.load(std::memory_order_relaxed);
+}
+
+void
+vsProfiler::Record( const char *name, uint64_t start, uint64_t end )
+{
+	vsProfilerThread *thread = GetThread();
+
+	uint32_t generation = s_generation.load(std::memory_order_relaxed);
+	if ( thread->generation.load(std::memory_order_relaxed) != generation )
+	{
+		// first zone of a new capture;  start over from our first chunk.
+		thread->count.store(0, std::memory_order_relaxed);
+		thread->dropped.store(0, std::memory_order_relaxed);
+		thread->current = thread->head;
+		thread->currentIndex = 0;
+		thread->generation.store(generation, std::memory_order_release);
+	}
+
+	if ( !thread->current || thread->currentIndex == PROFILER_CHUNK_EVENTS )
+	{
+		vsProfilerChunk *next = thread->current ? thread->current->next : thread->head;
+		if ( !next )
+		{
+			if ( thread->chunkCount == PROFILER_MAX_CHUNKS )
+			{
+				thread->dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			next = new vsProfilerChunk;
+			next->next = NULL;
+			thread->chunkCount++;
+			if ( thread->current )
+				thread->current->next = next;
+			else
+				thread->head = next;
+		}
+		thread->current = next;
+		thread->currentIndex = 0;
+	}
+
+	vsProfilerEvent &event = thread->current->event[thread->currentIndex++];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	thread->count.store( thread->count.load(std::memory_order_relaxed) + 1, std::memory_order_release );
+}
+
+static void AppendEscaped( vsString &out, const char *string )
+{
+	for ( const char *c = string; *c; c++ )
+	{
+		if ( *c == '"' || *c == '\\' )
+			out += '\\';
+		if ( (unsigned char)*c < 0x20 )
+			continue;
+		out += *c;
+	}
+}
+
+static void WriteCapture()
+{
+	uint64_t endTicks = vsProfiler::Now();
+	uint64_t endCounter = SDL_GetPerformanceCounter();
+
+	// Timestamps may be CPU ticks, so work out how many there are per
+	// microsecond by comparing against the performance counter.
+	double seconds = (double)(endCounter - s_startCounter) / (double)SDL_GetPerformanceFrequency();
+	double ticksPerMicrosecond = 1.0;
+	if ( seconds > 0.0 && endTicks > s_startTicks )
+		ticksPerMicrosecond = (endTicks - s_startTicks) / (seconds * 1000000.0);
+
+	vsFile file( s_filename, vsFile::MODE_WriteDirectly );
+	vsString out = "{\"traceEvents\":[\n";
+	out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+
+	for ( int i = 0; i < s_frameCount; i++ )
+	{
+		double ts = (s_frameStart[i] - s_startTicks) / ticksPerMicrosecond;
+		double dur = (s_frameStart[i+1] - s_frameStart[i]) / ticksPerMicrosecond;
+		out += vsFormatString(",\n{\"name\":\"Frame %d\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}", i, ts, dur);
+	}
+
+	uint32_t generation = s_generation.load(std::memory_order_relaxed);
+	int zones = 0;
+	int threads = 0;
+	int dropped = 0;
+
+	s_threadLock.Lock();
+	for ( vsProfilerThread *thread = s_threads; thread; thread = thread->next )
+	{
+		if ( thread->generation.load(std::memory_order_acquire) != generation )
+			continue;
+		uint32_t count = thread->count.load(std::memory_order_acquire);
+		dropped += thread->dropped.load(std::memory_order_relaxed);
+		threads++;
+
+		out += vsFormatString(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"", thread->id);
+		if ( thread->name[0] )
+			AppendEscaped( out, thread->name );
+		else
+			out += vsFormatString("Thread %d", thread->id);
+		out += "\"}}";
+
+		vsProfilerChunk *chunk = thread->head;
+		for ( uint32_t i = 0; i < count; i++ )
+		{
+			if ( i > 0 && (i % PROFILER_CHUNK_EVENTS) == 0 )
+				chunk = chunk->next;
+			const vsProfilerEvent &event = chunk->event[i % PROFILER_CHUNK_EVENTS];
+
+			// zones which started before the capture get clipped to its start.
+			uint64_t start = vsMax( event.start, s_startTicks );
+			uint64_t end = vsMax( event.end, start );
+			out += ",\n{\"name\":\"";
+			AppendEscaped( out, event.name );
+			out += vsFormatString("\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+					thread->id,
+					(start - s_startTicks) / ticksPerMicrosecond,
+					(end - start) / ticksPerMicrosecond);
+			zones++;
+
+			if ( out.size() > PROFILER_WRITE_BATCH )
+			{
+				file.WriteBytes( out.c_str(), out.size() );
+				out.clear();
+			}
+		}
+	}
+	s_threadLock.Unlock();
+
+	out += vsFormatString("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedZones\":%d}}\n", dropped);
+	file.WriteBytes( out.c_str(), out.size() );
+
+	vsLog("Profiler: wrote %d zones from %d threads over %d frames to '%s'", zones, threads, s_frameCount, s_filename.c_str());
+	if ( dropped )
+		vsLog("Profiler: %d zones were dropped;  capture fewer frames to see them", dropped);
+}
+
+void
+vsProfiler::FrameMarker()
+{
+	if ( s_capturing.load(std::memory_order_relaxed) )
+	{
+		s_frameStart[++s_frameCount] = Now();
+		if ( --s_framesLeft == 0 )
+		{
+			s_capturing.store(false, std::memory_order_relaxed);
+			WriteCapture();
+			vsDeleteArray( s_frameStart );
+		}
+	}
+	else if ( s_framesRequested > 0 )
+	{
+		s_frameStart = new uint64_t[s_framesRequested+1];
+		s_framesLeft = s_framesRequested;
+		s_framesRequested = 0;
+		s_frameCount = 0;
+
+		s_generation.fetch_add(1, std::memory_order_relaxed);
+		s_startCounter = SDL_GetPerformanceCounter();
+		s_startTicks = Now();
+		s_frameStart[0] = s_startTicks;
+		s_capturing.store(true, std::memory_order_release);
+	}
+}
+
+vsProfileZone::vsProfileZone( const vsString &name ):
+	m_name(NULL),
+	m_start(0)
+{
+	if ( vsProfiler::IsCapturing() )
+	{
+		m_name = vsStringId(name).c_str();
+		m_start = vsProfiler::Now();
+	}
+}
@@ -0,0 +1,113 @@
+/*
+ *  VS_Profiler.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_PROFILER_H
+#define VS_PROFILER_H
+
+#include <atomic>
+#include <SDL2/SDL.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define VS_PROFILER_RDTSC
+#include "VS/VS_DisableDebugNew.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#include "VS/VS_EnableDebugNew.h"
+#endif
+
+// vsProfiler records timed, nested zones from any thread, and writes them
+// out as a Chrome trace (the JSON format read by chrome://tracing and by
+// Perfetto).  It's always compiled in, and costs almost nothing until a
+// capture is started:  a zone checks a single flag, and that's all.
+//
+// Call StartCapture() from the main thread at any time (from a debug key, a
+// console command, or whatever you like) to capture the next N whole frames;
+// coreGame calls FrameMarker() at the start of every frame, which is where
+// captures begin and end, and where the trace file is written.
+//
+// While capturing, each zone costs two timestamp reads and one write into a
+// buffer belonging to the calling thread;  no locks are taken.  Each thread
+// records a limited number of zones per capture;  beyond that, zones are
+// dropped and counted.
+//
+// Use zones through the PROFILE() macro in VS_Profile.h, or directly:
+//
+//     {
+//         vsProfileZone zone("Physics");
+//         ...
+//     }
+//
+// Zone names passed as 'const char*' must stay valid until the capture has
+// been written (string literals are ideal).  Names passed as vsStrings are
+// interned, so are safe, but cost a hash lookup per zone while capturing.
+
+class vsProfiler
+{
+	static std::atomic<bool>	s_capturing;
+
+public:
+
+	static void		Startup();
+	static void		Shutdown();
+
+	// Main thread only.  Captures the next 'frames' frames, and writes them
+	// to 'filename' in the write directory.
+	static void		StartCapture( int frames, const vsString &filename = "profile.json" );
+	static bool		IsCaptureRequested();	// true from StartCapture() until the file is written
+
+	// Main thread only;  called by coreGame at the start of each frame.
+	static void		FrameMarker();
+
+	// Names the calling thread in traces.  Unnamed threads are "Thread N".
+	static void		SetThreadName( const char *name );
+
+	static inline bool IsCapturing() { return s_capturing.load(std::memory_order_acquire); }
+
+	static inline uint64_t Now()
+	{
+#if defined(VS_PROFILER_RDTSC)
+		return __rdtsc();
+#else
+		return SDL_GetPerformanceCounter();
+#endif
+	}
+
+	static void		Record( const char *name, uint64_t start, uint64_t end );
+};
+
+class vsProfileZone
+{
+	const char *	m_name;
+	uint64_t		m_start;
+
+public:
+
+	vsProfileZone( const char *name ):
+		m_name(NULL),
+		m_start(0)
+	{
+		if ( vsProfiler::IsCapturing() )
+		{
+			m_name = name;
+			m_start = vsProfiler::Now();
+		}
+	}
+	vsProfileZone( const vsString &name );
+
+	~vsProfileZone()
+	{
+		if ( m_name )
+			vsProfiler::Record( m_name, m_start, vsProfiler::Now() );
+	}
+};
+
+#endif // VS_PROFILER_H
@@ -0,0 +1,221 @@
+/*
+ *  VS_StringId.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_StringId.h"
+#include "VS_HashTable.h"
+#include "VS/Threads/VS_Spinlock.h"
+#include <atomic>
+
+// The interning table lives for the whole run, outside of any vsHeap;  names
+// are often interned for the first time while a game is running, and we don't
+// want them reported as that game's memory leaks when it exits.
+#undef malloc
+#undef free
+
+// Everything in here is either zero-initialised or trivially constructed, so
+// that it's safe to create vsStringIds from other files' static constructors.
+
+struct vsStringIdEntry
+{
+	const char *	string;
+	uint32_t		length;
+	uint32_t		hash;
+};
+
+#define STRINGID_CHUNK_SHIFT (10)
+#define STRINGID_CHUNK_SIZE (1 << STRINGID_CHUNK_SHIFT)
+#define STRINGID_MAX_CHUNKS (4096)
+#define STRINGID_TEXT_BLOCK_SIZE (16 * 1024)
+#define STRINGID_MIN_INDEX_SIZE (1024)
+
+// Entries, indexed by id.  Chunks never move once they're published.
+static std::atomic<vsStringIdEntry*>	s_chunk[STRINGID_MAX_CHUNKS];
+
+// Open-addressed index from string to id.  Each slot holds an id, or zero
+// if it's empty.  When it fills up we publish a bigger one;  readers might
+// still be looking at the old one, so we never free it.  (It only ever
+// holds ids which are in the new one too, so that's harmless)
+struct vsStringIdIndex
+{
+	uint32_t				mask;
+	std::atomic<uint32_t> *	slot;
+};
+static std::atomic<vsStringIdIndex*>	s_index;
+
+static vsSpinlock			s_lock;
+static std::atomic<uint32_t>	s_count;	// ids in use, including zero
+static char *				s_text;
+static size_t				s_textRemaining;
+
+static inline const vsStringIdEntry &
+GetEntry( uint32_t id )
+{
+	return s_chunk[id >> STRINGID_CHUNK_SHIFT].load(std::memory_order_acquire)[id & (STRINGID_CHUNK_SIZE-1)];
+}
+
+static uint32_t
+FindId( const vsStringIdIndex *index, const char *string, uint32_t length, uint32_t hash )
+{
+	uint32_t pos = hash & index->mask;
+	for (;;)
+	{
+		uint32_t id = index->slot[pos].load(std::memory_order_acquire);
+		if ( id == 0 )
+			return 0;
+		const vsStringIdEntry &entry = GetEntry(id);
+		if ( entry.hash == hash && entry.length == length && memcmp( entry.string, string, length ) == 0 )
+			return id;
+		pos = (pos + 1) & index->mask;
+	}
+}
+
+static void
+InsertId( vsStringIdIndex *index, uint32_t hash, uint32_t id )
+{
+	uint32_t pos = hash & index->mask;
+	while ( index->slot[pos].load(std::memory_order_relaxed) != 0 )
+		pos = (pos + 1) & index->mask;
+	index->slot[pos].store( id, std::memory_order_release );
+}
+
+static const char *
+StoreText( const char *string, uint32_t length )
+{
+	char *result;
+	if ( length + 1 > STRINGID_TEXT_BLOCK_SIZE / 4 )
+	{
+		result = (char*)malloc( length + 1 );
+	}
+	else
+	{
+		if ( s_textRemaining < length + 1 )
+		{
+			s_text = (char*)malloc( STRINGID_TEXT_BLOCK_SIZE );
+			s_textRemaining = STRINGID_TEXT_BLOCK_SIZE;
+		}
+		result = s_text;
+		s_text += length + 1;
+		s_textRemaining -= length + 1;
+	}
+	memcpy( result, string, length );
+	result[length] = 0;
+	return result;
+}
+
+static uint32_t
+Intern( const char *string, uint32_t length )
+{
+	if ( length == 0 )
+		return 0;
+
+	uint32_t hash = vsCalculateHash( string, length );
+
+	// Fast path;  no lock.
+	vsStringIdIndex *index = s_index.load(std::memory_order_acquire);
+	if ( index )
+	{
+		uint32_t id = FindId( index, string, length, hash );
+		if ( id )
+			return id;
+	}
+
+	s_lock.Lock();
+
+	// Somebody may have added it while we were waiting for the lock.
+	index = s_index.load(std::memory_order_relaxed);
+	uint32_t id = index ? FindId( index, string, length, hash ) : 0;
+	if ( id )
+	{
+		s_lock.Unlock();
+		return id;
+	}
+
+	id = s_count.load(std::memory_order_relaxed);
+	if ( id == 0 )
+		id = 1;	// zero is the empty string, which we never store.
+	vsAssert( id < STRINGID_MAX_CHUNKS * STRINGID_CHUNK_SIZE, "Too many interned strings!" );
+
+	int chunk = id >> STRINGID_CHUNK_SHIFT;
+	vsStringIdEntry *entries = s_chunk[chunk].load(std::memory_order_relaxed);
+	if ( !entries )
+	{
+		entries = (vsStringIdEntry*)malloc( sizeof(vsStringIdEntry) * STRINGID_CHUNK_SIZE );
+		s_chunk[chunk].store( entries, std::memory_order_release );
+	}
+	vsStringIdEntry &entry = entries[id & (STRINGID_CHUNK_SIZE-1)];
+	entry.string = StoreText( string, length );
+	entry.length = length;
+	entry.hash = hash;
+
+	// Keep the index at most half full.
+	uint32_t capacity = index ? index->mask + 1 : 0;
+	if ( (id + 1) * 2 > capacity )
+	{
+		capacity = vsMax( (uint32_t)STRINGID_MIN_INDEX_SIZE, capacity * 2 );
+		vsStringIdIndex *bigger = (vsStringIdIndex*)malloc( sizeof(vsStringIdIndex) );
+		bigger->mask = capacity - 1;
+		bigger->slot = (std::atomic<uint32_t>*)malloc( sizeof(std::atomic<uint32_t>) * capacity );
+		memset( (void*)bigger->slot, 0, sizeof(std::atomic<uint32_t>) * capacity );
+		for ( uint32_t i = 1; i < id; i++ )
+			InsertId( bigger, GetEntry(i).hash, i );
+		s_index.store( bigger, std::memory_order_release );
+		index = bigger;
+	}
+	InsertId( index, hash, id );
+	s_count.store( id + 1, std::memory_order_release );
+
+	s_lock.Unlock();
+	return id;
+}
+
+vsStringId::vsStringId( const char *string ):
+	m_id( Intern( string, (uint32_t)strlen(string) ) )
+{
+}
+
+vsStringId::vsStringId( const char *string, uint32_t length ):
+	m_id( Intern( string, length ) )
+{
+}
+
+vsStringId::vsStringId( const vsString &string ):
+	m_id( Intern( string.c_str(), (uint32_t)string.length() ) )
+{
+}
+
+const char *
+vsStringId::c_str() const
+{
+	if ( m_id == 0 )
+		return "";
+	return GetEntry(m_id).string;
+}
+
+uint32_t
+vsStringId::length() const
+{
+	if ( m_id == 0 )
+		return 0;
+	return GetEntry(m_id).length;
+}
+
+uint32_t
+vsStringId::GetHash() const
+{
+	if ( m_id == 0 )
+		return vsCalculateHash( "", 0 );
+	return GetEntry(m_id).hash;
+}
+
+int
+vsStringId::GetInternedCount()
+{
+	uint32_t count = s_count.load(std::memory_order_acquire);
+	return count ? count - 1 : 0;
+}
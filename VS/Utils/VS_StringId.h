@@ -0,0 +1,61 @@
+/*
+ *  VS_StringId.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_STRINGID_H
+#define VS_STRINGID_H
+
+#include "VS/Utils/VS_String.h"
+
+// A vsStringId is an interned string;  a small integer which stands for a
+// particular string of characters.  Two vsStringIds made from equal strings
+// are always equal, so comparing them is a single integer compare, and the
+// hash of the string is calculated once, when it's first interned, and then
+// stored.
+//
+// Creating a vsStringId from a string costs a hash and a table lookup, so
+// per-frame code should create its vsStringIds once (at load time, or in a
+// constructor) and hold onto them.  After that, using them never hashes or
+// compares strings again.
+//
+// Interned strings are never freed;  don't intern strings which are being
+// generated on the fly.  Creating vsStringIds and reading them back out
+// are safe from any thread, and reading never takes a lock.
+
+class vsStringId
+{
+	uint32_t	m_id;
+
+public:
+
+	// The default vsStringId is the empty string.
+	vsStringId(): m_id(0) {}
+	explicit vsStringId( const char *string );
+	explicit vsStringId( const char *string, uint32_t length );
+	explicit vsStringId( const vsString &string );
+
+	bool		operator==( const vsStringId &other ) const { return m_id == other.m_id; }
+	bool		operator!=( const vsStringId &other ) const { return m_id != other.m_id; }
+	bool		operator<( const vsStringId &other ) const { return m_id < other.m_id; }	// arbitrary, but stable for this run
+
+	bool		IsEmpty() const { return m_id == 0; }
+	uint32_t	GetId() const { return m_id; }
+
+	const char *	c_str() const;
+	uint32_t		length() const;
+	vsString		AsString() const { return vsString( c_str(), length() ); }
+
+	// vsCalculateHash() of the string.  Suitable for handing to
+	// vsHashTable::FindItem() and friends, which take a precomputed hash.
+	uint32_t		GetHash() const;
+
+	// Returns the number of unique strings which have been interned.
+	static int		GetInternedCount();
+};
+
+#endif // VS_STRINGID_H
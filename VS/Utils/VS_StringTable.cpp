@@ -18,13 +18,14 @@ int
 vsStringTable::AddString( const vsString& string )
 {
 	// already in the table?
-	Entry* indexPtr = m_stringIndex.FindItem(string);
+	uint32_t hash = vsCalculateHash(string);
+	Entry* indexPtr = m_stringIndex.FindItem(string, hash);
 	if ( indexPtr )
 		return indexPtr->id;
 
 	// add to the table!
 	int index = m_strings.ItemCount();
-	m_stringIndex[string] = index;
+	m_stringIndex.AddItemWithKey( Entry(index), string, hash );
 	m_strings.AddItem(string);
 	return index;
 }
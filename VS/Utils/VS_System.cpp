@@ -17,9 +17,13 @@
 #include "VS_Random.h"
 #include "VS_Screen.h"
 #include "VS_DynamicBatchManager.h"
+#include "VS_FrameArena.h"
+#include "VS_JobSystem.h"
 #include "VS_SingletonManager.h"
 #include "VS_TextureManager.h"
 #include "VS_FileCache.h"
+#include "VS_Profiler.h"
+#include "VS_StreamingQueue.h"
 #include "VS_ShaderCache.h"
 
 #include "VS_OpenGL.h"
@@ -66,6 +70,10 @@ vsSystem * vsSystem::s_instance = NULL;
 
 extern vsHeap *g_globalHeap;	// there exists this global heap;  we need to use this when changing video modes etc.
 
+const size_t c_frameArenaSize = 1024 * 1024 * 2;	// 2mb per frame for transient render data
+const size_t c_textureCacheBudget = 1024 * 1024 * 256;	// unused textures stay loaded until we're over 256mb
+const size_t c_materialCacheBudget = 1024 * 1024 * 4;
+
 
 
 #define VS_VERSION ("0.0.1")
@@ -125,6 +133,9 @@ vsSystem::vsSystem(const vsString& companyName, const vsString& title, int argc,
 	m_exitApplicationKeyEnabled( true ),
 	m_minBuffers(minBuffers),
 	m_orientation( Orientation_Normal ),
+	m_frameArena( NULL ),
+	m_jobSystem( NULL ),
+	m_streamingQueue( NULL ),
 	m_title( title ),
 	m_screen( NULL )
 {
@@ -142,9 +153,13 @@ vsSystem::vsSystem(const vsString& companyName, const vsString& title, int argc,
 
 	vsLog("VectorStorm engine version %s",VS_VERSION);
 
+	m_jobSystem = new vsJobSystem( GetNumberOfCores() );
+
+	vsProfiler::Startup();
 	vsFileCache::Startup();
 	vsShaderCache::Startup();
 	InitPhysFS( argc, argv, companyName, title );
+	m_streamingQueue = new vsStreamingQueue;
 
 	vsLog("Loading preferences...");
 	m_preferences = new vsSystemPreferences;
@@ -181,6 +196,8 @@ vsSystem::vsSystem(const vsString& companyName, const vsString& title, int argc,
 
 vsSystem::~vsSystem()
 {
+	vsDelete( m_streamingQueue );
+	vsDelete( m_jobSystem );
 	vsDelete( m_preferences );
 	vsDelete( m_screen );
 
@@ -189,6 +206,7 @@ vsSystem::~vsSystem()
 	DeinitPhysFS();
 	vsShaderCache::Shutdown();
 	vsFileCache::Shutdown();
+	vsProfiler::Shutdown();
 
 #if !TARGET_OS_IPHONE
 	SDL_Quit();
@@ -233,7 +251,9 @@ vsSystem::Init()
 	// Set requested GL context attributes
 	//initAttributes ();
 //#define IPHONELIKE
+	m_frameArena = new vsFrameArena( c_frameArenaSize );
 	m_textureManager = new vsTextureManager;
+	m_textureManager->SetBudget( c_textureCacheBudget );
 #if !defined(TARGET_OS_IPHONE) && defined(IPHONELIKE)
 //	m_screen = new vsScreen( 1920, 1080, 32, false );
 //	m_screen = new vsScreen( 1280, 720, 32, false );
@@ -250,6 +270,7 @@ vsSystem::Init()
 	m_screen = new vsScreen( width, height, 32, wt, vsMax(m_minBuffers, m_preferences->GetBloom() ? 2 : 1), m_preferences->GetVSync(), m_preferences->GetAntialias(), m_preferences->GetHighDPI() );
 #endif
 	LogSystemDetails();
+	m_screen->SetRenderThreadEnabled( m_preferences->GetRenderThread() );
 
 	vsBuiltInFont::Init();
 }
@@ -258,6 +279,7 @@ void
 vsSystem::InitGameData()
 {
 	m_materialManager = new vsMaterialManager;
+	m_materialManager->SetBudget( c_materialCacheBudget );
 	m_dynamicBatchManager = new vsDynamicBatchManager;
 }
 
@@ -267,6 +289,7 @@ vsSystem::DeinitGameData()
 	vsDelete( m_materialManager );
 	m_textureManager->CollectGarbage();
 	vsDelete( m_dynamicBatchManager );
+	m_frameArena->Reset();	// release any overflow allocations the game made, so they don't look like leaks
 }
 
 void
@@ -276,6 +299,7 @@ vsSystem::Deinit()
 
 	vsDelete( m_screen );
 	vsDelete( m_textureManager );
+	vsDelete( m_frameArena );
 
 	for ( int i = 0; i < CursorStyle_MAX; i++ )
 		SDL_FreeCursor( m_cursor[i] );
@@ -631,6 +655,7 @@ vsSystemPreferences::vsSystemPreferences()
 	m_dynamicBatching = m_preferences->GetPreference("DynamicBatching", 1, 0, 1);
 	m_antialias = m_preferences->GetPreference("Antialias", 0, 0, 1);
 	m_highDPI = m_preferences->GetPreference("HighDPI", 0, 0, 1);
+	m_renderThread = m_preferences->GetPreference("RenderThread", 0, 0, 1);
 	m_effectVolume = m_preferences->GetPreference("EffectVolume", 100, 0, 100);
 	m_musicVolume = m_preferences->GetPreference("MusicVolume", 100, 0, 100);
 	m_wheelSmoothing = m_preferences->GetPreference("WheelSmoothing", 1, 0, 1);
@@ -877,6 +902,18 @@ vsSystemPreferences::SetBloom(bool enabled)
 	m_bloom->m_value = enabled;
 }
 
+bool
+vsSystemPreferences::GetRenderThread()
+{
+	return !!(m_renderThread->m_value);
+}
+
+void
+vsSystemPreferences::SetRenderThread(bool enabled)
+{
+	m_renderThread->m_value = enabled;
+}
+
 bool
 vsSystemPreferences::GetAntialias()
 {
@@ -13,11 +13,14 @@
 #include "Utils/VS_Singleton.h"
 
 class vsDynamicBatchManager;
+class vsFrameArena;
+class vsJobSystem;
 class vsMaterialManager;
 class vsPreferences;
 class vsPreferenceObject;
 class vsSystemPreferences;
 class vsScreen;
+class vsStreamingQueue;
 class vsTextureManager;
 struct SDL_Cursor;
 
@@ -79,6 +82,9 @@ class vsSystem
 	vsTextureManager *	m_textureManager;
 	vsMaterialManager *	m_materialManager;
 	vsDynamicBatchManager *m_dynamicBatchManager;
+	vsFrameArena *		m_frameArena;
+	vsJobSystem *		m_jobSystem;
+	vsStreamingQueue *	m_streamingQueue;
 
 	vsString			m_title;
 	vsScreen *			m_screen;
@@ -184,6 +190,7 @@ class vsSystemPreferences
 	vsPreferenceObject *	m_dynamicBatching;
 	vsPreferenceObject *	m_antialias;
 	vsPreferenceObject *	m_highDPI;
+	vsPreferenceObject *	m_renderThread;
 	vsPreferenceObject *	m_wheelSmoothing;
 	vsPreferenceObject *	m_mouseWheelScalePercent;
 	vsPreferenceObject *	m_trackpadWheelScalePercent;
@@ -232,6 +239,9 @@ public:
 	bool			GetDynamicBatching();
 	void			SetDynamicBatching(bool enabled);
 
+	bool			GetRenderThread();
+	void			SetRenderThread(bool enabled);
+
 	bool			GetAntialias();
 	void			SetAntialias(bool enabled);
 
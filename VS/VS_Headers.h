@@ -17,6 +17,7 @@
 
 #include <Files/VS_File.h>
 #include <Files/VS_Record.h>
+#include <Files/VS_StreamingQueue.h>
 #include <Files/VS_Token.h>
 
 #include <Memory/VS_Heap.h>
@@ -32,6 +33,7 @@
 #include <VS/Utils/VS_WeakPointerTarget.h>
 
 #include <VS/Utils/VS_Profile.h>
+#include <VS/Utils/VS_Profiler.h>
 
 #ifdef USE_SDL_SOUND
 #include <Sound/VS_Music.h>
@@ -79,14 +81,17 @@
 #include <VS/Graphics/VS_RenderPipelineStageScenes.h>
 #include <VS/Graphics/VS_RenderQueue.h>
 #include <VS/Graphics/VS_RenderTarget.h>
+#include <VS/Graphics/VS_RenderThread.h>
 #include <VS/Graphics/VS_Renderer.h>
 #include <VS/Graphics/VS_Scene.h>
 #include <VS/Graphics/VS_Screen.h>
+#include <VS/Graphics/VS_ScreenshotQueue.h>
 #include <VS/Graphics/VS_Shader.h>
 #include <VS/Graphics/VS_ShaderSuite.h>
 #include <VS/Graphics/VS_ShaderValues.h>
 #include <VS/Graphics/VS_Sprite.h>
 #include <VS/Graphics/VS_Texture.h>
+#include <VS/Graphics/VS_TextureLoader.h>
 #include <VS/Graphics/VS_TextureManager.h>
 
 #include <VS/Network/VS_NetClient.h>
@@ -106,6 +111,7 @@
 #include <VS/Math/VS_Transform.h>
 #include <VS/Math/VS_Vector.h>
 
+#include <VS/Threads/VS_JobSystem.h>
 #include <VS/Threads/VS_Mutex.h>
 #include <VS/Threads/VS_Semaphore.h>
 #include <VS/Threads/VS_Spinlock.h>
@@ -134,6 +140,7 @@
 #include <VS/Utils/VS_SingleFloatImage.h>
 #include <VS/Utils/VS_Sleep.h>
 #include <VS/Utils/VS_String.h>
+#include <VS/Utils/VS_StringId.h>
 #include <VS/Utils/VS_System.h>
 #include <VS/Utils/VS_VolatileArray.h>
 #include <VS/Utils/VS_VolatileArrayStore.h>
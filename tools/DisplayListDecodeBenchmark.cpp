@@ -0,0 +1,160 @@
+/*
+ *  DisplayListDecodeBenchmark.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+// Records a frame's worth of scenes into a display list, then decodes that
+// FIFO over and over, once with PopOp() and once with PopOpView(), reading
+// the arguments a renderer would read, and reports ops per second for each.
+
+#include "VS_ToolHarness.h"
+#include "VS/Graphics/VS_DisplayList.h"
+#include "VS/Graphics/VS_Fragment.h"
+#include "VS/Graphics/VS_Scene.h"
+#include "VS/Graphics/VS_Sprite.h"
+#include "VS/Math/VS_Random.h"
+#include "VS/Utils/VS_Primitive.h"
+
+const int c_sceneCount = 3;
+const int c_spritesPerScene = 2000;
+const int c_materialCount = 24;
+const int c_passCount = 200;
+const size_t c_listSize = 1024 * 4000;
+
+// Something for the decoded arguments to go into, so they can't be optimised away.
+static volatile uintptr_t s_sink;
+
+static void
+ConsumeOp( vsDisplayList::op *op )
+{
+	uintptr_t sum = op->type;
+	switch ( op->type )
+	{
+		case vsDisplayList::OpCode_SetColor:
+			sum += (uintptr_t)(op->data.color.r * 255.f);
+			break;
+		case vsDisplayList::OpCode_SetMatrix4x4:
+		case vsDisplayList::OpCode_PushMatrix4x4:
+		case vsDisplayList::OpCode_SetWorldToViewMatrix4x4:
+		case vsDisplayList::OpCode_SetProjectionMatrix4x4:
+		{
+			vsMatrix4x4 m = op->data.GetMatrix4x4();
+			sum += (uintptr_t)m.w.x;
+			break;
+		}
+		case vsDisplayList::OpCode_SetMaterial:
+		case vsDisplayList::OpCode_BindBuffer:
+		case vsDisplayList::OpCode_TriangleListBuffer:
+		case vsDisplayList::OpCode_SetRenderTarget:
+			sum += (uintptr_t)op->data.p;
+			break;
+		default:
+			break;
+	}
+	s_sink += sum;
+}
+
+static void
+ConsumeView( const vsDisplayList::OpView *view )
+{
+	uintptr_t sum = view->GetType();
+	switch ( view->GetType() )
+	{
+		case vsDisplayList::OpCode_SetColor:
+			sum += (uintptr_t)(view->GetColor().r * 255.f);
+			break;
+		case vsDisplayList::OpCode_SetMatrix4x4:
+		case vsDisplayList::OpCode_PushMatrix4x4:
+		case vsDisplayList::OpCode_SetWorldToViewMatrix4x4:
+		case vsDisplayList::OpCode_SetProjectionMatrix4x4:
+		{
+			vsMatrix4x4 m;
+			view->GetMatrix4x4( &m );
+			sum += (uintptr_t)m.w.x;
+			break;
+		}
+		case vsDisplayList::OpCode_SetMaterial:
+		case vsDisplayList::OpCode_BindBuffer:
+		case vsDisplayList::OpCode_TriangleListBuffer:
+		case vsDisplayList::OpCode_SetRenderTarget:
+			sum += (uintptr_t)view->GetPointer();
+			break;
+		default:
+			break;
+	}
+	s_sink += sum;
+}
+
+int main(int argc, char* argv[])
+{
+	vsToolHarness harness( argc, argv, "DisplayListDecodeBenchmark" );
+	vsRandom::InitWithSeed( 1 );
+
+	vsMaterial *material[c_materialCount];
+	for ( int i = 0; i < c_materialCount; i++ )
+	{
+		vsColor color( vsRandom::GetFloat(1.f), vsRandom::GetFloat(1.f), vsRandom::GetFloat(1.f), 1.f );
+		material[i] = harness.MakeMaterial( color, vsRandom::GetInt(3) - 1, vsRandom::GetInt(4) == 0 );
+	}
+
+	vsScene *scene[c_sceneCount];
+	vsBox2D box( vsVector2D(-5.f,-5.f), vsVector2D(5.f,5.f) );
+	for ( int s = 0; s < c_sceneCount; s++ )
+	{
+		scene[s] = new vsScene;
+		for ( int i = 0; i < c_spritesPerScene; i++ )
+		{
+			vsFragment *fragment = vsMakeSolidBox2D( box, "White" );
+			fragment->SetMaterial( material[ vsRandom::GetInt(c_materialCount) ] );
+
+			vsSprite *sprite = new vsSprite;
+			sprite->AddFragment( fragment );
+			sprite->SetPosition( vsVector2D( vsRandom::GetFloat(-200.f,200.f), vsRandom::GetFloat(-200.f,200.f) ) );
+			scene[s]->RegisterEntityOnTop( sprite );
+		}
+	}
+
+	vsDisplayList *list = new vsDisplayList( c_listSize );
+	for ( int s = 0; s < c_sceneCount; s++ )
+		scene[s]->Draw( list );
+
+	int opCount = 0;
+	list->Rewind();
+	while ( list->PopOpView() )
+		opCount++;
+
+	uint64_t start = vsToolHarness::GetMicroseconds();
+	for ( int pass = 0; pass < c_passCount; pass++ )
+	{
+		list->Rewind();
+		while ( vsDisplayList::op *op = list->PopOp() )
+			ConsumeOp( op );
+	}
+	uint64_t opMicroseconds = vsToolHarness::GetMicroseconds() - start;
+
+	start = vsToolHarness::GetMicroseconds();
+	for ( int pass = 0; pass < c_passCount; pass++ )
+	{
+		list->Rewind();
+		while ( const vsDisplayList::OpView *view = list->PopOpView() )
+			ConsumeView( view );
+	}
+	uint64_t viewMicroseconds = vsToolHarness::GetMicroseconds() - start;
+
+	double ops = (double)opCount * c_passCount;
+	printf("%d ops (%d bytes) per frame, decoded %d times\n", opCount, (int)list->GetSize(), c_passCount);
+	printf("  PopOp:      %.1f Mops/s\n", ops / vsMax(opMicroseconds, (uint64_t)1) );
+	printf("  PopOpView:  %.1f Mops/s\n", ops / vsMax(viewMicroseconds, (uint64_t)1) );
+
+	vsDelete( list );
+	for ( int s = 0; s < c_sceneCount; s++ )
+		vsDelete( scene[s] );
+	for ( int i = 0; i < c_materialCount; i++ )
+		vsDelete( material[i] );
+
+	return 0;
+}
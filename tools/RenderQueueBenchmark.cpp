@@ -0,0 +1,115 @@
+/*
+ *  RenderQueueBenchmark.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+// Submits 10,000 draws using a few hundred materials to a vsRenderQueue, in
+// random order, and reports how long the queue takes to accept and record
+// them, and how many material and shader changes the recorded display list
+// contains, against how many drawing in submission order would have cost.
+//
+// Materials differ in layer, blending, colour, and draw mode (which picks
+// their default shader).  None are textured, so texture changes will be
+// zero here.
+
+#include "VS_ToolHarness.h"
+#include "VS/Graphics/VS_DisplayList.h"
+#include "VS/Graphics/VS_Fragment.h"
+#include "VS/Graphics/VS_MaterialInternal.h"
+#include "VS/Graphics/VS_RenderQueue.h"
+#include "VS/Math/VS_Random.h"
+#include "VS/Utils/VS_Primitive.h"
+
+const int c_drawCount = 10000;
+const int c_materialCount = 300;
+const int c_frameCount = 200;
+const size_t c_listSize = 1024 * 4000;
+
+int main(int argc, char* argv[])
+{
+	vsToolHarness harness( argc, argv, "RenderQueueBenchmark" );
+	vsRandom::InitWithSeed( 1 );
+
+	vsMaterial *material[c_materialCount];
+	vsFragment *fragment[c_materialCount];
+	vsBox2D box( vsVector2D(-1.f,-1.f), vsVector2D(1.f,1.f) );
+	for ( int i = 0; i < c_materialCount; i++ )
+	{
+		vsColor color( vsRandom::GetFloat(1.f), vsRandom::GetFloat(1.f), vsRandom::GetFloat(1.f), 1.f );
+		int layer = vsRandom::GetInt(3) - 1;
+		bool blend = vsRandom::GetInt(4) == 0;
+		vsDrawMode mode = vsRandom::GetInt(2) ? DrawMode_Lit : DrawMode_Normal;
+		material[i] = harness.MakeMaterial( color, layer, blend, mode );
+
+		fragment[i] = vsMakeSolidBox2D( box, "White" );
+		fragment[i]->SetMaterial( material[i] );
+	}
+
+	// The same draws every frame.
+	int drawFragment[c_drawCount];
+	vsMatrix4x4 drawMatrix[c_drawCount];
+	for ( int i = 0; i < c_drawCount; i++ )
+	{
+		drawFragment[i] = vsRandom::GetInt(c_materialCount);
+		drawMatrix[i].SetTranslation( vsVector3D( vsRandom::GetFloat(-50.f,50.f), vsRandom::GetFloat(-50.f,50.f), vsRandom::GetFloat(-100.f,-1.f) ) );
+	}
+
+	// What drawing in submission order would cost.
+	int submissionMaterialChanges = 0;
+	int submissionShaderChanges = 0;
+	for ( int i = 1; i < c_drawCount; i++ )
+	{
+		vsMaterialInternal *a = material[ drawFragment[i-1] ]->GetResource();
+		vsMaterialInternal *b = material[ drawFragment[i] ]->GetResource();
+		if ( a != b )
+			submissionMaterialChanges++;
+		if ( a->m_drawMode != b->m_drawMode )
+			submissionShaderChanges++;
+	}
+
+	vsRenderQueue *queue = new vsRenderQueue( 3, 1024*200 );
+	vsDisplayList *list = new vsDisplayList( c_listSize );
+
+	uint64_t totalMicroseconds = 0;
+	for ( int frame = 0; frame < c_frameCount; frame++ )
+	{
+		list->Clear();
+
+		uint64_t start = vsToolHarness::GetMicroseconds();
+		queue->StartRender( vsMatrix4x4::Identity, vsMatrix4x4::Identity, vsMatrix4x4::Identity );
+		for ( int i = 0; i < c_drawCount; i++ )
+		{
+			queue->PushMatrix( drawMatrix[i] );
+			queue->AddFragmentBatch( fragment[ drawFragment[i] ] );
+			queue->PopMatrix();
+		}
+		queue->Draw( list );
+		queue->EndRender();
+		totalMicroseconds += vsToolHarness::GetMicroseconds() - start;
+
+		harness.NextFrame();
+	}
+
+	const vsRenderQueue::Stats &stats = queue->GetStats();
+	printf("%d draws, %d materials, %d frames\n", c_drawCount, c_materialCount, c_frameCount);
+	printf("  queue CPU time:      %.1f us/frame\n", (double)totalMicroseconds / c_frameCount);
+	printf("  display list:        %d bytes\n", (int)list->GetSize());
+	printf("  elements drawn:      %d\n", stats.elements);
+	printf("  material changes:    %d  (%d in submission order)\n", stats.materialChanges, submissionMaterialChanges);
+	printf("  shader changes:      %d  (%d in submission order)\n", stats.shaderChanges, submissionShaderChanges);
+	printf("  texture changes:     %d\n", stats.textureChanges);
+
+	vsDelete( list );
+	vsDelete( queue );
+	for ( int i = 0; i < c_materialCount; i++ )
+	{
+		vsDelete( fragment[i] );
+		vsDelete( material[i] );
+	}
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+/*
+ *  SceneRecordingTest.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+// Records the same scenes through two vsRenderPipelineStageScenes every
+// frame, one serially and one in parallel, and checks that the two display
+// lists come out byte-for-byte identical.  Exits non-zero if they ever
+// differ.
+//
+// The parallel stage records its first frame serially (to size its scenes'
+// lists), so frames after the first are the ones that test parallel
+// recording.
+
+#include "VS_ToolHarness.h"
+#include "VS/Graphics/VS_DisplayList.h"
+#include "VS/Graphics/VS_Fragment.h"
+#include "VS/Graphics/VS_Material.h"
+#include "VS/Graphics/VS_RenderPipelineStageScenes.h"
+#include "VS/Graphics/VS_Scene.h"
+#include "VS/Graphics/VS_Screen.h"
+#include "VS/Graphics/VS_Sprite.h"
+#include "VS/Math/VS_Random.h"
+#include "VS/Memory/VS_Store.h"
+#include "VS/Threads/VS_JobSystem.h"
+#include "VS/Utils/VS_Primitive.h"
+
+const int c_sceneCount = 6;
+const int c_3dScene = 3;		// one 3D scene, to check the camera transform handoff
+const int c_spritesPerScene = 400;
+const int c_materialCount = 12;
+const int c_frameCount = 8;
+const size_t c_listSize = 1024 * 4000;
+
+static vsMaterial *		s_material[c_materialCount];
+static vsScene *		s_scene[c_sceneCount];
+static vsSprite *		s_sprite[c_sceneCount][c_spritesPerScene];
+
+static void
+BuildScenes( vsToolHarness &harness )
+{
+	// A mix of layers, and of blended and unblended materials, so that
+	// scenes' render queues actually have to sort.
+	for ( int i = 0; i < c_materialCount; i++ )
+	{
+		vsColor color( (i%3)/2.f, (i%4)/3.f, (i%5)/4.f, 1.f );
+		s_material[i] = harness.MakeMaterial( color, (i%3) - 1, (i%2) == 0 );
+	}
+
+	vsBox2D box( vsVector2D(-5.f,-5.f), vsVector2D(5.f,5.f) );
+	for ( int s = 0; s < c_sceneCount; s++ )
+	{
+		s_scene[s] = new vsScene;
+		s_scene[s]->Set3D( s == c_3dScene );
+		for ( int i = 0; i < c_spritesPerScene; i++ )
+		{
+			vsFragment *fragment = vsMakeSolidBox2D( box, "White" );
+			fragment->SetMaterial( s_material[ vsRandom::GetInt(c_materialCount) ] );
+
+			vsSprite *sprite = new vsSprite;
+			sprite->AddFragment( fragment );
+			sprite->SetPosition( vsVector2D( vsRandom::GetFloat(-200.f,200.f), vsRandom::GetFloat(-200.f,200.f) ) );
+			s_scene[s]->RegisterEntityOnTop( sprite );
+			s_sprite[s][i] = sprite;
+		}
+	}
+}
+
+static void
+DestroyScenes()
+{
+	// scenes delete their entities, and sprites their fragments.
+	for ( int s = 0; s < c_sceneCount; s++ )
+		vsDelete( s_scene[s] );
+	for ( int i = 0; i < c_materialCount; i++ )
+		vsDelete( s_material[i] );
+}
+
+static void
+Animate()
+{
+	// Move a few sprites each frame, so draw caches see both hits and misses.
+	for ( int s = 0; s < c_sceneCount; s++ )
+	{
+		for ( int i = 0; i < c_spritesPerScene / 10; i++ )
+		{
+			vsSprite *sprite = s_sprite[s][ vsRandom::GetInt(c_spritesPerScene) ];
+			sprite->SetPosition( sprite->GetPosition() + vsVector2D( vsRandom::GetFloat(-1.f,1.f), vsRandom::GetFloat(-1.f,1.f) ) );
+		}
+	}
+}
+
+static void
+Record( vsRenderPipelineStageScenes *stage, vsDisplayList *list )
+{
+	// What the previous scene left in g_drawingCameraTransform leaks into
+	// the next, so start both recordings from the same place.
+	g_drawingCameraTransform = vsTransform2D::Zero;
+	list->Clear();
+	stage->Draw( list );
+}
+
+int main(int argc, char* argv[])
+{
+	vsToolHarness harness( argc, argv, "SceneRecordingTest" );
+	vsRandom::InitWithSeed( 1 );
+
+	BuildScenes( harness );
+
+	vsRenderTarget *target = vsScreen::Instance()->GetMainRenderTarget();
+	vsRenderer::Settings settings;
+	vsRenderPipelineStageScenes *serial = new vsRenderPipelineStageScenes( s_scene, c_sceneCount, target, settings, false );
+	vsRenderPipelineStageScenes *parallel = new vsRenderPipelineStageScenes( s_scene, c_sceneCount, target, settings, false );
+	parallel->SetParallelRecording( true );
+
+	vsDisplayList *serialList = new vsDisplayList( c_listSize );
+	vsDisplayList *parallelList = new vsDisplayList( c_listSize );
+
+	if ( !vsJobSystem::Exists() )
+		fprintf(stderr, "No job system;  both recordings will be serial.\n");
+
+	int failures = 0;
+	for ( int frame = 0; frame < c_frameCount; frame++ )
+	{
+		Animate();
+		Record( serial, serialList );
+		Record( parallel, parallelList );
+
+		size_t serialSize = serialList->GetSize();
+		size_t parallelSize = parallelList->GetSize();
+		bool same = ( serialSize == parallelSize ) &&
+			memcmp( serialList->GetFifo()->GetBuffer(), parallelList->GetFifo()->GetBuffer(), serialSize ) == 0;
+
+		printf("frame %d:  serial %d bytes, parallel %d bytes:  %s\n", frame, (int)serialSize, (int)parallelSize, same ? "match" : "MISMATCH");
+		if ( !same )
+			failures++;
+
+		harness.NextFrame();
+	}
+
+	vsDelete( serialList );
+	vsDelete( parallelList );
+	vsDelete( serial );
+	vsDelete( parallel );
+	DestroyScenes();
+
+	return failures ? 1 : 0;
+}
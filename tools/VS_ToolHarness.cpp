@@ -0,0 +1,60 @@
+/*
+ *  VS_ToolHarness.cpp
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#include "VS_ToolHarness.h"
+#include "VS/Graphics/VS_DynamicMaterial.h"
+#include "VS/Graphics/VS_Screen.h"
+#include "VS/Memory/VS_FrameArena.h"
+#include "VS/Utils/VS_System.h"
+
+#include <SDL2/SDL.h>
+
+vsToolHarness::vsToolHarness( int argc, char* argv[], const char *title )
+{
+	new vsSystem( "VectorStorm", title, argc, argv );
+	vsSystem::Instance()->Init();
+	vsSystem::Instance()->InitGameData();
+
+	// Tools record display lists and look at them;  they never want them
+	// handed off to another thread, or batched in ways that depend on
+	// what was uploaded last frame.
+	vsScreen::Instance()->SetRenderThreadEnabled( false );
+	vsSystem::Instance()->GetPreferences()->SetDynamicBatching( false );
+}
+
+vsToolHarness::~vsToolHarness()
+{
+	vsSystem::Instance()->DeinitGameData();
+	vsSystem::Instance()->Deinit();
+	delete vsSystem::Instance();
+}
+
+vsMaterial *
+vsToolHarness::MakeMaterial( const vsColor &color, int layer, bool blend, vsDrawMode mode )
+{
+	vsDynamicMaterial *material = new vsDynamicMaterial;
+	material->SetDrawMode( mode );
+	material->SetColor( color );
+	material->SetLayer( layer );
+	material->SetBlend( blend );
+	material->SetShader();
+	return material;
+}
+
+void
+vsToolHarness::NextFrame()
+{
+	vsFrameArena::Instance()->NextFrame();
+}
+
+uint64_t
+vsToolHarness::GetMicroseconds()
+{
+	return (SDL_GetPerformanceCounter() * 1000000) / SDL_GetPerformanceFrequency();
+}
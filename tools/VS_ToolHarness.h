@@ -0,0 +1,41 @@
+/*
+ *  VS_ToolHarness.h
+ *  VectorStorm
+ *
+ *  Created by agent on 17/10/2026
+ *  Copyright 2026 agent.  All rights reserved.
+ *
+ */
+
+#ifndef VS_TOOLHARNESS_H
+#define VS_TOOLHARNESS_H
+
+#include "VS/Graphics/VS_Material.h"
+
+class vsColor;
+
+// Brings up enough of the engine for a command-line program to build scenes
+// and record display lists, without running a game:  vsSystem, the screen
+// (which needs an OpenGL context, so set SDL_VIDEODRIVER=offscreen or run
+// under a virtual X server on a headless machine), and the material
+// manager.  Nothing is ever presented.
+//
+// Materials and shaders are loaded from the Data directory beside the
+// executable;  the tools' CMakeLists.txt puts one there.
+
+class vsToolHarness
+{
+public:
+	vsToolHarness( int argc, char* argv[], const char *title );
+	~vsToolHarness();
+
+	// Makes a material with the default shader for 'mode'.  Caller deletes it.
+	vsMaterial *	MakeMaterial( const vsColor &color, int layer, bool blend, vsDrawMode mode = DrawMode_Normal );
+
+	// Starts a new frame for anything that allocates from the frame arena.
+	void			NextFrame();
+
+	static uint64_t	GetMicroseconds();
+};
+
+#endif // VS_TOOLHARNESS_H